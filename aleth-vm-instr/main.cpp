@@ -19,19 +19,29 @@
 
 #include <aleth/buildinfo.h>
 
+#include <libevm-gas-exploiter/ArithmeticBenchmark.h>
 #include <libevm-gas-exploiter/Benchmarker.h>
+#include <libevm-gas-exploiter/BlockReplay.h>
 #include <libevm-gas-exploiter/ExecutionEnv.h>
+#include <libevm-gas-exploiter/GasCostModel.h>
 #include <libevm-gas-exploiter/GeneticEngine.h>
 #include <libevm-gas-exploiter/InstructionMetadata.h>
+#include <libevm-gas-exploiter/IslandModel.h>
+#include <libevm-gas-exploiter/WorkerPool.h>
+#include <libevmanalysis/ColumnarFile.h>
+#include <libevmanalysis/HardwareCounterCollector.h>
+#include <libevmanalysis/InstructionStats.h>
 #include <libevmanalysis/StreamWrapper.h>
 
 #include <boost/algorithm/string.hpp>
 #include <boost/program_options.hpp>
 
+#include <algorithm>
 #include <ctime>
 #include <fstream>
 #include <iostream>
 #include <csignal>
+#include <sched.h>
 #include <unistd.h>
 
 using namespace std;
@@ -48,8 +58,15 @@ enum class Mode
     Benchmark,
     Search,
     BenchmarkCache,
+    ToJsonl,
+    Replay,
+    FitGasCosts,
+    BenchmarkArithmetic,
 };
 
+/// operands of each instruction timed by --mode benchmark-arithmetic
+constexpr size_t c_arithmeticOperandsCount = 10000;
+
 int64_t maxBlockGasLimit()
 {
     static int64_t limit =
@@ -138,6 +155,28 @@ std::vector<std::vector<bytes>> loadPrograms(const std::string& programsPath, ui
     }
     return blocks;
 }
+
+/// Schedule of the latest fork of the network, the one the gas costs are fitted against and
+/// a custom schedule is applied on
+EVMSchedule const& latestSchedule(ChainParams const& chainParams)
+{
+    return chainParams.scheduleForBlockNumber(c_infiniteBlockNumber - 1);
+}
+
+std::vector<unsigned> parseCores(const std::string& coresList)
+{
+    std::vector<std::string> coreNames;
+    boost::split(coreNames, coresList, boost::is_any_of(","));
+    std::vector<unsigned> cores;
+    for (auto& coreName : coreNames)
+    {
+        if (!coreName.empty())
+        {
+            cores.push_back(static_cast<unsigned>(std::stoul(coreName)));
+        }
+    }
+    return cores;
+}
 }
 
 int main(int argc, char** argv)
@@ -164,6 +203,12 @@ int main(int argc, char** argv)
     uint16_t initialWarmupCount = 10;
     bool dropCache = false;
     bool alwaysDropCache = false;
+    bool hardwareCounters = false;
+    double targetMedianWidth = 0;
+    uint64_t maxExecCount = 0;
+    std::vector<std::string> vms;
+    VMAggregation vmAggregation = VMAggregation::Min;
+    std::vector<unsigned> workerCores;
 
     uint32_t populationSize = 1000;
     uint32_t initialProgramSize = 2000;
@@ -172,10 +217,22 @@ int main(int argc, char** argv)
     uint32_t generationsCount = 1000;
     uint32_t mutationsCount = 5;
     bool cacheResults = false;
+    std::string fitnessCachePath;
     double eliteRatio = 0.1;
     double tournamentSelectionProb = 0.4;
     double tournamentSelectionRatio = 0.2;
     GeneticEngine::Metric targetMetric = GeneticEngine::Metric::ThroughputMedian;
+    std::vector<Objective> objectives;
+    uint32_t islandsCount = 1;
+    IslandModel::Topology islandTopology = IslandModel::Topology::Ring;
+    uint32_t migrationInterval = 10;
+    uint32_t migrantsCount = 5;
+    std::vector<unsigned> islandCores;
+    std::string checkpointPath;
+    uint32_t checkpointInterval = 10;
+    std::string resumePath;
+    std::string columnarOutputPath;
+    BlockReplayConfig replayConfig;
 
     Ethash::init();
     NoProof::init();
@@ -210,7 +267,7 @@ int main(int argc, char** argv)
     addGeneralOption("help,h", "Show this help message and exit.");
     addGeneralOption("debug", "Enables debug mode.");
     addGeneralOption("seed", po::value<unsigned int>(), "<s> Set random seed");
-    addGeneralOption("mode", po::value<std::string>(), "<m> Mode to use (benchmark, search, benchmark-cache)");
+    addGeneralOption("mode", po::value<std::string>(), "<m> Mode to use (benchmark, search, benchmark-cache, to-jsonl, replay, fit-gas-costs, benchmark-arithmetic)");
     addGeneralOption("author", po::value<Address>(), "<a> Set author");
     addGeneralOption("difficulty", po::value<u256>(), "<n> Set difficulty");
     addGeneralOption("number", po::value<int64_t>(), "<n> Set number");
@@ -220,12 +277,30 @@ int main(int argc, char** argv)
     addGeneralOption("initial-warmup-count", po::value<uint16_t>(), "Number of times to run warmup before the first measurement");
     addGeneralOption("no-warmup", "Do not warmup before each block execution");
     addGeneralOption("drop-cache", "Drop caches before starting benchmark");
-    addGeneralOption("always-drop-cache", "Drop caches before each benchmark execution");
+    addGeneralOption("always-drop-cache", "Drop caches before each benchmark execution, or before each block execution with --mode replay");
+    addGeneralOption("hardware-counters", "Collect CPU cycles, cache, branch and TLB misses of each execution");
+    addGeneralOption("target-median-width", po::value<double>(), "<x> Keep executing a program after --exec-count executions until the 95% confidence interval of its median time is narrower than <x> times the median (e.g. 0.02)");
+    addGeneralOption("vms", po::value<std::string>(), "<v> Comma-separated list of VMs to run every program on, each being 'legacy', 'interpreter' or the path of an EVMC shared library (default: the VM selected with --vm)");
+    addGeneralOption("vm-aggregation", po::value<std::string>(), "<a> How the times on each VM are combined: 'min' to keep the fastest VM or 'geomean' (default: min)");
+    addGeneralOption("max-exec-count", po::value<uint64_t>(), "<n> Maximum number of executions of a program with --target-median-width (default: 10 times --exec-count)");
     addGeneralOption("metadata-path", po::value<std::string>(), "<p> Set the path for the metadata");
     addGeneralOption("output-path", po::value<std::string>(), "<p> Set the path to save results");
+    addGeneralOption("input-path", po::value<std::string>(), "<p> Set the path of the columnar file to convert with --mode to-jsonl, or of the transactions measurements (JSONL or columnar) with --mode fit-gas-costs");
     addGeneralOption("programs-path", po::value<std::string>(), "<p> Set the path of the programs to benchmark");
     addGeneralOption("start-index", po::value<uint64_t>(), "<p> The first index (line number) of the programs to benchmark");
     addGeneralOption("end-index", po::value<uint64_t>(), "<p> The last index (line number) of the programs to benchmark");
+    addGeneralOption("gas-schedule", po::value<std::string>(), "<p> Execute every program with the prices of the JSON schedule at <p>, e.g. one proposed by --mode fit-gas-costs, applied on the latest fork of the network (legacy VM only)");
+    addGeneralOption("fit-min-count", po::value<uint64_t>(), "<n> Minimum number of executions of an instruction for its cost to be fitted with --mode fit-gas-costs (default: 1)");
+    addGeneralOption("worker-cores", po::value<std::string>(), "<c> Comma-separated list of cores to run one pinned benchmark worker process on each");
+    addGeneralOption("superinstructions-profile", po::value<std::string>(), "<p> Enable the superinstructions of the interpreter whose pairs are among the most frequent bigrams of the transactions measurements (JSONL) at <p>");
+    addGeneralOption("superinstructions-count", po::value<size_t>(), "<n> Number of most frequent bigrams of --superinstructions-profile considered for fusion (default: 16)");
+
+    po::options_description replayOptions("Replay options", c_lineWidth);
+    auto addReplayOption = replayOptions.add_options();
+    addReplayOption("first-block", po::value<uint64_t>(&replayConfig.firstBlock), "<n> First block of the chain database to execute again with --mode replay");
+    addReplayOption("last-block", po::value<uint64_t>(), "<n> Last block to execute again (default: --first-block)");
+    addReplayOption("repeat", po::value<uint64_t>(&replayConfig.repeatCount), "<n> Number of executions of each block (default: 1)");
+    addReplayOption("replay-core", po::value<int>(&replayConfig.core), "<c> Core to pin the replay thread to (default: the core it starts on)");
 
     po::options_description gaOptions("Genetic algorithm options", c_lineWidth);
     auto addGaOption = gaOptions.add_options();
@@ -234,12 +309,23 @@ int main(int argc, char** argv)
     addGaOption("min-program-size", po::value<uint32_t>(), "<n> Set minimum program size");
     addGaOption("max-program-size", po::value<uint32_t>(), "<n> Set maximum program size");
     addGaOption("cache-results", "Cache the results");
+    addGaOption("fitness-cache-path", po::value<std::string>(), "<p> File used to store and reuse evaluations across runs with the same benchmark settings (implies --cache-results)");
     addGaOption("generations-count", po::value<uint32_t>(), "<n> Set numbers of generation to run");
     addGaOption("mutations-count", po::value<uint32_t>(), "<n> Set numbers of mutations per sample");
     addGaOption("elite-ratio", po::value<double>(), "<x> Set the ratio of elite to keep across generations");
     addGaOption("tournament-selection-p", po::value<double>(), "<x> Set probability of picking first for tournament selection");
     addGaOption("tournament-selection-ratio", po::value<double>(), "<x> Set the ratio of samples to use for tournament selection");
-    addGaOption("target-metric", po::value<std::string>(), "<m> Metric to optimize when performing the search ('mean' or 'median')");
+    addGaOption("target-metric", po::value<std::string>(), "<m> Metric to optimize when performing the search ('throughput-mean', 'throughput-median', 'time-mean', 'time-median' or 'cycles-per-gas')");
+    addGaOption("objectives", po::value<std::string>(), "<o> Comma-separated objectives for a Pareto search, e.g. 'max:time_median,min:time_stdev' (overrides --target-metric)");
+    addGaOption("checkpoint-path", po::value<std::string>(), "<p> File where the state of the search is periodically saved");
+    addGaOption("checkpoint-interval", po::value<uint32_t>(), "<n> Number of generations between two checkpoints (default: 10)");
+    addGaOption("resume", po::value<std::string>(), "<p> Resume the search from a checkpoint, the other search options must be unchanged (checkpoints go to the same file unless --checkpoint-path is set)");
+    addGaOption("columnar-output", po::value<std::string>(), "<p> File where the stats of each generation and of its programs are also written in the columnar format");
+    addGaOption("islands", po::value<uint32_t>(), "<n> Number of populations to evolve in separate processes (default: 1)");
+    addGaOption("island-topology", po::value<std::string>(), "<t> Islands exchanging programs ('ring', 'star' or 'fully-connected', default: ring)");
+    addGaOption("migration-interval", po::value<uint32_t>(), "<n> Number of generations between two migrations (default: 10)");
+    addGaOption("migrants-count", po::value<uint32_t>(), "<n> Number of programs sent by an island at each migration (default: 5)");
+    addGaOption("island-cores", po::value<std::string>(), "<c> Comma-separated list of cores to pin each island to");
 
 
     po::options_description dbOptions = db::databaseProgramOptions(c_lineWidth);
@@ -252,6 +338,7 @@ int main(int argc, char** argv)
         .add(generalOptions)
         .add(dbOptions)
         .add(gaOptions)
+        .add(replayOptions)
         .add(transactionOptions);
     po::parsed_options parsed =
         po::command_line_parser(argc, argv).options(allowedOptions).allow_unregistered().run();
@@ -289,13 +376,99 @@ int main(int argc, char** argv)
             mode = Mode::Search;
         else if (modeName == "benchmark-cache")
             mode = Mode::BenchmarkCache;
+        else if (modeName == "to-jsonl")
+            mode = Mode::ToJsonl;
+        else if (modeName == "replay")
+            mode = Mode::Replay;
+        else if (modeName == "fit-gas-costs")
+            mode = Mode::FitGasCosts;
+        else if (modeName == "benchmark-arithmetic")
+            mode = Mode::BenchmarkArithmetic;
         else
         {
-            std::cerr << "mode should be 'benchmark' or 'search', got '" << modeName << "'" << std::endl;
+            std::cerr << "mode should be 'benchmark', 'search', 'benchmark-cache', 'to-jsonl', 'replay', 'fit-gas-costs' or 'benchmark-arithmetic', got '" << modeName << "'" << std::endl;
             return AlethErrors::UnknownArgument;
         }
     }
 
+    if (vm.count("superinstructions-profile"))
+    {
+        auto profilePath = vm["superinstructions-profile"].as<std::string>();
+        std::ifstream profile(profilePath);
+        if (!profile)
+        {
+            std::cerr << "could not open " << profilePath << std::endl;
+            return AlethErrors::ArgumentProcessingFailure;
+        }
+        auto count = vm.count("superinstructions-count") ? vm["superinstructions-count"].as<size_t>() : 16;
+        try
+        {
+            // applied by the interpreters when they are created, see EVMC
+            auto bigrams = mostFrequentBigrams(readBigramCounts(profile), count);
+            evmcOptions().emplace_back("superinstruction-bigrams", boost::algorithm::join(bigrams, ","));
+        }
+        catch (std::exception const& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return AlethErrors::ArgumentProcessingFailure;
+        }
+    }
+
+    if (mode == Mode::ToJsonl)
+    {
+        if (!vm.count("input-path"))
+        {
+            std::cerr << "'input-path' should be set to convert a columnar file" << std::endl;
+            return AlethErrors::ArgumentProcessingFailure;
+        }
+        auto outputStreamWrapper = OStreamWrapper(
+            vm.count("output-path") ? vm["output-path"].as<std::string>() : outputPath,
+            std::ios_base::trunc);
+        try
+        {
+            ColumnarReader reader(vm["input-path"].as<std::string>());
+            reader.writeJsonLines(outputStreamWrapper.getStream());
+        }
+        catch (std::exception const& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return AlethErrors::ArgumentProcessingFailure;
+        }
+        return AlethErrors::Success;
+    }
+
+    if (mode == Mode::BenchmarkArithmetic)
+    {
+        // 10 passes over the operands unless --exec-count is given
+        auto repetitions = vm.count("exec-count") ? vm["exec-count"].as<uint64_t>() : 10;
+        auto outputStreamWrapper = OStreamWrapper(
+            vm.count("output-path") ? vm["output-path"].as<std::string>() : outputPath,
+            std::ios_base::trunc);
+        std::vector<ArithmeticBenchmarkResult> results;
+        try
+        {
+            results = benchmarkArithmetic(c_arithmeticOperandsCount, repetitions, seed);
+        }
+        catch (std::invalid_argument const& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return AlethErrors::ArgumentProcessingFailure;
+        }
+        Json::Value root(Json::arrayValue);
+        for (auto const& result : results)
+        {
+            root.append(result.toJson());
+            std::cerr << result.name << ": " << result.boostTime << "ns with boost, "
+                      << result.word256Time << "ns with Word256" << std::endl;
+        }
+        Json::StreamWriterBuilder builder;
+        builder.settings_["indentation"] = "  ";
+        std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+        writer->write(root, &outputStreamWrapper.getStream());
+        outputStreamWrapper.getStream() << std::endl;
+        return AlethErrors::Success;
+    }
+
     if (vm.count("network"))
     {
         string network = vm["network"].as<string>();
@@ -321,6 +494,63 @@ int main(int argc, char** argv)
     }
 
     ChainParams chainParams(genesisInfo(networkName), genesisStateRoot(networkName));
+
+    if (mode == Mode::FitGasCosts)
+    {
+        if (!vm.count("input-path"))
+        {
+            std::cerr << "'input-path' should be set to fit the gas costs" << std::endl;
+            return AlethErrors::ArgumentProcessingFailure;
+        }
+        auto minCount = vm.count("fit-min-count") ? vm["fit-min-count"].as<uint64_t>() : 1;
+        auto outputStreamWrapper = OStreamWrapper(
+            vm.count("output-path") ? vm["output-path"].as<std::string>() : outputPath,
+            std::ios_base::trunc);
+        try
+        {
+            auto samples = loadCostSamples(vm["input-path"].as<std::string>());
+            auto const& schedule = latestSchedule(chainParams);
+            auto model = fitGasCostModel(samples, schedule, minCount);
+
+            Json::Value root = model.toJson();
+            root["schedule"] = scheduleToJson(model.proposeSchedule(schedule));
+            Json::StreamWriterBuilder builder;
+            builder.settings_["indentation"] = "  ";
+            std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+            writer->write(root, &outputStreamWrapper.getStream());
+            outputStreamWrapper.getStream() << std::endl;
+
+            std::cerr << "Fitted " << model.costs.size() << " instructions on "
+                      << model.samplesCount << " transactions (relative error "
+                      << model.relativeError << ", " << model.nanosecondsPerGas
+                      << "ns per gas), most deviating:" << std::endl;
+            for (size_t i = 0; i < model.costs.size() && i < 10 && model.costs[i].priced(); i++)
+            {
+                auto const& cost = model.costs[i];
+                std::cerr << "  " << cost.name << ": " << cost.time << "ns for " << cost.gas
+                          << " gas, proposed " << cost.proposedGas << " gas" << std::endl;
+            }
+        }
+        catch (std::exception const& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return AlethErrors::ArgumentProcessingFailure;
+        }
+        return AlethErrors::Success;
+    }
+    if (vm.count("gas-schedule"))
+    {
+        try
+        {
+            chainParams.customSchedule = loadSchedule(
+                vm["gas-schedule"].as<std::string>(), latestSchedule(chainParams));
+        }
+        catch (std::invalid_argument const& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return AlethErrors::ArgumentProcessingFailure;
+        }
+    }
     WithExisting withExisting = WithExisting::Trust;
     InstructionsBenchmark instructionsBenchmark;
     auto analysisEnv = std::make_shared<AnalysisEnv>(std::cout, std::cout, instructionsBenchmark);
@@ -374,6 +604,9 @@ int main(int argc, char** argv)
     if (vm.count("output-path"))
         outputPath = vm["output-path"].as<std::string>();
 
+    if (vm.count("worker-cores"))
+        workerCores = parseCores(vm["worker-cores"].as<std::string>());
+
     if (vm.count("initial-warmup-count"))
         initialWarmupCount = vm["initial-warmup-count"].as<uint16_t>();
     if (vm.count("no-warmup"))
@@ -388,6 +621,46 @@ int main(int argc, char** argv)
         requireRoot("must be root to drop caches");
         alwaysDropCache = true;
     }
+    if (vm.count("hardware-counters"))
+    {
+        HardwareCounterCollector::checkAvailable();
+        hardwareCounters = true;
+    }
+    if (vm.count("target-median-width"))
+    {
+        targetMedianWidth = vm["target-median-width"].as<double>();
+        maxExecCount = 10 * execCount;
+    }
+    if (vm.count("max-exec-count"))
+        maxExecCount = vm["max-exec-count"].as<uint64_t>();
+    if (vm.count("vms"))
+    {
+        boost::split(vms, vm["vms"].as<std::string>(), boost::is_any_of(","));
+        vms.erase(std::remove(vms.begin(), vms.end(), ""), vms.end());
+        try
+        {
+            // fail early if a VM cannot be loaded
+            for (const auto& vmName : vms)
+                VMFactory::create(vmName);
+        }
+        catch (const std::exception& e)
+        {
+            std::cerr << "invalid VM: " << e.what() << std::endl;
+            return AlethErrors::ArgumentProcessingFailure;
+        }
+    }
+    if (vm.count("vm-aggregation"))
+    {
+        try
+        {
+            vmAggregation = parseVMAggregation(vm["vm-aggregation"].as<std::string>());
+        }
+        catch (const std::invalid_argument& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return AlethErrors::UnknownArgument;
+        }
+    }
     if (vm.count("population-size"))
         populationSize = vm["population-size"].as<uint32_t>();
     if (vm.count("init-program-size"))
@@ -402,12 +675,66 @@ int main(int argc, char** argv)
         mutationsCount = vm["mutations-count"].as<uint32_t>();
     if (vm.count("cache-results"))
         cacheResults = true;
+    if (vm.count("fitness-cache-path"))
+    {
+        fitnessCachePath = vm["fitness-cache-path"].as<std::string>();
+        cacheResults = true;
+    }
     if (vm.count("elite-ratio"))
         eliteRatio = vm["elite-ratio"].as<double>();
     if (vm.count("tournament-selection-p"))
         tournamentSelectionProb = vm["tournament-selection-p"].as<double>();
     if (vm.count("tournament-selection-ratio"))
         tournamentSelectionRatio = vm["tournament-selection-ratio"].as<double>();
+    if (vm.count("objectives"))
+    {
+        std::vector<std::string> objectiveNames;
+        boost::split(objectiveNames, vm["objectives"].as<std::string>(), boost::is_any_of(","));
+        try
+        {
+            for (auto& objectiveName : objectiveNames)
+            {
+                objectives.push_back(Objective::parse(objectiveName));
+            }
+        }
+        catch (const std::invalid_argument& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return AlethErrors::ArgumentProcessingFailure;
+        }
+    }
+    if (vm.count("checkpoint-path"))
+        checkpointPath = vm["checkpoint-path"].as<std::string>();
+    if (vm.count("checkpoint-interval"))
+        checkpointInterval = vm["checkpoint-interval"].as<uint32_t>();
+    if (vm.count("columnar-output"))
+        columnarOutputPath = vm["columnar-output"].as<std::string>();
+    if (vm.count("resume"))
+    {
+        resumePath = vm["resume"].as<std::string>();
+        if (checkpointPath.empty())
+            checkpointPath = resumePath;
+    }
+    if (vm.count("islands"))
+        islandsCount = vm["islands"].as<uint32_t>();
+    if (vm.count("island-topology"))
+    {
+        try
+        {
+            islandTopology = IslandModel::parseTopology(vm["island-topology"].as<std::string>());
+        }
+        catch (const std::invalid_argument& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return AlethErrors::UnknownArgument;
+        }
+    }
+    if (vm.count("migration-interval"))
+        migrationInterval = vm["migration-interval"].as<uint32_t>();
+    if (vm.count("migrants-count"))
+        migrantsCount = vm["migrants-count"].as<uint32_t>();
+    if (vm.count("island-cores"))
+        islandCores = parseCores(vm["island-cores"].as<std::string>());
     if (vm.count("target-metric"))
     {
         std::string targetMetricName = vm["target-metric"].as<std::string>();
@@ -419,9 +746,11 @@ int main(int argc, char** argv)
             targetMetric = GeneticEngine::Metric::TimeMean;
         else if (targetMetricName == "time-median" )
             targetMetric = GeneticEngine::Metric::TimeMedian;
+        else if (targetMetricName == "cycles-per-gas" )
+            targetMetric = GeneticEngine::Metric::CyclesPerGas;
         else
         {
-            std::cerr << "target-metric should be 'throughput-mean', 'throughput-median', 'time-mean' or 'time-median', got '" << targetMetricName << "'" << std::endl;
+            std::cerr << "target-metric should be 'throughput-mean', 'throughput-median', 'time-mean', 'time-median' or 'cycles-per-gas', got '" << targetMetricName << "'" << std::endl;
             return AlethErrors::UnknownArgument;
         }
     }
@@ -461,9 +790,21 @@ int main(int argc, char** argv)
 
         auto outputStreamWrapper = OStreamWrapper(outputPath, std::ios_base::trunc);
         BenchmarkConfig benchmarkConfig(execCount, debug, initialWarmupCount, warmup, dropCache, alwaysDropCache);
+        benchmarkConfig.hardwareCounters = hardwareCounters;
+        benchmarkConfig.targetMedianWidth = targetMedianWidth;
+        benchmarkConfig.maxExecCount = maxExecCount;
+        benchmarkConfig.vms = vms;
+        benchmarkConfig.vmAggregation = vmAggregation;
         auto blockNumber = originalBlockHeader.number();
 
-        if (initialWarmupCount > 0)
+        std::unique_ptr<BenchmarkWorkerPool> workerPool;
+        if (!workerCores.empty())
+        {
+            auto calibrationProgram = ProgramGenerator(seed).generateInitialProgram(initialProgramSize);
+            workerPool = std::unique_ptr<BenchmarkWorkerPool>(new BenchmarkWorkerPool(
+                execEnv, benchmarkConfig, workerCores, calibrationProgram.toBytes()));
+        }
+        else if (initialWarmupCount > 0)
         {
             runInitialWarmup(programGenerator, execEnv, benchmarkConfig, initialProgramSize,
                 populationSize, initialWarmupCount);
@@ -473,7 +814,9 @@ int main(int argc, char** argv)
         {
             for (auto& programs : blocks)
             {
-                auto results = benchmarkCodes(execEnv, programs, benchmarkConfig);
+                auto results = workerPool != nullptr ?
+                                   workerPool->benchmarkCodes(programs) :
+                                   benchmarkCodes(execEnv, programs, benchmarkConfig);
                 auto jsonResults = results.toJson(true);
                 jsonResults["blockNumber"] = blockNumber;
                 jsonResults["execNumber"] = i;
@@ -486,6 +829,11 @@ int main(int argc, char** argv)
     {
         GeneticEngine::TournamentSelectionConfig tournamentConfig(tournamentSelectionRatio, tournamentSelectionProb);
         BenchmarkConfig benchmarkConfig(execCount, debug, initialWarmupCount, warmup, dropCache);
+        benchmarkConfig.hardwareCounters = hardwareCounters;
+        benchmarkConfig.targetMedianWidth = targetMedianWidth;
+        benchmarkConfig.maxExecCount = maxExecCount;
+        benchmarkConfig.vms = vms;
+        benchmarkConfig.vmAggregation = vmAggregation;
         GeneticEngine::Config config{
             .populationSize = populationSize,
             .initialProgramSize = initialProgramSize,
@@ -501,13 +849,70 @@ int main(int argc, char** argv)
             .seed = seed,
             .targetMetric = targetMetric,
             .benchmarkConfig = benchmarkConfig,
+            .workerCores = workerCores,
+            .fitnessCachePath = fitnessCachePath,
+            .objectives = objectives,
+            .checkpointPath = checkpointPath,
+            .checkpointInterval = checkpointInterval,
+            .columnarOutputPath = columnarOutputPath,
         };
 
+        if (islandsCount > 1 && !checkpointPath.empty())
+        {
+            std::cerr << "checkpoints are not supported with several islands" << std::endl;
+            return AlethErrors::ArgumentProcessingFailure;
+        }
+
         auto statStreamWrapper = OStreamWrapper(outputPath);
 
-        GeneticEngine geneticEngine(config, programGenerator, statStreamWrapper.getStream());
-        std::cerr << "Running for " << config.generationsCount << " generations" << std::endl;
-        geneticEngine.run();
+        if (islandsCount > 1)
+        {
+            IslandModel::Config islandConfig{
+                .islandsCount = islandsCount,
+                .topology = islandTopology,
+                .migrationInterval = migrationInterval,
+                .migrantsCount = migrantsCount,
+                .cores = islandCores,
+            };
+            IslandModel islandModel(
+                islandConfig, config, instructionsMetadata, statStreamWrapper.getStream());
+            std::cerr << "Running " << islandsCount << " islands for " << config.generationsCount
+                      << " generations" << std::endl;
+            islandModel.run();
+        }
+        else
+        {
+            GeneticEngine geneticEngine(config, programGenerator, statStreamWrapper.getStream());
+            if (!resumePath.empty())
+            {
+                geneticEngine.resume(resumePath);
+                std::cerr << "Resuming after generation " << geneticEngine.generation()
+                          << std::endl;
+            }
+            std::cerr << "Running for " << config.generationsCount << " generations" << std::endl;
+            geneticEngine.run();
+        }
+    }
+    else if (mode == Mode::Replay)
+    {
+        replayConfig.lastBlock =
+            vm.count("last-block") ? vm["last-block"].as<uint64_t>() : replayConfig.firstBlock;
+        replayConfig.dropCaches = alwaysDropCache;
+        if (replayConfig.core < 0)
+            replayConfig.core = sched_getcpu();
+        analysisEnv->setHardwareCounters(hardwareCounters);
+
+        auto outputStreamWrapper = OStreamWrapper(outputPath, std::ios_base::trunc);
+        try
+        {
+            replayBlocks(*blockchain, stateDB, analysisEnv, replayConfig,
+                outputStreamWrapper.getStream());
+        }
+        catch (std::invalid_argument const& e)
+        {
+            std::cerr << e.what() << std::endl;
+            return AlethErrors::ArgumentProcessingFailure;
+        }
     }
     else if (mode == Mode::BenchmarkCache)
     {
@@ -536,6 +941,12 @@ int main(int argc, char** argv)
             BenchmarkConfig(execCount, debug, initialWarmupCount, warmup, dropCache, false);
         auto withoutCacheConfig =
             BenchmarkConfig(execCount, debug, initialWarmupCount, warmup, dropCache, true);
+        withCacheConfig.hardwareCounters = hardwareCounters;
+        withoutCacheConfig.hardwareCounters = hardwareCounters;
+        withCacheConfig.targetMedianWidth = withoutCacheConfig.targetMedianWidth = targetMedianWidth;
+        withCacheConfig.maxExecCount = withoutCacheConfig.maxExecCount = maxExecCount;
+        withCacheConfig.vms = withoutCacheConfig.vms = vms;
+        withCacheConfig.vmAggregation = withoutCacheConfig.vmAggregation = vmAggregation;
         for (size_t i = 0; i < programs.size(); i++)
         {
             const auto& program = programs[i];
@@ -14,7 +14,9 @@
 #include <boost/program_options/options_description.hpp>
 
 #ifdef ETH_MEASURE_GAS
+#include <libethereum/Executive.h>
 #include <libevmanalysis/AnalysisEnv.h>
+#include <libevmanalysis/HardwareCounterCollector.h>
 #include <libevmanalysis/StreamWrapper.h>
 #endif
 
@@ -192,8 +194,19 @@ int main(int argc, char** argv)
 
     std::string measureGasPath("gas-measurements.jsonl.gz");
     std::string benchmarkPath("benchmark.jsonl");
-    uint64_t benchmarkGranularity = 1000;
     uint64_t benchmarkBlocksInterval = 100;
+    bool hardwareCounters = false;
+    ColumnarCodec measureGasCodec = ColumnarCodec::Snappy;
+    size_t statQueueSize = 4096;
+    StatQueueOverflow statQueueOverflow = StatQueueOverflow::Block;
+    InstructionSampling instructionSampling;
+    std::string basicBlocksPath;
+    std::string costModelPath;
+    uint64_t basicBlocksGranularity = 100;
+    std::string hotSpotsPath;
+    size_t hotSpotsCapacity = 10000;
+    int64_t hotSpotsBlocksInterval = 1000;
+    bool storageAccesses = false;
 #endif
 
     strings passwordsToNote;
@@ -364,13 +377,49 @@ int main(int argc, char** argv)
     po::options_description analysisOptions("ANALYSIS OPTIONS", c_lineWidth);
     auto addAnalysisOptions = analysisOptions.add_options();
     addAnalysisOptions("gas-measurements-file", po::value<string>()->value_name("<path>"),
-        ("file to output gas measurements"));
+        ("file to output gas measurements (written in the columnar format with a .col extension)"));
+    addAnalysisOptions("gas-measurements-codec", po::value<string>()->value_name("<codec>"),
+        ("compression of the columnar gas measurements ('snappy' or 'none', default: snappy)"));
     addAnalysisOptions("benchmark-file", po::value<string>()->value_name("<path>"),
         ("file to output benchmark results"));
-    addAnalysisOptions("benchmark-granularity", po::value<uint64_t>()->value_name("<n>"),
-        ("granularity for the benchmark (<n> measurements aggregated)"));
     addAnalysisOptions("benchmark-blocks-interval", po::value<int64_t>()->value_name("<n>"),
         ("print results every <n> blocks"));
+    addAnalysisOptions("benchmark-sampling-interval",
+        po::value<uint64_t>(&instructionSampling.interval)->value_name("<n>"),
+        ("time one instruction out of <n> (default: 1)"));
+    addAnalysisOptions("benchmark-sampling-random",
+        po::bool_switch(&instructionSampling.randomized),
+        ("draw the interval between two timed instructions at random, <n> on average"));
+    addAnalysisOptions("basic-blocks-file",
+        po::value<string>(&basicBlocksPath)->value_name("<path>"),
+        ("time basic blocks instead of single instructions and output their durations to <path>"));
+    addAnalysisOptions("basic-blocks-granularity",
+        po::value<uint64_t>(&basicBlocksGranularity)->value_name("<n>"),
+        ("executions of a basic block averaged in a measurement (default: 100)"));
+    addAnalysisOptions("cost-model-file",
+        po::value<string>(&costModelPath)->value_name("<path>"),
+        ("output the instruction costs fitted from the basic blocks durations to <path>, "
+         "usable as metadata by aleth-vm-instr"));
+    addAnalysisOptions("hot-spots-file", po::value<string>(&hotSpotsPath)->value_name("<path>"),
+        ("profile the time spent at each code location, written to <path> as folded stacks "
+         "(for flamegraph.pl) and to <path>.json as a ranking with the time per gas"));
+    addAnalysisOptions("hot-spots-capacity",
+        po::value<size_t>(&hotSpotsCapacity)->value_name("<n>"),
+        ("code locations tracked by the hot spots profile (default: 10000)"));
+    addAnalysisOptions("hot-spots-blocks-interval",
+        po::value<int64_t>(&hotSpotsBlocksInterval)->value_name("<n>"),
+        ("write the hot spots profile every <n> blocks (default: 1000)"));
+    addAnalysisOptions("storage-accesses", po::bool_switch(&storageAccesses),
+        ("classify the state accesses of SLOAD, SSTORE, BALANCE and EXTCODE* by the layer "
+         "answering them (state cache, OverlayDB memory or database) and add their time to the "
+         "benchmark results"));
+    addAnalysisOptions("hardware-counters",
+        "output CPU cycles, cache, branch and TLB misses of each transaction (uses perf_event_open)");
+    addAnalysisOptions("stat-queue-size", po::value<size_t>()->value_name("<n>"),
+        ("measurements queued for the writer thread, 0 writes them synchronously (default: 4096)"));
+    addAnalysisOptions("stat-queue-overflow", po::value<string>()->value_name("<policy>"),
+        ("when the writer thread falls behind, 'block' the import or 'drop' the measurements "
+         "(default: block)"));
 #endif
 
     po::options_description generalOptions("GENERAL OPTIONS", c_lineWidth);
@@ -745,10 +794,47 @@ int main(int argc, char** argv)
         measureGasPath = vm["gas-measurements-file"].as<string>();
     if (vm.count("benchmark-file"))
         benchmarkPath = vm["benchmark-file"].as<string>();
-    if (vm.count("benchmark-granularity"))
-        benchmarkGranularity = vm["benchmark-granularity"].as<uint64_t>();
     if (vm.count("benchmark-blocks-interval"))
         benchmarkBlocksInterval = vm["benchmark-blocks-interval"].as<int64_t>();
+    if (vm.count("hardware-counters"))
+    {
+        try
+        {
+            HardwareCounterCollector::checkAvailable();
+        }
+        catch (std::runtime_error const& e)
+        {
+            cerr << "--hardware-counters: " << e.what() << "\n";
+            return AlethErrors::ArgumentProcessingFailure;
+        }
+        hardwareCounters = true;
+    }
+    if (vm.count("gas-measurements-codec"))
+    {
+        try
+        {
+            measureGasCodec = parseColumnarCodec(vm["gas-measurements-codec"].as<string>());
+        }
+        catch (std::invalid_argument const& e)
+        {
+            cerr << e.what() << "\n";
+            return AlethErrors::ArgumentProcessingFailure;
+        }
+    }
+    if (vm.count("stat-queue-size"))
+        statQueueSize = vm["stat-queue-size"].as<size_t>();
+    if (vm.count("stat-queue-overflow"))
+    {
+        try
+        {
+            statQueueOverflow = parseStatQueueOverflow(vm["stat-queue-overflow"].as<string>());
+        }
+        catch (std::invalid_argument const& e)
+        {
+            cerr << e.what() << "\n";
+            return AlethErrors::ArgumentProcessingFailure;
+        }
+    }
 #endif
 
     setupLogging(loggingOptions);
@@ -823,12 +909,51 @@ int main(int argc, char** argv)
         chainParams.minimumDifficulty = minimumDifficulty;
     chainParams.sealEngineName = sealEngineName;
 
-    auto statStreamWrapper = OStreamWrapper(measureGasPath);
+    // the stat stream is not used when the measurements are written in the columnar format
+    auto statStreamWrapper = OStreamWrapper(isColumnarPath(measureGasPath) ? "-" : measureGasPath);
     auto benchmarkStreamWrapper = OStreamWrapper(benchmarkPath);
-    InstructionsBenchmark instructionsBenchmark(benchmarkGranularity);
+    InstructionsBenchmark instructionsBenchmark;
 
     auto analysisEnv = std::make_shared<AnalysisEnv>(statStreamWrapper.getStream(),
         benchmarkStreamWrapper.getStream(), instructionsBenchmark, benchmarkBlocksInterval);
+    analysisEnv->setHardwareCounters(hardwareCounters);
+    analysisEnv->setStorageAccessTracking(storageAccesses);
+    if (isColumnarPath(measureGasPath))
+    {
+        analysisEnv->setColumnarOutput(
+            std::make_shared<ColumnarWriter>(measureGasPath, measureGasCodec));
+    }
+    if (statQueueSize > 0)
+        analysisEnv->setAsyncOutput(statQueueSize, statQueueOverflow);
+    if (instructionSampling.interval == 0)
+    {
+        cerr << "The benchmark sampling interval must be at least 1\n";
+        return AlethErrors::ArgumentProcessingFailure;
+    }
+    instructionSampling.probeOverheadCycles = Executive::measureProbeOverhead();
+    cnote << "Instruction probes overhead: " << instructionSampling.probeOverheadCycles
+          << " cycles (" << CycleClock::nanosecondsPerCycle() << " ns/cycle)";
+    analysisEnv->setInstructionSampling(instructionSampling);
+    if (!basicBlocksPath.empty() || !costModelPath.empty())
+    {
+        analysisEnv->setBasicBlockProfile(
+            std::make_shared<BasicBlockProfile>(std::max<uint64_t>(basicBlocksGranularity, 1)));
+    }
+    if (!hotSpotsPath.empty())
+    {
+        if (!basicBlocksPath.empty() || !costModelPath.empty())
+        {
+            cerr << "The hot spots and the basic blocks cannot be profiled together\n";
+            return AlethErrors::ArgumentProcessingFailure;
+        }
+        if (hotSpotsCapacity == 0 || hotSpotsBlocksInterval <= 0)
+        {
+            cerr << "The hot spots capacity and blocks interval must be at least 1\n";
+            return AlethErrors::ArgumentProcessingFailure;
+        }
+        analysisEnv->setHotSpotProfiler(std::make_shared<HotSpotProfiler>(hotSpotsCapacity),
+            hotSpotsPath, hotSpotsBlocksInterval);
+    }
 
     dev::WebThreeDirect web3(WebThreeDirect::composeClientVersion("aleth"), db::databasePath(),
         snapshotPath, chainParams, withExisting, netPrefs, &nodesState, testingMode, analysisEnv);
@@ -1127,6 +1252,8 @@ int main(int argc, char** argv)
 
 #ifdef ETH_MEASURE_GAS
     analysisEnv->outputInstructionsBenchmark(c.blockChain().number(), true);
+    analysisEnv->outputBasicBlocks(basicBlocksPath, costModelPath);
+    analysisEnv->outputHotSpots(c.blockChain().number(), true);
 #endif
 
     return AlethErrors::Success;
@@ -20,6 +20,8 @@
 
 #include <aleth/buildinfo.h>
 
+#include <cstring>
+
 namespace
 {
 void destroy(evmc_instance* _instance)
@@ -105,9 +107,63 @@ evmc_result execute(evmc_instance* _instance, evmc_context* _context, evmc_revis
         result.output_size = output.size();
         result.release = delete_output;
     }
+    // the memory of the frame, holding the output, goes back to the arena
+    dev::ExecutionArena::threadArena().releaseMemory(output.takeBytes());
 
     return result;
 }
+
+evmc_set_option_result setOption(
+    evmc_instance* _instance, char const* _name, char const* _value) noexcept
+{
+    (void)_instance;
+    if (std::strcmp(_name, "superinstructions") == 0)
+    {
+        try
+        {
+            return dev::eth::VM::setSuperinstructions(_value) ? EVMC_SET_OPTION_SUCCESS :
+                                                                  EVMC_SET_OPTION_INVALID_VALUE;
+        }
+        catch (std::exception const&)
+        {
+            return EVMC_SET_OPTION_INVALID_VALUE;
+        }
+    }
+    if (std::strcmp(_name, "superinstruction-bigrams") == 0)
+    {
+        try
+        {
+            dev::eth::VM::setSuperinstructionsFromBigrams(_value);
+            return EVMC_SET_OPTION_SUCCESS;
+        }
+        catch (std::exception const&)
+        {
+            return EVMC_SET_OPTION_INVALID_VALUE;
+        }
+    }
+    if (std::strcmp(_name, "block-checks") == 0)
+    {
+        if (std::strcmp(_value, "on") != 0 && std::strcmp(_value, "off") != 0)
+            return EVMC_SET_OPTION_INVALID_VALUE;
+        dev::eth::VM::setBlockChecks(std::strcmp(_value, "on") == 0);
+        return EVMC_SET_OPTION_SUCCESS;
+    }
+    if (std::strcmp(_name, "analysis-cache-size") != 0)
+        return EVMC_SET_OPTION_INVALID_NAME;
+    try
+    {
+        size_t end = 0;
+        auto size = std::stoull(_value, &end);
+        if (_value[end] != '\0')
+            return EVMC_SET_OPTION_INVALID_VALUE;
+        dev::eth::VM::analysisCache().setCapacity(size);
+        return EVMC_SET_OPTION_SUCCESS;
+    }
+    catch (std::exception const&)
+    {
+        return EVMC_SET_OPTION_INVALID_VALUE;
+    }
+}
 }  // namespace
 
 extern "C" evmc_instance* evmc_create_interpreter() noexcept
@@ -121,7 +177,7 @@ extern "C" evmc_instance* evmc_create_interpreter() noexcept
         ::execute,
         getCapabilities,
         nullptr,  // set_tracer
-        nullptr,  // set_option
+        setOption,
     };
     return &s_instance;
 }
@@ -131,6 +187,13 @@ namespace dev
 {
 namespace eth
 {
+VM::~VM()
+{
+    assert(&m_arena == &ExecutionArena::threadArena() && "destroyed on another thread");
+    m_arena.releaseMemory(std::move(m_mem));
+    m_arena.releaseStack(m_stack);
+}
+
 uint64_t VM::memNeed(u256 const& _offset, u256 const& _size)
 {
     return toInt63(_size ? u512(_offset) + _size : u512(0));
@@ -225,7 +288,7 @@ void VM::updateMem(uint64_t _newMem)
     m_newMemSize = (_newMem + 31) / 32 * 32;
     updateGas();
     if (m_newMemSize > m_mem.size())
-        m_mem.resize(m_newMemSize);
+        m_arena.growMemory(m_mem, m_newMemSize);
 }
 
 void VM::logGasMem()
@@ -237,14 +300,46 @@ void VM::logGasMem()
     updateMem(memNeed(m_SP[0], m_SP[1]));
 }
 
+//
+// charge the gas of the block beginning at the program counter and check its stack bounds,
+// false if they would fail: its instructions are then checked one at a time
+//
+bool VM::enterBlock()
+{
+    auto const& block = m_analysis->blocks[m_blockAt[m_PC] - 1];
+    auto const height = m_stackEnd - m_SPP;
+    if (m_io_gas < block.gas || height < block.stackRequired ||
+        height + block.stackGrowth > VMSchedule::stackLimit)
+    {
+        m_blockSize = 0;
+        return false;
+    }
+
+    m_io_gas -= block.gas;
+    // the range excludes the entry: a jump back to it enters the block again
+    m_blockBegin = block.begin + 1;
+    m_blockSize = block.end - m_blockBegin;
+    return true;
+}
+
 void VM::fetchInstruction()
 {
     m_OP = Instruction(m_code[m_PC]);
     auto const metric = c_metrics[static_cast<size_t>(m_OP)];
-    adjustStack(metric.num_stack_arguments, metric.num_stack_returned_items);
+    if (m_PC - m_blockBegin < m_blockSize || (m_blockAt && m_blockAt[m_PC] && enterBlock()))
+    {
+        // the gas and the stack bounds were checked at the entry of the block
+        m_SP = m_SPP;
+        m_SPP += metric.num_stack_arguments - metric.num_stack_returned_items;
+        m_runGas = 0;
+    }
+    else
+    {
+        adjustStack(metric.num_stack_arguments, metric.num_stack_returned_items);
 
-    // FEES...
-    m_runGas = metric.gas_cost;
+        // FEES...
+        m_runGas = metric.gas_cost;
+    }
     m_newMemSize = m_mem.size();
     m_copyMemSize = 0;
 }
@@ -340,6 +435,7 @@ void VM::interpretCases()
 
             uint64_t b = (uint64_t)m_SP[0];
             uint64_t s = (uint64_t)m_SP[1];
+            // the memory goes back to the arena once the caller consumed the output
             m_output = owning_bytes_ref{std::move(m_mem), b, s};
             m_bounce = 0;
         }
@@ -570,7 +666,7 @@ void VM::interpretCases()
             updateIOGas();
 
             //pops two items and pushes their sum mod 2^256.
-            m_SPP[0] = m_SP[0] + m_SP[1];
+            m_SPP[0] = (Word256(m_SP[0]) + Word256(m_SP[1])).toU256();
         }
         NEXT
 
@@ -580,7 +676,7 @@ void VM::interpretCases()
             updateIOGas();
 
             //pops two items and pushes their product mod 2^256.
-            m_SPP[0] = m_SP[0] * m_SP[1];
+            m_SPP[0] = (Word256(m_SP[0]) * Word256(m_SP[1])).toU256();
         }
         NEXT
 
@@ -589,7 +685,7 @@ void VM::interpretCases()
             ON_OP();
             updateIOGas();
 
-            m_SPP[0] = m_SP[0] - m_SP[1];
+            m_SPP[0] = (Word256(m_SP[0]) - Word256(m_SP[1])).toU256();
         }
         NEXT
 
@@ -598,7 +694,15 @@ void VM::interpretCases()
             ON_OP();
             updateIOGas();
 
-            m_SPP[0] = m_SP[1] ? divWorkaround(m_SP[0], m_SP[1]) : 0;
+            Word256 divisor(m_SP[1]);
+            if (divisor.isZero())
+                m_SPP[0] = 0;
+            else
+            {
+                Word256 quotient, remainder;
+                divRem(Word256(m_SP[0]), divisor, quotient, remainder);
+                m_SPP[0] = quotient.toU256();
+            }
         }
         NEXT
 
@@ -617,7 +721,15 @@ void VM::interpretCases()
             ON_OP();
             updateIOGas();
 
-            m_SPP[0] = m_SP[1] ? modWorkaround(m_SP[0], m_SP[1]) : 0;
+            Word256 divisor(m_SP[1]);
+            if (divisor.isZero())
+                m_SPP[0] = 0;
+            else
+            {
+                Word256 quotient, remainder;
+                divRem(Word256(m_SP[0]), divisor, quotient, remainder);
+                m_SPP[0] = remainder.toU256();
+            }
         }
         NEXT
 
@@ -662,7 +774,7 @@ void VM::interpretCases()
             ON_OP();
             updateIOGas();
 
-            m_SPP[0] = u2s(m_SP[0]) < u2s(m_SP[1]) ? 1 : 0;
+            m_SPP[0] = slt(Word256(m_SP[0]), Word256(m_SP[1])) ? 1 : 0;
         }
         NEXT
 
@@ -671,7 +783,7 @@ void VM::interpretCases()
             ON_OP();
             updateIOGas();
 
-            m_SPP[0] = u2s(m_SP[0]) > u2s(m_SP[1]) ? 1 : 0;
+            m_SPP[0] = slt(Word256(m_SP[1]), Word256(m_SP[0])) ? 1 : 0;
         }
         NEXT
 
@@ -738,10 +850,7 @@ void VM::interpretCases()
             ON_OP();
             updateIOGas();
 
-            if (m_SP[0] >= 256)
-                m_SPP[0] = 0;
-            else
-                m_SPP[0] = m_SP[1] << unsigned(m_SP[0]);
+            m_SPP[0] = (Word256(m_SP[1]) << Word256(m_SP[0]).shiftAmount()).toU256();
         }
         NEXT
 
@@ -770,25 +879,7 @@ void VM::interpretCases()
             ON_OP();
             updateIOGas();
 
-            static u256 const hibit = u256(1) << 255;
-            static u256 const allbits =
-                u256("0xffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffffff");
-
-            u256 shiftee = m_SP[1];
-            if (m_SP[0] >= 256)
-            {
-                if (shiftee & hibit)
-                    m_SPP[0] = allbits;
-                else
-                    m_SPP[0] = 0;
-            }
-            else
-            {
-                unsigned amount = unsigned(m_SP[0]);
-                m_SPP[0] = shiftee >> amount;
-                if (shiftee & hibit)
-                    m_SPP[0] |= allbits << (256 - amount);
-            }
+            m_SPP[0] = sar(Word256(m_SP[1]), Word256(m_SP[0]).shiftAmount()).toU256();
         }
         NEXT
 
@@ -797,7 +888,11 @@ void VM::interpretCases()
             ON_OP();
             updateIOGas();
 
-            m_SPP[0] = m_SP[2] ? u256((u512(m_SP[0]) + u512(m_SP[1])) % m_SP[2]) : 0;
+            Word256 modulus(m_SP[2]);
+            if (modulus.isZero())
+                m_SPP[0] = 0;
+            else
+                m_SPP[0] = addMod(Word256(m_SP[0]), Word256(m_SP[1]), modulus).toU256();
         }
         NEXT
 
@@ -806,7 +901,11 @@ void VM::interpretCases()
             ON_OP();
             updateIOGas();
 
-            m_SPP[0] = m_SP[2] ? u256((u512(m_SP[0]) * u512(m_SP[1])) % m_SP[2]) : 0;
+            Word256 modulus(m_SP[2]);
+            if (modulus.isZero())
+                m_SPP[0] = 0;
+            else
+                m_SPP[0] = mulMod(Word256(m_SP[0]), Word256(m_SP[1]), modulus).toU256();
         }
         NEXT
 
@@ -1166,7 +1265,7 @@ void VM::interpretCases()
             off = m_code[m_PC++] << 8;
             off |= m_code[m_PC++];
             m_PC += m_code[m_PC];
-            m_SPP[0] = m_pool[off];
+            m_SPP[0] = m_analysis->pool[off];
             TRACE_VAL(2, "Retrieved pooled const", m_SPP[0]);
 #else
             throwBadInstruction();
@@ -1277,6 +1376,92 @@ void VM::interpretCases()
         }
         CONTINUE
 
+        //
+        // superinstructions, see VM::fuse: the first instruction of a pair is executed as
+        // usual, the second one is dispatched directly
+        //
+
+        FUSED_CASE(PUSH1ADD)
+        {
+            ON_OP();
+            updateIOGas();
+            m_SPP[0] = m_code[m_PC + 1];
+            m_PC += 2;
+        }
+        CONTINUE_AT(ADD)
+
+        FUSED_CASE(PUSH1MLOAD)
+        {
+            ON_OP();
+            updateIOGas();
+            m_SPP[0] = m_code[m_PC + 1];
+            m_PC += 2;
+        }
+        CONTINUE_AT(MLOAD)
+
+        FUSED_CASE(PUSH1MSTORE)
+        {
+            ON_OP();
+            updateIOGas();
+            m_SPP[0] = m_code[m_PC + 1];
+            m_PC += 2;
+        }
+        CONTINUE_AT(MSTORE)
+
+        // the jumps to constant destinations are pre-verified by the first pass if enabled,
+        // see c_superinstructions
+        FUSED_CASE(PUSH2JUMP)
+        {
+            ON_OP();
+            updateIOGas();
+            m_SPP[0] = (m_code[m_PC + 1] << 8) | m_code[m_PC + 2];
+            m_PC += 3;
+        }
+#if EVM_REPLACE_CONST_JUMP
+        CONTINUE_AT(JUMPC)
+#else
+        CONTINUE_AT(JUMP)
+#endif
+
+        FUSED_CASE(PUSH2JUMPI)
+        {
+            ON_OP();
+            updateIOGas();
+            m_SPP[0] = (m_code[m_PC + 1] << 8) | m_code[m_PC + 2];
+            m_PC += 3;
+        }
+#if EVM_REPLACE_CONST_JUMP
+        CONTINUE_AT(JUMPCI)
+#else
+        CONTINUE_AT(JUMPI)
+#endif
+
+        FUSED_CASE(SWAP1POP)
+        {
+            ON_OP();
+            updateIOGas();
+            std::swap(m_SP[0], m_SP[1]);
+            ++m_PC;
+        }
+        CONTINUE_AT(POP)
+
+        FUSED_CASE(POPPOP)
+        {
+            ON_OP();
+            updateIOGas();
+            ++m_PC;
+        }
+        CONTINUE_AT(POP)
+
+        FUSED_CASE(ISZEROPUSH2)
+        {
+            ON_OP();
+            updateIOGas();
+            m_SPP[0] = m_SP[0] ? 0 : 1;
+            ++m_PC;
+        }
+        CONTINUE_AT(PUSH2)
+
         CASE(DUP1)
         CASE(DUP2)
         CASE(DUP3)
@@ -1402,7 +1587,6 @@ void VM::interpretCases()
 
         CASE(JUMPDEST)
         {
-            m_runGas = VMSchedule::jumpdestGas;
             ON_OP();
             updateIOGas();
         }
@@ -19,6 +19,9 @@
 
 #include "VMConfig.h"
 
+#include <libdevcore/CodeAnalysisCache.h>
+#include <libdevcore/ExecutionArena.h>
+#include <libdevcore/Word256.h>
 #include <libevm/VMFace.h>
 
 #include <evmc/evmc.h>
@@ -26,6 +29,8 @@
 
 #include <boost/optional.hpp>
 
+#include <atomic>
+
 namespace dev
 {
 namespace eth
@@ -60,15 +65,50 @@ struct VMSchedule
     static constexpr int64_t callNewAccount = 25000;
 };
 
+/// Opcodes of the superinstructions, internal to the interpreter, see VM::fuse. They take bytes
+/// unassigned in the EVM, turned into INVALID when found in the executed code.
+enum class FusedInstruction : uint8_t
+{
+    PUSH1ADD = 0xa5,  ///< PUSH1 followed by ADD
+    PUSH1MLOAD,       ///< PUSH1 followed by MLOAD
+    PUSH1MSTORE,      ///< PUSH1 followed by MSTORE
+    PUSH2JUMP,        ///< PUSH2 followed by JUMP (JUMPC when constant jumps are replaced)
+    PUSH2JUMPI,       ///< PUSH2 followed by JUMPI (JUMPCI when constant jumps are replaced)
+    SWAP1POP,         ///< SWAP1 followed by POP
+    POPPOP,           ///< POP followed by POP
+    ISZEROPUSH2 = 0xaf,  ///< ISZERO followed by PUSH2
+};
+
 class VM
 {
 public:
     VM() = default;
+    ~VM();
 
     owning_bytes_ref exec(evmc_context* _context, evmc_revision _rev, const evmc_message* _msg,
         uint8_t const* _code, size_t _codeSize);
 
     uint64_t m_io_gas = 0;
+
+    /// Analyses of the codes executed by the interpreters of the process
+    static CodeAnalysisCache& analysisCache();
+
+    /// Enables the superinstructions named in the comma-separated @a _names (e.g.
+    /// "PUSH1ADD,SWAP1POP"), all of them with "all" and none with "none" or "". Returns false,
+    /// keeping the current ones, if a name is unknown.
+    static bool setSuperinstructions(std::string const& _names);
+
+    /// Enables the superinstructions fusing the pairs among the comma-separated bigrams
+    /// @a _bigrams (e.g. "PUSH1 ADD,DUP1 PUSH1,SWAP1 POP"), the most frequent ones of a profile
+    /// of the instructions executed, see InstructionStats. The superinstructions are a fixed
+    /// set: the profile selects among them, the bigrams of the other pairs are ignored.
+    static void setSuperinstructionsFromBigrams(std::string const& _bigrams);
+
+    /// Enables or disables the checks of the gas and of the stack bounds once per block of
+    /// instructions of static costs rather than once per instruction. Disabled by default until
+    /// the VM and State tests pass with `--vm interpreter --evmc block-checks=on`.
+    static void setBlockChecks(bool _enabled);
+
 private:
     evmc_context* m_context = nullptr;
     evmc_revision m_rev = EVMC_FRONTIER;
@@ -76,9 +116,12 @@ private:
     boost::optional<evmc_tx_context> m_tx_context;
 
     static std::array<evmc_instruction_metrics, 256> c_metrics;
+    /// bit i set if c_superinstructions[i] is enabled
+    static std::atomic<uint32_t> s_superinstructions;
+    static std::atomic<bool> s_blockChecks;
     static void initMetrics();
     static u256 exp256(u256 _base, u256 _exponent);
-    void copyCode(int);
+    void copyCode(bytes& _code, int _extraBytes);
     typedef void (VM::*MemFnPtr)();
     MemFnPtr m_bounce = nullptr;
     uint64_t m_nSteps = 0;
@@ -86,25 +129,32 @@ private:
     // return bytes
     owning_bytes_ref m_output;
 
+    // arena of the constructing thread, giving the memory and the stack of the frame, which
+    // must be destroyed on that thread
+    ExecutionArena& m_arena = ExecutionArena::threadArena();
+
     // space for memory
-    bytes m_mem;
+    bytes m_mem = m_arena.acquireMemory();
 
     uint8_t const* m_pCode = nullptr;
     size_t m_codeSize = 0;
-    // space for code
-    bytes m_code;
+    // analysis shared with the other executions of the code, and its code
+    std::shared_ptr<CodeAnalysis const> m_analysis;
+    byte const* m_code = nullptr;
+    uint32_t const* m_blockAt = nullptr;
+    // positions following the entry of the block being executed, whose gas was charged and
+    // stack bounds checked at its entry
+    uint64_t m_blockBegin = 0;
+    uint64_t m_blockSize = 0;
 
     /// RETURNDATA buffer for memory returned from direct subcalls.
     bytes m_returnData;
 
     // space for data stack, grows towards smaller addresses from the end
-    u256 m_stack[VMSchedule::stackLimit];
-    u256 *m_stackEnd = &m_stack[VMSchedule::stackLimit];
+    u256* m_stack = m_arena.acquireStack();
+    u256* m_stackEnd = m_stack + ExecutionArena::c_stackSize;
     size_t stackSize() { return m_stackEnd - m_SP; }
     
-    // constant pool
-    std::vector<u256> m_pool;
-
     // interpreter state
     Instruction m_OP;         // current operation
     uint64_t m_PC = 0;        // program counter
@@ -119,6 +169,11 @@ private:
     // initialize interpreter
     void initEntry();
     void optimize();
+    /// Key of the analysis of the code with the given settings in the analysis cache
+    h256 analysisKey(uint32_t _superinstructions, bool _blockChecks);
+    void fuse(bytes& _code, uint32_t _enabled);
+    void buildBlocks(CodeAnalysis& _analysis);
+    void useAnalysis();
 
     // interpreter loop & switch
     void interpretCases();
@@ -141,8 +196,6 @@ private:
     void throwDisallowedStateChange();
     void throwBufferOverrun(bigint const& _enfOfAccess);
 
-    std::vector<uint64_t> m_beginSubs;
-    std::vector<uint64_t> m_jumpDests;
     int64_t verifyJumpDest(u256 const& _dest, bool _throw = true);
 
     void onOperation() {}
@@ -152,6 +205,7 @@ private:
     void updateGas();
     void updateMem(uint64_t _newMem);
     void logGasMem();
+    bool enterBlock();
     void fetchInstruction();
     
     uint64_t decodeJumpDest(const byte* const _code, uint64_t& _pc);
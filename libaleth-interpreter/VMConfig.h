@@ -131,10 +131,12 @@ namespace eth
         switch (m_OP)       \
         {
 #define CASE(name) case Instruction::name:
+#define FUSED_CASE(name) case Instruction(FusedInstruction::name):
 #define NEXT \
     ++m_PC;  \
     break;
 #define CONTINUE continue;
+#define CONTINUE_AT(name) continue;
 #define BREAK return;
 #define DEFAULT default:
 #define WHILE_CASES \
@@ -317,17 +319,17 @@ namespace eth
         &&LOG2,                                 \
         &&LOG3,                                 \
         &&LOG4,                                 \
-        &&INVALID,                              \
-        &&INVALID,                              \
-        &&INVALID,                              \
-        &&INVALID,                              \
-        &&INVALID,                              \
-        &&INVALID,                              \
-        &&INVALID,                              \
+        &&PUSH1ADD,                             \
+        &&PUSH1MLOAD,                           \
+        &&PUSH1MSTORE,                          \
+        &&PUSH2JUMP,                            \
+        &&PUSH2JUMPI,                           \
+        &&SWAP1POP,                             \
+        &&POPPOP,                               \
         &&PUSHC,                                \
         &&JUMPC,                                \
         &&JUMPCI,                               \
-        &&INVALID,                              \
+        &&ISZEROPUSH2,                          \
         &&JUMPTO, /* B0, */                     \
         &&JUMPIF,                               \
         &&JUMPSUB,                              \
@@ -415,6 +417,8 @@ namespace eth
     goto* jumpTable[(int)m_OP];
 #define CASE(name) \
     name:
+#define FUSED_CASE(name) \
+    name:
 #define NEXT            \
     ++m_PC;             \
     fetchInstruction(); \
@@ -422,6 +426,11 @@ namespace eth
 #define CONTINUE        \
     fetchInstruction(); \
     goto* jumpTable[(int)m_OP];
+// continue with the instruction at the program counter, known to be name, without the
+// indirect jump
+#define CONTINUE_AT(name) \
+    fetchInstruction();   \
+    goto name;
 #define BREAK return;
 #define DEFAULT
 #define WHILE_CASES
@@ -17,10 +17,149 @@
 
 #include "VM.h"
 
+#include <libdevcore/SHA3.h>
+
+#include <algorithm>
+#include <sstream>
+
 namespace dev
 {
 namespace eth
 {
+namespace
+{
+/// Pair of instructions executed with a single dispatch
+struct Superinstruction
+{
+    char const* name;
+    /// the pair as named in the bigrams of the instruction statistics
+    char const* bigram;
+    FusedInstruction fused;
+    Instruction first;
+    Instruction second;
+};
+
+// the fusion runs after the first pass, which replaces the jumps to constant destinations
+#if EVM_REPLACE_CONST_JUMP
+Instruction const c_constantJump = Instruction::JUMPC;
+Instruction const c_constantJumpI = Instruction::JUMPCI;
+#else
+Instruction const c_constantJump = Instruction::JUMP;
+Instruction const c_constantJumpI = Instruction::JUMPI;
+#endif
+
+/// Pairs the interpreter has a case for, enabled by name or picked among the most frequent
+/// bigrams of a profile, see VM::setSuperinstructionsFromBigrams. The set is fixed, as each
+/// pair needs its own case: a profile only selects among them, and enables none if none of
+/// them is frequent. They are pairs common in compiled contracts: constants fed to arithmetic
+/// and memory instructions, constant jumps and the stack cleanups of function epilogues
+Superinstruction const c_superinstructions[] = {
+    {"PUSH1ADD", "PUSH1 ADD", FusedInstruction::PUSH1ADD, Instruction::PUSH1, Instruction::ADD},
+    {"PUSH1MLOAD", "PUSH1 MLOAD", FusedInstruction::PUSH1MLOAD, Instruction::PUSH1,
+        Instruction::MLOAD},
+    {"PUSH1MSTORE", "PUSH1 MSTORE", FusedInstruction::PUSH1MSTORE, Instruction::PUSH1,
+        Instruction::MSTORE},
+    {"PUSH2JUMP", "PUSH2 JUMP", FusedInstruction::PUSH2JUMP, Instruction::PUSH2, c_constantJump},
+    {"PUSH2JUMPI", "PUSH2 JUMPI", FusedInstruction::PUSH2JUMPI, Instruction::PUSH2,
+        c_constantJumpI},
+    {"SWAP1POP", "SWAP1 POP", FusedInstruction::SWAP1POP, Instruction::SWAP1, Instruction::POP},
+    {"POPPOP", "POP POP", FusedInstruction::POPPOP, Instruction::POP, Instruction::POP},
+    {"ISZEROPUSH2", "ISZERO PUSH2", FusedInstruction::ISZEROPUSH2, Instruction::ISZERO,
+        Instruction::PUSH2},
+};
+
+size_t const c_superinstructionsCount =
+    sizeof(c_superinstructions) / sizeof(c_superinstructions[0]);
+
+bool isSuperinstruction(Instruction _op)
+{
+    for (auto const& superinstruction : c_superinstructions)
+        if (Instruction(superinstruction.fused) == _op)
+            return true;
+    return false;
+}
+
+/// Whether the case of @a _op charges exactly the cost of its metrics, without reading the gas
+/// left nor calling out, so that it can be charged at the entry of its block
+bool hasStaticCost(Instruction _op)
+{
+    switch (_op)
+    {
+    case Instruction::STOP:
+    case Instruction::ADD:
+    case Instruction::MUL:
+    case Instruction::SUB:
+    case Instruction::DIV:
+    case Instruction::SDIV:
+    case Instruction::MOD:
+    case Instruction::SMOD:
+    case Instruction::ADDMOD:
+    case Instruction::MULMOD:
+    case Instruction::SIGNEXTEND:
+    case Instruction::LT:
+    case Instruction::GT:
+    case Instruction::SLT:
+    case Instruction::SGT:
+    case Instruction::EQ:
+    case Instruction::ISZERO:
+    case Instruction::AND:
+    case Instruction::OR:
+    case Instruction::XOR:
+    case Instruction::NOT:
+    case Instruction::BYTE:
+    case Instruction::SHL:
+    case Instruction::SHR:
+    case Instruction::SAR:
+    case Instruction::ADDRESS:
+    case Instruction::ORIGIN:
+    case Instruction::CALLER:
+    case Instruction::CALLVALUE:
+    case Instruction::CALLDATALOAD:
+    case Instruction::CALLDATASIZE:
+    case Instruction::CODESIZE:
+    case Instruction::GASPRICE:
+    case Instruction::RETURNDATASIZE:
+    case Instruction::EXTCODEHASH:
+    case Instruction::COINBASE:
+    case Instruction::TIMESTAMP:
+    case Instruction::NUMBER:
+    case Instruction::DIFFICULTY:
+    case Instruction::GASLIMIT:
+    case Instruction::POP:
+    case Instruction::JUMP:
+    case Instruction::JUMPI:
+    case Instruction::PC:
+    case Instruction::MSIZE:
+    case Instruction::JUMPDEST:
+    case Instruction::PUSHC:
+    case Instruction::JUMPC:
+    case Instruction::JUMPCI:
+        return true;
+    default:
+        return (Instruction::PUSH1 <= _op && _op <= Instruction::PUSH32) ||
+               (Instruction::DUP1 <= _op && _op <= Instruction::SWAP16) ||
+               isSuperinstruction(_op);
+    }
+}
+
+/// Whether the instruction executed after @a _op may not be the next one in the code
+bool endsBlock(Instruction _op)
+{
+    return _op == Instruction::STOP || _op == Instruction::JUMP || _op == Instruction::JUMPI ||
+           _op == Instruction::JUMPC || _op == Instruction::JUMPCI;
+}
+
+size_t instructionSize(Instruction _op)
+{
+    if (Instruction::PUSH1 <= _op && _op <= Instruction::PUSH32)
+        return 2 + (size_t)_op - (size_t)Instruction::PUSH1;
+    return 1;
+}
+}  // namespace
+
+std::atomic<uint32_t> VM::s_superinstructions{0};
+std::atomic<bool> VM::s_blockChecks{false};
+
 std::array<evmc_instruction_metrics, 256> VM::c_metrics{{}};
 void VM::initMetrics()
 {
@@ -34,25 +173,83 @@ void VM::initMetrics()
         c_metrics[uint8_t(Instruction::PUSHC)] = c_metrics[uint8_t(Instruction::PUSH1)];
         c_metrics[uint8_t(Instruction::JUMPC)] = c_metrics[uint8_t(Instruction::JUMP)];
         c_metrics[uint8_t(Instruction::JUMPCI)] = c_metrics[uint8_t(Instruction::JUMPI)];
+        // the metrics of a superinstruction are the ones of its first instruction, the second
+        // one is fetched by its case
+        for (auto const& superinstruction : c_superinstructions)
+            c_metrics[uint8_t(superinstruction.fused)] =
+                c_metrics[uint8_t(superinstruction.first)];
         return true;
     }();
     (void)done;
 }
 
-void VM::copyCode(int _extraBytes)
+void VM::copyCode(bytes& _code, int _extraBytes)
 {
     // Copy code so that it can be safely modified and extend code by
     // _extraBytes zero bytes to allow reading virtual data at the end
     // of the code without bounds checks.
     auto extendedSize = m_codeSize + _extraBytes;
-    m_code.reserve(extendedSize);
-    m_code.assign(m_pCode, m_pCode + m_codeSize);
-    m_code.resize(extendedSize);
+    _code.reserve(extendedSize);
+    _code.assign(m_pCode, m_pCode + m_codeSize);
+    _code.resize(extendedSize);
+}
+
+CodeAnalysisCache& VM::analysisCache()
+{
+    static CodeAnalysisCache s_cache;
+    return s_cache;
+}
+
+h256 VM::analysisKey(uint32_t _superinstructions, bool _blockChecks)
+{
+    h256 codeHash;
+    // a CALL runs the code of its destination: the host gives its hash without hashing it
+    // again, unless the code does not come from the state
+    if (m_message->kind == EVMC_CALL)
+    {
+        auto const hostHash = m_context->host->get_code_hash(m_context, &m_message->destination);
+        codeHash = h256(hostHash.bytes, h256::ConstructFromPointer);
+    }
+    if (!codeHash || codeHash == EmptySHA3)
+        codeHash = sha3(bytesConstRef(m_pCode, m_codeSize));
+
+    // the analyses of the same code with other settings are different entries, they are
+    // evicted once no longer used
+    codeHash[0] ^= byte(_blockChecks);
+    for (size_t i = 0; i < sizeof(_superinstructions); ++i)
+        codeHash[1 + i] ^= byte(_superinstructions >> (8 * i));
+    return codeHash;
 }
 
 void VM::optimize()
 {
-    copyCode(33);
+    // the settings may be changed by another thread during the analysis, which uses the ones
+    // of its key
+    uint32_t const superinstructions = s_superinstructions.load(std::memory_order_relaxed);
+    bool const blockChecks = s_blockChecks.load(std::memory_order_relaxed);
+
+    // EVMC does not give the hash of the code: the analyses of the init codes of the creations
+    // are not kept
+    bool const cacheable =
+        m_message->kind != EVMC_CREATE && m_message->kind != EVMC_CREATE2 && m_codeSize > 0;
+    h256 key;
+    if (cacheable)
+    {
+        key = analysisKey(superinstructions, blockChecks);
+        m_analysis = analysisCache().find(key);
+        if (m_analysis && m_analysis->codeSize == m_codeSize)
+        {
+            useAnalysis();
+            return;
+        }
+    }
+
+    auto analysis = std::make_shared<CodeAnalysis>();
+    bytes& code = analysis->code;
+    copyCode(code, 33);
+    analysis->codeSize = m_codeSize;
+    // verifyJumpDest reads the table being built
+    m_analysis = analysis;
 
     size_t const nBytes = m_codeSize;
 
@@ -61,23 +258,24 @@ void VM::optimize()
     TRACE_STR(1, "Build JUMPDEST table")
     for (size_t pc = 0; pc < nBytes; ++pc)
     {
-        Instruction op = Instruction(m_code[pc]);
+        Instruction op = Instruction(code[pc]);
         TRACE_OP(2, pc, op);
                 
         // make synthetic ops in user code trigger invalid instruction if run
         if (
             op == Instruction::PUSHC ||
             op == Instruction::JUMPC ||
-            op == Instruction::JUMPCI
+            op == Instruction::JUMPCI ||
+            isSuperinstruction(op)
         )
         {
             TRACE_OP(1, pc, op);
-            m_code[pc] = (byte)Instruction::INVALID;
+            code[pc] = (byte)Instruction::INVALID;
         }
 
         if (op == Instruction::JUMPDEST)
         {
-            m_jumpDests.push_back(pc);
+            analysis->jumpDests.push_back(pc);
         }
         else if (
             (byte)Instruction::PUSH1 <= (byte)op &&
@@ -94,16 +292,16 @@ void VM::optimize()
     for (size_t pc = 0; pc < nBytes; ++pc)
     {
         u256 val = 0;
-        Instruction op = Instruction(m_code[pc]);
+        Instruction op = Instruction(code[pc]);
 
         if ((byte)Instruction::PUSH1 <= (byte)op && (byte)op <= (byte)Instruction::PUSH32)
         {
             byte nPush = (byte)op - (byte)Instruction::PUSH1 + 1;
 
             // decode pushed bytes to integral value
-            val = m_code[pc+1];
+            val = code[pc+1];
             for (uint64_t i = pc+2, n = nPush; --n; ++i) {
-                val = (val << 8) | m_code[i];
+                val = (val << 8) | code[i];
             }
 
         #if EVM_USE_CONSTANT_POOL
@@ -113,16 +311,16 @@ void VM::optimize()
             // followed by one byte count of remaining pushed bytes
             if (5 < nPush)
             {
-                uint16_t pool_off = m_pool.size();
+                uint16_t pool_off = analysis->pool.size();
                 TRACE_VAL(1, "stash", val);
                 TRACE_VAL(1, "... in pool at offset" , pool_off);
-                m_pool.push_back(val);
+                analysis->pool.push_back(val);
 
                 TRACE_PRE_OPT(1, pc, op);
-                m_code[pc] = byte(op = Instruction::PUSHC);
-                m_code[pc+3] = nPush - 2;
-                m_code[pc+2] = pool_off & 0xff;
-                m_code[pc+1] = pool_off >> 8;
+                code[pc] = byte(op = Instruction::PUSHC);
+                code[pc+3] = nPush - 2;
+                code[pc+2] = pool_off & 0xff;
+                code[pc+1] = pool_off >> 8;
                 TRACE_POST_OPT(1, pc, op);
             }
 
@@ -134,14 +332,14 @@ void VM::optimize()
             // outer loop is N = number of bytes in code array
             // so complexity is N log M, worst case is N log N
             size_t i = pc + nPush + 1;
-            op = Instruction(m_code[i]);
+            op = Instruction(code[i]);
             if (op == Instruction::JUMP)
             {
                 TRACE_VAL(1, "Replace const JUMP with JUMPC to", val)
                 TRACE_PRE_OPT(1, i, op);
                 
                 if (0 <= verifyJumpDest(val, false))
-                    m_code[i] = byte(op = Instruction::JUMPC);
+                    code[i] = byte(op = Instruction::JUMPC);
                 
                 TRACE_POST_OPT(1, i, op);
             }
@@ -151,7 +349,7 @@ void VM::optimize()
                 TRACE_PRE_OPT(1, i, op);
                 
                 if (0 <= verifyJumpDest(val, false))
-                    m_code[i] = byte(op = Instruction::JUMPCI);
+                    code[i] = byte(op = Instruction::JUMPCI);
                 
                 TRACE_POST_OPT(1, i, op);
             }
@@ -162,9 +360,156 @@ void VM::optimize()
     }
     TRACE_STR(1, "Finished optimizations")
 #endif    
+
+    fuse(code, superinstructions);
+    if (blockChecks)
+        buildBlocks(*analysis);
+
+    useAnalysis();
+    if (cacheable)
+        analysisCache().insert(key, m_analysis);
 }
 
 
+void VM::fuse(bytes& _code, uint32_t _enabled)
+{
+    if (!_enabled)
+        return;
+
+    TRACE_STR(1, "Fuse superinstructions")
+    // the boundaries of the instructions are the ones of the original code as the first pass
+    // keeps the sizes of the instructions it replaces
+    for (size_t pc = 0; pc < m_codeSize;)
+    {
+        size_t next = pc + instructionSize(Instruction(m_pCode[pc]));
+        if (next >= m_codeSize)
+            break;
+        size_t after = next + instructionSize(Instruction(m_pCode[next]));
+        bool fused = false;
+        for (size_t i = 0; i < c_superinstructionsCount; ++i)
+        {
+            auto const& superinstruction = c_superinstructions[i];
+            if ((_enabled >> i & 1) && Instruction(_code[pc]) == superinstruction.first &&
+                Instruction(_code[next]) == superinstruction.second)
+            {
+                TRACE_PRE_OPT(1, pc, Instruction(_code[pc]));
+                _code[pc] = byte(superinstruction.fused);
+                TRACE_POST_OPT(1, pc, Instruction(_code[pc]));
+                fused = true;
+                break;
+            }
+        }
+        // the cases of the second instructions expect them unfused: the pairs do not overlap
+        pc = fused ? after : next;
+    }
+}
+
+bool VM::setSuperinstructions(std::string const& _names)
+{
+    uint32_t enabled = 0;
+    if (_names == "all")
+        enabled = (1u << c_superinstructionsCount) - 1;
+    else if (!_names.empty() && _names != "none")
+    {
+        std::istringstream names(_names);
+        std::string name;
+        while (std::getline(names, name, ','))
+        {
+            size_t i = 0;
+            while (i < c_superinstructionsCount && name != c_superinstructions[i].name)
+                ++i;
+            if (i == c_superinstructionsCount)
+                return false;
+            enabled |= 1u << i;
+        }
+    }
+
+    s_superinstructions = enabled;
+    return true;
+}
+
+void VM::setSuperinstructionsFromBigrams(std::string const& _bigrams)
+{
+    uint32_t enabled = 0;
+    std::istringstream bigrams(_bigrams);
+    std::string bigram;
+    while (std::getline(bigrams, bigram, ','))
+        for (size_t i = 0; i < c_superinstructionsCount; ++i)
+            if (bigram == c_superinstructions[i].bigram)
+                enabled |= 1u << i;
+    s_superinstructions = enabled;
+}
+
+void VM::buildBlocks(CodeAnalysis& _analysis)
+{
+    TRACE_STR(1, "Build blocks")
+    bytes const& code = _analysis.code;
+    CodeAnalysis::Block block;
+    size_t length = 0;
+    // growth of the stack since the entry of the block
+    int growth = 0;
+    auto close = [&](uint64_t _end) {
+        // a block of a single instruction would be checked as often as the instruction
+        if (length > 1)
+        {
+            block.end = _end;
+            _analysis.blocks.push_back(block);
+        }
+        length = 0;
+    };
+
+    // the boundaries of the instructions are the ones of the original code, see VM::fuse
+    size_t pc = 0;
+    while (pc < m_codeSize)
+    {
+        auto const op = Instruction(code[pc]);
+        size_t const next = pc + instructionSize(Instruction(m_pCode[pc]));
+        if (!hasStaticCost(op))
+        {
+            close(pc);
+            pc = next;
+            continue;
+        }
+
+        // the jumps land on the entries of the blocks, never inside them
+        if (op == Instruction::JUMPDEST)
+            close(pc);
+        if (length == 0)
+        {
+            block = CodeAnalysis::Block();
+            block.begin = pc;
+            growth = 0;
+        }
+        auto const& metric = c_metrics[static_cast<size_t>(op)];
+        block.stackRequired = std::max(block.stackRequired, metric.num_stack_arguments - growth);
+        growth += metric.num_stack_returned_items - metric.num_stack_arguments;
+        block.stackGrowth = std::max(block.stackGrowth, growth);
+        block.gas += metric.gas_cost;
+        ++length;
+        pc = next;
+        if (endsBlock(op))
+            close(pc);
+    }
+    close(pc);
+
+    if (_analysis.blocks.empty())
+        return;
+    _analysis.blockAt.assign(code.size(), 0);
+    for (size_t i = 0; i < _analysis.blocks.size(); ++i)
+        _analysis.blockAt[_analysis.blocks[i].begin] = i + 1;
+}
+
+void VM::setBlockChecks(bool _enabled)
+{
+    s_blockChecks = _enabled;
+}
+
+void VM::useAnalysis()
+{
+    m_code = m_analysis->code.data();
+    m_blockAt = m_analysis->blockAt.empty() ? nullptr : m_analysis->blockAt.data();
+}
+
 //
 // Init interpreter on entry.
 //
@@ -184,16 +529,7 @@ void VM::initEntry()
 // Do not inline it.
 u256 VM::exp256(u256 _base, u256 _exponent)
 {
-    using boost::multiprecision::limb_type;
-    u256 result = 1;
-    while (_exponent)
-    {
-        if (static_cast<limb_type>(_exponent) & 1)    // If exponent is odd.
-            result *= _base;
-        _base *= _base;
-        _exponent >>= 1;
-    }
-    return result;
+    return exp(Word256(_base), Word256(_exponent)).toU256();
 }
 }
 }
@@ -0,0 +1,91 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+#include "CodeAnalysisCache.h"
+
+namespace dev
+{
+size_t CodeAnalysis::memoryUsage() const
+{
+    return sizeof(CodeAnalysis) + code.capacity() +
+           (jumpDests.capacity() + beginSubs.capacity()) * sizeof(uint64_t) +
+           pool.capacity() * sizeof(u256) + blocks.capacity() * sizeof(Block) +
+           blockAt.capacity() * sizeof(uint32_t);
+}
+
+std::shared_ptr<CodeAnalysis const> CodeAnalysisCache::find(h256 const& _codeHash)
+{
+    Guard l(m_lock);
+    auto it = m_entries.find(_codeHash);
+    if (it == m_entries.end())
+    {
+        m_stats.misses++;
+        return nullptr;
+    }
+    m_stats.hits++;
+    m_lru.splice(m_lru.begin(), m_lru, it->second.position);
+    return it->second.analysis;
+}
+
+void CodeAnalysisCache::insert(h256 const& _codeHash, std::shared_ptr<CodeAnalysis const> _analysis)
+{
+    auto size = _analysis->memoryUsage();
+    Guard l(m_lock);
+    if (size > m_capacity)
+        return;
+
+    auto it = m_entries.find(_codeHash);
+    if (it != m_entries.end())
+    {
+        // analysed concurrently by another execution
+        m_lru.splice(m_lru.begin(), m_lru, it->second.position);
+        return;
+    }
+    m_lru.push_front(_codeHash);
+    m_entries.emplace(_codeHash, Entry{std::move(_analysis), size, m_lru.begin()});
+    m_stats.size += size;
+    shrink();
+}
+
+size_t CodeAnalysisCache::capacity() const
+{
+    Guard l(m_lock);
+    return m_capacity;
+}
+
+void CodeAnalysisCache::setCapacity(size_t _capacity)
+{
+    Guard l(m_lock);
+    m_capacity = _capacity;
+    shrink();
+}
+
+void CodeAnalysisCache::clear()
+{
+    Guard l(m_lock);
+    m_lru.clear();
+    m_entries.clear();
+    m_stats.size = 0;
+}
+
+CodeAnalysisCache::Stats CodeAnalysisCache::stats() const
+{
+    Guard l(m_lock);
+    Stats stats = m_stats;
+    stats.entries = m_entries.size();
+    return stats;
+}
+
+void CodeAnalysisCache::shrink()
+{
+    while (m_stats.size > m_capacity)
+    {
+        auto it = m_entries.find(m_lru.back());
+        m_stats.size -= it->second.size;
+        m_stats.evictions++;
+        m_entries.erase(it);
+        m_lru.pop_back();
+    }
+}
+
+}  // namespace dev
@@ -0,0 +1,111 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+#pragma once
+
+#include "Common.h"
+#include "FixedHash.h"
+#include "Guards.h"
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+namespace dev
+{
+/// Result of the first pass of an interpreter over a code. It is immutable once built so that
+/// the executions of the same code, in any thread, can share it.
+struct CodeAnalysis
+{
+    /// Run of instructions of static costs whose gas and stack bounds are checked once, at the
+    /// entry of the run.
+    struct Block
+    {
+        uint64_t begin = 0;
+        /// Position following the last instruction.
+        uint64_t end = 0;
+        /// Sum of the costs of the instructions.
+        uint64_t gas = 0;
+        /// Minimum height of the stack at the entry for none of the instructions to underflow.
+        int stackRequired = 0;
+        /// Maximum growth of the stack over the entry height during the run.
+        int stackGrowth = 0;
+    };
+
+    /// Code with the synthetic instructions disabled or introduced by the optimizations,
+    /// padded with zero bytes so that the values of a truncated PUSH can be read.
+    bytes code;
+    /// Size of the code before the padding.
+    size_t codeSize = 0;
+    /// Sorted positions of the JUMPDEST instructions.
+    std::vector<uint64_t> jumpDests;
+    /// Sorted positions of the BEGINSUB instructions (EIP-615).
+    std::vector<uint64_t> beginSubs;
+    /// Values of the PUSHC instructions.
+    std::vector<u256> pool;
+    /// Blocks of the code, by position.
+    std::vector<Block> blocks;
+    /// For each position of the padded code, 1 + the index of the block beginning there, 0 if
+    /// none does. Empty if the blocks are not used.
+    std::vector<uint32_t> blockAt;
+
+    /// Approximate number of bytes used by the analysis.
+    size_t memoryUsage() const;
+};
+
+/// Least recently used analyses of the codes, keyed by the hash of the code and bounded by
+/// their memory usage. The analyses are returned as shared pointers: an execution keeps the
+/// analysis it borrowed even if it is evicted in the meantime.
+class CodeAnalysisCache
+{
+public:
+    static constexpr size_t c_defaultCapacity = 64 * 1024 * 1024;
+
+    struct Stats
+    {
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+        size_t entries = 0;
+        /// bytes used by the cached analyses
+        size_t size = 0;
+    };
+
+    /// @param _capacity  maximum size of the cached analyses in bytes, 0 disables the cache
+    explicit CodeAnalysisCache(size_t _capacity = c_defaultCapacity): m_capacity(_capacity) {}
+
+    /// Returns the analysis of the code with the hash @a _codeHash, nullptr if it is not cached.
+    std::shared_ptr<CodeAnalysis const> find(h256 const& _codeHash);
+
+    /// Caches @a _analysis, evicting the least recently used analyses if the capacity is
+    /// exceeded. Analyses larger than the capacity are not cached.
+    void insert(h256 const& _codeHash, std::shared_ptr<CodeAnalysis const> _analysis);
+
+    size_t capacity() const;
+    /// Changes the capacity, evicting analyses if the cache is larger.
+    void setCapacity(size_t _capacity);
+
+    void clear();
+    Stats stats() const;
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<CodeAnalysis const> analysis;
+        size_t size;
+        /// position in m_lru
+        std::list<h256>::iterator position;
+    };
+
+    /// Evicts analyses until the cache fits in its capacity. m_lock must be held.
+    void shrink();
+
+    mutable Mutex m_lock;
+    size_t m_capacity;
+    /// Hashes from the most recently used to the least recently used
+    std::list<h256> m_lru;
+    std::unordered_map<h256, Entry> m_entries;
+    Stats m_stats;
+};
+
+}  // namespace dev
@@ -0,0 +1,80 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+#include "ExecutionArena.h"
+
+#include <algorithm>
+
+namespace dev
+{
+constexpr size_t ExecutionArena::c_stackSize;
+constexpr size_t ExecutionArena::c_pageSize;
+constexpr size_t ExecutionArena::c_maxPooledMemory;
+constexpr size_t ExecutionArena::c_maxPooled;
+
+ExecutionArena& ExecutionArena::threadArena()
+{
+    static thread_local ExecutionArena s_arena;
+    return s_arena;
+}
+
+u256* ExecutionArena::acquireStack()
+{
+    if (m_stacks.empty())
+    {
+        ++m_stats.allocations;
+        m_stats.allocatedBytes += c_stackSize * sizeof(u256);
+        return new u256[c_stackSize];
+    }
+    ++m_stats.reuses;
+    u256* stack = m_stacks.back().release();
+    m_stacks.pop_back();
+    return stack;
+}
+
+void ExecutionArena::releaseStack(u256* _stack)
+{
+    std::unique_ptr<u256[]> stack{_stack};
+    if (stack && m_stacks.size() < c_maxPooled)
+        m_stacks.push_back(std::move(stack));
+}
+
+bytes ExecutionArena::acquireMemory()
+{
+    if (m_memories.empty())
+        return {};
+    ++m_stats.reuses;
+    bytes memory = std::move(m_memories.back());
+    m_memories.pop_back();
+    return memory;
+}
+
+void ExecutionArena::releaseMemory(bytes&& _memory)
+{
+    if (_memory.capacity() == 0 || _memory.capacity() > c_maxPooledMemory ||
+        m_memories.size() >= c_maxPooled)
+        return;
+    _memory.clear();
+    m_memories.push_back(std::move(_memory));
+}
+
+void ExecutionArena::growMemory(bytes& _memory, size_t _size)
+{
+    if (_size > _memory.capacity())
+    {
+        size_t capacity = std::max(_size, 2 * _memory.capacity());
+        capacity = (capacity + c_pageSize - 1) / c_pageSize * c_pageSize;
+        _memory.reserve(capacity);
+        ++m_stats.allocations;
+        m_stats.allocatedBytes += capacity;
+    }
+    _memory.resize(_size);
+}
+
+void ExecutionArena::clear()
+{
+    m_stacks.clear();
+    m_memories.clear();
+}
+
+}  // namespace dev
@@ -0,0 +1,71 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+#pragma once
+
+#include "Common.h"
+
+#include <memory>
+#include <vector>
+
+namespace dev
+{
+/// Stacks and memories of the VM frames of a thread. A frame takes them from the arena of its
+/// thread and gives them back when it ends, so that the nested calls and the following
+/// transactions reuse them rather than allocating their own. A frame ending with RETURN or
+/// REVERT hands its memory over with its output instead, and the caller gives it back once it
+/// consumed the output.
+///
+/// An arena is not synchronized: a frame must be destroyed on the thread that constructed it.
+class ExecutionArena
+{
+public:
+    /// Number of items of a stack.
+    static constexpr size_t c_stackSize = 1024;
+    /// Granularity of the memory capacities.
+    static constexpr size_t c_pageSize = 4096;
+    /// Memories kept for reuse, the larger ones are freed.
+    static constexpr size_t c_maxPooledMemory = 1024 * 1024;
+    /// Maximum number of pooled stacks and of pooled memories.
+    static constexpr size_t c_maxPooled = 64;
+
+    struct Stats
+    {
+        /// stacks and memory regions allocated, including the growths of the memories
+        uint64_t allocations = 0;
+        uint64_t allocatedBytes = 0;
+        /// stacks and memories handed out from the pools
+        uint64_t reuses = 0;
+    };
+
+    ExecutionArena() = default;
+    ExecutionArena(ExecutionArena const&) = delete;
+    ExecutionArena& operator=(ExecutionArena const&) = delete;
+
+    /// Arena of the calling thread.
+    static ExecutionArena& threadArena();
+
+    /// Returns a stack of c_stackSize items, to be given back with releaseStack. Its items are
+    /// not cleared.
+    u256* acquireStack();
+    void releaseStack(u256* _stack);
+
+    /// Returns an empty memory, with the capacity of a previous frame if one was released.
+    bytes acquireMemory();
+    /// Takes @a _memory back, a moved-from memory is ignored.
+    void releaseMemory(bytes&& _memory);
+    /// Grows @a _memory to @a _size bytes, the new bytes being zero. The capacity grows
+    /// geometrically, in whole pages.
+    void growMemory(bytes& _memory, size_t _size);
+
+    Stats const& stats() const { return m_stats; }
+    /// Frees the pooled stacks and memories.
+    void clear();
+
+private:
+    std::vector<std::unique_ptr<u256[]>> m_stacks;
+    std::vector<bytes> m_memories;
+    Stats m_stats;
+};
+
+}  // namespace dev
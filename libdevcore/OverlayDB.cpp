@@ -43,6 +43,14 @@ inline db::Slice toSlice(bytes const& _b)
 
 }  // namespace
 
+#ifdef ETH_MEASURE_GAS
+thread_local OverlayDB::LookupCounters OverlayDB::s_lookupCounters;
+
+#define COUNT_OVERLAYDB_LOOKUP(_counter) ++s_lookupCounters._counter
+#else
+#define COUNT_OVERLAYDB_LOOKUP(_counter)
+#endif
+
 OverlayDB::~OverlayDB() = default;
 
 void OverlayDB::commit()
@@ -103,7 +111,11 @@ bytes OverlayDB::lookupAux(h256 const& _h) const
 {
     bytes ret = StateCacheDB::lookupAux(_h);
     if (!ret.empty() || !m_db)
+    {
+        COUNT_OVERLAYDB_LOOKUP(memoryHits);
         return ret;
+    }
+    COUNT_OVERLAYDB_LOOKUP(databaseReads);
 
     bytes b = _h.asBytes();
     b.push_back(255);   // for aux
@@ -126,16 +138,26 @@ std::string OverlayDB::lookup(h256 const& _h) const
 {
     std::string ret = StateCacheDB::lookup(_h);
     if (!ret.empty() || !m_db)
+    {
+        COUNT_OVERLAYDB_LOOKUP(memoryHits);
         return ret;
+    }
 
+    COUNT_OVERLAYDB_LOOKUP(databaseReads);
     return m_db->lookup(toSlice(_h));
 }
 
 bool OverlayDB::exists(h256 const& _h) const
 {
     if (StateCacheDB::exists(_h))
+    {
+        COUNT_OVERLAYDB_LOOKUP(memoryHits);
         return true;
-    return m_db && m_db->exists(toSlice(_h));
+    }
+    if (!m_db)
+        return false;
+    COUNT_OVERLAYDB_LOOKUP(databaseReads);
+    return m_db->exists(toSlice(_h));
 }
 
 void OverlayDB::kill(h256 const& _h)
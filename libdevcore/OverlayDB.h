@@ -58,10 +58,27 @@ public:
 
 	bytes lookupAux(h256 const& _h) const;
 
+#ifdef ETH_MEASURE_GAS
+    /// Lookups made by a thread, split between the ones answered by the memory layer and the
+    /// ones reaching the database
+    struct LookupCounters
+    {
+        uint64_t memoryHits = 0;
+        uint64_t databaseReads = 0;
+    };
+
+    /// Lookups made by the calling thread on every OverlayDB since it started
+    static LookupCounters const& threadLookupCounters() { return s_lookupCounters; }
+#endif
+
 private:
 	using StateCacheDB::clear;
 
     std::shared_ptr<db::DatabaseFace> m_db;
+
+#ifdef ETH_MEASURE_GAS
+    static thread_local LookupCounters s_lookupCounters;
+#endif
 };
 
 }
@@ -0,0 +1,249 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+#include "Word256.h"
+
+namespace dev
+{
+namespace
+{
+/// Number of leading zero bits of @a _x, which must not be 0.
+unsigned countLeadingZeros(uint64_t _x)
+{
+#if defined(__GNUC__)
+    return static_cast<unsigned>(__builtin_clzll(_x));
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long index;
+    _BitScanReverse64(&index, _x);
+    return 63 - index;
+#else
+    unsigned n = 0;
+    while (!(_x >> 63))
+    {
+        _x <<= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+/// Divides the 128-bit number @a _hi:@a _lo by @a _d, @a _hi must be less than @a _d so that
+/// the quotient fits in 64 bits.
+uint64_t div128(uint64_t _hi, uint64_t _lo, uint64_t _d, uint64_t& o_remainder)
+{
+#if defined(__x86_64__) && defined(__GNUC__)
+    uint64_t q;
+    __asm__("divq %4" : "=a"(q), "=d"(o_remainder) : "a"(_lo), "d"(_hi), "rm"(_d));
+    return q;
+#elif defined(__SIZEOF_INT128__)
+    unsigned __int128 n = (static_cast<unsigned __int128>(_hi) << 64) | _lo;
+    o_remainder = static_cast<uint64_t>(n % _d);
+    return static_cast<uint64_t>(n / _d);
+#else
+    // Hacker's Delight divlu: two 64 by 32-bit divisions on the normalized divisor
+    uint64_t const b = 1ULL << 32;
+    unsigned s = countLeadingZeros(_d);
+    _d <<= s;
+    uint64_t dHi = _d >> 32;
+    uint64_t dLo = _d & 0xffffffff;
+    uint64_t n32 = s ? (_hi << s) | (_lo >> (64 - s)) : _hi;
+    uint64_t n10 = _lo << s;
+    uint64_t n1 = n10 >> 32;
+    uint64_t n0 = n10 & 0xffffffff;
+
+    uint64_t q1 = n32 / dHi;
+    uint64_t rhat = n32 - q1 * dHi;
+    while (q1 >= b || q1 * dLo > b * rhat + n1)
+    {
+        --q1;
+        rhat += dHi;
+        if (rhat >= b)
+            break;
+    }
+    uint64_t n21 = n32 * b + n1 - q1 * _d;
+
+    uint64_t q0 = n21 / dHi;
+    rhat = n21 - q0 * dHi;
+    while (q0 >= b || q0 * dLo > b * rhat + n0)
+    {
+        --q0;
+        rhat += dHi;
+        if (rhat >= b)
+            break;
+    }
+    o_remainder = (n21 * b + n0 - q0 * _d) >> s;
+    return q1 * b + q0;
+#endif
+}
+
+/// Knuth's algorithm D: divides the @a _m limbs of @a _u by the @a _n limbs of @a _v, whose most
+/// significant limb must not be 0, with 1 <= @a _n <= 4 and @a _n <= @a _m <= 8. Writes the
+/// @a _m - @a _n + 1 limbs of the quotient and the @a _n limbs of the remainder.
+void divRemLimbs(uint64_t const* _u, unsigned _m, uint64_t const* _v, unsigned _n,
+    uint64_t* o_quotient, uint64_t* o_remainder)
+{
+    if (_n == 1)
+    {
+        uint64_t remainder = 0;
+        for (unsigned j = _m; j-- > 0;)
+            o_quotient[j] = div128(remainder, _u[j], _v[0], remainder);
+        o_remainder[0] = remainder;
+        return;
+    }
+
+    // normalize so that the most significant bit of the divisor is set
+    unsigned s = countLeadingZeros(_v[_n - 1]);
+    uint64_t vn[4];
+    uint64_t un[9];
+    for (unsigned i = _n - 1; i > 0; --i)
+        vn[i] = (_v[i] << s) | (s ? _v[i - 1] >> (64 - s) : 0);
+    vn[0] = _v[0] << s;
+    un[_m] = s ? _u[_m - 1] >> (64 - s) : 0;
+    for (unsigned i = _m - 1; i > 0; --i)
+        un[i] = (_u[i] << s) | (s ? _u[i - 1] >> (64 - s) : 0);
+    un[0] = _u[0] << s;
+
+    for (unsigned j = _m - _n + 1; j-- > 0;)
+    {
+        // estimate the quotient limb from the two most significant limbs, it is at most 2 too
+        // large after the correction with the third one
+        uint64_t qhat;
+        uint64_t rhat;
+        bool rhatOverflow = false;
+        if (un[j + _n] >= vn[_n - 1])
+        {
+            qhat = ~0ULL;
+            rhat = un[j + _n - 1] + vn[_n - 1];
+            rhatOverflow = rhat < vn[_n - 1];
+        }
+        else
+            qhat = div128(un[j + _n], un[j + _n - 1], vn[_n - 1], rhat);
+        while (!rhatOverflow)
+        {
+            uint64_t hi;
+            uint64_t lo = word256::mulWide(qhat, vn[_n - 2], hi);
+            if (hi < rhat || (hi == rhat && lo <= un[j + _n - 2]))
+                break;
+            --qhat;
+            rhat += vn[_n - 1];
+            rhatOverflow = rhat < vn[_n - 1];
+        }
+
+        // multiply and subtract
+        uint64_t carry = 0;
+        uint8_t borrow = 0;
+        for (unsigned i = 0; i < _n; ++i)
+        {
+            uint64_t hi;
+            uint64_t lo = word256::mulWide(qhat, vn[i], hi);
+            lo += carry;
+            hi += lo < carry;
+            carry = hi;
+            un[i + j] = word256::subBorrow(un[i + j], lo, borrow);
+        }
+        un[j + _n] = word256::subBorrow(un[j + _n], carry, borrow);
+
+        // add back if the estimate was one too large
+        if (borrow)
+        {
+            --qhat;
+            uint8_t addCarry = 0;
+            for (unsigned i = 0; i < _n; ++i)
+                un[i + j] = word256::addCarry(un[i + j], vn[i], addCarry);
+            un[j + _n] += addCarry;
+        }
+        o_quotient[j] = qhat;
+    }
+
+    for (unsigned i = 0; i < _n; ++i)
+        o_remainder[i] = (un[i] >> s) | (s ? un[i + 1] << (64 - s) : 0);
+}
+
+/// Remainder of the @a _m limbs of @a _u by @a _d, which must not be 0.
+Word256 modLimbs(uint64_t const* _u, unsigned _m, Word256 const& _d)
+{
+    unsigned n = _d.significantLimbs();
+    while (_m > 0 && _u[_m - 1] == 0)
+        --_m;
+    Word256 r;
+    if (_m < n)
+    {
+        for (unsigned i = 0; i < _m; ++i)
+            r.limbs[i] = _u[i];
+        return r;
+    }
+    uint64_t q[8];
+    divRemLimbs(_u, _m, _d.limbs, n, q, r.limbs);
+    return r;
+}
+}  // namespace
+
+void divRem(Word256 const& _a, Word256 const& _b, Word256& o_quotient, Word256& o_remainder)
+{
+    unsigned m = _a.significantLimbs();
+    unsigned n = _b.significantLimbs();
+    Word256 q;
+    Word256 r;
+    if (m < n)
+        r = _a;
+    else if (m == 1)
+    {
+        q.limbs[0] = _a.limbs[0] / _b.limbs[0];
+        r.limbs[0] = _a.limbs[0] % _b.limbs[0];
+    }
+    else
+        divRemLimbs(_a.limbs, m, _b.limbs, n, q.limbs, r.limbs);
+    o_quotient = q;
+    o_remainder = r;
+}
+
+Word256 addMod(Word256 const& _a, Word256 const& _b, Word256 const& _m)
+{
+    uint64_t sum[5];
+    uint8_t carry = 0;
+    for (unsigned i = 0; i < 4; ++i)
+        sum[i] = word256::addCarry(_a.limbs[i], _b.limbs[i], carry);
+    sum[4] = carry;
+    return modLimbs(sum, 5, _m);
+}
+
+Word256 mulMod(Word256 const& _a, Word256 const& _b, Word256 const& _m)
+{
+    uint64_t product[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        uint64_t carry = 0;
+        for (unsigned j = 0; j < 4; ++j)
+        {
+            uint64_t hi;
+            uint64_t lo = word256::mulWide(_a.limbs[i], _b.limbs[j], hi);
+            lo += carry;
+            hi += lo < carry;
+            product[i + j] += lo;
+            hi += product[i + j] < lo;
+            carry = hi;
+        }
+        product[i + 4] = carry;
+    }
+    return modLimbs(product, 8, _m);
+}
+
+Word256 exp(Word256 _base, Word256 const& _exponent)
+{
+    Word256 result(1);
+    unsigned n = _exponent.significantLimbs();
+    for (unsigned i = 0; i < n; ++i)
+    {
+        uint64_t bits = _exponent.limbs[i];
+        // the squarings past the most significant bit are skipped
+        for (unsigned k = 0; k < 64 && (bits || i + 1 < n); ++k, bits >>= 1)
+        {
+            if (bits & 1)
+                result = result * _base;
+            _base = _base * _base;
+        }
+    }
+    return result;
+}
+
+}  // namespace dev
@@ -0,0 +1,284 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+#pragma once
+
+#include "Common.h"
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#elif defined(__x86_64__)
+#include <x86intrin.h>
+#endif
+
+namespace dev
+{
+namespace word256
+{
+/// Returns @a _a + @a _b + @a _carry and sets @a _carry to the carry out.
+inline uint64_t addCarry(uint64_t _a, uint64_t _b, uint8_t& _carry)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    unsigned long long r;
+    _carry = _addcarry_u64(_carry, _a, _b, &r);
+    return r;
+#else
+    uint64_t s = _a + _b;
+    uint8_t c = s < _a;
+    uint64_t r = s + _carry;
+    _carry = c | (r < s);
+    return r;
+#endif
+}
+
+/// Returns @a _a - @a _b - @a _borrow and sets @a _borrow to the borrow out.
+inline uint64_t subBorrow(uint64_t _a, uint64_t _b, uint8_t& _borrow)
+{
+#if defined(__x86_64__) || defined(_M_X64)
+    unsigned long long r;
+    _borrow = _subborrow_u64(_borrow, _a, _b, &r);
+    return r;
+#else
+    uint64_t d = _a - _b;
+    uint8_t b = _a < _b;
+    uint64_t r = d - _borrow;
+    _borrow = b | (d < _borrow);
+    return r;
+#endif
+}
+
+/// Returns the low half of @a _a * @a _b and sets @a _hi to the high half.
+inline uint64_t mulWide(uint64_t _a, uint64_t _b, uint64_t& _hi)
+{
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 p = static_cast<unsigned __int128>(_a) * _b;
+    _hi = static_cast<uint64_t>(p >> 64);
+    return static_cast<uint64_t>(p);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned __int64 hi;
+    uint64_t lo = _umul128(_a, _b, &hi);
+    _hi = hi;
+    return lo;
+#else
+    uint64_t a0 = _a & 0xffffffff, a1 = _a >> 32;
+    uint64_t b0 = _b & 0xffffffff, b1 = _b >> 32;
+    uint64_t p00 = a0 * b0, p01 = a0 * b1, p10 = a1 * b0, p11 = a1 * b1;
+    uint64_t middle = (p00 >> 32) + (p01 & 0xffffffff) + (p10 & 0xffffffff);
+    _hi = p11 + (p01 >> 32) + (p10 >> 32) + (middle >> 32);
+    return (middle << 32) | (p00 & 0xffffffff);
+#endif
+}
+}  // namespace word256
+
+/// 256-bit unsigned integer stored as four 64-bit limbs, least significant first, with
+/// fixed-width arithmetic kernels for the interpreter. Conversions with u256 copy the limbs of
+/// the boost backend.
+struct Word256
+{
+    uint64_t limbs[4] = {0, 0, 0, 0};
+
+    Word256() = default;
+    explicit Word256(uint64_t _v): limbs{_v, 0, 0, 0} {}
+    Word256(uint64_t _l0, uint64_t _l1, uint64_t _l2, uint64_t _l3): limbs{_l0, _l1, _l2, _l3} {}
+    explicit Word256(u256 const& _v);
+
+    u256 toU256() const;
+
+    bool isZero() const { return (limbs[0] | limbs[1] | limbs[2] | limbs[3]) == 0; }
+    bool isNegative() const { return limbs[3] >> 63; }
+    /// Number of limbs up to the most significant non-zero one.
+    unsigned significantLimbs() const;
+    /// Value as a shift amount: the value if it is less than 256, 256 otherwise.
+    unsigned shiftAmount() const;
+};
+
+inline Word256::Word256(u256 const& _v)
+{
+    using boost::multiprecision::limb_type;
+    auto const& backend = _v.backend();
+    if (sizeof(limb_type) == sizeof(uint64_t))
+    {
+        // the limbs past the size of the backend can hold stale values, the ones of the word
+        // past that size are left zero
+        for (unsigned i = 0; i < backend.size(); ++i)
+            limbs[i] = backend.limbs()[i];
+    }
+    else
+        for (unsigned i = 0; i < backend.size(); ++i)
+        {
+            unsigned bit = i * sizeof(limb_type) * 8;
+            limbs[bit / 64] |= static_cast<uint64_t>(backend.limbs()[i]) << (bit % 64);
+        }
+}
+
+inline u256 Word256::toU256() const
+{
+    using boost::multiprecision::limb_type;
+    constexpr unsigned limbCount = 32 / sizeof(limb_type);
+    u256 v;
+    auto& backend = v.backend();
+    backend.resize(limbCount, limbCount);
+    if (sizeof(limb_type) == sizeof(uint64_t))
+        std::memcpy(backend.limbs(), limbs, sizeof(limbs));
+    else
+        for (unsigned i = 0; i < limbCount; ++i)
+        {
+            unsigned bit = i * sizeof(limb_type) * 8;
+            backend.limbs()[i] = static_cast<limb_type>(limbs[bit / 64] >> (bit % 64));
+        }
+    backend.normalize();
+    return v;
+}
+
+inline unsigned Word256::significantLimbs() const
+{
+    unsigned n = 4;
+    while (n > 0 && limbs[n - 1] == 0)
+        --n;
+    return n;
+}
+
+inline unsigned Word256::shiftAmount() const
+{
+    if ((limbs[1] | limbs[2] | limbs[3]) != 0 || limbs[0] >= 256)
+        return 256;
+    return static_cast<unsigned>(limbs[0]);
+}
+
+inline bool operator==(Word256 const& _a, Word256 const& _b)
+{
+    return ((_a.limbs[0] ^ _b.limbs[0]) | (_a.limbs[1] ^ _b.limbs[1]) |
+               (_a.limbs[2] ^ _b.limbs[2]) | (_a.limbs[3] ^ _b.limbs[3])) == 0;
+}
+
+inline bool operator!=(Word256 const& _a, Word256 const& _b)
+{
+    return !(_a == _b);
+}
+
+inline bool operator<(Word256 const& _a, Word256 const& _b)
+{
+    // the borrow out of the subtraction
+    uint8_t borrow = 0;
+    for (unsigned i = 0; i < 4; ++i)
+        word256::subBorrow(_a.limbs[i], _b.limbs[i], borrow);
+    return borrow;
+}
+
+inline bool operator>(Word256 const& _a, Word256 const& _b)
+{
+    return _b < _a;
+}
+
+/// Two's complement comparison.
+inline bool slt(Word256 const& _a, Word256 const& _b)
+{
+    if (_a.isNegative() != _b.isNegative())
+        return _a.isNegative();
+    return _a < _b;
+}
+
+inline Word256 operator+(Word256 const& _a, Word256 const& _b)
+{
+    Word256 r;
+    uint8_t carry = 0;
+    for (unsigned i = 0; i < 4; ++i)
+        r.limbs[i] = word256::addCarry(_a.limbs[i], _b.limbs[i], carry);
+    return r;
+}
+
+inline Word256 operator-(Word256 const& _a, Word256 const& _b)
+{
+    Word256 r;
+    uint8_t borrow = 0;
+    for (unsigned i = 0; i < 4; ++i)
+        r.limbs[i] = word256::subBorrow(_a.limbs[i], _b.limbs[i], borrow);
+    return r;
+}
+
+/// Product modulo 2^256.
+inline Word256 operator*(Word256 const& _a, Word256 const& _b)
+{
+    Word256 r;
+    for (unsigned i = 0; i < 4; ++i)
+    {
+        uint64_t carry = 0;
+        for (unsigned j = 0; i + j < 4; ++j)
+        {
+            uint64_t hi;
+            uint64_t lo = word256::mulWide(_a.limbs[i], _b.limbs[j], hi);
+            lo += carry;
+            hi += lo < carry;
+            r.limbs[i + j] += lo;
+            hi += r.limbs[i + j] < lo;
+            carry = hi;
+        }
+    }
+    return r;
+}
+
+/// Left shift, 0 if @a _shift is 256 or more.
+inline Word256 operator<<(Word256 const& _a, unsigned _shift)
+{
+    Word256 r;
+    if (_shift >= 256)
+        return r;
+    unsigned limbShift = _shift / 64;
+    unsigned bitShift = _shift % 64;
+    for (unsigned i = limbShift; i < 4; ++i)
+    {
+        r.limbs[i] = _a.limbs[i - limbShift] << bitShift;
+        if (bitShift && i > limbShift)
+            r.limbs[i] |= _a.limbs[i - limbShift - 1] >> (64 - bitShift);
+    }
+    return r;
+}
+
+/// Logical right shift, 0 if @a _shift is 256 or more.
+inline Word256 operator>>(Word256 const& _a, unsigned _shift)
+{
+    Word256 r;
+    if (_shift >= 256)
+        return r;
+    unsigned limbShift = _shift / 64;
+    unsigned bitShift = _shift % 64;
+    for (unsigned i = 0; i + limbShift < 4; ++i)
+    {
+        r.limbs[i] = _a.limbs[i + limbShift] >> bitShift;
+        if (bitShift && i + limbShift < 3)
+            r.limbs[i] |= _a.limbs[i + limbShift + 1] << (64 - bitShift);
+    }
+    return r;
+}
+
+/// Arithmetic right shift.
+inline Word256 sar(Word256 const& _a, unsigned _shift)
+{
+    if (!_a.isNegative())
+        return _a >> _shift;
+    if (_shift >= 256)
+        return Word256(~0ULL, ~0ULL, ~0ULL, ~0ULL);
+    Word256 r = _a >> _shift;
+    Word256 fill = Word256(~0ULL, ~0ULL, ~0ULL, ~0ULL) << (256 - _shift);
+    for (unsigned i = 0; i < 4; ++i)
+        r.limbs[i] |= fill.limbs[i];
+    return r;
+}
+
+/// Sets @a o_quotient and @a o_remainder to the quotient and the remainder of @a _a by
+/// @a _b, which must not be 0.
+void divRem(Word256 const& _a, Word256 const& _b, Word256& o_quotient, Word256& o_remainder);
+
+/// (@a _a + @a _b) % @a _m computed without overflow, @a _m must not be 0.
+Word256 addMod(Word256 const& _a, Word256 const& _b, Word256 const& _m);
+
+/// (@a _a * @a _b) % @a _m computed without overflow, @a _m must not be 0.
+Word256 mulMod(Word256 const& _a, Word256 const& _b, Word256 const& _m);
+
+/// @a _base to the power of @a _exponent modulo 2^256.
+Word256 exp(Word256 _base, Word256 const& _exponent);
+
+}  // namespace dev
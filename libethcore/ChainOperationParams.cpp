@@ -55,6 +55,8 @@ ChainOperationParams::ChainOperationParams():
 
 EVMSchedule const& ChainOperationParams::scheduleForBlockNumber(u256 const& _blockNumber) const
 {
+    if (customSchedule)
+        return *customSchedule;
     if (_blockNumber >= experimentalForkBlock)
         return ExperimentalSchedule;
     else if (_blockNumber >= constantinopleFixForkBlock)
@@ -106,6 +106,10 @@ public:
 
     /// Precompiled contracts as specified in the chain params.
     std::unordered_map<Address, PrecompiledContract> precompiled;
+
+    /// Schedule used for every block instead of the one of its fork, e.g. to benchmark a
+    /// repricing of the instructions.
+    boost::optional<EVMSchedule> customSchedule;
 };
 
 }
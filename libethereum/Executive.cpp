@@ -32,6 +32,7 @@
 
 #include <json/json.h>
 
+#include <algorithm>
 #include <numeric>
 #include <set>
 #include <sstream>
@@ -43,8 +44,6 @@ using namespace dev::eth;
 
 namespace
 {
-const int64_t nanosecondsPerSecond = 1000000000;
-
 std::string dumpStackAndMemory(LegacyVM const& _vm)
 {
     ostringstream o;
@@ -453,16 +452,20 @@ OnOpFunc Executive::traceInstructions(bool debug)
     auto& instructionStats = m_instructionStats;
 
     return [&instructionStats, debug](
-               uint64_t /* steps */, uint64_t /* PC */, Instruction inst,
+               uint64_t /* steps */, uint64_t PC, Instruction inst,
                bigint /* newMemSize */, bigint /* gasCost */, bigint gas, VMFace const* _vm,
                ExtVMFace const* voidExt) {
         ExtVM const& ext = *dynamic_cast<ExtVM const*>(voidExt);
+        // only the legacy VM exposes its stack, instructions traced by other VMs
+        // are recorded without their arguments
+        static const u256s noStack;
         auto vm = dynamic_cast<LegacyVM const*>(_vm);
-        const auto& stack = vm->stack();
+        const auto& stack = vm != nullptr ? vm->stack() : noStack;
 
-        auto einstruction = fromInstruction(inst, stack);
+        auto einstruction = vm != nullptr ? fromInstruction(inst, stack) : fromInstruction(inst);
 
         instructionStats.recordInstruction(einstruction);
+        instructionStats.recordBigram(inst, PC, ext.depth);
 
         if (debug)
         {
@@ -516,45 +519,104 @@ OnOpFunc Executive::traceInstructions(bool debug)
     };
 }
 
-OnOpFunc Executive::benchmarkInstructionsOp()
+namespace
 {
-    auto& start = m_benchmarkStart;
-    auto& benchmarking = m_benchmarking;
-
-    return [&start, &benchmarking](uint64_t /* steps */, uint64_t /* PC */, Instruction /* inst */,
+OnOpFunc startInstructionProbe(InstructionSampler& sampler)
+{
+    return [&sampler](uint64_t /* steps */, uint64_t /* PC */, Instruction /* inst */,
                bigint /* newMemSize */, bigint /* gasCost */, bigint /* gas */,
-               VMFace const* /* _vm */, ExtVMFace const* /* voidExt */) {
-        benchmarking = clock_gettime(CLOCK_MONOTONIC, &start) == 0;
+               VMFace const* /* _vm */, ExtVMFace const* /* voidExt */) { sampler.start(); };
+}
+
+OnOpFunc stopInstructionProbe(
+    InstructionSampler& sampler, InstructionHistograms::ThreadHistograms& histograms)
+{
+    return [&sampler, &histograms](uint64_t /* steps */, uint64_t /* PC */, Instruction inst,
+               bigint /* newMemSize */, bigint gasCost, bigint /* gas */, VMFace const* _vm,
+               ExtVMFace const* /* voidExt */) {
+        if (!sampler.stop())
+            return;
+        // only calls to precompiled contracts need the stack to be inspected
+        auto einst = fromInstruction(inst);
+        if (inst == Instruction::CALL)
+        {
+            if (auto vm = dynamic_cast<LegacyVM const*>(_vm))
+                einst = fromInstruction(inst, vm->stack());
+        }
+        histograms.record(einst, sampler.lastNanoseconds(), gasCost.convert_to<double>());
     };
 }
+}  // namespace
+
+OnOpFunc Executive::benchmarkInstructionsOp()
+{
+    return startInstructionProbe(m_sampler);
+}
 
 
 OnOpFunc Executive::benchmarkInstructionsAfterOp(InstructionsBenchmark& benchmark)
 {
-    auto& start = m_benchmarkStart;
-    auto& end = m_benchmarkEnd;
-    auto& benchmarking = m_benchmarking;
-    auto& logger = m_warningLogger;
-    return [&start, &end, &benchmark, &benchmarking, &logger](uint64_t /* steps */,
-               uint64_t /* PC */, Instruction inst, bigint /* newMemSize */, bigint gasCost,
-               bigint /* gas */, VMFace const* _vm, ExtVMFace const* /* voidExt */) {
-        auto vm = dynamic_cast<LegacyVM const*>(_vm);
-        const auto& stack = vm->stack();
+    // the table of the executing thread, so that recording does not need any lookup
+    return stopInstructionProbe(m_sampler, benchmark.local());
+}
 
-        if (benchmarking && clock_gettime(CLOCK_MONOTONIC, &end) == 0)
-        {
-            auto ellapsed = (end.tv_sec * nanosecondsPerSecond + end.tv_nsec) -
-                            (start.tv_sec * nanosecondsPerSecond + start.tv_nsec);
-            if (ellapsed < 0)
-            {
-                LOG(logger) << "ellapsed time is negative: " << ellapsed
-                            << "ns, something might be wrong";
-                ellapsed = 0;
-            }
-            auto einst = fromInstruction(inst, stack);
-            benchmark.addMeasurement(einst, BenchmarkMeasurement(ellapsed, gasCost));
-        }
-    };
+OnOpFunc Executive::benchmarkBasicBlocksOp(BasicBlockProfile& profile)
+{
+    m_basicBlockTimer.reset(
+        new BasicBlockTimer(profile, m_sampler.sampling().probeOverheadCycles));
+    auto& timer = *m_basicBlockTimer;
+    return [&timer](uint64_t steps, uint64_t PC, Instruction /* inst */, bigint /* newMemSize */,
+               bigint gasCost, bigint /* gas */, VMFace const* /* _vm */,
+               ExtVMFace const* voidExt) { timer.onOp(steps, PC, gasCost, voidExt); };
+}
+
+OnOpFunc Executive::profileHotSpotsOp(HotSpotProfiler& profiler)
+{
+    m_hotSpotTracer.reset(new HotSpotTracer(profiler, m_sampler.sampling().probeOverheadCycles));
+    auto& tracer = *m_hotSpotTracer;
+    return [&tracer](uint64_t steps, uint64_t PC, Instruction inst, bigint /* newMemSize */,
+               bigint gasCost, bigint /* gas */, VMFace const* /* _vm */,
+               ExtVMFace const* voidExt) { tracer.onOp(steps, PC, inst, gasCost, voidExt); };
+}
+
+void Executive::stopHardwareCounters()
+{
+    if (m_runningCounterCollector == nullptr)
+        return;
+    m_hardwareCounters = m_runningCounterCollector->stop();
+    m_runningCounterCollector = nullptr;
+}
+
+OnOpFunc Executive::trackStorageAccessesOp()
+{
+    m_storageAccessTracker.reset(new StorageAccessTracker());
+    auto& tracker = *m_storageAccessTracker;
+    return [&tracker](uint64_t /* steps */, uint64_t /* PC */, Instruction inst,
+               bigint /* newMemSize */, bigint /* gasCost */, bigint gas, VMFace const* /* _vm */,
+               ExtVMFace const* voidExt) { tracker.onOp(inst, gas, voidExt); };
+}
+
+double Executive::measureProbeOverhead(size_t iterations)
+{
+    InstructionHistograms histograms;
+    InstructionSampler sampler;
+    // the probes are called through the same wrappers as during the executions
+    auto startProbe = compoundOnOpFunc({startInstructionProbe(sampler)});
+    auto stopProbe = stopInstructionProbe(sampler, histograms.local());
+
+    std::vector<uint64_t> cycles;
+    cycles.reserve(iterations);
+    for (size_t i = 0; i < iterations; i++)
+    {
+        startProbe(0, 0, Instruction::STOP, 0, 0, 0, nullptr, nullptr);
+        stopProbe(0, 0, Instruction::STOP, 0, 0, 0, nullptr, nullptr);
+        cycles.push_back(sampler.lastCycles());
+    }
+    if (cycles.empty())
+        return 0;
+    auto median = cycles.begin() + cycles.size() / 2;
+    std::nth_element(cycles.begin(), median, cycles.end());
+    return static_cast<double>(*median);
 }
 #endif
 
@@ -613,6 +675,12 @@ bool Executive::go(OnOpFunc const& _onOp)
             else
             {
 #if ETH_MEASURE_GAS
+                // counters are started before the timer so that they are not part of the time
+                if (m_collectHardwareCounters)
+                {
+                    m_runningCounterCollector = &HardwareCounterCollector::threadCollector();
+                    m_runningCounterCollector->start();
+                }
                 SystemUsageStatCollector collector;
                 {
                     auto vm = VMFactory::create();
@@ -620,6 +688,7 @@ bool Executive::go(OnOpFunc const& _onOp)
                 }
                 m_usageStat = collector.getSystemStat();
                 m_usageStatCollected = true;
+                stopHardwareCounters();
 #else
                 auto vm = VMFactory::create();
                 m_output = vm->exec(m_gas, *m_ext, _onOp);
@@ -628,12 +697,18 @@ bool Executive::go(OnOpFunc const& _onOp)
         }
         catch (RevertInstruction& _e)
         {
+#if ETH_MEASURE_GAS
+            stopHardwareCounters();
+#endif
             revert();
             m_output = _e.output();
             m_excepted = TransactionException::RevertInstruction;
         }
         catch (VMException const& _e)
         {
+#if ETH_MEASURE_GAS
+            stopHardwareCounters();
+#endif
             LOG(m_detailsLogger) << "Safe VM Exception. " << diagnostic_information(_e);
             m_gas = 0;
             m_excepted = toTransactionException(_e);
@@ -641,6 +716,9 @@ bool Executive::go(OnOpFunc const& _onOp)
         }
         catch (InternalVMError const& _e)
         {
+#if ETH_MEASURE_GAS
+            stopHardwareCounters();
+#endif
             cerror << "Internal VM Error (EVMC status code: "
                  << *boost::get_error_info<errinfo_evmcStatusCode>(_e) << ")";
             revert();
@@ -676,56 +754,39 @@ bool Executive::go(OnOpFunc const& _onOp)
 }
 
 #ifdef ETH_MEASURE_GAS
-static std::string u256ToString(const u256& value)
-{
-    stringstream ss;
-    ss << value;
-    return ss.str();
-}
-
-void Executive::outputResults(std::ostream& os, bool includeInput)
+boost::optional<TransactionMeasurement> Executive::measurement(bool includeOutput) const
 {
     if (!m_usageStatCollected || !m_t)
     {
-        return;
+        return boost::none;
     }
-    Json::Value root;
-    root["env"] = Json::Value();
-    root["env"]["block"] = m_envInfo.number();
-
-
-    root["usage"] = m_usageStat.toJson();
-    root["instructions"] = m_instructionStats.toJson();
+    TransactionMeasurement measurement;
+    measurement.blockNumber = m_envInfo.number();
+    measurement.usage = m_usageStat;
+    if (m_collectHardwareCounters)
+        measurement.counters = m_hardwareCounters;
+    measurement.instructions = m_instructionStats;
 
     if (m_res)
     {
-        root["transaction"] = Json::Value();
-        if (m_t.hasSignature()) {
-            root["transaction"]["hash"] = m_t.sha3().hex();
-        }
-        root["transaction"]["sender"] = m_t.sender().hex();
-        root["transaction"]["receiver"] = m_t.receiveAddress().hex();
-        root["transaction"]["to"] = m_t.to().hex();
-        root["transaction"]["gas"] = u256ToString(m_t.gas());
-        root["transaction"]["gas_price"] = u256ToString(m_t.gasPrice());
-        root["transaction"]["value"] = u256ToString(m_t.value());
-        root["transaction"]["gas_for_deposit"] = u256ToString(m_res->gasForDeposit);
-        root["transaction"]["gas_refunded"] = u256ToString(m_res->gasRefunded);
-        root["transaction"]["gas_used"] = u256ToString(m_res->gasUsed);
-        root["transaction"]["output_size"] = m_res->output.size();
-        root["transaction"]["excepted"] = static_cast<int>(m_res->excepted);
-        if (includeInput) {
-            root["transaction"]["output"] = toHex(m_res->output);
-        }
-
-        root["usage"]["gas/s"] = m_res->gasUsed.convert_to<double>() / m_usageStat.chronoTime;
+        measurement.hasResult = true;
+        if (m_t.hasSignature())
+            measurement.hash = m_t.sha3();
+        measurement.sender = m_t.sender();
+        measurement.receiver = m_t.receiveAddress();
+        measurement.to = m_t.to();
+        measurement.gas = m_t.gas();
+        measurement.gasPrice = m_t.gasPrice();
+        measurement.value = m_t.value();
+        measurement.gasForDeposit = m_res->gasForDeposit;
+        measurement.gasRefunded = m_res->gasRefunded;
+        measurement.gasUsed = m_res->gasUsed;
+        measurement.outputSize = m_res->output.size();
+        measurement.excepted = static_cast<int64_t>(m_res->excepted);
+        if (includeOutput)
+            measurement.output = m_res->output;
     }
-
-    Json::StreamWriterBuilder builder;
-    builder.settings_["indentation"] = "";
-    std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
-    writer->write(root, &os);
-    os << std::endl;
+    return measurement;
 }
 #endif
 
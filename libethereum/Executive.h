@@ -25,9 +25,16 @@
 #include <map>
 
 #ifdef ETH_MEASURE_GAS
+#include <libevmanalysis/BasicBlocks.h>
 #include <libevmanalysis/BenchmarkResults.h>
+#include <libevmanalysis/HardwareCounterCollector.h>
+#include <libevmanalysis/HotSpots.h>
+#include <libevmanalysis/StorageAccesses.h>
+#include <libevmanalysis/InstructionHistograms.h>
+#include <libevmanalysis/InstructionSampler.h>
 #include <libevmanalysis/InstructionStats.h>
 #include <libevmanalysis/SystemUsageStatCollector.h>
+#include <libevmanalysis/TransactionMeasurement.h>
 #endif
 
 #ifndef BENCHMARK_GRANULARITY
@@ -198,12 +205,18 @@ public:
     void revert();
 
 #if ETH_MEASURE_GAS
-    /// Output measurements
-    void outputResults(std::ostream& os, bool includeInput = false);
+    /// Copy of the measurements of the execution, none if the transaction was not executed
+    boost::optional<TransactionMeasurement> measurement(bool includeOutput = false) const;
 
     /// Returns the execution time of the contract
     float executionTime() const { return m_usageStat.chronoTime; };
 
+    /// Count the hardware events of the VM execution with the counters of the calling thread
+    void collectHardwareCounters(bool _collect) { m_collectHardwareCounters = _collect; }
+
+    /// Returns the hardware events of the VM execution, only set when collected
+    HardwareCounters const& hardwareCounters() const { return m_hardwareCounters; }
+
     /// Operation function to trace changes to the store during gas execution
     OnOpFunc traceInstructions(bool debug = false);
 
@@ -213,6 +226,33 @@ public:
     /// Operations function to save benchmark instructions
     OnOpFunc benchmarkInstructionsAfterOp(InstructionsBenchmark& benchmark);
 
+    /// Operations function timing basic blocks, replaces the instructions benchmark operations.
+    /// The probe overhead of the instruction sampling is subtracted from the measurements
+    OnOpFunc benchmarkBasicBlocksOp(BasicBlockProfile& profile);
+
+    /// Operations function timing the code locations executed by the transaction, nested calls
+    /// included, the samples are added to `profiler` when the executive is destroyed
+    OnOpFunc profileHotSpotsOp(HotSpotProfiler& profiler);
+
+    /// Operations function classifying and timing the state accesses of the transaction
+    OnOpFunc trackStorageAccessesOp();
+
+    /// State accesses of the execution, null if they were not tracked
+    StorageAccessStats const* storageAccesses() const
+    {
+        return m_storageAccessTracker ? &m_storageAccessTracker->stats() : nullptr;
+    }
+
+    /// Selects the instructions timed by the benchmark operations
+    void setInstructionSampling(InstructionSampling const& _sampling)
+    {
+        m_sampler = InstructionSampler(_sampling);
+    }
+
+    /// Median number of cycles measured by the benchmark operations around an empty
+    /// instruction, to be set as `InstructionSampling::probeOverheadCycles`
+    static double measureProbeOverhead(size_t iterations = 100000);
+
     // Go function accepting an after operation
     bool go(OnOpFunc const& _onOp, OnOpFunc const& _afterOp);
 #endif
@@ -242,10 +282,17 @@ private:
 #if ETH_MEASURE_GAS
     SystemUsageStat m_usageStat;
     bool m_usageStatCollected = false;
+    bool m_collectHardwareCounters = false;
+    HardwareCounters m_hardwareCounters;
+    /// collector counting the VM execution, null when it is not running
+    HardwareCounterCollector* m_runningCounterCollector = nullptr;
+    /// Stops the counters of the VM execution if they are running
+    void stopHardwareCounters();
     InstructionStats m_instructionStats;
-    bool m_benchmarking = false;
-    timespec m_benchmarkStart;
-    timespec m_benchmarkEnd;
+    InstructionSampler m_sampler;
+    std::unique_ptr<BasicBlockTimer> m_basicBlockTimer;
+    std::unique_ptr<HotSpotTracer> m_hotSpotTracer;
+    std::unique_ptr<StorageAccessTracker> m_storageAccessTracker;
 #endif
 
     bool m_isCreation = false;
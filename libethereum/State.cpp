@@ -625,23 +625,35 @@ std::pair<ExecutionResult, TransactionReceipt> State::execute(EnvInfo const& _en
 
 #if ETH_MEASURE_GAS
     auto afterOp = OnOpFunc();
+    e.collectHardwareCounters(analysisEnv()->hardwareCounters());
+    e.setInstructionSampling(analysisEnv()->instructionSampling());
     auto traceOp = e.traceInstructions();
-    auto benchmarkOp = e.benchmarkInstructionsOp();
+    // the basic blocks and hot spots profiles replace the instructions benchmark
+    auto basicBlockProfile = analysisEnv()->basicBlockProfile();
+    auto hotSpotProfiler = analysisEnv()->hotSpotProfiler();
+    auto benchmarkOp = basicBlockProfile ? e.benchmarkBasicBlocksOp(*basicBlockProfile) :
+                       hotSpotProfiler   ? e.profileHotSpotsOp(*hotSpotProfiler) :
+                                           e.benchmarkInstructionsOp();
     auto ops = std::vector<OnOpFunc>({traceOp, benchmarkOp});
+    // last so that the accesses are timed as close as possible to their instructions
+    if (analysisEnv()->storageAccessTracking())
+        ops.push_back(e.trackStorageAccessesOp());
     if (!onOp)
     {
         onOp = compoundOnOpFunc(ops);
-        afterOp = e.benchmarkInstructionsAfterOp(analysisEnv()->instructionsBenchmark());
+        if (!basicBlockProfile && !hotSpotProfiler)
+            afterOp = e.benchmarkInstructionsAfterOp(analysisEnv()->instructionsBenchmark());
     }
     bool const statusCode = executeTransaction(e, _t, onOp, afterOp);
-    {
-        boost::mutex::scoped_lock scoped_lock(analysisEnv()->statStreamLock());
-        e.outputResults(analysisEnv()->statStream());
-    }
+    if (auto measurement = e.measurement())
+        analysisEnv()->outputTransaction(std::move(*measurement));
+    if (auto storageAccesses = e.storageAccesses())
+        analysisEnv()->addStorageAccesses(*storageAccesses);
     if (_envInfo.number() % analysisEnv()->benchmarkInteval() == 0)
     {
         analysisEnv()->outputInstructionsBenchmark(_envInfo.number());
     }
+    analysisEnv()->outputHotSpots(_envInfo.number());
 #else
     bool const statusCode = executeTransaction(e, _t, onOp);
 #endif
@@ -667,16 +679,31 @@ std::pair<ExecutionResult, TransactionReceipt> State::execute(EnvInfo const& _en
 }
 
 void State::executeBlockTransactions(Block const& _block, unsigned _txCount, LastBlockHashesFace const& _lastHashes, SealEngineFace const& _sealEngine)
+{
+    executeBlockTransactions(_block.info(), _block.pending(), _txCount, _lastHashes, _sealEngine);
+}
+
+void State::executeBlockTransactions(BlockHeader const& _header, Transactions const& _transactions, unsigned _txCount, LastBlockHashesFace const& _lastHashes, SealEngineFace const& _sealEngine, TransactionCallback const& _onTransaction)
 {
     u256 gasUsed = 0;
     for (unsigned i = 0; i < _txCount; ++i)
     {
-        EnvInfo envInfo(_block.info(), _lastHashes, gasUsed);
+        EnvInfo envInfo(_header, _lastHashes, gasUsed);
 
         Executive e(*this, envInfo, _sealEngine);
-        executeTransaction(e, _block.pending()[i], OnOpFunc());
+#if ETH_MEASURE_GAS
+        ExecutionResult res;
+        if (_onTransaction)
+        {
+            e.setResultRecipient(res);
+            e.collectHardwareCounters(analysisEnv() && analysisEnv()->hardwareCounters());
+        }
+#endif
+        executeTransaction(e, _transactions[i], OnOpFunc());
 
         gasUsed += e.gasUsed();
+        if (_onTransaction)
+            _onTransaction(i, e);
     }
 }
 
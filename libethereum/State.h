@@ -242,6 +242,13 @@ public:
     /// This will change the state accordingly.
     void executeBlockTransactions(Block const& _block, unsigned _txCount, LastBlockHashesFace const& _lastHashes, SealEngineFace const& _sealEngine);
 
+    /// Called after each transaction executed by executeBlockTransactions with its index.
+    using TransactionCallback = std::function<void(unsigned, Executive const&)>;
+
+    /// Execute the @a _txCount first transactions of @a _transactions in the block @a _header.
+    /// This will change the state accordingly.
+    void executeBlockTransactions(BlockHeader const& _header, Transactions const& _transactions, unsigned _txCount, LastBlockHashesFace const& _lastHashes, SealEngineFace const& _sealEngine, TransactionCallback const& _onTransaction = TransactionCallback());
+
     /// Check if the address is in use.
     bool addressInUse(Address const& _address) const;
 
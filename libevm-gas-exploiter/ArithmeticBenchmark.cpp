@@ -0,0 +1,173 @@
+#include "ArithmeticBenchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <random>
+#include <stdexcept>
+
+#include <libdevcore/Common.h>
+#include <libdevcore/Word256.h>
+
+namespace dev
+{
+namespace eth
+{
+namespace
+{
+/// Keeps the results alive so that the timed loops are not optimized out
+volatile uint64_t g_sink = 0;
+
+uint64_t lowLimb(u256 const& value)
+{
+    return value.backend().limbs()[0];
+}
+
+struct Operands
+{
+    std::vector<u256> a;
+    std::vector<u256> b;
+    std::vector<u256> c;
+};
+
+/// Values of 1 to 256 bits so that the divisions go through their different paths
+u256 randomValue(std::mt19937_64& engine)
+{
+    unsigned bits = engine() % 256 + 1;
+    u256 value;
+    for (unsigned i = 0; i < 4; ++i)
+        value = (value << 64) | engine();
+    value >>= 256 - bits;
+    return value | 1;
+}
+
+Operands makeOperands(size_t count, unsigned seed)
+{
+    std::mt19937_64 engine(seed);
+    Operands operands;
+    for (size_t i = 0; i < count; ++i)
+    {
+        operands.a.push_back(randomValue(engine));
+        operands.b.push_back(randomValue(engine));
+        operands.c.push_back(randomValue(engine));
+    }
+    return operands;
+}
+
+/// Best time per operation of `repetitions` passes of `operation` over the operands indices
+template <typename Operation>
+double timeOperation(size_t count, uint32_t repetitions, Operation operation)
+{
+    double best = std::numeric_limits<double>::max();
+    uint64_t sink = 0;
+    for (uint32_t r = 0; r < repetitions; ++r)
+    {
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; ++i)
+            sink ^= operation(i);
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    g_sink ^= sink;
+    return best / count;
+}
+
+u256 boostExp(u256 base, u256 exponent)
+{
+    u256 result = 1;
+    while (exponent)
+    {
+        if (static_cast<uint64_t>(exponent) & 1)
+            result *= base;
+        base *= base;
+        exponent >>= 1;
+    }
+    return result;
+}
+
+unsigned boostShift(u256 const& shift)
+{
+    return shift >= 256 ? 256 : unsigned(shift);
+}
+}  // namespace
+
+Json::Value ArithmeticBenchmarkResult::toJson() const
+{
+    Json::Value root;
+    root["name"] = name;
+    root["boost_time"] = boostTime;
+    root["word256_time"] = word256Time;
+    root["speedup"] = speedup();
+    return root;
+}
+
+std::vector<ArithmeticBenchmarkResult> benchmarkArithmetic(
+    size_t operandsCount, uint32_t repetitions, unsigned seed)
+{
+    if (operandsCount == 0 || repetitions == 0)
+        throw std::invalid_argument("the operands count and the repetitions should be positive");
+
+    auto operands = makeOperands(operandsCount, seed);
+    auto const& a = operands.a;
+    auto const& b = operands.b;
+    auto const& c = operands.c;
+    // shift amounts below 256 for the shifts to do some work
+    std::vector<u256> shifts;
+    for (auto const& value : c)
+        shifts.push_back(value % 256);
+
+    std::vector<ArithmeticBenchmarkResult> results;
+    auto add = [&](std::string const& name, double boostTime, double word256Time) {
+        results.push_back({name, boostTime, word256Time});
+    };
+    auto time = [&](auto operation) { return timeOperation(operandsCount, repetitions, operation); };
+
+    add("ADD", time([&](size_t i) { return lowLimb(a[i] + b[i]); }),
+        time([&](size_t i) { return lowLimb((Word256(a[i]) + Word256(b[i])).toU256()); }));
+    add("SUB", time([&](size_t i) { return lowLimb(a[i] - b[i]); }),
+        time([&](size_t i) { return lowLimb((Word256(a[i]) - Word256(b[i])).toU256()); }));
+    add("MUL", time([&](size_t i) { return lowLimb(a[i] * b[i]); }),
+        time([&](size_t i) { return lowLimb((Word256(a[i]) * Word256(b[i])).toU256()); }));
+    add("DIV", time([&](size_t i) { return lowLimb(u256(s512(a[i]) / s512(b[i]))); }),
+        time([&](size_t i) {
+            Word256 q, r;
+            divRem(Word256(a[i]), Word256(b[i]), q, r);
+            return lowLimb(q.toU256());
+        }));
+    add("MOD", time([&](size_t i) { return lowLimb(u256(s512(a[i]) % s512(b[i]))); }),
+        time([&](size_t i) {
+            Word256 q, r;
+            divRem(Word256(a[i]), Word256(b[i]), q, r);
+            return lowLimb(r.toU256());
+        }));
+    add("ADDMOD", time([&](size_t i) { return lowLimb(u256((u512(a[i]) + u512(b[i])) % c[i])); }),
+        time([&](size_t i) {
+            return lowLimb(addMod(Word256(a[i]), Word256(b[i]), Word256(c[i])).toU256());
+        }));
+    add("MULMOD", time([&](size_t i) { return lowLimb(u256((u512(a[i]) * u512(b[i])) % c[i])); }),
+        time([&](size_t i) {
+            return lowLimb(mulMod(Word256(a[i]), Word256(b[i]), Word256(c[i])).toU256());
+        }));
+    add("EXP", time([&](size_t i) { return lowLimb(boostExp(a[i], b[i])); }),
+        time([&](size_t i) { return lowLimb(exp(Word256(a[i]), Word256(b[i])).toU256()); }));
+    add("LT", time([&](size_t i) { return uint64_t(a[i] < b[i]); }),
+        time([&](size_t i) { return uint64_t(Word256(a[i]) < Word256(b[i])); }));
+    add("SLT", time([&](size_t i) { return uint64_t(u2s(a[i]) < u2s(b[i])); }),
+        time([&](size_t i) { return uint64_t(slt(Word256(a[i]), Word256(b[i]))); }));
+    add("SHL", time([&](size_t i) { return lowLimb(a[i] << boostShift(shifts[i])); }),
+        time([&](size_t i) {
+            return lowLimb((Word256(a[i]) << Word256(shifts[i]).shiftAmount()).toU256());
+        }));
+    add("SHR", time([&](size_t i) { return lowLimb(a[i] >> boostShift(shifts[i])); }),
+        time([&](size_t i) {
+            return lowLimb((Word256(a[i]) >> Word256(shifts[i]).shiftAmount()).toU256());
+        }));
+    add("SAR", time([&](size_t i) { return lowLimb(s2u(u2s(a[i]) >> boostShift(shifts[i]))); }),
+        time([&](size_t i) {
+            return lowLimb(sar(Word256(a[i]), Word256(shifts[i]).shiftAmount()).toU256());
+        }));
+    return results;
+}
+
+}  // namespace eth
+}  // namespace dev
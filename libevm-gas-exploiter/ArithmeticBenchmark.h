@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <json/json.h>
+
+namespace dev
+{
+namespace eth
+{
+/// Time of the implementation of an arithmetic instruction by the legacy VM, on boost
+/// multiprecision, and by the interpreter, on the Word256 kernels
+struct ArithmeticBenchmarkResult
+{
+    std::string name;
+    /// nanoseconds per operation, including the conversions from and to the u256 of the stack
+    double boostTime = 0;
+    double word256Time = 0;
+
+    double speedup() const { return word256Time > 0 ? boostTime / word256Time : 0; }
+    Json::Value toJson() const;
+};
+
+/// Times the arithmetic, comparison and shift instructions on `operandsCount` random operands
+/// of random widths, each time being the best of `repetitions` passes over the operands.
+/// Throws std::invalid_argument if `operandsCount` or `repetitions` is 0
+std::vector<ArithmeticBenchmarkResult> benchmarkArithmetic(
+    size_t operandsCount, uint32_t repetitions, unsigned seed);
+
+}  // namespace eth
+}  // namespace dev
@@ -0,0 +1,136 @@
+#include "BenchmarkContext.h"
+
+#include <libethereum/Transaction.h>
+#include <libevmanalysis/SystemUsageStatCollector.h>
+
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace dev
+{
+namespace eth
+{
+
+std::vector<Address> contractAddresses(size_t count)
+{
+    std::vector<Address> addresses;
+    std::string baseAddress = "1122334455667788991011121314151617181920";
+    size_t codeIndexLength = std::max<size_t>(1, static_cast<size_t>(ceil(log10(count))));
+    baseAddress = baseAddress.substr(0, baseAddress.size() - codeIndexLength);
+    for (size_t i = 0; i < count; i++)
+    {
+        std::ostringstream oss;
+        oss << baseAddress << std::setw(codeIndexLength) << std::setfill('0') << i;
+        addresses.push_back(Address(oss.str()));
+    }
+    return addresses;
+}
+
+
+BenchmarkContext::BenchmarkContext(const ExecutionEnv& execEnv, const std::vector<bytes>& codes,
+    bool collectCounters, const std::string& vm)
+  : m_execEnv(execEnv),
+    m_state(execEnv.block.state()),
+    m_envInfo(execEnv.blockHeader, execEnv.chain->lastBlockHashes(), 0),
+    m_addresses(contractAddresses(codes.size())),
+    m_vm(vm.empty() ? VMFactory::create() : VMFactory::create(vm))
+{
+    std::unordered_map<Address, Account> map;
+    for (size_t i = 0; i < codes.size(); i++)
+    {
+        Account account(0, 0);
+        account.setCode(bytes{codes[i]});
+        map[m_addresses[i]] = account;
+    }
+    m_state.populateFrom(map);
+
+    auto sealEngine = execEnv.chain->sealEngine();
+    for (size_t i = 0; i < codes.size(); i++)
+    {
+        // same transfer as the one done by Executive::call for each transaction
+        m_state.addBalance(execEnv.sender, execEnv.value);
+        m_state.transferBalance(execEnv.sender, m_addresses[i], execEnv.value);
+
+        m_exts.emplace_back(new ExtVM(m_state, m_envInfo, *sealEngine, m_addresses[i],
+            execEnv.sender, execEnv.sender, execEnv.value, execEnv.gasPrice, &m_data, &codes[i],
+            m_state.codeHash(m_addresses[i]), 0, false, false));
+    }
+
+    m_savepoint = m_state.savepoint();
+
+    if (collectCounters)
+    {
+        m_counterCollector = &HardwareCounterCollector::threadCollector();
+    }
+}
+
+ExecutionStats BenchmarkContext::execute(size_t index, bool debug)
+{
+    auto& ext = *m_exts[index];
+    ext.sub.clear();
+
+    OnOpFunc onOp;
+    if (debug)
+    {
+        onOp = [](uint64_t, uint64_t, Instruction inst, bigint, bigint, bigint gas, VMFace const*,
+                   ExtVMFace const*) {
+            std::cout << instructionInfo(inst).name << "(gas left = " << gas << ")" << std::endl;
+        };
+    }
+
+    u256 gas = m_execEnv.gas;
+    bytes output;
+    auto excepted = TransactionException::None;
+
+    // the counters are started outside of the timed region to keep the time comparable
+    if (m_counterCollector)
+    {
+        m_counterCollector->start();
+    }
+    SystemUsageStatCollector collector;
+    try
+    {
+        output = m_vm->exec(gas, ext, onOp).toVector();
+    }
+    catch (RevertInstruction& e)
+    {
+        output = e.output().toVector();
+        excepted = TransactionException::RevertInstruction;
+        // the substate is dropped as in Executive::revert
+        ext.sub.clear();
+    }
+    catch (VMException const& e)
+    {
+        gas = 0;
+        excepted = toTransactionException(e);
+        ext.sub.clear();
+    }
+    auto usageStat = collector.getSystemStat();
+    HardwareCounters counters;
+    if (m_counterCollector)
+    {
+        counters = m_counterCollector->stop();
+    }
+
+    // refunds are applied as in Executive::finalize, the exceptions drop them with the substate
+    if (excepted == TransactionException::None)
+    {
+        ext.sub.refunds += ext.evmSchedule().suicideRefundGas * ext.sub.suicides.size();
+        int64_t maxRefund = (static_cast<int64_t>(m_execEnv.gas) - static_cast<int64_t>(gas)) / 2;
+        gas += std::min(maxRefund, ext.sub.refunds);
+    }
+
+    m_state.rollback(m_savepoint);
+
+    return ExecutionStats{
+        .gasUsed = m_execEnv.gas - gas,
+        .executionTime = usageStat.chronoTime,
+        .output = output,
+        .excepted = excepted,
+        .counters = counters,
+    };
+}
+
+}  // namespace eth
+}  // namespace dev
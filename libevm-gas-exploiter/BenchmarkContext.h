@@ -0,0 +1,57 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <libethereum/ExtVM.h>
+#include <libethereum/State.h>
+#include <libevm/VMFactory.h>
+
+#include "ExecutionEnv.h"
+
+namespace dev
+{
+namespace eth
+{
+
+/// BenchmarkContext executes programs repeatedly without going through `Executive`.
+/// The state, the `ExtVM` of each program and the VM are created once,
+/// and the state is rolled back to a savepoint after each execution,
+/// so that only `vm->exec` is timed.
+/// The execution time is measured with the same collector as `Executive::executionTime()`
+/// but does not include the creation and destruction of the VM.
+class BenchmarkContext
+{
+public:
+    /// When `collectCounters` is true, the hardware counters of the calling thread
+    /// are opened here and the context must only be used from this thread.
+    /// `vm` is a name accepted by `VMFactory::create`, the VM selected with --vm when empty
+    BenchmarkContext(const ExecutionEnv& execEnv, const std::vector<bytes>& codes,
+        bool collectCounters = false, const std::string& vm = "");
+
+    BenchmarkContext(const BenchmarkContext&) = delete;
+    BenchmarkContext& operator=(const BenchmarkContext&) = delete;
+
+    /// Executes the code at `index` and restores the state as it was before the execution
+    ExecutionStats execute(size_t index, bool debug = false);
+
+    size_t size() const { return m_exts.size(); }
+    const Address& address(size_t index) const { return m_addresses[index]; }
+
+private:
+    ExecutionEnv m_execEnv;
+    State m_state;
+    EnvInfo m_envInfo;
+    std::vector<Address> m_addresses;
+    bytes m_data;  ///< call data of every execution, referenced by the ExtVMs
+    std::vector<std::unique_ptr<ExtVM>> m_exts;
+    VMPtr m_vm;
+    size_t m_savepoint;
+    HardwareCounterCollector* m_counterCollector = nullptr;
+};
+
+/// Returns the `count` addresses at which the programs of a block are deployed
+std::vector<Address> contractAddresses(size_t count);
+
+}  // namespace eth
+}  // namespace dev
@@ -1,26 +1,63 @@
 #include <fcntl.h>
+#include <sched.h>
 
+#include <cerrno>
+#include <cmath>
+#include <cstring>
+
+#include "BenchmarkContext.h"
 #include "Benchmarker.h"
 #include "Utils.h"
 
+#include <libdevcore/SHA3.h>
 #include <libethereum/Executive.h>
+#include <libevm/VMFactory.h>
 
 namespace
 {
 
 const uint64_t warmupCount = 3;
 
-void dropCache()
+/// Whether a program measured `measurements` times needs to be executed again
+bool needsMoreMeasurements(const std::vector<double>& measurements, const dev::eth::BenchmarkConfig& config)
 {
-    sync();
-
-    std::ofstream ofs("/proc/sys/vm/drop_caches");
-    ofs << "3" << std::endl;
-    ofs.close();
-    if(!ofs)
+    if (measurements.size() < config.execCount)
     {
-        throw std::runtime_error("failed to drop cache");
+        return true;
+    }
+    if (config.targetMedianWidth <= 0 || measurements.size() >= config.maxExecCount)
+    {
+        return false;
     }
+    if (measurements.empty())
+    {
+        return true;
+    }
+    auto interval = dev::math::medianConfidenceInterval(measurements.begin(), measurements.end());
+    auto median = dev::math::constMedian(measurements.begin(), measurements.end());
+    return median <= 0 || (interval.second - interval.first) / median > config.targetMedianWidth;
+}
+
+dev::eth::ExecutionAggregatedStats aggregateMeasurements(
+    const dev::u256& gasUsed, const std::vector<double>& measurements)
+{
+    double totalTime = dev::math::sum(measurements.begin(), measurements.end());
+    double medianTime = dev::math::constMedian(measurements.begin(), measurements.end());
+    auto interval = dev::math::medianConfidenceInterval(measurements.begin(), measurements.end());
+    return dev::eth::ExecutionAggregatedStats{
+        .gas = gasUsed.convert_to<uint64_t>(),
+        .execCount = measurements.size(),
+        .totalTime = totalTime,
+        .gasPerSecond = gasUsed.convert_to<double>() / totalTime * measurements.size(),
+        .timeMean = dev::math::mean(measurements.begin(), measurements.end()),
+        .timeStdev = dev::math::stdev(measurements.begin(), measurements.end()),
+        .timeMedian = medianTime,
+        .medianGasPerSecond = gasUsed.convert_to<double>() / medianTime,
+        .measurements = measurements,
+        .counters = boost::none,
+        .timeMedianLow = interval.first,
+        .timeMedianHigh = interval.second,
+    };
 }
 
 }
@@ -29,6 +66,17 @@ namespace dev
 {
 namespace eth
 {
+Json::Value WorkerCalibration::toJson() const
+{
+    Json::Value root;
+    root["core"] = core;
+    root["initialTime"] = initialTime;
+    root["lastTime"] = lastTime;
+    root["drift"] = drift;
+    root["skew"] = skew;
+    return root;
+}
+
 Json::Value BenchmarkStats::toJson(bool verbose) const
 {
     Json::Value root;
@@ -44,6 +92,15 @@ Json::Value BenchmarkStats::toJson(bool verbose) const
         root["blockExecutionTimes"].append(executionTime);
     }
 
+    if (!workerCalibrations.empty())
+    {
+        root["workerCalibrations"] = Json::Value(Json::arrayValue);
+        for (auto& calibration : workerCalibrations)
+        {
+            root["workerCalibrations"].append(calibration.toJson());
+        }
+    }
+
     if (verbose)
     {
         root["programStats"] = Json::Value(Json::arrayValue);
@@ -115,12 +172,168 @@ ExecutionStats executeCode(bytes code, ExecutionEnv execEnv, bool debug)
 }
 
 
-ExecutionAggregatedStats benchmarkCode(ExecutionEnv execEnv, bytes code, const BenchmarkConfig& config)
+VMAggregation parseVMAggregation(const std::string& name)
+{
+    if (name == "min")
+    {
+        return VMAggregation::Min;
+    }
+    else if (name == "geomean")
+    {
+        return VMAggregation::GeometricMean;
+    }
+    throw std::invalid_argument("VM aggregation should be 'min' or 'geomean', got '" + name + "'");
+}
+
+
+h256 benchmarkFingerprint(const ExecutionEnv& execEnv, const BenchmarkConfig& config)
+{
+    Json::Value root;
+    Json::Value& vms = root["vms"];
+    if (config.vms.empty())
+    {
+        vms.append(VMFactory::name());
+    }
+    for (const auto& vm : config.vms)
+    {
+        vms.append(vm);
+    }
+    root["vm_aggregation"] = static_cast<int>(config.vmAggregation);
+    for (const auto& option : evmcOptions())
+    {
+        Json::Value pair;
+        pair.append(option.first);
+        pair.append(option.second);
+        root["evmc_options"].append(pair);
+    }
+    root["exec_count"] = static_cast<Json::UInt64>(config.execCount);
+    root["max_exec_count"] = static_cast<Json::UInt64>(config.maxExecCount);
+    root["target_median_width"] = config.targetMedianWidth;
+    root["warmup"] = config.warmup;
+    root["drop_caches"] = config.dropCaches;
+    root["always_drop_cache"] = config.alwaysDropCache;
+    root["hardware_counters"] = config.hardwareCounters;
+
+    // not the hash of the header, whose timestamp changes with each run
+    root["block"]["number"] = static_cast<Json::Int64>(execEnv.blockHeader.number());
+    root["block"]["gas_limit"] = execEnv.blockHeader.gasLimit().str();
+    root["block"]["difficulty"] = execEnv.blockHeader.difficulty().str();
+    root["block"]["author"] = execEnv.blockHeader.author().hex();
+    if (execEnv.chain != nullptr)
+    {
+        root["genesis"] = execEnv.chain->genesisHash().hex();
+    }
+    root["value"] = execEnv.value.str();
+    root["gas_price"] = execEnv.gasPrice.str();
+    root["gas"] = execEnv.gas.str();
+    root["sender"] = execEnv.sender.hex();
+    root["origin"] = execEnv.origin.hex();
+
+    Json::StreamWriterBuilder builder;
+    builder.settings_["indentation"] = "";
+    return sha3(Json::writeString(builder, root));
+}
+
+
+namespace
+{
+double geometricMean(const std::vector<double>& values)
+{
+    double logSum = 0;
+    for (auto value : values)
+    {
+        logSum += std::log(value);
+    }
+    return std::exp(logSum / values.size());
+}
+
+double combine(const std::vector<double>& values, VMAggregation aggregation)
+{
+    if (aggregation == VMAggregation::Min)
+    {
+        return *std::min_element(values.begin(), values.end());
+    }
+    return geometricMean(values);
+}
+
+ExecutionAggregatedStats combineVMStats(
+    const std::map<std::string, ExecutionAggregatedStats>& backends, VMAggregation aggregation)
+{
+    const auto& first = backends.begin()->second;
+    for (const auto& backend : backends)
+    {
+        if (backend.second.gas != first.gas)
+        {
+            throw std::runtime_error("obtained different gas used on VM " + backend.first);
+        }
+    }
+
+    ExecutionAggregatedStats result;
+    if (aggregation == VMAggregation::Min)
+    {
+        auto fastest = std::min_element(backends.begin(), backends.end(),
+            [](const std::pair<const std::string, ExecutionAggregatedStats>& left,
+                const std::pair<const std::string, ExecutionAggregatedStats>& right) {
+                return left.second.timeMedian < right.second.timeMedian;
+            });
+        result = fastest->second;
+    }
+    else
+    {
+        // combines a time of every VM, the throughputs are computed from the combined times
+        auto combineField = [&](double ExecutionAggregatedStats::*field) {
+            std::vector<double> values;
+            for (const auto& backend : backends)
+            {
+                values.push_back(backend.second.*field);
+            }
+            return geometricMean(values);
+        };
+        result = first;
+        result.execCount = 0;
+        result.totalTime = 0;
+        result.counters = HardwareCounters();
+        for (const auto& backend : backends)
+        {
+            result.execCount += backend.second.execCount;
+            result.totalTime += backend.second.totalTime;
+            if (result.counters && backend.second.counters)
+            {
+                *result.counters += *backend.second.counters;
+            }
+            else
+            {
+                result.counters = boost::none;
+            }
+        }
+        result.timeMean = combineField(&ExecutionAggregatedStats::timeMean);
+        result.timeStdev = combineField(&ExecutionAggregatedStats::timeStdev);
+        result.timeMedian = combineField(&ExecutionAggregatedStats::timeMedian);
+        result.timeMedianLow = combineField(&ExecutionAggregatedStats::timeMedianLow);
+        result.timeMedianHigh = combineField(&ExecutionAggregatedStats::timeMedianHigh);
+        result.gasPerSecond = result.gas / result.timeMean;
+        result.medianGasPerSecond = result.gas / result.timeMedian;
+        // measurements of different VMs cannot be combined one by one
+        result.measurements.clear();
+    }
+    result.backends = backends;
+    return result;
+}
+
+ExecutionAggregatedStats benchmarkCodeOnVM(
+    ExecutionEnv execEnv, const bytes& code, const BenchmarkConfig& config, const std::string& vm)
 {
     std::vector<double> measurements;
     u256 gasUsed = 0;
     bytes output;
 
+    BenchmarkContext context(execEnv, {code}, config.hardwareCounters, vm);
+    boost::optional<HardwareCounters> counters;
+    if (config.hardwareCounters)
+    {
+        counters = HardwareCounters();
+    }
+
     if (config.dropCaches)
     {
         dropCache();
@@ -130,17 +343,17 @@ ExecutionAggregatedStats benchmarkCode(ExecutionEnv execEnv, bytes code, const B
     {
         for (uint64_t i = 0; i < warmupCount; i++)
         {
-            executeCode(code, execEnv, config.debug);
+            context.execute(0, config.debug);
         }
     }
 
-    for (uint64_t i = 0; i < config.execCount; i++)
+    while (needsMoreMeasurements(measurements, config))
     {
         if (config.alwaysDropCache)
         {
             dropCache();
         }
-        auto stats = executeCode(code, execEnv, config.debug);
+        auto stats = context.execute(0, config.debug);
         if (stats.excepted != TransactionException::None)
         {
             std::stringstream ss;
@@ -170,46 +383,70 @@ ExecutionAggregatedStats benchmarkCode(ExecutionEnv execEnv, bytes code, const B
         }
 
         measurements.push_back(stats.executionTime);
+        if (counters)
+        {
+            *counters += stats.counters;
+        }
     }
 
-    double totalTime = math::sum(measurements.begin(), measurements.end());
-    double medianTime = math::constMedian(measurements.begin(), measurements.end());
-    return ExecutionAggregatedStats{
-        .gas = gasUsed.convert_to<uint64_t>(),
-        .execCount = config.execCount,
-        .totalTime = totalTime,
-        .gasPerSecond = gasUsed.convert_to<double>() / totalTime * config.execCount,
-        .timeMean = math::mean(measurements.begin(), measurements.end()),
-        .timeStdev = math::stdev(measurements.begin(), measurements.end()),
-        .timeMedian = medianTime,
-        .medianGasPerSecond = gasUsed.convert_to<double>() / medianTime,
-        .measurements = measurements,
-    };
+    auto result = aggregateMeasurements(gasUsed, measurements);
+    result.counters = counters;
+    return result;
 }
 
 
-BenchmarkStats benchmarkCodes(
-    ExecutionEnv execEnv, const std::vector<bytes>& codes, const BenchmarkConfig& config)
+BenchmarkStats benchmarkCodesOnVM(ExecutionEnv execEnv, const std::vector<bytes>& codes,
+    const BenchmarkConfig& config, const std::string& vm)
 {
     std::vector<std::vector<double>> measurements(codes.size());
     std::vector<u256> gasUsed(codes.size(), 0);
     std::vector<bytes> outputs(codes.size());
+    std::vector<HardwareCounters> counters(codes.size());
 
-    std::unordered_map<Address, Account> map;
-    std::vector<Address> addresses;
-    std::string baseAddress = "1122334455667788991011121314151617181920";
-    size_t codeIndexLength = static_cast<size_t>(ceil(log10(codes.size())));
-    baseAddress = baseAddress.substr(0, baseAddress.size() - codeIndexLength);
-    for (size_t i = 0; i < codes.size(); i++)
-    {
-        std::ostringstream oss;
-        oss << baseAddress << std::setw(codeIndexLength) << std::setfill('0') << i;
-        Address contractDestination(oss.str());
-        Account account(0, 0);
-        addresses.push_back(contractDestination);
-        account.setCode(bytes{codes[i]});
-        map[contractDestination] = account;
-    }
+    // all the contracts are deployed once and the state is restored after each execution
+    BenchmarkContext context(execEnv, codes, config.hardwareCounters, vm);
+
+    // executes the j-th program once and returns its execution time
+    auto measure = [&](size_t j) {
+        if (config.alwaysDropCache)
+        {
+            dropCache();
+        }
+
+        auto stats = context.execute(j, config.debug);
+
+        if (stats.excepted != TransactionException::None)
+        {
+            std::stringstream ss;
+            ss << "exception: " << stats.excepted;
+            throw std::runtime_error(ss.str().c_str());
+        }
+
+        if (outputs[j].empty())
+        {
+            outputs[j] = stats.output;
+        }
+        else if (outputs[j] != stats.output)
+        {
+            throw std::runtime_error("obtained different output");
+        }
+
+        if (gasUsed[j] == 0)
+        {
+            gasUsed[j] = stats.gasUsed;
+        }
+        else if (gasUsed[j] != stats.gasUsed)
+        {
+            std::stringstream ss;
+            ss << "obtained different gas used: '" << gasUsed[j]
+               << "' != '" << stats.gasUsed << "'";
+            throw std::runtime_error(ss.str().c_str());
+        }
+
+        measurements[j].push_back(stats.executionTime);
+        counters[j] += stats.counters;
+        return stats.executionTime;
+    };
 
     std::vector<double> blockExecutionTimes;
 
@@ -221,98 +458,170 @@ BenchmarkStats benchmarkCodes(
         }
 
         // Execute all the contracts as if they were part of the same block
-        auto block = execEnv.block;
-        auto& state = block.mutableState();
-        auto blockHeader = execEnv.blockHeader;
-        state.populateFrom(map);
-
         double totalExecutionTime = 0.0;
-
         for (size_t j = 0; j < codes.size(); j++)
         {
-            if (config.alwaysDropCache)
-            {
-                dropCache();
-            }
-
-            auto stats = executeCode(addresses[j], execEnv, state, blockHeader, config.debug);
+            totalExecutionTime += measure(j);
+        }
+        blockExecutionTimes.push_back(totalExecutionTime);
+    }
 
-            if (stats.excepted != TransactionException::None)
-            {
-                std::stringstream ss;
-                ss << "exception: " << stats.excepted;
-                throw std::runtime_error(ss.str().c_str());
-            }
-            totalExecutionTime += stats.executionTime;
+    // in adaptive mode, only the programs whose median is not precise enough yet are executed
+    // again, these executions are not part of the block execution times
+    std::vector<size_t> pending;
+    for (size_t j = 0; j < codes.size(); j++)
+    {
+        if (needsMoreMeasurements(measurements[j], config))
+        {
+            pending.push_back(j);
+        }
+    }
+    while (!pending.empty())
+    {
+        if (config.dropCaches)
+        {
+            dropCache();
+        }
 
-            if (outputs[j].empty())
-            {
-                outputs[j] = stats.output;
-            }
-            else if (outputs[j] != stats.output)
+        std::vector<size_t> stillPending;
+        for (auto j : pending)
+        {
+            measure(j);
+            if (needsMoreMeasurements(measurements[j], config))
             {
-                throw std::runtime_error("obtained different output");
+                stillPending.push_back(j);
             }
+        }
+        pending = stillPending;
+    }
 
-            if (gasUsed[j] == 0)
-            {
-                gasUsed[j] = stats.gasUsed;
-            }
-            else if (gasUsed[j] != stats.gasUsed)
-            {
-                std::stringstream ss;
-                ss << "obtained different gas used: '" << gasUsed[j]
-                   << "' != '" << stats.gasUsed << "'";
-                throw std::runtime_error(ss.str().c_str());
-            }
+    std::vector<ExecutionAggregatedStats> results(codes.size());
 
-            measurements[j].push_back(stats.executionTime);
+    for (size_t i = 0; i < codes.size(); i++)
+    {
+        results[i] = aggregateMeasurements(gasUsed[i], measurements[i]);
+        if (config.hardwareCounters)
+        {
+            results[i].counters = counters[i];
         }
+    }
 
-        blockExecutionTimes.push_back(totalExecutionTime);
+    return aggregateBenchmarkStats(blockExecutionTimes, results);
+}
+}  // namespace
+
+
+ExecutionAggregatedStats benchmarkCode(ExecutionEnv execEnv, bytes code, const BenchmarkConfig& config)
+{
+    if (config.vms.empty())
+    {
+        return benchmarkCodeOnVM(execEnv, code, config, "");
     }
 
-    std::vector<ExecutionAggregatedStats> results(codes.size());
+    std::map<std::string, ExecutionAggregatedStats> backends;
+    for (const auto& vm : config.vms)
+    {
+        backends[vm] = benchmarkCodeOnVM(execEnv, code, config, vm);
+    }
+    return combineVMStats(backends, config.vmAggregation);
+}
+
+
+BenchmarkStats benchmarkCodes(
+    ExecutionEnv execEnv, const std::vector<bytes>& codes, const BenchmarkConfig& config)
+{
+    if (config.vms.empty())
+    {
+        return benchmarkCodesOnVM(execEnv, codes, config, "");
+    }
+
+    std::vector<BenchmarkStats> vmStats;
+    for (const auto& vm : config.vms)
+    {
+        vmStats.push_back(benchmarkCodesOnVM(execEnv, codes, config, vm));
+    }
+
+    // block times are combined iteration by iteration
+    std::vector<double> blockExecutionTimes;
+    for (size_t i = 0; i < vmStats[0].blockExecutionTimes.size(); i++)
+    {
+        std::vector<double> times;
+        for (const auto& stats : vmStats)
+        {
+            times.push_back(stats.blockExecutionTimes[i]);
+        }
+        blockExecutionTimes.push_back(combine(times, config.vmAggregation));
+    }
 
-    u256 blockGas = 0;
+    std::vector<ExecutionAggregatedStats> programStats;
     for (size_t i = 0; i < codes.size(); i++)
     {
-        auto& codeMeasurements = measurements[i];
-        double totalTime = math::sum(codeMeasurements.begin(), codeMeasurements.end());
-        double medianTime = math::constMedian(codeMeasurements.begin(), codeMeasurements.end());
-        auto gas = gasUsed[i];
-        blockGas += gas;
-        results[i] = ExecutionAggregatedStats{
-            .gas = gas.convert_to<uint64_t>(),
-            .execCount = config.execCount,
-            .totalTime = totalTime,
-            .gasPerSecond = gas.convert_to<double>() / totalTime * config.execCount,
-            .timeMean = math::mean(codeMeasurements.begin(), codeMeasurements.end()),
-            .timeStdev = math::stdev(codeMeasurements.begin(), codeMeasurements.end()),
-            .timeMedian = medianTime,
-            .medianGasPerSecond = gas.convert_to<double>() / medianTime,
-            .measurements = measurements[i],
-        };
+        std::map<std::string, ExecutionAggregatedStats> backends;
+        for (size_t j = 0; j < config.vms.size(); j++)
+        {
+            backends[config.vms[j]] = vmStats[j].programStats[i];
+        }
+        programStats.push_back(combineVMStats(backends, config.vmAggregation));
+    }
+
+    return aggregateBenchmarkStats(blockExecutionTimes, programStats);
+}
+
+
+BenchmarkStats aggregateBenchmarkStats(
+    std::vector<double> blockExecutionTimes, std::vector<ExecutionAggregatedStats> programStats)
+{
+    double blockGas = 0;
+    for (auto& stats : programStats)
+    {
+        blockGas += stats.gas;
     }
 
     auto blockExecTimeMean = math::mean(blockExecutionTimes.begin(), blockExecutionTimes.end());
     auto blockExecTimeMedian = math::constMedian(blockExecutionTimes.begin(), blockExecutionTimes.end());
-    auto blockGasD = blockGas.convert_to<double>();
 
     return BenchmarkStats{
         .blockExecutionTimeMean = blockExecTimeMean,
         .blockExecutionTimeMedian = blockExecTimeMedian,
         .blockExecutionTimeStdev =
             math::stdev(blockExecutionTimes.begin(), blockExecutionTimes.end()),
-        .blockGas = blockGasD,
-        .blockThroughputMean = blockGasD / blockExecTimeMean,
-        .blockThroughputMedian = blockGasD / blockExecTimeMedian,
+        .blockGas = blockGas,
+        .blockThroughputMean = blockGas / blockExecTimeMean,
+        .blockThroughputMedian = blockGas / blockExecTimeMedian,
         .blockExecutionTimes = blockExecutionTimes,
-        .programStats = results,
+        .programStats = programStats,
+        .workerCalibrations = std::vector<WorkerCalibration>(),
     };
 }
 
 
+void dropCache()
+{
+    sync();
+
+    std::ofstream ofs("/proc/sys/vm/drop_caches");
+    ofs << "3" << std::endl;
+    ofs.close();
+    if(!ofs)
+    {
+        throw std::runtime_error("failed to drop cache");
+    }
+}
+
+
+void pinToCore(unsigned core)
+{
+    cpu_set_t cpuSet;
+    CPU_ZERO(&cpuSet);
+    CPU_SET(core, &cpuSet);
+    if (sched_setaffinity(0, sizeof(cpuSet), &cpuSet) != 0)
+    {
+        throw std::runtime_error(
+            "failed to pin to core " + std::to_string(core) + ": " + std::strerror(errno));
+    }
+}
+
+
 void runInitialWarmup(
     std::shared_ptr<ProgramGenerator> programGenerator,
     ExecutionEnv execEnv,
@@ -9,6 +9,21 @@ namespace dev
 {
 namespace eth
 {
+/// Timing of a fixed reference program on a benchmark worker, used to check
+/// that the cores of a worker pool stay comparable over a long search
+struct WorkerCalibration
+{
+    unsigned core;
+    double initialTime;
+    double lastTime;
+    /// relative change of lastTime compared to the time measured when the worker started
+    double drift;
+    /// relative difference of lastTime compared to the median of all the workers
+    double skew;
+
+    Json::Value toJson() const;
+};
+
 struct BenchmarkStats
 {
     double blockExecutionTimeMean;
@@ -19,10 +34,23 @@ struct BenchmarkStats
     double blockThroughputMedian;
     std::vector<double> blockExecutionTimes;
     std::vector<ExecutionAggregatedStats> programStats;
+    std::vector<WorkerCalibration> workerCalibrations;
 
     Json::Value toJson(bool verbose = false) const;
 };
 
+/// How the measurements of a program on several VMs are combined
+enum class VMAggregation
+{
+    /// keep the stats of the VM with the lowest median time,
+    /// i.e. a program is only as slow as it is on the fastest VM
+    Min,
+    /// geometric mean of the times on each VM
+    GeometricMean,
+};
+
+VMAggregation parseVMAggregation(const std::string& name);
+
 struct BenchmarkConfig
 {
     BenchmarkConfig(uint64_t _execCount, bool _debug = false,
@@ -38,13 +66,41 @@ struct BenchmarkConfig
     bool warmup = true;
     bool dropCaches = false;
     bool alwaysDropCache = false;
+    /// collect CPU cycles, cache, branch and TLB misses of each execution with perf_event_open
+    bool hardwareCounters = false;
+    /// when positive, programs are executed again after `execCount` executions until
+    /// the confidence interval of their median time is narrower than this fraction of the median,
+    /// or until they were executed `maxExecCount` times
+    double targetMedianWidth = 0;
+    uint64_t maxExecCount = 0;
+    /// VMs every program is executed on, by name as accepted by `VMFactory::create`
+    /// programs run on the VM selected with --vm when empty
+    std::vector<std::string> vms;
+    VMAggregation vmAggregation = VMAggregation::Min;
 };
 
+/// Hash of the settings the measurements of a program depend on: the measured VMs and their
+/// EVMC options, how their measurements are aggregated, the number of executions, the
+/// hardware counters and the environment of the executions. Measurements made with
+/// different fingerprints cannot be compared, see `FitnessCache`
+h256 benchmarkFingerprint(const ExecutionEnv& execEnv, const BenchmarkConfig& config);
+
 ExecutionStats executeCode(bytes code, ExecutionEnv execEnv, bool debug = false);
 ExecutionAggregatedStats benchmarkCode(ExecutionEnv execEnv, bytes code, const BenchmarkConfig& config);
 BenchmarkStats benchmarkCodes(
     ExecutionEnv execEnv, const std::vector<bytes>& codes, const BenchmarkConfig& config);
 
+/// Computes the block level statistics from the per-iteration block execution times
+/// and the statistics of each program of the block
+BenchmarkStats aggregateBenchmarkStats(
+    std::vector<double> blockExecutionTimes, std::vector<ExecutionAggregatedStats> programStats);
+
+/// Writes the dirty pages and drops the page cache, dentries and inodes, requires root
+void dropCache();
+
+/// Pins the calling thread to the given core
+void pinToCore(unsigned core);
+
 void runInitialWarmup(
     std::shared_ptr<ProgramGenerator> programGenerator,
     ExecutionEnv execEnv,
@@ -0,0 +1,148 @@
+#include "BlockReplay.h"
+
+#include <chrono>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include <libethereum/Executive.h>
+#include <libethereum/GenesisInfo.h>
+#include <libethereum/State.h>
+
+#include "Benchmarker.h"
+
+namespace dev
+{
+namespace eth
+{
+namespace
+{
+/// Moves the balances of the DAO accounts at the DAO fork block, as Block does before the
+/// transactions
+void performIrregularModifications(State& state, const ChainParams& params, uint64_t number)
+{
+    if (params.daoHardforkBlock == 0 || number != params.daoHardforkBlock)
+        return;
+    Address recipient("0xbf4ed7b27f1d666546e30d74d50d173d20bca754");
+    for (Address const& dao : childDaos())
+        state.transferBalance(dao, recipient, state.balance(dao));
+    state.commit(State::CommitBehaviour::KeepEmptyAccounts);
+}
+
+/// Rewards the author of the block and of its uncles, as Block::applyRewards
+void applyRewards(State& state, const BlockHeader& header, const std::vector<BlockHeader>& uncles,
+    const u256& blockReward)
+{
+    u256 reward = blockReward;
+    for (auto const& uncle : uncles)
+    {
+        state.addBalance(uncle.author(), blockReward * (8 + uncle.number() - header.number()) / 8);
+        reward += blockReward / 32;
+    }
+    state.addBalance(header.author(), reward);
+}
+}  // namespace
+
+Json::Value BlockReplayStats::toJson() const
+{
+    Json::Value root;
+    root["number"] = static_cast<Json::UInt64>(blockNumber);
+    root["repeat"] = static_cast<Json::UInt64>(repeat);
+    root["transactions_count"] = transactionsCount;
+    root["gas_used"] = gasUsed.str();
+    root["state_root"] = stateRoot.hex();
+    root["execution_time"] = executionTime;
+    root["wall_time"] = wallTime;
+    root["gas/s"] = wallTime > 0 ? gasUsed.convert_to<double>() / wallTime : 0;
+    return root;
+}
+
+void replayBlocks(const BlockChain& chain, const OverlayDB& stateDB,
+    std::shared_ptr<AnalysisEnv> analysisEnv, const BlockReplayConfig& config,
+    std::ostream& output)
+{
+    if (config.firstBlock == 0 || config.firstBlock > config.lastBlock ||
+        config.lastBlock > chain.number())
+    {
+        throw std::invalid_argument("the blocks to replay must be between 1 and " +
+                                    std::to_string(chain.number()));
+    }
+    if (config.core >= 0)
+        pinToCore(static_cast<unsigned>(config.core));
+
+    Json::StreamWriterBuilder builder;
+    builder.settings_["indentation"] = "";
+    std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+
+    for (uint64_t number = config.firstBlock; number <= config.lastBlock; number++)
+    {
+        auto hash = chain.numberHash(static_cast<unsigned>(number));
+        auto block = chain.block(hash);
+        BlockHeader header(block);
+        BlockHeader parent = chain.info(header.parentHash());
+
+        Transactions transactions;
+        for (auto const& transactionRLP : RLP(block)[1])
+        {
+            transactions.emplace_back(transactionRLP.data(), CheckTransaction::None);
+            transactions.back().sender();
+        }
+        std::vector<BlockHeader> uncles;
+        for (auto const& uncleRLP : RLP(block)[2])
+            uncles.emplace_back(uncleRLP.data(), HeaderData);
+        auto const blockReward = chain.sealEngine()->blockReward(number);
+
+        for (uint64_t repeat = 0; repeat < config.repeatCount; repeat++)
+        {
+            if (config.dropCaches)
+                dropCache();
+            // the state copies the database, so the nodes committed by the previous
+            // executions are not in its memory layer
+            State state(chain.chainParams().accountStartNonce, stateDB, analysisEnv);
+            state.setRoot(parent.stateRoot());
+            performIrregularModifications(state, chain.chainParams(), number);
+
+            BlockReplayStats stats;
+            stats.blockNumber = number;
+            stats.repeat = repeat;
+            stats.transactionsCount = transactions.size();
+            // written after the block so that the outputs are not part of its time
+            std::vector<std::pair<unsigned, TransactionMeasurement>> measurements;
+            auto start = std::chrono::steady_clock::now();
+            state.executeBlockTransactions(header, transactions, transactions.size(),
+                chain.lastBlockHashes(), *chain.sealEngine(),
+                [&](unsigned index, Executive const& e) {
+                    stats.gasUsed += e.gasUsed();
+                    // transfers do not run the VM and have no measurement
+                    auto measurement = e.measurement();
+                    if (!measurement)
+                        return;
+                    stats.executionTime += measurement->usage.chronoTime;
+                    measurements.emplace_back(index, std::move(*measurement));
+                });
+            stats.wallTime =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            applyRewards(state, header, uncles, blockReward);
+            state.commit(number >= chain.chainParams().EIP158ForkBlock ?
+                             State::CommitBehaviour::RemoveEmptyAccounts :
+                             State::CommitBehaviour::KeepEmptyAccounts);
+            stats.stateRoot = state.rootHash();
+
+            for (auto const& measurement : measurements)
+            {
+                auto root = measurement.second.toJson();
+                root["replay"]["repeat"] = static_cast<Json::UInt64>(repeat);
+                root["replay"]["index"] = measurement.first;
+                writer->write(root, &output);
+                output << std::endl;
+            }
+            Json::Value root;
+            root["block"] = stats.toJson();
+            writer->write(root, &output);
+            output << std::endl;
+        }
+    }
+}
+
+}  // namespace eth
+}  // namespace dev
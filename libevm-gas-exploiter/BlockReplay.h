@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <ostream>
+
+#include <json/json.h>
+
+#include <libdevcore/OverlayDB.h>
+#include <libethereum/BlockChain.h>
+#include <libevmanalysis/AnalysisEnv.h>
+
+namespace dev
+{
+namespace eth
+{
+struct BlockReplayConfig
+{
+    /// range of blocks to execute, both included
+    uint64_t firstBlock = 1;
+    uint64_t lastBlock = 1;
+    /// executions of each block
+    uint64_t repeatCount = 1;
+    /// drops the page cache before each execution of a block, requires root
+    bool dropCaches = false;
+    /// core the calling thread is pinned to, -1 to stay on the current one
+    int core = -1;
+};
+
+/// Totals of the executions of a block
+struct BlockReplayStats
+{
+    uint64_t blockNumber = 0;
+    uint64_t repeat = 0;
+    unsigned transactionsCount = 0;
+    u256 gasUsed;
+    /// root of the state after the transactions and the block rewards, the state root of the
+    /// header if the execution matches the one of the chain
+    h256 stateRoot;
+    /// seconds, sum of the execution times of the transactions
+    double executionTime = 0;
+    /// seconds, execution of all the transactions including their initialization and
+    /// finalization
+    double wallTime = 0;
+
+    Json::Value toJson() const;
+};
+
+/// Re-executes the transactions of the blocks of an existing chain database on the state of
+/// their parent, without networking or block verification. Each execution runs on a new State
+/// over a copy of `stateDB`, starting from the parent state root with an empty accounts cache.
+/// The rewards of the block and the DAO fork transfers are applied as in Block, outside of the
+/// timed execution, and the state is committed to the copy after it is timed. The transactions
+/// senders are recovered before the executions so that the signatures checks are not measured.
+///
+/// After each execution of a block, a JSON line is written to `output` for each transaction
+/// running the VM (its measurement with a `replay` object holding the repeat and the index of
+/// the transaction) and one for the block (a `block` object with the totals and the state root).
+/// Throws std::invalid_argument if the range is not in the chain
+void replayBlocks(const BlockChain& chain, const OverlayDB& stateDB,
+    std::shared_ptr<AnalysisEnv> analysisEnv, const BlockReplayConfig& config,
+    std::ostream& output);
+
+}  // namespace eth
+}  // namespace dev
@@ -9,11 +9,16 @@ Json::Value ExecutionAggregatedStats::toJson() const
 {
     Json::Value root;
     root["gas"] = gas;
+    root["exec_count"] = execCount;
+    root["total_time"] = totalTime;
     root["gas_per_second"] = gasPerSecond;
     root["time_mean"] = timeMean;
     root["time_stdev"] = timeStdev;
     root["time_median"] = timeMedian;
     root["median_gas_per_second"] = medianGasPerSecond;
+    root["time_median_ci"] = Json::Value(Json::arrayValue);
+    root["time_median_ci"].append(timeMedianLow);
+    root["time_median_ci"].append(timeMedianHigh);
     if (!measurements.empty())
     {
         root["measurements"] = Json::Value(Json::arrayValue);
@@ -22,9 +27,82 @@ Json::Value ExecutionAggregatedStats::toJson() const
             root["measurements"].append(measurement);
         }
     }
+    if (counters)
+    {
+        root["counters"] = counters->toJson();
+        root["cycles_per_gas"] = cyclesPerGas();
+        if (counters->cycles > 0)
+        {
+            root["instructions_per_cycle"] =
+                static_cast<double>(counters->instructions) / counters->cycles;
+        }
+    }
+    if (!backends.empty())
+    {
+        root["backends"] = Json::Value(Json::objectValue);
+        for (const auto& backend : backends)
+        {
+            root["backends"][backend.first] = backend.second.toJson();
+        }
+    }
     return root;
 }
 
+double ExecutionAggregatedStats::cyclesPerGas() const
+{
+    if (!counters || gas == 0 || execCount == 0)
+    {
+        return 0;
+    }
+    return static_cast<double>(counters->cycles) / execCount / gas;
+}
+
+double ExecutionAggregatedStats::timeMedianRelativeWidth() const
+{
+    if (timeMedian <= 0)
+    {
+        return 0;
+    }
+    return (timeMedianHigh - timeMedianLow) / timeMedian;
+}
+
+ExecutionAggregatedStats ExecutionAggregatedStats::fromJson(const Json::Value& root)
+{
+    std::vector<double> measurements;
+    for (auto& measurement : root["measurements"])
+    {
+        measurements.push_back(measurement.asDouble());
+    }
+    boost::optional<HardwareCounters> counters;
+    if (root.isMember("counters"))
+    {
+        counters = HardwareCounters::fromJson(root["counters"]);
+    }
+    // evaluations saved before the interval was reported have the median as bounds
+    auto timeMedian = root["time_median"].asDouble();
+    const auto& medianInterval = root["time_median_ci"];
+    std::map<std::string, ExecutionAggregatedStats> backends;
+    for (const auto& name : root["backends"].getMemberNames())
+    {
+        backends[name] = fromJson(root["backends"][name]);
+    }
+    return ExecutionAggregatedStats{
+        .gas = root["gas"].asUInt64(),
+        .execCount = root.get("exec_count", static_cast<Json::UInt64>(measurements.size())).asUInt64(),
+        .totalTime = root["total_time"].asDouble(),
+        .gasPerSecond = root["gas_per_second"].asDouble(),
+        .timeMean = root["time_mean"].asDouble(),
+        .timeStdev = root["time_stdev"].asDouble(),
+        .timeMedian = timeMedian,
+        .medianGasPerSecond = root["median_gas_per_second"].asDouble(),
+        .measurements = measurements,
+        .counters = counters,
+        .timeMedianLow = medianInterval.isArray() ? medianInterval[0].asDouble() : timeMedian,
+        .timeMedianHigh = medianInterval.isArray() ? medianInterval[1].asDouble() : timeMedian,
+        .backends = backends,
+    };
+}
+
 
 }
 }
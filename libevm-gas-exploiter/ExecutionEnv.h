@@ -3,9 +3,13 @@
 #include <libethereum/Block.h>
 #include <libethereum/BlockChain.h>
 #include <libethereum/State.h>
+#include <libevmanalysis/HardwareCounterCollector.h>
 
+#include <map>
 #include <memory>
 
+#include <boost/optional.hpp>
+
 #include <json/json.h>
 
 namespace dev
@@ -32,6 +36,8 @@ struct ExecutionStats
     float executionTime;
     bytes output;
     TransactionException excepted;
+    /// only set when hardware counters are collected
+    HardwareCounters counters;
 };
 
 struct ExecutionAggregatedStats
@@ -45,8 +51,23 @@ struct ExecutionAggregatedStats
     double timeMedian;
     double medianGasPerSecond;
     std::vector<double> measurements;
+    /// hardware events summed over all the measured executions, if collected
+    boost::optional<HardwareCounters> counters;
+    /// bounds of the 95% confidence interval of timeMedian
+    double timeMedianLow;
+    double timeMedianHigh;
+    /// stats on each VM, by VM name, when the program was executed on several VMs
+    /// the other fields then combine these stats, see `BenchmarkConfig::vmAggregation`
+    std::map<std::string, ExecutionAggregatedStats> backends;
+
+    /// CPU cycles spent per unit of gas, 0 if hardware counters were not collected
+    double cyclesPerGas() const;
+
+    /// Width of the confidence interval of the median time relative to the median
+    double timeMedianRelativeWidth() const;
 
     Json::Value toJson() const;
+    static ExecutionAggregatedStats fromJson(const Json::Value& root);
 };
 
 }
@@ -0,0 +1,122 @@
+#include "FitnessCache.h"
+
+#include <libdevcore/SHA3.h>
+
+#include <fstream>
+#include <stdexcept>
+
+namespace dev
+{
+namespace eth
+{
+
+FitnessCache::FitnessCache(const std::string& path, const h256& fingerprint)
+{
+    bool loaded = std::ifstream(path).good() && load(path, fingerprint);
+
+    Json::StreamWriterBuilder builder;
+    builder.settings_["indentation"] = "";
+    m_jsonWriter = std::unique_ptr<Json::StreamWriter>(builder.newStreamWriter());
+    m_outputWrapper = std::unique_ptr<OStreamWrapper>(new OStreamWrapper(path));
+
+    if (!loaded)
+    {
+        Json::Value root;
+        root["fingerprint"] = fingerprint.hex();
+        auto& outputStream = m_outputWrapper->getStream();
+        m_jsonWriter->write(root, &outputStream);
+        outputStream << std::endl;
+    }
+}
+
+h256 FitnessCache::key(const bytes& code)
+{
+    return sha3(code);
+}
+
+bool FitnessCache::load(const std::string& path, const h256& fingerprint)
+{
+    auto inWrapper = IStreamWrapper(path);
+    auto& inputStream = inWrapper.getStream();
+    Json::Reader reader;
+    std::string line;
+    bool checked = false;
+    while (std::getline(inputStream, line))
+    {
+        if (line.empty())
+        {
+            continue;
+        }
+
+        Json::Value root;
+        if (!checked)
+        {
+            if (!reader.parse(line, root) || !root.isMember("fingerprint") ||
+                h256(root["fingerprint"].asString()) != fingerprint)
+            {
+                throw std::runtime_error("fitness cache " + path +
+                                         " was measured with other benchmark settings");
+            }
+            checked = true;
+            continue;
+        }
+
+        // a run killed while writing can leave a truncated last line
+        if (!reader.parse(line, root) || !root.isMember("key") || !root.isMember("evaluation"))
+        {
+            continue;
+        }
+        auto cacheKey = h256(root["key"].asString());
+        m_evaluations[cacheKey] = ExecutionAggregatedStats::fromJson(root["evaluation"]);
+    }
+    return checked;
+}
+
+boost::optional<ExecutionAggregatedStats> FitnessCache::find(const h256& key)
+{
+    auto it = m_evaluations.find(key);
+    if (it == m_evaluations.end())
+    {
+        m_misses++;
+        return boost::none;
+    }
+    m_hits++;
+    return it->second;
+}
+
+void FitnessCache::insert(const h256& key, const ExecutionAggregatedStats& evaluation)
+{
+    auto inserted = m_evaluations.insert(std::make_pair(key, evaluation));
+    if (!inserted.second || !persistent())
+    {
+        return;
+    }
+
+    Json::Value root;
+    root["key"] = key.hex();
+    root["evaluation"] = evaluation.toJson();
+    auto& outputStream = m_outputWrapper->getStream();
+    m_jsonWriter->write(root, &outputStream);
+    outputStream << std::endl;
+}
+
+void FitnessCache::restore(const std::unordered_map<h256, ExecutionAggregatedStats>& evaluations,
+    uint64_t hits, uint64_t misses)
+{
+    // entries loaded from the cache file take precedence
+    m_evaluations.insert(evaluations.begin(), evaluations.end());
+    m_hits = hits;
+    m_misses = misses;
+}
+
+Json::Value FitnessCache::toJson() const
+{
+    Json::Value result;
+    result["size"] = static_cast<Json::UInt64>(size());
+    result["hits"] = hits();
+    result["misses"] = misses();
+    return result;
+}
+
+}  // namespace eth
+}  // namespace dev
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include <boost/optional.hpp>
+#include <json/json.h>
+
+#include <libdevcore/FixedHash.h>
+#include <libevmanalysis/StreamWrapper.h>
+
+#include "ExecutionEnv.h"
+#include "Program.h"
+
+namespace dev
+{
+namespace eth
+{
+
+/// FitnessCache stores the evaluation of programs keyed by the keccak of their code,
+/// so that any program byte-identical to a program already measured is not benchmarked again.
+/// When a path is given, existing entries are loaded from it and new entries are appended
+/// to it as JSON lines, which allows to share measurements between runs
+/// and to warm-start a search from previous measurements.
+/// The first line of the file holds the fingerprint of the benchmark settings the entries were
+/// measured with (see `benchmarkFingerprint`), a file of other settings is not loaded.
+class FitnessCache
+{
+public:
+    FitnessCache() = default;
+    /// Throws std::runtime_error if the file at `path` was written with another fingerprint
+    FitnessCache(const std::string& path, const h256& fingerprint);
+
+    static h256 key(const bytes& code);
+    static h256 key(const Program& program) { return key(program.toBytes()); }
+
+    boost::optional<ExecutionAggregatedStats> find(const h256& key);
+    void insert(const h256& key, const ExecutionAggregatedStats& evaluation);
+
+    size_t size() const { return m_evaluations.size(); }
+    uint64_t hits() const { return m_hits; }
+    uint64_t misses() const { return m_misses; }
+    bool persistent() const { return m_outputWrapper != nullptr; }
+
+    Json::Value toJson() const;
+
+    const std::unordered_map<h256, ExecutionAggregatedStats>& evaluations() const
+    {
+        return m_evaluations;
+    }
+
+    /// Restores evaluations and counters saved in a search checkpoint,
+    /// restored evaluations are kept in memory only
+    void restore(const std::unordered_map<h256, ExecutionAggregatedStats>& evaluations,
+        uint64_t hits, uint64_t misses);
+
+private:
+    std::unordered_map<h256, ExecutionAggregatedStats> m_evaluations;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+
+    std::unique_ptr<OStreamWrapper> m_outputWrapper;
+    std::unique_ptr<Json::StreamWriter> m_jsonWriter;
+
+    /// Returns false if the file is empty
+    bool load(const std::string& path, const h256& fingerprint);
+};
+
+}  // namespace eth
+}  // namespace dev
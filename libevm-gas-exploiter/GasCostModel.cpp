@@ -0,0 +1,430 @@
+#include "GasCostModel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <stdexcept>
+#include <utility>
+
+#include <libevm/Instruction.h>
+#include <libevmanalysis/ColumnarFile.h>
+#include <libevmanalysis/NonNegativeLeastSquares.h>
+
+#include "GasEstimator.h"
+
+namespace dev
+{
+namespace eth
+{
+namespace
+{
+/// Prices of EVMSchedule which can be read and written, tierStepGas excepted
+const std::vector<std::pair<std::string, unsigned EVMSchedule::*>> c_scheduleFields = {
+    {"expGas", &EVMSchedule::expGas},
+    {"expByteGas", &EVMSchedule::expByteGas},
+    {"sha3Gas", &EVMSchedule::sha3Gas},
+    {"sha3WordGas", &EVMSchedule::sha3WordGas},
+    {"sloadGas", &EVMSchedule::sloadGas},
+    {"sstoreSetGas", &EVMSchedule::sstoreSetGas},
+    {"sstoreResetGas", &EVMSchedule::sstoreResetGas},
+    {"sstoreUnchangedGas", &EVMSchedule::sstoreUnchangedGas},
+    {"sstoreRefundGas", &EVMSchedule::sstoreRefundGas},
+    {"sstoreRefundNonzeroGas", &EVMSchedule::sstoreRefundNonzeroGas},
+    {"jumpdestGas", &EVMSchedule::jumpdestGas},
+    {"logGas", &EVMSchedule::logGas},
+    {"logDataGas", &EVMSchedule::logDataGas},
+    {"logTopicGas", &EVMSchedule::logTopicGas},
+    {"createGas", &EVMSchedule::createGas},
+    {"callGas", &EVMSchedule::callGas},
+    {"callStipend", &EVMSchedule::callStipend},
+    {"callValueTransferGas", &EVMSchedule::callValueTransferGas},
+    {"callNewAccountGas", &EVMSchedule::callNewAccountGas},
+    {"suicideRefundGas", &EVMSchedule::suicideRefundGas},
+    {"memoryGas", &EVMSchedule::memoryGas},
+    {"quadCoeffDiv", &EVMSchedule::quadCoeffDiv},
+    {"createDataGas", &EVMSchedule::createDataGas},
+    {"copyGas", &EVMSchedule::copyGas},
+    {"extcodesizeGas", &EVMSchedule::extcodesizeGas},
+    {"extcodecopyGas", &EVMSchedule::extcodecopyGas},
+    {"extcodehashGas", &EVMSchedule::extcodehashGas},
+    {"balanceGas", &EVMSchedule::balanceGas},
+    {"suicideGas", &EVMSchedule::suicideGas},
+    {"blockhashGas", &EVMSchedule::blockhashGas},
+};
+
+/// Ratios below are reported as this one, for the instructions fitted as free
+constexpr double c_minCostRatio = 1.0 / 1024;
+
+/// Fields of the schedule pricing an instruction of the special tier, empty if its price
+/// cannot be derived from its static gas
+std::vector<unsigned EVMSchedule::*> specialPriceFields(Instruction instruction)
+{
+    switch (instruction)
+    {
+    case Instruction::SHA3:
+        return {&EVMSchedule::sha3Gas, &EVMSchedule::sha3WordGas};
+    case Instruction::EXP:
+        return {&EVMSchedule::expGas, &EVMSchedule::expByteGas};
+    case Instruction::BALANCE:
+        return {&EVMSchedule::balanceGas};
+    case Instruction::EXTCODESIZE:
+        return {&EVMSchedule::extcodesizeGas};
+    case Instruction::EXTCODECOPY:
+        return {&EVMSchedule::extcodecopyGas};
+    case Instruction::EXTCODEHASH:
+        return {&EVMSchedule::extcodehashGas};
+    case Instruction::BLOCKHASH:
+        return {&EVMSchedule::blockhashGas};
+    case Instruction::SLOAD:
+        return {&EVMSchedule::sloadGas};
+    case Instruction::JUMPDEST:
+        return {&EVMSchedule::jumpdestGas};
+    case Instruction::LOG0:
+    case Instruction::LOG1:
+    case Instruction::LOG2:
+    case Instruction::LOG3:
+    case Instruction::LOG4:
+        return {&EVMSchedule::logGas, &EVMSchedule::logTopicGas, &EVMSchedule::logDataGas};
+    default:
+        return {};
+    }
+}
+
+/// Group of instructions sharing their prices in the schedule: the tier for the tiers with
+/// a step gas, an id above them for the special instructions, -1 if there are none
+int priceGroup(Instruction instruction)
+{
+    auto tier = instructionInfo(instruction).gasPriceTier;
+    if (tier == Tier::Invalid || tier == Tier::Zero)
+        return -1;
+    if (tier != Tier::Special)
+        return static_cast<int>(tier);
+    if (specialPriceFields(instruction).empty())
+        return -1;
+    // instructions using the same fields share a group
+    auto first = instruction >= Instruction::LOG0 && instruction <= Instruction::LOG4 ?
+                     Instruction::LOG0 :
+                     instruction;
+    return static_cast<int>(Tier::Invalid) + 1 + static_cast<int>(first);
+}
+
+unsigned scalePrice(unsigned price, double ratio)
+{
+    if (price == 0)
+        return 0;
+    return static_cast<unsigned>(std::max<long long>(1, std::llround(price * ratio)));
+}
+
+size_t columnIndex(const TableSchema& schema, const std::string& name)
+{
+    for (size_t i = 0; i < schema.columns.size(); i++)
+        if (schema.columns[i].name == name)
+            return i;
+    throw std::invalid_argument("column " + name + " not found in table " + schema.name);
+}
+
+void removeEmptySamples(std::vector<CostSample>& samples)
+{
+    samples.erase(std::remove_if(samples.begin(), samples.end(),
+                      [](const CostSample& s) { return s.counts.empty() || s.time <= 0; }),
+        samples.end());
+}
+}  // namespace
+
+std::vector<CostSample> readCostSamples(std::istream& is)
+{
+    std::vector<CostSample> samples;
+    Json::Reader reader;
+    std::string line;
+    while (std::getline(is, line))
+    {
+        if (line.empty())
+            continue;
+        Json::Value root;
+        if (!reader.parse(line, root))
+            throw std::invalid_argument("invalid JSON line: " + reader.getFormattedErrorMessages());
+        const auto& calls = root["instructions"]["calls"];
+        if (!calls.isObject())
+            continue;
+        CostSample sample;
+        sample.time = root["usage"]["chrono_time"].asDouble() * 1e9;
+        for (auto it = calls.begin(); it != calls.end(); ++it)
+            sample.counts[it.key().asString()] += it->asUInt64();
+        samples.push_back(std::move(sample));
+    }
+    removeEmptySamples(samples);
+    return samples;
+}
+
+std::vector<CostSample> loadCostSamples(const std::string& path)
+{
+    if (!isColumnarPath(path))
+    {
+        std::ifstream is(path);
+        if (!is)
+            throw std::invalid_argument("could not open " + path);
+        return readCostSamples(is);
+    }
+
+    // rows of the two tables are buffered separately by the writer: the calls of a
+    // transaction may come before its row
+    std::vector<CostSample> samples;
+    uint64_t transactionRow = 0;
+    ColumnarReader reader(path);
+    ColumnarReader::Block block;
+    while (reader.next(block))
+    {
+        const auto& schema = block.schema();
+        if (schema.name == "transactions")
+        {
+            auto timeColumn = columnIndex(schema, "usage.chrono_time");
+            for (size_t row = 0; row < block.rowsCount(); row++, transactionRow++)
+            {
+                if (samples.size() <= transactionRow)
+                    samples.resize(transactionRow + 1);
+                samples[transactionRow].time = block.getDouble(timeColumn, row) * 1e9;
+            }
+        }
+        else if (schema.name == "instruction_calls")
+        {
+            auto transactionColumn = columnIndex(schema, "transaction");
+            auto instructionColumn = columnIndex(schema, "instruction");
+            auto countColumn = columnIndex(schema, "count");
+            for (size_t row = 0; row < block.rowsCount(); row++)
+            {
+                auto transaction = block.getUInt64(transactionColumn, row);
+                if (samples.size() <= transaction)
+                    samples.resize(transaction + 1);
+                samples[transaction].counts[block.getSymbol(instructionColumn, row)] +=
+                    block.getUInt64(countColumn, row);
+            }
+        }
+    }
+    removeEmptySamples(samples);
+    return samples;
+}
+
+
+Json::Value FittedInstructionCost::toJson() const
+{
+    Json::Value result;
+    result["name"] = name;
+    result["count"] = static_cast<Json::UInt64>(count);
+    result["time"] = time;
+    result["gas"] = static_cast<Json::UInt64>(gas);
+    result["time/gas"] = timePerGas();
+    result["proposed_gas"] = static_cast<Json::UInt64>(proposedGas);
+    result["deviation"] = deviation;
+    return result;
+}
+
+Json::Value GasCostModel::toJson(size_t limit) const
+{
+    Json::Value result;
+    result["samples_count"] = static_cast<Json::UInt64>(samplesCount);
+    result["relative_error"] = relativeError;
+    result["transaction_overhead"] = transactionOverhead;
+    result["time/gas"] = nanosecondsPerGas;
+    result["instructions"] = Json::Value(Json::arrayValue);
+    for (size_t i = 0; i < costs.size() && (limit == 0 || i < limit); i++)
+        result["instructions"].append(costs[i].toJson());
+    return result;
+}
+
+EVMSchedule GasCostModel::proposeSchedule(const EVMSchedule& schedule) const
+{
+    // per group: executions weighted sums of the proposed and current gas
+    std::map<int, std::pair<double, double>> groups;
+    std::map<int, Instruction> groupInstructions;
+    for (const auto& cost : costs)
+    {
+        if (!cost.priced())
+            continue;
+        auto instruction = instructionFromName(cost.name);
+        auto group = priceGroup(instruction);
+        if (group < 0)
+            continue;
+        groups[group].first += static_cast<double>(cost.count) * cost.proposedGas;
+        groups[group].second += static_cast<double>(cost.count) * cost.gas;
+        groupInstructions[group] = instruction;
+    }
+
+    EVMSchedule proposed = schedule;
+    for (const auto& kv : groups)
+    {
+        auto ratio = kv.second.first / kv.second.second;
+        auto instruction = groupInstructions[kv.first];
+        auto tier = instructionInfo(instruction).gasPriceTier;
+        if (tier != Tier::Special)
+        {
+            auto index = static_cast<unsigned>(tier);
+            proposed.tierStepGas[index] = scalePrice(schedule.tierStepGas[index], ratio);
+            continue;
+        }
+        for (auto field : specialPriceFields(instruction))
+            proposed.*field = scalePrice(schedule.*field, ratio);
+    }
+    return proposed;
+}
+
+GasCostModel fitGasCostModel(
+    const std::vector<CostSample>& samples, const EVMSchedule& schedule, uint64_t minCount)
+{
+    if (samples.empty())
+        throw std::invalid_argument("no transaction measurements to fit the costs on");
+
+    std::map<std::string, uint64_t> totals;
+    for (const auto& sample : samples)
+        for (const auto& kv : sample.counts)
+            totals[kv.first] += kv.second;
+
+    std::map<std::string, size_t> indices;
+    std::vector<std::string> names;
+    for (const auto& kv : totals)
+    {
+        if (kv.second < std::max<uint64_t>(minCount, 1))
+            continue;
+        indices[kv.first] = names.size();
+        names.push_back(kv.first);
+    }
+
+    // the last variable is the overhead of a transaction
+    auto overheadIndex = names.size();
+    auto rowOf = [&](const CostSample& sample) {
+        std::vector<double> row(names.size() + 1, 0);
+        for (const auto& kv : sample.counts)
+        {
+            auto it = indices.find(kv.first);
+            if (it != indices.end())
+                row[it->second] = static_cast<double>(kv.second);
+        }
+        row[overheadIndex] = 1;
+        return row;
+    };
+
+    NormalEquations equations(names.size() + 1);
+    for (const auto& sample : samples)
+        equations.addRow(rowOf(sample), sample.time, 1 / sample.time);
+    auto solution = nonNegativeLeastSquares(equations);
+
+    GasCostModel model;
+    model.samplesCount = samples.size();
+    model.transactionOverhead = solution[overheadIndex];
+
+    double squaredErrors = 0;
+    for (const auto& sample : samples)
+    {
+        auto row = rowOf(sample);
+        double predicted = 0;
+        for (size_t i = 0; i < row.size(); i++)
+            predicted += row[i] * solution[i];
+        squaredErrors += std::pow((predicted - sample.time) / sample.time, 2);
+    }
+    model.relativeError = std::sqrt(squaredErrors / samples.size());
+
+    GasEstimator gasEstimator(schedule);
+    double pricedTime = 0;
+    double pricedGas = 0;
+    for (size_t i = 0; i < names.size(); i++)
+    {
+        FittedInstructionCost cost;
+        cost.name = names[i];
+        cost.count = totals[names[i]];
+        cost.time = solution[i];
+        auto instruction = instructionFromName(names[i]);
+        // the gas of SSTORE depends on the storage and cannot be compared with its time
+        if (instruction != Instruction::SSTORE)
+            cost.gas = gasEstimator.estimateGas(instruction);
+        if (cost.priced())
+        {
+            pricedTime += static_cast<double>(cost.count) * cost.time;
+            pricedGas += static_cast<double>(cost.count) * cost.gas;
+        }
+        model.costs.push_back(cost);
+    }
+    model.nanosecondsPerGas = pricedGas > 0 ? pricedTime / pricedGas : 0;
+
+    for (auto& cost : model.costs)
+    {
+        if (!cost.priced() || model.nanosecondsPerGas <= 0)
+            continue;
+        auto ratio = cost.timePerGas() / model.nanosecondsPerGas;
+        cost.deviation = std::log2(std::max(ratio, c_minCostRatio));
+        cost.proposedGas = static_cast<uint64_t>(
+            std::max<long long>(1, std::llround(cost.time / model.nanosecondsPerGas)));
+    }
+    std::stable_sort(model.costs.begin(), model.costs.end(),
+        [](const FittedInstructionCost& a, const FittedInstructionCost& b) {
+            if (a.priced() != b.priced())
+                return a.priced();
+            if (a.priced())
+                return std::abs(a.deviation) > std::abs(b.deviation);
+            return a.count * a.time > b.count * b.time;
+        });
+    return model;
+}
+
+
+Json::Value scheduleToJson(const EVMSchedule& schedule)
+{
+    Json::Value result;
+    result["tierStepGas"] = Json::Value(Json::arrayValue);
+    for (auto gas : schedule.tierStepGas)
+        result["tierStepGas"].append(gas);
+    for (const auto& field : c_scheduleFields)
+        result[field.first] = schedule.*field.second;
+    return result;
+}
+
+EVMSchedule scheduleFromJson(const Json::Value& json, const EVMSchedule& base)
+{
+    const auto& prices = json.isMember("schedule") ? json["schedule"] : json;
+    if (!prices.isObject())
+        throw std::invalid_argument("the schedule should be a JSON object");
+
+    EVMSchedule schedule = base;
+    for (const auto& name : prices.getMemberNames())
+    {
+        const auto& value = prices[name];
+        if (name == "tierStepGas")
+        {
+            if (!value.isArray() || value.size() != schedule.tierStepGas.size())
+                throw std::invalid_argument("tierStepGas should be an array of " +
+                                            std::to_string(schedule.tierStepGas.size()) +
+                                            " prices");
+            for (Json::ArrayIndex i = 0; i < value.size(); i++)
+            {
+                if (!value[i].isUInt())
+                    throw std::invalid_argument("invalid price in tierStepGas");
+                schedule.tierStepGas[i] = value[i].asUInt();
+            }
+            continue;
+        }
+        auto field = std::find_if(c_scheduleFields.begin(), c_scheduleFields.end(),
+            [&](const std::pair<std::string, unsigned EVMSchedule::*>& f) {
+                return f.first == name;
+            });
+        if (field == c_scheduleFields.end())
+            throw std::invalid_argument("unknown schedule field: " + name);
+        if (!value.isUInt())
+            throw std::invalid_argument("invalid price for " + name);
+        schedule.*field->second = value.asUInt();
+    }
+    return schedule;
+}
+
+EVMSchedule loadSchedule(const std::string& path, const EVMSchedule& base)
+{
+    std::ifstream is(path);
+    if (!is)
+        throw std::invalid_argument("could not open " + path);
+    Json::Value root;
+    Json::Reader reader;
+    if (!reader.parse(is, root))
+        throw std::invalid_argument(
+            "could not parse " + path + ": " + reader.getFormattedErrorMessages());
+    return scheduleFromJson(root, base);
+}
+
+}  // namespace eth
+}  // namespace dev
@@ -0,0 +1,103 @@
+#pragma once
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <json/json.h>
+
+#include <libethcore/Common.h>
+#include <libethcore/EVMSchedule.h>
+
+namespace dev
+{
+namespace eth
+{
+/// Instructions executed by a transaction and its execution time
+struct CostSample
+{
+    /// calls per instruction name, as in the `instructions.calls` of the measurements
+    std::map<std::string, uint64_t> counts;
+    /// nanoseconds
+    double time = 0;
+};
+
+/// Reads the transactions measurements written as JSON lines (the `instructions.calls` and
+/// `usage.chrono_time` of each line). Lines without instructions, e.g. the ones of the blocks
+/// written by the replay mode, are skipped. Throws std::invalid_argument on invalid JSON
+std::vector<CostSample> readCostSamples(std::istream& is);
+
+/// Reads the transactions measurements of `path`, a columnar file if it has a `.col`
+/// extension (the `transactions` and `instruction_calls` tables) and JSON lines otherwise
+std::vector<CostSample> loadCostSamples(const std::string& path);
+
+/// Fitted cost of an instruction compared to its gas
+struct FittedInstructionCost
+{
+    std::string name;
+    /// executions in all the samples
+    uint64_t count = 0;
+    /// nanoseconds per execution
+    double time = 0;
+    /// static gas of an execution in the current schedule (see GasEstimator),
+    /// 0 if the instruction is not priced by the schedule or only dynamically (SSTORE, CALL...)
+    uint64_t gas = 0;
+    /// gas for which the instruction would cost the reference time per gas of the model
+    uint64_t proposedGas = 0;
+    /// log2 of the ratio between the time per gas of the instruction and the reference,
+    /// positive for underpriced instructions
+    double deviation = 0;
+
+    bool priced() const { return gas > 0; }
+    double timePerGas() const { return priced() ? time / gas : 0; }
+    Json::Value toJson() const;
+};
+
+/// Per instruction costs such that the time of a transaction is about the sum of the
+/// executions counts of its instructions multiplied by their costs, plus a fixed overhead
+struct GasCostModel
+{
+    /// priced instructions by decreasing absolute deviation, then the others by decreasing
+    /// total time
+    std::vector<FittedInstructionCost> costs;
+    /// nanoseconds per transaction which are not explained by its instructions
+    double transactionOverhead = 0;
+    /// total time divided by total gas of the priced instructions, the time per gas the
+    /// proposed costs are computed for
+    double nanosecondsPerGas = 0;
+    size_t samplesCount = 0;
+    /// root mean square of the residuals relative to the time of the samples
+    double relativeError = 0;
+
+    /// `limit` instructions at most, all of them if it is 0
+    Json::Value toJson(size_t limit = 0) const;
+
+    /// `schedule` with the prices of the instructions scaled by the count weighted mean of the
+    /// ratios between their proposed and current gas. Instructions sharing a price (the ones
+    /// of a tier, LOG0 to LOG4) get a single one. SSTORE, whose price depends on the storage,
+    /// the calls and the creations are kept unchanged
+    EVMSchedule proposeSchedule(const EVMSchedule& schedule) const;
+};
+
+/// Fits the costs of the instructions executed at least `minCount` times in `samples` with
+/// non-negative least squares, the samples being weighted by the inverse of their time so that
+/// the long transactions do not hide the others. `schedule` gives the current gas.
+/// Throws std::invalid_argument if there are no samples
+GasCostModel fitGasCostModel(
+    const std::vector<CostSample>& samples, const EVMSchedule& schedule, uint64_t minCount = 1);
+
+/// The prices of `schedule` (its `tierStepGas` and `*Gas` fields) as a JSON object
+Json::Value scheduleToJson(const EVMSchedule& schedule);
+
+/// `base` with the prices set in `json` overwritten, `json` being an object in the format of
+/// scheduleToJson or the output of the gas cost fit containing one under `schedule`.
+/// Throws std::invalid_argument for unknown fields or invalid values
+EVMSchedule scheduleFromJson(const Json::Value& json, const EVMSchedule& base);
+
+/// Reads a schedule written as JSON in `path`, see scheduleFromJson
+EVMSchedule loadSchedule(const std::string& path, const EVMSchedule& base);
+
+}  // namespace eth
+}  // namespace dev
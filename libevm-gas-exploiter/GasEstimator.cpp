@@ -33,7 +33,7 @@ uint32_t GasEstimator::estimateSpecialTierGas(Instruction instruction)
     case Instruction::SSTORE:
         return m_schedule.sstoreSetGas;
     case Instruction::JUMPDEST:
-        return 1;
+        return m_schedule.jumpdestGas;
     case Instruction::LOG0:
     case Instruction::LOG1:
     case Instruction::LOG2:
@@ -42,7 +42,6 @@ uint32_t GasEstimator::estimateSpecialTierGas(Instruction instruction)
     {
         auto n = static_cast<unsigned>(instruction) - static_cast<unsigned>(Instruction::LOG0);
         return m_schedule.logGas + m_schedule.logTopicGas * n + m_schedule.logDataGas * 2;
-        return 1;
     }
     default:
         return 0;
@@ -60,7 +59,7 @@ uint32_t GasEstimator::estimateGas(Instruction instruction)
     case Tier::Invalid:
         return 0;
     default:
-        return m_schedule.tierStepGas[static_cast<int>(instruction)];
+        return m_schedule.tierStepGas[static_cast<unsigned>(info.gasPriceTier)];
     }
 }
 
@@ -1,9 +1,14 @@
 #include "GeneticEngine.h"
 #include "Benchmarker.h"
 #include "InstructionGenerator.h"
+#include "Message.h"
 #include "Utils.h"
 
+#include <libdevcore/CommonIO.h>
+
+#include <cmath>
 #include <csignal>
+#include <sstream>
 
 
 namespace dev
@@ -41,6 +46,83 @@ void installHandler()
         handlerInstalled = true;
     }
 }
+
+/// "GECK" in little-endian
+const uint32_t checkpointMagic = 0x4b434547;
+const uint32_t checkpointVersion = 4;
+
+void writeEvaluatedProgram(MessageWriter& writer, const GeneticEngine::EvaluatedProgram& eProgram)
+{
+    writer.writeBytes(eProgram.program.encode());
+    writer.write(eProgram.evaluation.is_initialized());
+    if (eProgram.evaluation)
+    {
+        writeExecutionStats(writer, *eProgram.evaluation);
+    }
+    writer.writeDoubles(eProgram.objectiveValues);
+    writer.write<uint64_t>(eProgram.paretoRank);
+    writer.write(eProgram.crowdingDistance);
+}
+
+GeneticEngine::EvaluatedProgram readEvaluatedProgram(MessageReader& reader)
+{
+    auto encoded = reader.readBytes();
+    GeneticEngine::EvaluatedProgram eProgram(Program::decode(&encoded));
+    if (reader.read<bool>())
+    {
+        eProgram.evaluation = readExecutionStats(reader);
+    }
+    eProgram.objectiveValues = reader.readDoubles();
+    eProgram.paretoRank = reader.read<uint64_t>();
+    eProgram.crowdingDistance = reader.read<double>();
+    return eProgram;
+}
+
+TableSchema generationsSchema()
+{
+    return TableSchema{"generations",
+        {
+            {"generationNumber", ColumnType::UInt64},
+            {"bestProgram.size", ColumnType::UInt64},
+            {"bestProgram.gas", ColumnType::UInt64},
+            {"bestProgram.time_median", ColumnType::Double},
+            {"bestProgram.median_gas_per_second", ColumnType::Double},
+            {"results.blockExecutionTimeMean", ColumnType::Double},
+            {"results.blockExecutionTimeMedian", ColumnType::Double},
+            {"results.blockExecutionTimeStdev", ColumnType::Double},
+            {"results.blockGas", ColumnType::Double},
+            {"results.blockThroughputMean", ColumnType::Double},
+            {"results.blockThroughputMedian", ColumnType::Double},
+            {"paretoFront.size", ColumnType::UInt64},
+            {"time_measurements.fitnessComputationTime", ColumnType::UInt64},
+            {"time_measurements.populationCreationTime", ColumnType::UInt64},
+        }};
+}
+
+/// Programs of each generation, the code is not stored but can be found
+/// in the JSON output or in the fitness cache from its hash
+TableSchema programsSchema()
+{
+    return TableSchema{"programs",
+        {
+            {"generationNumber", ColumnType::UInt64},
+            {"code_hash", ColumnType::Hash},
+            {"size", ColumnType::UInt64},
+            {"uniqueSize", ColumnType::UInt64},
+            {"gas", ColumnType::UInt64},
+            {"exec_count", ColumnType::UInt64},
+            {"time_mean", ColumnType::Double},
+            {"time_stdev", ColumnType::Double},
+            {"time_median", ColumnType::Double},
+            {"time_median_low", ColumnType::Double},
+            {"time_median_high", ColumnType::Double},
+            {"gas_per_second", ColumnType::Double},
+            {"median_gas_per_second", ColumnType::Double},
+            {"cycles_per_gas", ColumnType::Double},
+            {"paretoRank", ColumnType::UInt64},
+            {"crowdingDistance", ColumnType::Double},
+        }};
+}
 }
 
 Json::Value GeneticEngine::Stats::toJson() const
@@ -49,6 +131,14 @@ Json::Value GeneticEngine::Stats::toJson() const
     result["generationNumber"] = generationNumber();
     result["bestProgram"] = m_bestProgram.toJson();
     result["results"] = m_benchmarkStats.toJson();
+    if (!m_paretoFront.empty())
+    {
+        result["paretoFront"] = Json::Value(Json::arrayValue);
+        for (const auto& eProgram : m_paretoFront)
+        {
+            result["paretoFront"].append(eProgram.toJson(true));
+        }
+    }
     return result;
 }
 
@@ -76,6 +166,18 @@ Json::Value GeneticEngine::EvaluatedProgram::toJson(bool verbose) const
     {
         result["program"]["code"] = program.toHex();
     }
+    if (!objectiveValues.empty())
+    {
+        result["objectives"] = Json::Value(Json::arrayValue);
+        for (auto value : objectiveValues)
+        {
+            result["objectives"].append(value);
+        }
+        result["paretoRank"] = static_cast<Json::UInt64>(paretoRank);
+        // boundaries of the front have an infinite distance which is not valid JSON
+        result["crowdingDistance"] =
+            std::isinf(crowdingDistance) ? Json::Value() : Json::Value(crowdingDistance);
+    }
     return result;
 }
 
@@ -95,12 +197,45 @@ GeneticEngine::GeneticEngine(
     m_outputStream(outputStream),
     m_generator(std::default_random_engine(config.seed))
 {
+    if (config.objectives.empty() && config.targetMetric == Metric::CyclesPerGas &&
+        !config.benchmarkConfig.hardwareCounters)
+    {
+        throw std::invalid_argument("cycles per gas metric requires hardware counters");
+    }
+
     installHandler();
 
     Json::StreamWriterBuilder builder;
     builder.settings_["indentation"] = "";
     m_jsonWriter = std::unique_ptr<Json::StreamWriter>(builder.newStreamWriter());
 
+    if (!config.fitnessCachePath.empty())
+    {
+        m_fitnessCache = std::unique_ptr<FitnessCache>(new FitnessCache(config.fitnessCachePath,
+            benchmarkFingerprint(config.execEnv, config.benchmarkConfig)));
+    }
+    else if (config.cacheResults)
+    {
+        m_fitnessCache = std::unique_ptr<FitnessCache>(new FitnessCache());
+    }
+
+    if (!config.columnarOutputPath.empty())
+    {
+        m_columnarWriter =
+            std::unique_ptr<ColumnarWriter>(new ColumnarWriter(config.columnarOutputPath));
+        m_generationsTable = m_columnarWriter->addTable(generationsSchema());
+        m_programsTable = m_columnarWriter->addTable(programsSchema());
+    }
+
+    if (!config.workerCores.empty())
+    {
+        // use a separate generator so that the calibration program does not
+        // change the sequence of programs generated for the search
+        auto calibrationProgram = ProgramGenerator(config.seed).generateInitialProgram(config.initialProgramSize);
+        m_workerPool = std::unique_ptr<BenchmarkWorkerPool>(new BenchmarkWorkerPool(
+            config.execEnv, config.benchmarkConfig, config.workerCores, calibrationProgram.toBytes()));
+    }
+
     for (size_t i = 0; i < config.populationSize; i++)
     {
         auto program = m_programGenerator->generateInitialProgram(config.initialProgramSize);
@@ -124,6 +259,15 @@ GeneticEngine::comparePrograms()
         {
             return true;
         }
+        // crowded comparison of NSGA-II, ranks are set by assignParetoRanks
+        if (!config.objectives.empty())
+        {
+            if (left->paretoRank != right->paretoRank)
+            {
+                return left->paretoRank < right->paretoRank;
+            }
+            return left->crowdingDistance > right->crowdingDistance;
+        }
         switch (config.targetMetric)
         {
         case Metric::ThroughputMedian:
@@ -134,27 +278,188 @@ GeneticEngine::comparePrograms()
             return left->evaluation->timeMean > right->evaluation->timeMean;
         case Metric::TimeMedian:
             return left->evaluation->timeMedian > right->evaluation->timeMedian;
+        case Metric::CyclesPerGas:
+            return left->evaluation->cyclesPerGas() > right->evaluation->cyclesPerGas();
         default:
             throw std::invalid_argument("unknown metric");
         }
     };
 }
 
-void GeneticEngine::run()
+void GeneticEngine::warmup()
 {
-    if (m_config.benchmarkConfig.initialWarmupCount > 0)
+    // workers are warmed up when the pool starts
+    if (m_config.benchmarkConfig.initialWarmupCount > 0 && m_workerPool == nullptr)
     {
-        runInitialWarmup(m_programGenerator, m_config.execEnv,
+        // a resumed search restored the generator state saved after the initial warmup,
+        // so warm up with a copy to keep generating the same programs
+        auto programGenerator = m_generation == 0 ?
+                                    m_programGenerator :
+                                    std::make_shared<ProgramGenerator>(*m_programGenerator);
+        runInitialWarmup(programGenerator, m_config.execEnv,
                          m_config.benchmarkConfig, m_config.initialProgramSize,
                          m_config.populationSize);
     }
+}
+
+void GeneticEngine::run()
+{
+    warmup();
 
-    for (uint32_t i = 0; !shouldStop && i < m_config.generationsCount; i++)
+    while (!shouldStop && m_generation < m_config.generationsCount)
     {
         advanceGeneration();
+
+        if (m_config.checkpointPath.empty())
+        {
+            continue;
+        }
+        bool lastGeneration = shouldStop || m_generation == m_config.generationsCount;
+        if (lastGeneration ||
+            (m_config.checkpointInterval > 0 && m_generation % m_config.checkpointInterval == 0))
+        {
+            saveCheckpoint(m_config.checkpointPath);
+        }
     }
 }
 
+void GeneticEngine::saveCheckpoint(const std::string& path) const
+{
+    MessageWriter writer;
+    writer.write(checkpointMagic);
+    writer.write(checkpointVersion);
+    writer.write(m_config.seed);
+    writer.write(m_config.populationSize);
+
+    std::ostringstream generatorState;
+    generatorState << m_generator;
+    writer.writeString(generatorState.str());
+    writer.writeString(m_programGenerator->state());
+
+    writer.write<uint64_t>(m_population.size());
+    for (const auto& eProgram : m_population)
+    {
+        writeEvaluatedProgram(writer, *eProgram);
+    }
+
+    // only the last generation, the others are in the output stream
+    writer.write(m_generation);
+    if (m_generation > 0)
+    {
+        const auto& stats = m_stats.back();
+        writeEvaluatedProgram(writer, stats.bestProgram());
+        writer.write<uint64_t>(stats.paretoFront().size());
+        for (const auto& eProgram : stats.paretoFront())
+        {
+            writeEvaluatedProgram(writer, eProgram);
+        }
+    }
+
+    writer.write(m_fitnessCache != nullptr);
+    if (m_fitnessCache != nullptr)
+    {
+        writer.write(m_fitnessCache->hits());
+        writer.write(m_fitnessCache->misses());
+        // a persistent cache is reloaded from its file, only an in-memory one is embedded
+        writer.writeString(m_config.fitnessCachePath);
+        if (!m_fitnessCache->persistent())
+        {
+            writer.write<uint64_t>(m_fitnessCache->evaluations().size());
+            for (const auto& entry : m_fitnessCache->evaluations())
+            {
+                writer.writeBytes(entry.first.asBytes());
+                writeExecutionStats(writer, entry.second);
+            }
+        }
+    }
+
+    // write to a temporary file first so that a crash never leaves a truncated checkpoint
+    writeFile(path, writer.buffer(), true);
+}
+
+void GeneticEngine::resume(const std::string& path)
+{
+    MessageReader reader(contents(path));
+    if (reader.atEnd())
+    {
+        throw std::runtime_error("could not read checkpoint " + path);
+    }
+    if (reader.read<uint32_t>() != checkpointMagic || reader.read<uint32_t>() != checkpointVersion)
+    {
+        throw std::runtime_error(path + " is not a valid checkpoint");
+    }
+    if (reader.read<unsigned>() != m_config.seed ||
+        reader.read<uint32_t>() != m_config.populationSize)
+    {
+        throw std::invalid_argument(
+            "checkpoint " + path + " was created with a different seed or population size");
+    }
+
+    std::istringstream generatorState(reader.readString());
+    generatorState >> m_generator;
+    if (generatorState.fail())
+    {
+        throw std::runtime_error("invalid generator state in checkpoint " + path);
+    }
+    m_programGenerator->setState(reader.readString());
+
+    std::vector<std::shared_ptr<EvaluatedProgram>> population(reader.read<uint64_t>());
+    for (auto& eProgram : population)
+    {
+        eProgram = std::make_shared<EvaluatedProgram>(readEvaluatedProgram(reader));
+    }
+
+    std::vector<Stats> stats;
+    auto generation = reader.read<uint64_t>();
+    if (generation > 0)
+    {
+        auto bestProgram = readEvaluatedProgram(reader);
+        std::vector<EvaluatedProgram> paretoFront;
+        auto frontSize = reader.read<uint64_t>();
+        for (uint64_t j = 0; j < frontSize; j++)
+        {
+            paretoFront.push_back(readEvaluatedProgram(reader));
+        }
+        auto bestValue = getTargetMetric(*bestProgram.evaluation);
+        stats.emplace_back(generation - 1, bestValue, bestProgram, BenchmarkStats{}, paretoFront);
+    }
+
+    if (reader.read<bool>())
+    {
+        auto hits = reader.read<uint64_t>();
+        auto misses = reader.read<uint64_t>();
+        auto fitnessCachePath = reader.readString();
+        std::unordered_map<h256, ExecutionAggregatedStats> evaluations;
+        if (fitnessCachePath.empty())
+        {
+            auto evaluationsCount = reader.read<uint64_t>();
+            for (uint64_t i = 0; i < evaluationsCount; i++)
+            {
+                auto key = h256(reader.readBytes());
+                evaluations[key] = readExecutionStats(reader);
+            }
+        }
+        else if (fitnessCachePath != m_config.fitnessCachePath)
+        {
+            throw std::invalid_argument("checkpoint " + path + " was created with the fitness cache " +
+                                        fitnessCachePath);
+        }
+        if (m_fitnessCache != nullptr)
+        {
+            m_fitnessCache->restore(evaluations, hits, misses);
+        }
+    }
+
+    if (!reader.atEnd())
+    {
+        throw std::runtime_error("unexpected data at the end of checkpoint " + path);
+    }
+
+    m_population = population;
+    m_stats = stats;
+    m_generation = generation;
+}
+
 
 void GeneticEngine::advanceGeneration()
 {
@@ -163,6 +468,7 @@ void GeneticEngine::advanceGeneration()
     auto stats = computeFitness();
     m_timeMeasurements.fitnessComputationTime = stepTimer.elapsed();
     m_stats.push_back(stats);
+    m_generation++;
 
     outputStats(stats);
 
@@ -203,9 +509,104 @@ void GeneticEngine::advanceGeneration()
 void GeneticEngine::outputStats(const GeneticEngine::Stats& stats) const
 {
     auto json = stats.toJson(m_population);
+    for (const auto& key : m_outputContext.getMemberNames())
+    {
+        json[key] = m_outputContext[key];
+    }
     json["time_measurements"] = m_timeMeasurements.toJson();
+    if (!m_config.objectives.empty())
+    {
+        json["objectives"] = Json::Value(Json::arrayValue);
+        for (const auto& objective : m_config.objectives)
+        {
+            json["objectives"].append(objective.toString());
+        }
+    }
+    if (m_fitnessCache != nullptr)
+    {
+        json["fitness_cache"] = m_fitnessCache->toJson();
+    }
     m_jsonWriter->write(json, &m_outputStream);
     m_outputStream << std::endl;
+
+    if (m_columnarWriter != nullptr)
+    {
+        outputColumns(stats);
+    }
+}
+
+void GeneticEngine::outputColumns(const GeneticEngine::Stats& stats) const
+{
+    const auto& best = stats.bestProgram();
+    const auto& results = stats.benchmarkStats();
+    m_columnarWriter->beginRow(m_generationsTable)
+        .add(stats.generationNumber())
+        .add(static_cast<uint64_t>(best.program.size()))
+        .add(best.evaluation ? best.evaluation->gas : 0)
+        .add(best.evaluation ? best.evaluation->timeMedian : 0.0)
+        .add(best.evaluation ? best.evaluation->medianGasPerSecond : 0.0)
+        .add(results.blockExecutionTimeMean)
+        .add(results.blockExecutionTimeMedian)
+        .add(results.blockExecutionTimeStdev)
+        .add(results.blockGas)
+        .add(results.blockThroughputMean)
+        .add(results.blockThroughputMedian)
+        .add(static_cast<uint64_t>(stats.paretoFront().size()))
+        .add(m_timeMeasurements.fitnessComputationTime)
+        .add(m_timeMeasurements.populationCreationTime);
+    m_columnarWriter->endRow();
+
+    for (const auto& eProgram : m_population)
+    {
+        static const ExecutionAggregatedStats notEvaluated{};
+        const auto& evaluation = eProgram->evaluation ? *eProgram->evaluation : notEvaluated;
+        m_columnarWriter->beginRow(m_programsTable)
+            .add(stats.generationNumber())
+            .add(FitnessCache::key(eProgram->program))
+            .add(static_cast<uint64_t>(eProgram->program.size()))
+            .add(static_cast<uint64_t>(eProgram->program.uniqueSize()))
+            .add(evaluation.gas)
+            .add(evaluation.execCount)
+            .add(evaluation.timeMean)
+            .add(evaluation.timeStdev)
+            .add(evaluation.timeMedian)
+            .add(evaluation.timeMedianLow)
+            .add(evaluation.timeMedianHigh)
+            .add(evaluation.gasPerSecond)
+            .add(evaluation.medianGasPerSecond)
+            .add(eProgram->evaluation ? evaluation.cyclesPerGas() : 0.0)
+            .add(static_cast<uint64_t>(eProgram->paretoRank))
+            .add(eProgram->crowdingDistance);
+        m_columnarWriter->endRow();
+    }
+    // a generation is complete once it is in the file
+    m_columnarWriter->flush();
+}
+
+std::vector<Program> GeneticEngine::emigrants(size_t count)
+{
+    auto candidates = m_population;
+    std::sort(candidates.begin(), candidates.end(), comparePrograms());
+    std::vector<Program> programs;
+    for (size_t i = 0; i < candidates.size() && programs.size() < count; i++)
+    {
+        if (candidates[i]->evaluation.is_initialized())
+        {
+            programs.push_back(candidates[i]->program);
+        }
+    }
+    return programs;
+}
+
+void GeneticEngine::immigrate(const std::vector<Program>& programs)
+{
+    // programs which are not evaluated are sorted last, so fresh children are replaced first
+    std::sort(m_population.begin(), m_population.end(), comparePrograms());
+    auto count = std::min(programs.size(), m_population.size());
+    for (size_t i = 0; i < count; i++)
+    {
+        m_population[m_population.size() - 1 - i] = std::make_shared<EvaluatedProgram>(programs[i]);
+    }
 }
 
 std::shared_ptr<GeneticEngine::EvaluatedProgram> GeneticEngine::tournamentSelection(
@@ -243,6 +644,10 @@ std::shared_ptr<GeneticEngine::EvaluatedProgram> GeneticEngine::tournamentSelect
 
 double GeneticEngine::getTargetMetric(const ExecutionAggregatedStats& stats)
 {
+    if (!m_config.objectives.empty())
+    {
+        return m_config.objectives.front().value(stats);
+    }
     switch (m_config.targetMetric)
     {
         case Metric::ThroughputMean:
@@ -253,6 +658,8 @@ double GeneticEngine::getTargetMetric(const ExecutionAggregatedStats& stats)
             return stats.timeMean;
         case Metric::TimeMedian:
             return stats.timeMedian;
+        case Metric::CyclesPerGas:
+            return stats.cyclesPerGas();
         default:
             throw std::invalid_argument("invalid metric");
     }
@@ -264,81 +671,160 @@ GeneticEngine::Stats GeneticEngine::computeFitness()
     std::shared_ptr<EvaluatedProgram> bestProgram = nullptr;
 
     std::vector<bytes> codes;
+    std::vector<h256> codeKeys;
+    std::vector<std::shared_ptr<EvaluatedProgram>> toEvaluate;
     for (auto eProgram : m_population)
     {
         if (m_config.debug)
         {
             std::cout << eProgram->program.toHex() << std::endl;
         }
-        codes.push_back(eProgram->program.toBytes());
+        if (m_config.cacheResults && eProgram->evaluation.is_initialized())
+        {
+            continue;
+        }
+
+        auto code = eProgram->program.toBytes();
+        if (m_fitnessCache != nullptr)
+        {
+            auto codeKey = FitnessCache::key(code);
+            if (auto cached = m_fitnessCache->find(codeKey))
+            {
+                eProgram->evaluation = *cached;
+                continue;
+            }
+            codeKeys.push_back(codeKey);
+        }
+        codes.push_back(code);
+        toEvaluate.push_back(eProgram);
     }
 
-    auto results = benchmarkCodes(m_config.execEnv, codes, m_config.benchmarkConfig);
-    auto programIsBetter = comparePrograms();
+    BenchmarkStats results{};
+    if (!codes.empty())
+    {
+        results = m_workerPool != nullptr ?
+                      m_workerPool->benchmarkCodes(codes) :
+                      benchmarkCodes(m_config.execEnv, codes, m_config.benchmarkConfig);
+    }
 
-    for (size_t i = 0; i < m_population.size(); i++)
+    for (size_t i = 0; i < toEvaluate.size(); i++)
+    {
+        toEvaluate[i]->evaluation = results.programStats[i];
+        if (m_fitnessCache != nullptr)
+        {
+            m_fitnessCache->insert(codeKeys[i], results.programStats[i]);
+        }
+    }
+
+    auto programIsBetter = comparePrograms();
+    std::vector<EvaluatedProgram> paretoFront;
+    if (!m_config.objectives.empty())
     {
-        auto eProgram = m_population[i];
-        if (!eProgram->evaluation.is_initialized() || !m_config.cacheResults)
+        assignParetoRanks();
+        // the best program is the one of the Pareto front with the best first objective
+        const auto& objective = m_config.objectives.front();
+        programIsBetter = [&objective](std::shared_ptr<EvaluatedProgram> left,
+                              std::shared_ptr<EvaluatedProgram> right) {
+            if (left->paretoRank != right->paretoRank)
+            {
+                return left->paretoRank < right->paretoRank;
+            }
+            return objective.score(*left->evaluation) > objective.score(*right->evaluation);
+        };
+        for (auto eProgram : m_population)
         {
-            eProgram->evaluation = results.programStats[i];
+            if (eProgram->paretoRank == 0)
+            {
+                paretoFront.push_back(*eProgram);
+            }
         }
+    }
 
+    for (auto eProgram : m_population)
+    {
         if (bestProgram == nullptr || programIsBetter(eProgram, bestProgram))
         {
             bestProgram = eProgram;
         }
     }
 
-    return Stats(m_stats.size(), getTargetMetric(*bestProgram->evaluation), *bestProgram, results);
+    return Stats(m_generation, getTargetMetric(*bestProgram->evaluation), *bestProgram, results,
+        paretoFront);
 }
 
-void GeneticEngine::appendProgram(Program& child, const Program& parent,
-                                  size_t progSplitPoint, bool useTail)
+void GeneticEngine::assignParetoRanks()
 {
-    auto& instructions = parent.instructions();
-    size_t start = 0;
-    size_t end = progSplitPoint;
-    if (useTail)
+    std::vector<std::vector<double>> scores;
+    for (auto& eProgram : m_population)
     {
-        start = progSplitPoint;
-        end = instructions.size();
+        eProgram->objectiveValues.clear();
+        std::vector<double> programScores;
+        for (const auto& objective : m_config.objectives)
+        {
+            eProgram->objectiveValues.push_back(objective.value(*eProgram->evaluation));
+            programScores.push_back(objective.score(*eProgram->evaluation));
+        }
+        scores.push_back(programScores);
     }
 
-    for (size_t i = start; i < end; i++)
+    auto fronts = nonDominatedSort(scores);
+    for (size_t rank = 0; rank < fronts.size(); rank++)
     {
-        child.addInstruction(instructions[i]);
+        auto distances = crowdingDistances(scores, fronts[rank]);
+        for (size_t i = 0; i < fronts[rank].size(); i++)
+        {
+            auto& eProgram = m_population[fronts[rank][i]];
+            eProgram->paretoRank = rank;
+            eProgram->crowdingDistance = distances[i];
+        }
     }
 }
 
 std::pair<Program, Program> GeneticEngine::crossOver(const Program& prog, const Program& other)
 {
-    auto progStackIndex = prog.stackSizeReverseIndex();
-    auto otherStackIndex = other.stackSizeReverseIndex();
-
-    auto stackSizesCandidates = keyIntersection(progStackIndex, otherStackIndex);
-    std::vector<uint64_t> weights;
-    for (auto stackSize : stackSizesCandidates)
+    const auto& progStackIndex = prog.stackSizeReverseIndex();
+    const auto& otherStackIndex = other.stackSizeReverseIndex();
+
+    // cumulated weights of the stack sizes the two programs have in common
+    std::vector<uint64_t> stackSizesCandidates;
+    std::vector<uint64_t> cumulatedWeights;
+    uint64_t totalWeight = 0;
+    auto maxStackSize = std::min(progStackIndex.maxStackSize(), otherStackIndex.maxStackSize());
+    for (uint64_t stackSize = 0; stackSize <= maxStackSize; stackSize++)
+    {
+        auto progCount = progStackIndex.count(stackSize);
+        auto otherCount = otherStackIndex.count(stackSize);
+        if (progCount > 0 && otherCount > 0)
+        {
+            totalWeight += progCount + otherCount;
+            stackSizesCandidates.push_back(stackSize);
+            cumulatedWeights.push_back(totalWeight);
+        }
+    }
+    if (stackSizesCandidates.empty())
     {
-        weights.push_back(progStackIndex[stackSize].size() + otherStackIndex[stackSize].size());
+        throw std::runtime_error("programs do not have any stack size in common");
     }
-    std::discrete_distribution<size_t> distribution(weights.begin(), weights.end());
-    auto stackSizeIndex = distribution(m_generator);
 
-    auto splitStackSize = stackSizesCandidates[stackSizeIndex];
+    std::uniform_int_distribution<uint64_t> weightDistribution(0, totalWeight - 1);
+    auto weightIt = std::upper_bound(
+        cumulatedWeights.begin(), cumulatedWeights.end(), weightDistribution(m_generator));
+    auto splitStackSize = stackSizesCandidates[weightIt - cumulatedWeights.begin()];
 
-    std::uniform_int_distribution<size_t> progDist(0, progStackIndex[splitStackSize].size() - 1);
-    auto progSplitPoint = progStackIndex[splitStackSize][progDist(m_generator)];
-    std::uniform_int_distribution<size_t> otherDist(0, otherStackIndex[splitStackSize].size() - 1);
-    auto otherSplitPoint = otherStackIndex[splitStackSize][otherDist(m_generator)];
+    const auto& progPositions = progStackIndex.positions(splitStackSize);
+    std::uniform_int_distribution<size_t> progDist(0, progPositions.size() - 1);
+    auto progSplitPoint = progPositions[progDist(m_generator)];
+    const auto& otherPositions = otherStackIndex.positions(splitStackSize);
+    std::uniform_int_distribution<size_t> otherDist(0, otherPositions.size() - 1);
+    auto otherSplitPoint = otherPositions[otherDist(m_generator)];
 
     Program child1;
-    appendProgram(child1, prog, progSplitPoint, false);
-    appendProgram(child1, other, otherSplitPoint, true);
+    child1.append(prog, 0, progSplitPoint);
+    child1.append(other, otherSplitPoint, other.size());
 
     Program child2;
-    appendProgram(child2, other, otherSplitPoint, false);
-    appendProgram(child2, prog, progSplitPoint, true);
+    child2.append(other, 0, otherSplitPoint);
+    child2.append(prog, progSplitPoint, prog.size());
 
     return std::make_pair(child1, child2);
 }
@@ -355,25 +841,14 @@ void GeneticEngine::mutate(Program& program, size_t n)
 void GeneticEngine::mutateOnce(Program& program)
 {
     std::uniform_int_distribution<int> indexDistribution(0 , program.size() - 1);
-    auto indexToChange = indexDistribution(m_generator);
-    auto instructionToChange = program[indexToChange];
+    size_t indexToChange = indexDistribution(m_generator);
 
     // If the instruction is a PUSH or POP required by an instruction
-    // find the actual instruction
-    if (instructionToChange->requiredBy() != nullptr)
-    {
-        for (size_t i = indexToChange + 1; i < program.size(); i++)
-        {
-            if (program[i] == instructionToChange->requiredBy())
-            {
-                indexToChange = i;
-                instructionToChange = program[i];
-                break;
-            }
-        }
-    }
+    // change the actual instruction, which is the last of its protection group
+    auto protectionGroup = program.protectionGroup(indexToChange);
+    indexToChange = protectionGroup.second - 1;
 
-    auto instrInfo = instructionInfo(instructionToChange->instruction());
+    auto instrInfo = instructionInfo(program.instruction(indexToChange));
     std::vector<Instruction> candidates;
     for (auto instr : programGenerator()->instructionsPerArgsCount(instrInfo.args))
     {
@@ -384,9 +859,9 @@ void GeneticEngine::mutateOnce(Program& program)
     }
     std::uniform_int_distribution<int> candidateIndexDistribution(0 , candidates.size() - 1);
     auto newInstr = candidates[candidateIndexDistribution(m_generator)];
-    auto newPInstr = m_programGenerator->makeInstruction(newInstr);
-    auto replacementSequence = generateMemorySafeSequence(newPInstr, m_generator);
-    program.replaceInstruction(indexToChange, replacementSequence);
+    Program replacement(program.stackSize(protectionGroup.first));
+    appendMemorySafeSequence(replacement, m_programGenerator->makeInstruction(newInstr), m_generator);
+    program.replaceInstruction(indexToChange, replacement);
 }
 
 
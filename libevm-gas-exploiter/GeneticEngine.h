@@ -4,11 +4,16 @@
 #include <ostream>
 
 #include "ExecutionEnv.h"
+#include "FitnessCache.h"
 #include "InstructionMetadata.h"
+#include "ParetoSelection.h"
 #include "ProgramGenerator.h"
 #include "Benchmarker.h"
+#include "WorkerPool.h"
 #include <boost/optional.hpp>
 
+#include <libevmanalysis/ColumnarFile.h>
+
 namespace dev
 {
 namespace eth
@@ -42,6 +47,8 @@ public:
         ThroughputMedian,
         TimeMedian,
         TimeMean,
+        /// requires `BenchmarkConfig::hardwareCounters`
+        CyclesPerGas,
     };
 
     struct Config
@@ -60,6 +67,21 @@ public:
         unsigned seed;
         Metric targetMetric;
         BenchmarkConfig benchmarkConfig;
+        /// cores to pin benchmark workers to, fitness is computed in-process when empty
+        std::vector<unsigned> workerCores;
+        /// file where evaluations are stored by code hash and reloaded from on start
+        /// evaluations are only kept in memory when empty
+        std::string fitnessCachePath;
+        /// when set, programs are ranked by Pareto dominance on these objectives
+        /// (NSGA-II non-dominated sorting and crowding distance) instead of `targetMetric`
+        std::vector<Objective> objectives;
+        /// file where the state of the search is saved every `checkpointInterval` generations,
+        /// as well as after the last generation or an interruption, no checkpoint when empty
+        std::string checkpointPath;
+        uint32_t checkpointInterval;
+        /// file where the stats of each generation and of its programs are also written
+        /// in the columnar format (see `ColumnarWriter`), nothing is written when empty
+        std::string columnarOutputPath;
     };
 
     struct TimeMeasurements
@@ -78,6 +100,12 @@ public:
         {}
         Program program;
         boost::optional<ExecutionAggregatedStats> evaluation;
+        /// values of the objectives, only set when searching with several objectives
+        std::vector<double> objectiveValues;
+        /// index of the non-dominated front of the program, 0 being the Pareto front
+        size_t paretoRank = 0;
+        /// crowding distance of the program in its front, infinite at the boundaries
+        double crowdingDistance = 0;
         Json::Value toJson(bool verbose = false) const;
     };
 
@@ -85,11 +113,12 @@ public:
     {
     public:
         Stats(uint64_t generationNumber, double bestValue, EvaluatedProgram bestProgram,
-            BenchmarkStats benchmarkStats)
+            BenchmarkStats benchmarkStats, std::vector<EvaluatedProgram> paretoFront = {})
           : m_generationNumber(generationNumber),
             m_bestValue(bestValue),
             m_bestProgram(bestProgram),
-            m_benchmarkStats(benchmarkStats)
+            m_benchmarkStats(benchmarkStats),
+            m_paretoFront(paretoFront)
         {}
 
         Json::Value toJson() const;
@@ -97,19 +126,40 @@ public:
         uint64_t generationNumber() const { return m_generationNumber; }
         uint64_t bestValue() const { return m_bestValue; }
         uint64_t minProgramSize() const { return m_bestProgram.program.size(); }
+        const EvaluatedProgram& bestProgram() const { return m_bestProgram; }
+        const BenchmarkStats& benchmarkStats() const { return m_benchmarkStats; }
+        const std::vector<EvaluatedProgram>& paretoFront() const { return m_paretoFront; }
 
     private:
         uint64_t m_generationNumber;
         double m_bestValue;
         EvaluatedProgram m_bestProgram;
         BenchmarkStats m_benchmarkStats;
+        /// programs which are not dominated by any other, empty with a single target metric
+        std::vector<EvaluatedProgram> m_paretoFront;
     };
 
 
     GeneticEngine(Config config, std::shared_ptr<ProgramGenerator> programGenerator,
         std::ostream& outputStream);
 
+    /// Runs the generations left to reach `generationsCount`
     void run();
+    /// Runs the initial warmup, done by `run` before the first generation
+    void warmup();
+
+    /// Writes the population, the best programs of the last generation, the state of the random
+    /// generators and the counters of the fitness cache to `path` in a compact binary format.
+    /// The evaluations of the cache are only written when it has no file: a persistent cache is
+    /// referenced by its path
+    void saveCheckpoint(const std::string& path) const;
+
+    /// Restores the state saved by `saveCheckpoint`, the engine must have been created
+    /// with the same config for the search to continue exactly as it would have.
+    /// Only the stats of the last generation are restored, without its benchmark results:
+    /// the previous ones are in the output stream.
+    /// Throws std::invalid_argument if the config does not match the checkpoint
+    void resume(const std::string& path);
     Stats computeFitness();
     void advanceGeneration();
     std::shared_ptr<EvaluatedProgram> tournamentSelection()
@@ -121,11 +171,12 @@ public:
         TournamentSelectionConfig config);
 
     /// The procedure for cross-over is as follow:
-    /// 1. Compute a reversed index where the key is the stack size
+    /// 1. Get the reversed index where the key is the stack size
     /// and the value is a list of points in the program where it has this
-    /// particular stack size
+    /// particular stack size (cached by each program until it changes)
     /// 2. Find the stack sizes that the two programs have in common
     /// 3. Sample one of these stack sizes based on how frequent they are
+    /// using a binary search over the cumulated frequencies
     /// 4. Select a random value in each of the reverse indexes
     /// 5. Take the first program up to the selected index
     /// and the second program up to the other selected index
@@ -136,15 +187,31 @@ public:
     void mutate(Program& program, size_t n);
     void mutateOnce(Program& program);
 
+    /// Stats of the generations run by this engine, preceded by the last one of the
+    /// checkpoint it was resumed from
     const std::vector<Stats>& stats() const { return m_stats; }
+    /// Number of generations run, including the ones before the checkpoint
+    uint64_t generation() const { return m_generation; }
     const std::vector<std::shared_ptr<EvaluatedProgram>>& population() const
     {
         return m_population;
     }
 
     void outputStats(const Stats& stats) const;
+    /// Writes the stats of the generation and its programs to the columnar output
+    void outputColumns(const Stats& stats) const;
+
+    /// Fields added to every stats line written to the output stream, e.g. an island index
+    void setOutputContext(const Json::Value& context) { m_outputContext = context; }
+
+    /// Returns the `count` best evaluated programs, to be sent to other populations
+    std::vector<Program> emigrants(size_t count);
+
+    /// Replaces the worst, or not yet evaluated, programs of the population by `programs`
+    void immigrate(const std::vector<Program>& programs);
 
     const Config& config() const { return m_config; }
+    const FitnessCache* fitnessCache() const { return m_fitnessCache.get(); }
     std::shared_ptr<ProgramGenerator> programGenerator() { return m_programGenerator; }
 
     std::function<bool(std::shared_ptr<EvaluatedProgram>, std::shared_ptr<EvaluatedProgram>)>
@@ -161,6 +228,7 @@ private:
 
     /// Stats about each generation
     std::vector<Stats> m_stats;
+    uint64_t m_generation = 0;
 
     /// A generator to generate the initial set of program
     std::shared_ptr<ProgramGenerator> m_programGenerator;
@@ -175,12 +243,27 @@ private:
     /// Keep track of time measurements
     TimeMeasurements m_timeMeasurements;
 
-    /// Helper for cross-over
-    void appendProgram(Program& child, const Program& parent,
-                                  size_t progSplitPoint, bool useTail);
+    /// Fields added to every stats line
+    Json::Value m_outputContext;
+
+    /// Pool of processes used to compute the fitness when `workerCores` is set
+    std::unique_ptr<BenchmarkWorkerPool> m_workerPool;
+
+    /// Evaluations indexed by code hash, set when `cacheResults` or `fitnessCachePath` is set
+    std::unique_ptr<FitnessCache> m_fitnessCache;
+
+    /// Columnar output, set when `columnarOutputPath` is set
+    std::unique_ptr<ColumnarWriter> m_columnarWriter;
+    uint16_t m_generationsTable = 0;
+    uint16_t m_programsTable = 0;
 
     /// Helper to get the target metric of the program
+    /// this is the first objective when searching with several objectives
     double getTargetMetric(const ExecutionAggregatedStats& stats);
+
+    /// Sorts the evaluated population in non-dominated fronts and sets the objective values,
+    /// Pareto rank and crowding distance of each program
+    void assignParetoRanks();
 };
 
 }  // namespace eth
@@ -20,11 +20,11 @@ ProgramData randomData(std::default_random_engine randEngine)
     return ProgramData(memoryLengthDistribution(randEngine), programDataSize);
 }
 
-std::vector<std::shared_ptr<ProgramInstruction>> generateMemorySafeSequence(
-    const std::shared_ptr<ProgramInstruction> inst, std::default_random_engine randEngine)
+void appendMemorySafeSequence(
+    Program& program, const ProgramInstruction& inst, std::default_random_engine randEngine)
 {
-    std::vector<std::shared_ptr<ProgramInstruction>> sequence;
-    switch (inst->instruction())
+    auto initialSize = program.size();
+    switch (inst.instruction())
     {
     /// signature: CALLDATACOPY(destOffset, offset, length)
     ///            CODECOPY(destOffset, offset, length)
@@ -35,16 +35,15 @@ std::vector<std::shared_ptr<ProgramInstruction>> generateMemorySafeSequence(
     case Instruction::CODECOPY:
     case Instruction::RETURNDATACOPY:
     {
-        inst->enableProtection();
         auto memoryLength = randomData(randEngine);
         auto offset = randomData(randEngine);
         auto destOffset = randomData(randEngine);
-        sequence.push_back(std::make_shared<ProgramInstruction>(Instruction::POP, inst));
-        sequence.push_back(std::make_shared<ProgramInstruction>(Instruction::POP, inst));
-        sequence.push_back(std::make_shared<ProgramInstruction>(Instruction::POP, inst));
-        sequence.push_back(std::make_shared<ProgramInstructionWithData>(Instruction::PUSH1, memoryLength, inst));
-        sequence.push_back(std::make_shared<ProgramInstructionWithData>(Instruction::PUSH1, offset, inst));
-        sequence.push_back(std::make_shared<ProgramInstructionWithData>(Instruction::PUSH1, destOffset, inst));
+        program.addInstruction(Instruction::POP);
+        program.addInstruction(Instruction::POP);
+        program.addInstruction(Instruction::POP);
+        program.addInstruction(Instruction::PUSH1, memoryLength);
+        program.addInstruction(Instruction::PUSH1, offset);
+        program.addInstruction(Instruction::PUSH1, destOffset);
         break;
     }
 
@@ -55,10 +54,9 @@ std::vector<std::shared_ptr<ProgramInstruction>> generateMemorySafeSequence(
     case Instruction::MSTORE8:
     case Instruction::MSTORE:
     {
-        inst->enableProtection();
         auto offset = randomData(randEngine);
-        sequence.push_back(std::make_shared<ProgramInstruction>(Instruction::POP, inst));
-        sequence.push_back(std::make_shared<ProgramInstructionWithData>(Instruction::PUSH1, offset, inst));
+        program.addInstruction(Instruction::POP);
+        program.addInstruction(Instruction::PUSH1, offset);
         break;
     }
 
@@ -67,10 +65,9 @@ std::vector<std::shared_ptr<ProgramInstruction>> generateMemorySafeSequence(
     /// stack after:  offset
     case Instruction::MLOAD:
     {
-        inst->enableProtection();
         auto offset = randomData(randEngine);
-        sequence.push_back(std::make_shared<ProgramInstruction>(Instruction::POP, inst));
-        sequence.push_back(std::make_shared<ProgramInstructionWithData>(Instruction::PUSH1, offset, inst));
+        program.addInstruction(Instruction::POP);
+        program.addInstruction(Instruction::PUSH1, offset);
         break;
     }
 
@@ -79,13 +76,12 @@ std::vector<std::shared_ptr<ProgramInstruction>> generateMemorySafeSequence(
     /// stack after:  offset, length
     case Instruction::SHA3:
     {
-        inst->enableProtection();
         auto offset = randomData(randEngine);
         auto length = randomData(randEngine);
-        sequence.push_back(std::make_shared<ProgramInstruction>(Instruction::POP, inst));
-        sequence.push_back(std::make_shared<ProgramInstruction>(Instruction::POP, inst));
-        sequence.push_back(std::make_shared<ProgramInstructionWithData>(Instruction::PUSH1, length, inst));
-        sequence.push_back(std::make_shared<ProgramInstructionWithData>(Instruction::PUSH1, offset, inst));
+        program.addInstruction(Instruction::POP);
+        program.addInstruction(Instruction::POP);
+        program.addInstruction(Instruction::PUSH1, length);
+        program.addInstruction(Instruction::PUSH1, offset);
         break;
     }
 
@@ -94,20 +90,19 @@ std::vector<std::shared_ptr<ProgramInstruction>> generateMemorySafeSequence(
     /// stack after: a, destOffset, offset, length
     case Instruction::EXTCODECOPY:
     {
-        inst->enableProtection();
         auto memoryLength = randomData(randEngine);
         auto offset = randomData(randEngine);
         auto destOffset = randomData(randEngine);
-        sequence.push_back(std::make_shared<ProgramInstruction>(Instruction::SWAP3, inst));
-        sequence.push_back(std::make_shared<ProgramInstruction>(Instruction::POP, inst));
-        sequence.push_back(std::make_shared<ProgramInstruction>(Instruction::POP, inst));
-        sequence.push_back(std::make_shared<ProgramInstruction>(Instruction::POP, inst));
-        sequence.push_back(std::make_shared<ProgramInstructionWithData>(Instruction::PUSH1, memoryLength, inst));
-        sequence.push_back(std::make_shared<ProgramInstruction>(Instruction::SWAP1, inst));
-        sequence.push_back(std::make_shared<ProgramInstructionWithData>(Instruction::PUSH1, offset, inst));
-        sequence.push_back(std::make_shared<ProgramInstruction>(Instruction::SWAP1, inst));
-        sequence.push_back(std::make_shared<ProgramInstructionWithData>(Instruction::PUSH1, destOffset, inst));
-        sequence.push_back(std::make_shared<ProgramInstruction>(Instruction::SWAP1, inst));
+        program.addInstruction(Instruction::SWAP3);
+        program.addInstruction(Instruction::POP);
+        program.addInstruction(Instruction::POP);
+        program.addInstruction(Instruction::POP);
+        program.addInstruction(Instruction::PUSH1, memoryLength);
+        program.addInstruction(Instruction::SWAP1);
+        program.addInstruction(Instruction::PUSH1, offset);
+        program.addInstruction(Instruction::SWAP1);
+        program.addInstruction(Instruction::PUSH1, destOffset);
+        program.addInstruction(Instruction::SWAP1);
         break;
     }
 
@@ -122,13 +117,12 @@ std::vector<std::shared_ptr<ProgramInstruction>> generateMemorySafeSequence(
     case Instruction::LOG3:
     case Instruction::LOG4:
     {
-        inst->enableProtection();
         auto memoryLength = randomData(randEngine);
         auto offsetLength = randomData(randEngine);
-        sequence.push_back(std::make_shared<ProgramInstruction>(Instruction::POP, inst));
-        sequence.push_back(std::make_shared<ProgramInstruction>(Instruction::POP, inst));
-        sequence.push_back(std::make_shared<ProgramInstructionWithData>(Instruction::PUSH1, memoryLength, inst));
-        sequence.push_back(std::make_shared<ProgramInstructionWithData>(Instruction::PUSH1, offsetLength, inst));
+        program.addInstruction(Instruction::POP);
+        program.addInstruction(Instruction::POP);
+        program.addInstruction(Instruction::PUSH1, memoryLength);
+        program.addInstruction(Instruction::PUSH1, offsetLength);
         break;
     }
 
@@ -136,9 +130,13 @@ std::vector<std::shared_ptr<ProgramInstruction>> generateMemorySafeSequence(
         break;
     }
 
-    sequence.push_back(inst);
+    program.addInstruction(inst);
 
-    return sequence;
+    auto sequenceSize = program.size() - initialSize;
+    if (sequenceSize > 1)
+    {
+        program.protectLast(sequenceSize);
+    }
 }
 
 
@@ -14,8 +14,9 @@ namespace eth
 {
 
 
-std::vector<std::shared_ptr<ProgramInstruction>> generateMemorySafeSequence(
-    const std::shared_ptr<ProgramInstruction> inst,
+/// Appends `inst` to `program`, preceded by the instructions needed to make its memory access safe.
+/// When such instructions are needed, they are added with `inst` in a single protection group
+void appendMemorySafeSequence(Program& program, const ProgramInstruction& inst,
     std::default_random_engine randEngine = std::default_random_engine());
 
 }
@@ -2,6 +2,8 @@
 
 #include "InstructionHelpers.h"
 
+#include <array>
+
 
 namespace dev
 {
@@ -11,6 +13,32 @@ namespace eth
 static const uint8_t push1Opcode = static_cast<uint8_t>(Instruction::PUSH1);
 static const uint8_t push32Opcode = static_cast<uint8_t>(Instruction::PUSH32);
 
+namespace
+{
+struct StackEffect
+{
+    uint8_t args;
+    int8_t difference;
+};
+
+/// instructionInfo looks up a map, programs use this table instead
+/// as they need the stack effect of every instruction they contain
+const std::array<StackEffect, 256>& stackEffects()
+{
+    static const std::array<StackEffect, 256> effects = []() {
+        std::array<StackEffect, 256> result;
+        for (size_t opcode = 0; opcode < result.size(); opcode++)
+        {
+            auto info = instructionInfo(static_cast<Instruction>(opcode));
+            result[opcode].args = info.args;
+            result[opcode].difference = info.ret - info.args;
+        }
+        return result;
+    }();
+    return effects;
+}
+}
+
 bool isPush(Instruction instruction)
 {
     auto opcode = static_cast<uint8_t>(instruction);
@@ -30,6 +58,16 @@ u256 pushMaxValue(Instruction instruction)
     return maxValue.convert_to<u256>();
 }
 
+uint8_t stackArguments(Instruction instruction)
+{
+    return stackEffects()[static_cast<uint8_t>(instruction)].args;
+}
+
+int stackDifference(Instruction instruction)
+{
+    return stackEffects()[static_cast<uint8_t>(instruction)].difference;
+}
+
 
 }
 }
@@ -12,5 +12,11 @@ bool isPush(Instruction instruction);
 uint8_t pushOperandSize(Instruction instruction);
 u256 pushMaxValue(Instruction instruction);
 
+/// Number of elements `instruction` takes from the stack
+uint8_t stackArguments(Instruction instruction);
+
+/// Difference in the stack size after executing `instruction`
+int stackDifference(Instruction instruction);
+
 }
 }
@@ -0,0 +1,370 @@
+#include "IslandModel.h"
+#include "Benchmarker.h"
+#include "Message.h"
+
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+
+namespace
+{
+enum class Request : uint8_t
+{
+    Run = 0,
+    Shutdown = 1,
+};
+
+enum class Response : uint8_t
+{
+    Ok = 0,
+    Error = 1,
+};
+
+volatile bool shouldStop = false;
+
+void signalHandler(int)
+{
+    if (shouldStop)
+    {
+        std::cerr << "SIGINT signal received again, forcing shutdown" << std::endl;
+        exit(1);
+    }
+    shouldStop = true;
+    std::cerr << "SIGINT signal received, stopping after the current migration..." << std::endl;
+}
+
+/// Main loop of an island process, this never returns
+[[noreturn]] void runIsland(size_t index, const dev::eth::IslandModel::Config& config,
+    dev::eth::GeneticEngine::Config engineConfig,
+    const std::map<dev::eth::Instruction, dev::eth::InstructionMetadata>& instructionsMetadata,
+    int fd)
+{
+    int exitCode = 0;
+    try
+    {
+        if (!config.cores.empty())
+        {
+            dev::eth::pinToCore(config.cores[index]);
+        }
+
+        std::ostringstream output;
+        auto programGenerator =
+            std::make_shared<dev::eth::ProgramGenerator>(instructionsMetadata, engineConfig.seed);
+        dev::eth::GeneticEngine engine(engineConfig, programGenerator, output);
+        // the coordinator is in charge of handling interruptions
+        signal(SIGINT, SIG_IGN);
+
+        Json::Value context;
+        context["island"] = static_cast<Json::UInt64>(index);
+        engine.setOutputContext(context);
+        engine.warmup();
+
+        while (true)
+        {
+            auto request = dev::eth::MessageReader::receive(fd);
+            if (request.read<Request>() == Request::Shutdown)
+            {
+                break;
+            }
+
+            auto generationsCount = request.read<uint32_t>();
+            std::vector<dev::eth::Program> immigrants(request.read<uint64_t>());
+            for (auto& program : immigrants)
+            {
+                auto encoded = request.readBytes();
+                program = dev::eth::Program::decode(&encoded);
+            }
+
+            try
+            {
+                engine.immigrate(immigrants);
+                for (uint32_t i = 0; i < generationsCount; i++)
+                {
+                    engine.advanceGeneration();
+                }
+
+                dev::eth::MessageWriter response;
+                response.write(Response::Ok);
+                response.writeString(output.str());
+                output.str("");
+                auto emigrants = engine.emigrants(config.migrantsCount);
+                response.write<uint64_t>(emigrants.size());
+                for (const auto& program : emigrants)
+                {
+                    response.writeBytes(program.encode());
+                }
+                response.send(fd);
+            }
+            catch (std::exception const& e)
+            {
+                dev::eth::MessageWriter response;
+                response.write(Response::Error);
+                response.writeString(e.what());
+                response.send(fd);
+            }
+        }
+    }
+    catch (std::exception const& e)
+    {
+        try
+        {
+            dev::eth::MessageWriter response;
+            response.write(Response::Error);
+            response.writeString(e.what());
+            response.send(fd);
+        }
+        catch (std::exception const&)
+        {
+            // the coordinator is gone, nothing left to report to
+        }
+        exitCode = 1;
+    }
+
+    close(fd);
+    // do not run the destructors and exit handlers inherited from the parent
+    _exit(exitCode);
+}
+}  // namespace
+
+namespace dev
+{
+namespace eth
+{
+
+IslandModel::IslandModel(Config config, GeneticEngine::Config engineConfig,
+    std::map<Instruction, InstructionMetadata> instructionsMetadata, std::ostream& outputStream)
+  : m_config(config),
+    m_engineConfig(engineConfig),
+    m_instructionsMetadata(instructionsMetadata),
+    m_outputStream(outputStream)
+{
+    if (config.islandsCount == 0)
+    {
+        throw std::invalid_argument("island model needs at least one island");
+    }
+    if (!config.cores.empty() && config.cores.size() != config.islandsCount)
+    {
+        throw std::invalid_argument("island model needs one core per island");
+    }
+    if (config.migrationInterval == 0)
+    {
+        throw std::invalid_argument("migration interval must be positive");
+    }
+
+    try
+    {
+        for (size_t i = 0; i < config.islandsCount; i++)
+        {
+            startIsland(i);
+        }
+    }
+    catch (...)
+    {
+        stopIslands();
+        throw;
+    }
+}
+
+IslandModel::~IslandModel()
+{
+    stopIslands();
+}
+
+void IslandModel::startIsland(size_t index)
+{
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0)
+    {
+        throw std::runtime_error(std::string("failed to create socket: ") + std::strerror(errno));
+    }
+
+    // avoid duplicating pending output in the child
+    m_outputStream.flush();
+    std::cout.flush();
+    std::cerr.flush();
+
+    auto pid = fork();
+    if (pid < 0)
+    {
+        close(sockets[0]);
+        close(sockets[1]);
+        throw std::runtime_error(std::string("failed to fork island: ") + std::strerror(errno));
+    }
+
+    if (pid == 0)
+    {
+        for (auto& island : m_islands)
+        {
+            close(island.fd);
+        }
+        close(sockets[0]);
+
+        auto engineConfig = m_engineConfig;
+        engineConfig.seed += index;
+        // islands are already one process per core
+        engineConfig.workerCores.clear();
+        if (!engineConfig.fitnessCachePath.empty())
+        {
+            engineConfig.fitnessCachePath += "." + std::to_string(index);
+        }
+        if (!engineConfig.columnarOutputPath.empty())
+        {
+            engineConfig.columnarOutputPath += "." + std::to_string(index);
+        }
+        runIsland(index, m_config, engineConfig, m_instructionsMetadata, sockets[1]);
+    }
+
+    close(sockets[1]);
+    m_islands.push_back(Island{
+        .pid = pid,
+        .fd = sockets[0],
+    });
+}
+
+void IslandModel::stopIslands()
+{
+    for (auto& island : m_islands)
+    {
+        try
+        {
+            MessageWriter request;
+            request.write(Request::Shutdown);
+            request.send(island.fd);
+        }
+        catch (std::exception const&)
+        {
+            // the island already exited
+        }
+        close(island.fd);
+    }
+    for (auto& island : m_islands)
+    {
+        waitpid(island.pid, nullptr, 0);
+    }
+    m_islands.clear();
+}
+
+void IslandModel::run()
+{
+    signal(SIGINT, signalHandler);
+
+    std::vector<std::vector<bytes>> immigrants(m_islands.size());
+    uint32_t remainingGenerations = m_engineConfig.generationsCount;
+    while (!shouldStop && remainingGenerations > 0)
+    {
+        auto generationsCount = std::min(remainingGenerations, m_config.migrationInterval);
+
+        // send all the requests first so that the islands run concurrently
+        for (size_t i = 0; i < m_islands.size(); i++)
+        {
+            MessageWriter request;
+            request.write(Request::Run);
+            request.write(generationsCount);
+            request.write<uint64_t>(immigrants[i].size());
+            for (const auto& program : immigrants[i])
+            {
+                request.writeBytes(program);
+            }
+            request.send(m_islands[i].fd);
+            immigrants[i].clear();
+        }
+
+        std::string error;
+        for (size_t i = 0; i < m_islands.size(); i++)
+        {
+            auto response = MessageReader::receive(m_islands[i].fd);
+            if (response.read<Response>() == Response::Error)
+            {
+                if (error.empty())
+                {
+                    error = "island " + std::to_string(i) + " failed: " + response.readString();
+                }
+                continue;
+            }
+
+            m_outputStream << response.readString();
+            auto emigrantsCount = response.read<uint64_t>();
+            std::vector<bytes> emigrants;
+            for (uint64_t j = 0; j < emigrantsCount; j++)
+            {
+                emigrants.push_back(response.readBytes());
+            }
+            for (auto destination : destinations(m_config.topology, i, m_islands.size()))
+            {
+                immigrants[destination].insert(
+                    immigrants[destination].end(), emigrants.begin(), emigrants.end());
+            }
+        }
+        m_outputStream.flush();
+
+        if (!error.empty())
+        {
+            throw std::runtime_error(error);
+        }
+        remainingGenerations -= generationsCount;
+    }
+}
+
+std::vector<size_t> IslandModel::destinations(Topology topology, size_t island, size_t islandsCount)
+{
+    std::vector<size_t> result;
+    if (islandsCount < 2)
+    {
+        return result;
+    }
+    switch (topology)
+    {
+    case Topology::Ring:
+        result.push_back((island + 1) % islandsCount);
+        break;
+    case Topology::Star:
+        if (island != 0)
+        {
+            result.push_back(0);
+            break;
+        }
+        for (size_t i = 1; i < islandsCount; i++)
+        {
+            result.push_back(i);
+        }
+        break;
+    case Topology::FullyConnected:
+        for (size_t i = 0; i < islandsCount; i++)
+        {
+            if (i != island)
+            {
+                result.push_back(i);
+            }
+        }
+        break;
+    }
+    return result;
+}
+
+IslandModel::Topology IslandModel::parseTopology(const std::string& name)
+{
+    if (name == "ring")
+    {
+        return Topology::Ring;
+    }
+    else if (name == "star")
+    {
+        return Topology::Star;
+    }
+    else if (name == "fully-connected")
+    {
+        return Topology::FullyConnected;
+    }
+    throw std::invalid_argument(
+        "topology should be 'ring', 'star' or 'fully-connected', got '" + name + "'");
+}
+
+}  // namespace eth
+}  // namespace dev
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "GeneticEngine.h"
+#include "InstructionMetadata.h"
+
+namespace dev
+{
+namespace eth
+{
+
+/// IslandModel runs several independent `GeneticEngine` populations, one per forked process,
+/// and periodically migrates the best programs of each island to its neighbours.
+///
+/// Islands run `migrationInterval` generations between two migrations. At each migration,
+/// every island sends its stats lines and its best programs to the coordinator (the parent
+/// process) over a unix socket. The coordinator writes the stats to the output stream,
+/// with an `island` field, and forwards the programs to the neighbours given by the topology,
+/// where they replace the worst programs. Migrations are synchronous so that a search
+/// with a given seed is reproducible.
+class IslandModel
+{
+public:
+    enum class Topology
+    {
+        /// island i sends its programs to island i + 1
+        Ring,
+        /// island 0 exchanges programs with every other island
+        Star,
+        /// every island sends its programs to all the others
+        FullyConnected,
+    };
+
+    struct Config
+    {
+        uint32_t islandsCount;
+        Topology topology;
+        /// number of generations between two migrations
+        uint32_t migrationInterval;
+        /// number of programs sent to each neighbour
+        uint32_t migrantsCount;
+        /// core to pin each island to, islands are not pinned when empty
+        std::vector<unsigned> cores;
+    };
+
+    /// Each island runs with `engineConfig`, except for its seed, which is offset
+    /// by the island index, and its fitness cache and columnar output files,
+    /// which get the island index as suffix
+    IslandModel(Config config, GeneticEngine::Config engineConfig,
+        std::map<Instruction, InstructionMetadata> instructionsMetadata,
+        std::ostream& outputStream);
+    ~IslandModel();
+
+    IslandModel(const IslandModel&) = delete;
+    IslandModel& operator=(const IslandModel&) = delete;
+
+    /// Runs `generationsCount` generations on every island
+    void run();
+
+    /// Islands receiving the programs of `island`
+    static std::vector<size_t> destinations(Topology topology, size_t island, size_t islandsCount);
+
+    static Topology parseTopology(const std::string& name);
+
+private:
+    struct Island
+    {
+        pid_t pid;
+        int fd;
+    };
+
+    Config m_config;
+    GeneticEngine::Config m_engineConfig;
+    std::map<Instruction, InstructionMetadata> m_instructionsMetadata;
+    std::ostream& m_outputStream;
+    std::vector<Island> m_islands;
+
+    void startIsland(size_t index);
+    void stopIslands();
+};
+
+}  // namespace eth
+}  // namespace dev
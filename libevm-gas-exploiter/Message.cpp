@@ -0,0 +1,211 @@
+#include "Message.h"
+
+#include <pthread.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <csignal>
+
+namespace
+{
+/// Blocks SIGPIPE in the calling thread while alive, so that writing to a pipe whose reader
+/// died fails with EPIPE instead of killing the process
+class SigpipeBlocker
+{
+public:
+    SigpipeBlocker()
+    {
+        sigemptyset(&m_sigpipe);
+        sigaddset(&m_sigpipe, SIGPIPE);
+        sigset_t pending;
+        sigpending(&pending);
+        m_wasPending = sigismember(&pending, SIGPIPE);
+        pthread_sigmask(SIG_BLOCK, &m_sigpipe, &m_previous);
+    }
+
+    ~SigpipeBlocker()
+    {
+        if (m_broken && !m_wasPending)
+        {
+            // discard the SIGPIPE raised by the failed write before unblocking it
+            struct timespec noWait = {0, 0};
+            sigtimedwait(&m_sigpipe, nullptr, &noWait);
+        }
+        pthread_sigmask(SIG_SETMASK, &m_previous, nullptr);
+    }
+
+    void setBroken() { m_broken = true; }
+
+private:
+    sigset_t m_sigpipe;
+    sigset_t m_previous;
+    bool m_wasPending = false;
+    bool m_broken = false;
+};
+}  // namespace
+
+namespace dev
+{
+namespace eth
+{
+void writeAll(int fd, const void* data, size_t size)
+{
+    SigpipeBlocker sigpipeBlocker;
+    auto ptr = static_cast<const uint8_t*>(data);
+    while (size > 0)
+    {
+        auto written = write(fd, ptr, size);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            if (errno == EPIPE)
+            {
+                sigpipeBlocker.setBroken();
+            }
+            throw std::runtime_error(
+                std::string("failed to write message: ") + std::strerror(errno));
+        }
+        ptr += written;
+        size -= written;
+    }
+}
+
+void readAll(int fd, void* data, size_t size)
+{
+    auto ptr = static_cast<uint8_t*>(data);
+    while (size > 0)
+    {
+        auto readCount = read(fd, ptr, size);
+        if (readCount < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            throw std::runtime_error(
+                std::string("failed to read message: ") + std::strerror(errno));
+        }
+        if (readCount == 0)
+        {
+            throw std::runtime_error("process exited unexpectedly");
+        }
+        ptr += readCount;
+        size -= readCount;
+    }
+}
+
+void MessageWriter::send(int fd) const
+{
+    uint64_t size = m_buffer.size();
+    writeAll(fd, &size, sizeof(size));
+    writeAll(fd, m_buffer.data(), m_buffer.size());
+}
+
+MessageReader MessageReader::receive(int fd)
+{
+    uint64_t size;
+    readAll(fd, &size, sizeof(size));
+    MessageReader reader;
+    reader.m_buffer.resize(size);
+    readAll(fd, reader.m_buffer.data(), size);
+    return reader;
+}
+
+bytes MessageReader::readBytes()
+{
+    auto size = read<uint64_t>();
+    if (m_offset + size > m_buffer.size())
+    {
+        throw std::runtime_error("truncated message");
+    }
+    bytes data(m_buffer.begin() + m_offset, m_buffer.begin() + m_offset + size);
+    m_offset += size;
+    return data;
+}
+
+std::string MessageReader::readString()
+{
+    auto data = readBytes();
+    return std::string(data.begin(), data.end());
+}
+
+std::vector<double> MessageReader::readDoubles()
+{
+    auto size = read<uint64_t>();
+    std::vector<double> values;
+    values.reserve(size);
+    for (uint64_t i = 0; i < size; i++)
+    {
+        values.push_back(read<double>());
+    }
+    return values;
+}
+
+void writeExecutionStats(MessageWriter& writer, const ExecutionAggregatedStats& stats)
+{
+    writer.write(stats.gas);
+    writer.write(stats.execCount);
+    writer.write(stats.totalTime);
+    writer.write(stats.gasPerSecond);
+    writer.write(stats.timeMean);
+    writer.write(stats.timeStdev);
+    writer.write(stats.timeMedian);
+    writer.write(stats.medianGasPerSecond);
+    writer.writeDoubles(stats.measurements);
+    writer.write(stats.counters.is_initialized());
+    if (stats.counters)
+    {
+        writer.write(stats.counters->cycles);
+        writer.write(stats.counters->instructions);
+        writer.write(stats.counters->cacheMisses);
+        writer.write(stats.counters->branchMisses);
+        writer.write(stats.counters->tlbMisses);
+    }
+    writer.write(stats.timeMedianLow);
+    writer.write(stats.timeMedianHigh);
+    writer.write<uint64_t>(stats.backends.size());
+    for (const auto& backend : stats.backends)
+    {
+        writer.writeString(backend.first);
+        writeExecutionStats(writer, backend.second);
+    }
+}
+
+ExecutionAggregatedStats readExecutionStats(MessageReader& reader)
+{
+    ExecutionAggregatedStats stats;
+    stats.gas = reader.read<uint64_t>();
+    stats.execCount = reader.read<uint64_t>();
+    stats.totalTime = reader.read<double>();
+    stats.gasPerSecond = reader.read<double>();
+    stats.timeMean = reader.read<double>();
+    stats.timeStdev = reader.read<double>();
+    stats.timeMedian = reader.read<double>();
+    stats.medianGasPerSecond = reader.read<double>();
+    stats.measurements = reader.readDoubles();
+    if (reader.read<bool>())
+    {
+        HardwareCounters counters;
+        counters.cycles = reader.read<uint64_t>();
+        counters.instructions = reader.read<uint64_t>();
+        counters.cacheMisses = reader.read<uint64_t>();
+        counters.branchMisses = reader.read<uint64_t>();
+        counters.tlbMisses = reader.read<uint64_t>();
+        stats.counters = counters;
+    }
+    stats.timeMedianLow = reader.read<double>();
+    stats.timeMedianHigh = reader.read<double>();
+    auto backendsCount = reader.read<uint64_t>();
+    for (uint64_t i = 0; i < backendsCount; i++)
+    {
+        auto name = reader.readString();
+        stats.backends[name] = readExecutionStats(reader);
+    }
+    return stats;
+}
+
+}  // namespace eth
+}  // namespace dev
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <libdevcore/Common.h>
+
+#include "ExecutionEnv.h"
+
+namespace dev
+{
+namespace eth
+{
+/// Writes exactly `size` bytes to `fd`, retrying on interruptions.
+/// Throws instead of raising SIGPIPE if the other end is closed
+void writeAll(int fd, const void* data, size_t size);
+
+/// Reads exactly `size` bytes from `fd`, throws if the other end is closed
+void readAll(int fd, void* data, size_t size);
+
+/// Length-prefixed message exchanged between the processes of a search
+/// (benchmark workers, islands) over pipes or sockets, also used for search checkpoints.
+/// Both ends run the same binary on the same machine so values are sent in native layout
+class MessageWriter
+{
+public:
+    template <typename T>
+    void write(T value)
+    {
+        auto ptr = reinterpret_cast<const uint8_t*>(&value);
+        m_buffer.insert(m_buffer.end(), ptr, ptr + sizeof(T));
+    }
+
+    void writeBytes(const bytes& data)
+    {
+        write<uint64_t>(data.size());
+        m_buffer.insert(m_buffer.end(), data.begin(), data.end());
+    }
+
+    void writeString(const std::string& value) { writeBytes(bytes(value.begin(), value.end())); }
+
+    void writeDoubles(const std::vector<double>& values)
+    {
+        write<uint64_t>(values.size());
+        for (auto value : values)
+        {
+            write(value);
+        }
+    }
+
+    void send(int fd) const;
+
+    const bytes& buffer() const { return m_buffer; }
+
+private:
+    bytes m_buffer;
+};
+
+class MessageReader
+{
+public:
+    MessageReader() = default;
+    explicit MessageReader(bytes buffer) : m_buffer(std::move(buffer)) {}
+
+    static MessageReader receive(int fd);
+
+    template <typename T>
+    T read()
+    {
+        if (m_offset + sizeof(T) > m_buffer.size())
+        {
+            throw std::runtime_error("truncated message");
+        }
+        T value;
+        std::memcpy(&value, m_buffer.data() + m_offset, sizeof(T));
+        m_offset += sizeof(T);
+        return value;
+    }
+
+    bytes readBytes();
+    std::string readString();
+    std::vector<double> readDoubles();
+
+    bool atEnd() const { return m_offset == m_buffer.size(); }
+
+private:
+    bytes m_buffer;
+    size_t m_offset = 0;
+};
+
+void writeExecutionStats(MessageWriter& writer, const ExecutionAggregatedStats& stats);
+ExecutionAggregatedStats readExecutionStats(MessageReader& reader);
+
+}  // namespace eth
+}  // namespace dev
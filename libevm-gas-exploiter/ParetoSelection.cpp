@@ -0,0 +1,207 @@
+#include "ParetoSelection.h"
+
+#include <algorithm>
+#include <limits>
+#include <map>
+#include <numeric>
+#include <stdexcept>
+
+namespace dev
+{
+namespace eth
+{
+namespace
+{
+using Getter = double (*)(const ExecutionAggregatedStats&);
+
+double perExecution(const ExecutionAggregatedStats& stats, uint64_t HardwareCounters::*field)
+{
+    if (!stats.counters || stats.execCount == 0)
+    {
+        return 0;
+    }
+    return static_cast<double>((*stats.counters).*field) / stats.execCount;
+}
+
+const std::map<std::string, Getter>& getters()
+{
+    static const std::map<std::string, Getter> getters = {
+        {"gas", [](const ExecutionAggregatedStats& s) -> double { return s.gas; }},
+        {"total_time", [](const ExecutionAggregatedStats& s) { return s.totalTime; }},
+        {"gas_per_second", [](const ExecutionAggregatedStats& s) { return s.gasPerSecond; }},
+        {"time_mean", [](const ExecutionAggregatedStats& s) { return s.timeMean; }},
+        {"time_stdev", [](const ExecutionAggregatedStats& s) { return s.timeStdev; }},
+        {"time_median", [](const ExecutionAggregatedStats& s) { return s.timeMedian; }},
+        {"time_median_ci_width",
+            [](const ExecutionAggregatedStats& s) { return s.timeMedianRelativeWidth(); }},
+        {"median_gas_per_second",
+            [](const ExecutionAggregatedStats& s) { return s.medianGasPerSecond; }},
+        {"cycles_per_gas", [](const ExecutionAggregatedStats& s) { return s.cyclesPerGas(); }},
+        {"cache_misses",
+            [](const ExecutionAggregatedStats& s) {
+                return perExecution(s, &HardwareCounters::cacheMisses);
+            }},
+        {"branch_misses",
+            [](const ExecutionAggregatedStats& s) {
+                return perExecution(s, &HardwareCounters::branchMisses);
+            }},
+        {"tlb_misses",
+            [](const ExecutionAggregatedStats& s) {
+                return perExecution(s, &HardwareCounters::tlbMisses);
+            }},
+    };
+    return getters;
+}
+}  // namespace
+
+
+Objective::Objective(const std::string& field, Direction direction)
+  : m_field(field), m_direction(direction)
+{
+    auto it = getters().find(field);
+    if (it == getters().end())
+    {
+        throw std::invalid_argument("unknown objective field '" + field + "'");
+    }
+    m_getter = it->second;
+}
+
+Objective Objective::parse(const std::string& description)
+{
+    auto separator = description.find(':');
+    if (separator == std::string::npos)
+    {
+        throw std::invalid_argument(
+            "objective should be 'max:<field>' or 'min:<field>', got '" + description + "'");
+    }
+    auto direction = description.substr(0, separator);
+    auto field = description.substr(separator + 1);
+    if (direction == "max")
+    {
+        return Objective(field, Direction::Maximize);
+    }
+    else if (direction == "min")
+    {
+        return Objective(field, Direction::Minimize);
+    }
+    throw std::invalid_argument("objective direction should be 'max' or 'min', got '" + direction + "'");
+}
+
+double Objective::value(const ExecutionAggregatedStats& stats) const
+{
+    return m_getter(stats);
+}
+
+double Objective::score(const ExecutionAggregatedStats& stats) const
+{
+    auto objectiveValue = value(stats);
+    return m_direction == Direction::Maximize ? objectiveValue : -objectiveValue;
+}
+
+std::string Objective::toString() const
+{
+    return (m_direction == Direction::Maximize ? "max:" : "min:") + m_field;
+}
+
+
+bool dominates(const std::vector<double>& scores, const std::vector<double>& other)
+{
+    bool strictlyBetter = false;
+    for (size_t i = 0; i < scores.size(); i++)
+    {
+        if (scores[i] < other[i])
+        {
+            return false;
+        }
+        if (scores[i] > other[i])
+        {
+            strictlyBetter = true;
+        }
+    }
+    return strictlyBetter;
+}
+
+std::vector<std::vector<size_t>> nonDominatedSort(const std::vector<std::vector<double>>& scores)
+{
+    std::vector<std::vector<size_t>> dominated(scores.size());
+    std::vector<size_t> dominationCounts(scores.size(), 0);
+    std::vector<std::vector<size_t>> fronts(1);
+
+    for (size_t i = 0; i < scores.size(); i++)
+    {
+        for (size_t j = i + 1; j < scores.size(); j++)
+        {
+            if (dominates(scores[i], scores[j]))
+            {
+                dominated[i].push_back(j);
+                dominationCounts[j]++;
+            }
+            else if (dominates(scores[j], scores[i]))
+            {
+                dominated[j].push_back(i);
+                dominationCounts[i]++;
+            }
+        }
+        // all the pairs containing i have been compared at this point
+        if (dominationCounts[i] == 0)
+        {
+            fronts[0].push_back(i);
+        }
+    }
+
+    while (!fronts.back().empty())
+    {
+        std::vector<size_t> nextFront;
+        for (auto i : fronts.back())
+        {
+            for (auto j : dominated[i])
+            {
+                if (--dominationCounts[j] == 0)
+                {
+                    nextFront.push_back(j);
+                }
+            }
+        }
+        fronts.push_back(nextFront);
+    }
+    fronts.pop_back();
+    return fronts;
+}
+
+std::vector<double> crowdingDistances(
+    const std::vector<std::vector<double>>& scores, const std::vector<size_t>& front)
+{
+    std::vector<double> distances(front.size(), 0);
+    if (front.empty())
+    {
+        return distances;
+    }
+
+    const auto infinity = std::numeric_limits<double>::infinity();
+    std::vector<size_t> order(front.size());
+    for (size_t objective = 0; objective < scores[front[0]].size(); objective++)
+    {
+        std::iota(order.begin(), order.end(), 0);
+        std::sort(order.begin(), order.end(), [&](size_t left, size_t right) {
+            return scores[front[left]][objective] < scores[front[right]][objective];
+        });
+
+        distances[order.front()] = infinity;
+        distances[order.back()] = infinity;
+        auto range = scores[front[order.back()]][objective] - scores[front[order.front()]][objective];
+        if (range <= 0)
+        {
+            continue;
+        }
+        for (size_t i = 1; i + 1 < order.size(); i++)
+        {
+            distances[order[i]] +=
+                (scores[front[order[i + 1]]][objective] - scores[front[order[i - 1]]][objective]) /
+                range;
+        }
+    }
+    return distances;
+}
+
+}  // namespace eth
+}  // namespace dev
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include <json/json.h>
+
+#include "ExecutionEnv.h"
+
+namespace dev
+{
+namespace eth
+{
+/// An objective of a multi-objective search: a field of `ExecutionAggregatedStats`
+/// and whether it should be maximized or minimized.
+/// Fields are named as in `ExecutionAggregatedStats::toJson`, e.g. `time_median`,
+/// `time_stdev`, `gas`, `gas_per_second` or `cycles_per_gas`
+class Objective
+{
+public:
+    enum class Direction
+    {
+        Minimize,
+        Maximize,
+    };
+
+    Objective(const std::string& field, Direction direction);
+
+    /// Parses an objective of the form `max:<field>` or `min:<field>`
+    static Objective parse(const std::string& description);
+
+    /// Value of the field for the given stats
+    double value(const ExecutionAggregatedStats& stats) const;
+
+    /// Value oriented so that a higher score is always better
+    double score(const ExecutionAggregatedStats& stats) const;
+
+    const std::string& field() const { return m_field; }
+    Direction direction() const { return m_direction; }
+    std::string toString() const;
+
+private:
+    std::string m_field;
+    Direction m_direction;
+    double (*m_getter)(const ExecutionAggregatedStats&);
+};
+
+
+/// Returns true if `scores` is at least as good as `other` for every objective
+/// and strictly better for at least one of them
+bool dominates(const std::vector<double>& scores, const std::vector<double>& other);
+
+/// Sorts the points in successive non-dominated fronts as done by NSGA-II.
+/// `scores[i]` contains the objective scores of the i-th point, higher being better.
+/// The first front contains the indexes of the points which are not dominated by any
+/// other point, the second front the ones only dominated by points of the first front, etc.
+std::vector<std::vector<size_t>> nonDominatedSort(const std::vector<std::vector<double>>& scores);
+
+/// Computes the crowding distance of each point of `front`, returned in the same order.
+/// Points at the boundaries of an objective have an infinite distance
+std::vector<double> crowdingDistances(
+    const std::vector<std::vector<double>>& scores, const std::vector<size_t>& front);
+
+}  // namespace eth
+}  // namespace dev
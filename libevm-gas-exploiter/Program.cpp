@@ -1,24 +1,49 @@
 #include "Program.h"
 #include "InstructionHelpers.h"
 
+#include <libdevcore/RLP.h>
+
+#include <algorithm>
 #include <stdexcept>
 #include <boost/algorithm/string.hpp>
 
+namespace
+{
+/// Replaces the elements of `values` in [begin, end) by the elements in [first, last)
+template <typename T, typename It>
+void replaceRange(std::vector<T>& values, size_t begin, size_t end, It first, It last)
+{
+    size_t count = std::distance(first, last);
+    auto copied = std::min(end - begin, count);
+    std::copy_n(first, copied, values.begin() + begin);
+    if (count > copied)
+    {
+        values.insert(values.begin() + end, first + copied, last);
+    }
+    else
+    {
+        values.erase(values.begin() + begin + count, values.begin() + end);
+    }
+}
+}
+
 namespace dev
 {
 namespace eth
 {
 
-std::shared_ptr<ProgramInstruction> ProgramInstruction::create(
+ProgramInstruction::ProgramInstruction(
     Instruction instruction, ProgramData data, Protection protection)
+  : m_instruction(instruction), m_data(data), m_protection(protection)
 {
-    if (isPush(instruction) && (
-        data.size != pushOperandSize(instruction) ||
-        data.value > pushMaxValue(instruction)))
+    if (!isPush(instruction))
+    {
+        throw std::invalid_argument("data can only be passed with push");
+    }
+    if (data.size != pushOperandSize(instruction) || data.value > pushMaxValue(instruction))
     {
         throw std::runtime_error("invalid value for PUSH");
     }
-    return std::make_shared<ProgramInstructionWithData>(instruction, data, protection);
 }
 
 std::string ProgramData::toHex() const
@@ -38,90 +63,185 @@ std::string ProgramInstruction::toHex() const
 {
     std::stringstream ss;
     ss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(m_instruction);
+    if (hasData())
+    {
+        ss << m_data.toHex();
+    }
     return boost::algorithm::to_lower_copy(ss.str());
 }
 
-std::string ProgramInstructionWithData::toHex() const
-{
-    std::stringstream ss;
-    ss << ProgramInstruction::toHex();
-    ss << m_data.toHex();
-    return ss.str();
-}
-
 std::string ProgramInstruction::toOpcode() const
-{
-    return instructionInfo(m_instruction).name;
-}
-
-std::string ProgramInstructionWithData::toOpcode() const
 {
     std::stringstream ss;
-    ss << ProgramInstruction::toOpcode() << ' ';
-    ss << m_data.toHex();
+    ss << instructionInfo(m_instruction).name;
+    if (hasData())
+    {
+        ss << ' ' << m_data.toHex();
+    }
     return ss.str();
 }
 
 
 Program::Program() {}
-Program::Program(std::vector<std::shared_ptr<ProgramInstruction>> _instructions)
-    : m_instructions(_instructions) {}
+Program::Program(uint64_t initialStackSize) : m_stackSize({initialStackSize}) {}
 
 
-void Program::addInstruction(std::shared_ptr<ProgramInstruction> pInstruction)
+void Program::addInstruction(const ProgramInstruction& instruction)
 {
-    auto info = instructionInfo(pInstruction->instruction());
     auto currentStackSize = stackSize();
-    if (static_cast<uint64_t>(info.args) > currentStackSize)
+    if (stackArguments(instruction.instruction()) > currentStackSize)
     {
         throw std::runtime_error("not enough elements on the stack");
     }
-    auto stackDifference = info.ret - info.args;
-    currentStackSize += stackDifference;
-    m_stackSize.push_back(currentStackSize);
-    m_instructions.push_back(pInstruction);
+
+    m_opcodes.push_back(static_cast<uint8_t>(instruction.instruction()));
+
+    // PUSH instructions added without data push 0
+    auto dataSize = isPush(instruction.instruction()) ? pushOperandSize(instruction.instruction()) : 0;
+    auto data = instruction.data();
+    for (int i = dataSize - 1; i >= 0; i--)
+    {
+        m_immediates.push_back(static_cast<uint8_t>(data.value >> (8 * i)));
+    }
+    m_immediateOffsets.push_back(m_immediates.size());
+
+    m_protectionGroups.push_back(instruction.isProtected() ? ++m_lastProtectionGroup : 0);
+    m_stackSize.push_back(currentStackSize + stackDifference(instruction.instruction()));
+    m_stackSizeIndex.reset();
 }
 
 void Program::addInstruction(Instruction instruction, Protection protection)
 {
-    addInstruction(ProgramInstruction::create(instruction, protection));
+    addInstruction(ProgramInstruction(instruction, protection));
 }
 
 void Program::addInstruction(Instruction instruction, ProgramData data, Protection protection)
 {
-    if (isPush(instruction))
+    addInstruction(ProgramInstruction(instruction, data, protection));
+}
+
+void Program::addInstruction(Instruction instruction, u256 data, Protection protection)
+{
+    auto dataSize = isPush(instruction) ? pushOperandSize(instruction) : 0;
+    addInstruction(instruction, ProgramData(data, dataSize), protection);
+}
+
+void Program::append(const Program& other, size_t begin, size_t end)
+{
+    if (begin > end || end > other.size())
     {
-        addInstruction(ProgramInstruction::create(instruction, data, protection));
+        throw std::out_of_range("invalid range to append");
     }
-    else
+
+    auto count = end - begin;
+    auto oldSize = size();
+    auto currentStackSize = stackSize();
+    auto baseStackSize = other.m_stackSize[begin];
+
+    if (currentStackSize < baseStackSize)
     {
-        throw std::invalid_argument("data can only be passed with push");
+        for (size_t i = begin; i < end; i++)
+        {
+            if (other.m_stackSize[i] + currentStackSize < stackArguments(other.instruction(i)) + baseStackSize)
+            {
+                throw std::runtime_error("not enough elements on the stack");
+            }
+        }
+    }
+
+    auto immediatesBegin = other.m_immediateOffsets[begin];
+    auto immediatesEnd = other.m_immediateOffsets[end];
+    auto oldImmediatesSize = m_immediates.size();
+
+    // `other` can be this program, so nothing must be read from it
+    // before all the vectors are resized
+    m_opcodes.resize(oldSize + count);
+    m_immediates.resize(oldImmediatesSize + immediatesEnd - immediatesBegin);
+    m_immediateOffsets.resize(oldSize + count + 1);
+    m_protectionGroups.resize(oldSize + count);
+    m_stackSize.resize(oldSize + count + 1);
+
+    std::copy_n(other.m_opcodes.begin() + begin, count, m_opcodes.begin() + oldSize);
+    std::copy(other.m_immediates.begin() + immediatesBegin,
+        other.m_immediates.begin() + immediatesEnd, m_immediates.begin() + oldImmediatesSize);
+    for (size_t i = 1; i <= count; i++)
+    {
+        m_immediateOffsets[oldSize + i] =
+            other.m_immediateOffsets[begin + i] - immediatesBegin + oldImmediatesSize;
+        m_stackSize[oldSize + i] = other.m_stackSize[begin + i] + currentStackSize - baseStackSize;
     }
+
+    // group ids are only unique within a program, so appended groups get new ids
+    uint32_t previousGroup = 0;
+    for (size_t i = 0; i < count; i++)
+    {
+        auto group = other.m_protectionGroups[begin + i];
+        if (group != 0 && group != previousGroup)
+        {
+            m_lastProtectionGroup++;
+        }
+        previousGroup = group;
+        m_protectionGroups[oldSize + i] = group == 0 ? 0 : m_lastProtectionGroup;
+    }
+    m_stackSizeIndex.reset();
 }
 
-void Program::addInstruction(Instruction instruction, u256 data, Protection protection)
+void Program::protectLast(size_t count)
 {
-    auto dataSize = isPush(instruction) ? pushOperandSize(instruction) : 0;
-    addInstruction(instruction, ProgramData(data, dataSize), protection);
+    if (count == 0 || count > size())
+    {
+        throw std::invalid_argument("invalid number of instructions to protect");
+    }
+    m_lastProtectionGroup++;
+    std::fill(m_protectionGroups.end() - count, m_protectionGroups.end(), m_lastProtectionGroup);
+    m_stackSizeIndex.reset();
 }
 
+std::pair<size_t, size_t> Program::protectionGroup(size_t i) const
+{
+    auto group = m_protectionGroups[i];
+    if (group == 0)
+    {
+        return std::make_pair(i, i + 1);
+    }
+    size_t begin = i;
+    while (begin > 0 && m_protectionGroups[begin - 1] == group)
+    {
+        begin--;
+    }
+    size_t end = i + 1;
+    while (end < size() && m_protectionGroups[end] == group)
+    {
+        end++;
+    }
+    return std::make_pair(begin, end);
+}
 
-std::string Program::toHex() const
+ProgramInstruction Program::operator[](size_t i) const
 {
-    std::stringstream sstream;
-    for (auto inst: m_instructions)
+    auto protection = isProtected(i) ? Protection::Protected : Protection::None;
+    auto dataBegin = m_immediateOffsets[i];
+    auto dataSize = m_immediateOffsets[i + 1] - dataBegin;
+    if (dataSize == 0)
     {
-        sstream << inst->toHex();
+        return ProgramInstruction(instruction(i), protection);
     }
-    return sstream.str();
+    auto value = fromBigEndian<u256>(bytesConstRef(m_immediates.data() + dataBegin, dataSize));
+    return ProgramInstruction(instruction(i), ProgramData(value, dataSize), protection);
+}
+
+
+std::string Program::toHex() const
+{
+    return dev::toHex(toBytes());
 }
 
 std::string Program::toOpcodes() const
 {
     std::stringstream sstream;
-    for (auto inst: m_instructions)
+    for (size_t i = 0; i < size(); i++)
     {
-        sstream << inst->toOpcode() << '\n';
+        sstream << (*this)[i].toOpcode() << '\n';
     }
     return sstream.str();
 }
@@ -129,7 +249,15 @@ std::string Program::toOpcodes() const
 
 bytes Program::toBytes() const
 {
-    return fromHex(toHex(), WhenError::Throw);
+    bytes code;
+    code.reserve(m_opcodes.size() + m_immediates.size());
+    auto immediates = m_immediates.begin();
+    for (size_t i = 0; i < size(); i++)
+    {
+        code.push_back(m_opcodes[i]);
+        code.insert(code.end(), immediates + m_immediateOffsets[i], immediates + m_immediateOffsets[i + 1]);
+    }
+    return code;
 }
 
 
@@ -150,8 +278,12 @@ void Program::limitSize(size_t maximumSize)
 {
     if (size() > maximumSize)
     {
-        m_instructions.resize(maximumSize);
+        m_opcodes.resize(maximumSize);
+        m_immediates.resize(m_immediateOffsets[maximumSize]);
+        m_immediateOffsets.resize(maximumSize + 1);
+        m_protectionGroups.resize(maximumSize);
         m_stackSize.resize(maximumSize + 1);
+        m_stackSizeIndex.reset();
     }
 }
 
@@ -160,113 +292,193 @@ void Program::extendSize(size_t minimumSize)
     auto instToRepeat = uniqueSize();
     while (size() < minimumSize)
     {
-        for (size_t i = 0; i < instToRepeat; i++)
-        {
-            addInstruction(m_instructions[i]);
-        }
+        append(*this, 0, instToRepeat);
         m_repeatedTime++;
     }
 }
 
 
-void Program::replaceInstruction(size_t index, std::vector<std::shared_ptr<ProgramInstruction>> replacement)
+void Program::replaceInstruction(size_t index, const Program& replacement)
 {
-    if (replacement.empty())
+    if (replacement.size() == 0)
     {
         throw std::invalid_argument("replacement cannot be empty");
     }
 
-    auto instr = m_instructions[index];
-
     // check that the stack stays consistent
-    auto replacedInfo = instructionInfo(instr->instruction());
-    auto replacementInfo = instructionInfo(replacement[replacement.size() - 1]->instruction());
-    auto stackSizeDiff = (replacementInfo.ret - replacementInfo.args) - (replacedInfo.ret - replacedInfo.args);
-    if (replacementInfo.args > replacedInfo.args || stackSizeDiff < 0)
+    auto replaced = instruction(index);
+    auto replacing = replacement.instruction(replacement.size() - 1);
+    auto stackSizeDiff = stackDifference(replacing) - stackDifference(replaced);
+    if (stackArguments(replacing) > stackArguments(replaced) || stackSizeDiff < 0)
     {
         throw std::invalid_argument("replacement must use <= args and return >= values");
     }
 
-    // list up all the indexes to replace (including PUSH/POP dependencies)
-    std::vector<size_t> indexesToReplace = { index };
-    for (size_t i = index; i > 0 && m_instructions[i - 1]->requiredBy() == instr; i--)
+    // the instruction is replaced with all the PUSH/POP it depends on
+    auto begin = protectionGroup(index).first;
+    auto end = index + 1;
+    auto count = replacement.size();
+
+    auto baseStackSize = m_stackSize[begin];
+    if (replacement.m_stackSize[0] > baseStackSize)
     {
-        indexesToReplace.push_back(i - 1);
+        throw std::invalid_argument("replacement requires more elements on the stack");
     }
-    std::reverse(indexesToReplace.begin(), indexesToReplace.end());
 
-    // replace values
-    size_t i;
-    for (i = 0; i < indexesToReplace.size() && i < replacement.size(); i++)
+    replaceRange(m_opcodes, begin, end, replacement.m_opcodes.begin(), replacement.m_opcodes.end());
+
+    auto immediatesBegin = m_immediateOffsets[begin];
+    auto immediatesEnd = m_immediateOffsets[end];
+    replaceRange(m_immediates, immediatesBegin, immediatesEnd, replacement.m_immediates.begin(),
+        replacement.m_immediates.end());
+    replaceRange(m_immediateOffsets, begin + 1, end + 1, replacement.m_immediateOffsets.begin() + 1,
+        replacement.m_immediateOffsets.end());
+    for (size_t i = begin + 1; i <= begin + count; i++)
     {
-        m_instructions[indexesToReplace[i]] = replacement[i];
+        m_immediateOffsets[i] += immediatesBegin;
     }
-
-    // if the replaced and replacement were the same size
-    // both vectors should be fully consumed
-    if (i == indexesToReplace.size() && i == replacement.size())
+    auto immediatesShift = immediatesBegin + replacement.m_immediates.size() - immediatesEnd;
+    if (immediatesShift != 0)
     {
-        // adjust the stack sizes if necessary
-        if (stackSizeDiff != 0)
+        for (size_t i = begin + count + 1; i < m_immediateOffsets.size(); i++)
         {
-            recomputeStackSize();
+            m_immediateOffsets[i] += immediatesShift;
         }
-        return;
     }
-    // otherwise, we need to consume the rest
-    // and to adjust the stack size
-    else if (i < indexesToReplace.size())
+
+    replaceRange(m_protectionGroups, begin, end, replacement.m_protectionGroups.begin(),
+        replacement.m_protectionGroups.end());
+    uint32_t previousGroup = 0;
+    for (size_t i = begin; i < begin + count; i++)
     {
-        for (size_t j = i; j < indexesToReplace.size(); j++)
+        auto group = m_protectionGroups[i];
+        if (group != 0 && group != previousGroup)
         {
-            m_instructions.erase(m_instructions.begin() + indexesToReplace[i]);
+            m_lastProtectionGroup++;
         }
+        previousGroup = group;
+        m_protectionGroups[i] = group == 0 ? 0 : m_lastProtectionGroup;
     }
-    else if (i < replacement.size())
+
+    // only the stack sizes of the replaced range need to be updated
+    // unless the replacement changes the stack size after it
+    auto oldEndStackSize = m_stackSize[end];
+    replaceRange(m_stackSize, begin + 1, end + 1, replacement.m_stackSize.begin() + 1,
+        replacement.m_stackSize.end());
+    for (size_t i = begin + 1; i <= begin + count; i++)
+    {
+        m_stackSize[i] += baseStackSize - replacement.m_stackSize[0];
+    }
+    auto stackSizeShift = m_stackSize[begin + count] - oldEndStackSize;
+    if (stackSizeShift != 0)
     {
-        for (; i < replacement.size(); i++)
+        for (size_t i = begin + count + 1; i < m_stackSize.size(); i++)
         {
-            m_instructions.insert(m_instructions.begin() + indexesToReplace[0] + i, replacement[i]);
+            m_stackSize[i] += stackSizeShift;
         }
     }
-    recomputeStackSize();
-}
 
-void Program::recomputeStackSize()
-{
-    size_t stackSize = 0;
-    m_stackSize = {stackSize};
-    for (auto instr : m_instructions)
-    {
-        auto info = instructionInfo(instr->instruction());
-        auto stackDifference = info.ret - info.args;
-        stackSize += stackDifference;
-        m_stackSize.push_back(stackSize);
-    }
+    m_stackSizeIndex.reset();
 }
 
 Program Program::withStop() const
 {
-    Program program(m_instructions);
+    Program program(*this);
     program.addInstruction(Instruction::STOP);
     return program;
 }
 
-std::map<uint64_t, std::vector<size_t>> Program::stackSizeReverseIndex() const
+StackSizeIndex::StackSizeIndex(
+    const std::vector<uint64_t>& stackSizes, const std::vector<uint32_t>& protectionGroups)
 {
-    std::map<uint64_t, std::vector<size_t>> reverseIndex;
-    for (size_t i = 1; i < m_instructions.size(); i++)
+    // stackSizes also contains the stack size after the last instruction
+    for (size_t i = 1; i + 1 < stackSizes.size(); i++)
     {
-        auto& instr = m_instructions[i];
-        if (instr->isProtected())
+        if (protectionGroups[i] != 0)
         {
             continue;
         }
-        auto stackSize = m_stackSize[i];
-        auto& positions = reverseIndex[stackSize];
-        positions.push_back(i);
+        auto stackSize = stackSizes[i];
+        if (stackSize >= m_positions.size())
+        {
+            m_positions.resize(stackSize + 1);
+        }
+        if (m_positions[stackSize].empty())
+        {
+            m_stackSizesCount++;
+        }
+        m_positions[stackSize].push_back(i);
+    }
+}
+
+const std::vector<size_t>& StackSizeIndex::positions(uint64_t stackSize) const
+{
+    static const std::vector<size_t> noPositions;
+    return stackSize < m_positions.size() ? m_positions[stackSize] : noPositions;
+}
+
+bytes Program::encode() const
+{
+    RLPStream stream(5);
+    stream << u256(m_stackSize[0]) << u256(m_repeatedTime) << m_opcodes
+           << m_immediates << m_protectionGroups;
+    return stream.out();
+}
+
+Program Program::decode(bytesConstRef data)
+{
+    try
+    {
+        RLP rlp(data);
+        Program program(rlp[0].toInt<uint64_t>());
+        program.m_repeatedTime = rlp[1].toInt<uint64_t>();
+        program.m_opcodes = rlp[2].toBytes();
+        program.m_immediates = rlp[3].toBytes();
+        program.m_protectionGroups = rlp[4].toVector<uint32_t>(RLP::VeryStrict);
+
+        auto count = program.m_opcodes.size();
+        if (program.m_protectionGroups.size() != count || program.m_repeatedTime == 0)
+        {
+            throw std::runtime_error("inconsistent sizes");
+        }
+        program.m_immediateOffsets.reserve(count + 1);
+        program.m_stackSize.reserve(count + 1);
+        for (size_t i = 0; i < count; i++)
+        {
+            auto instruction = program.instruction(i);
+            if (stackArguments(instruction) > program.m_stackSize[i])
+            {
+                throw std::runtime_error("not enough elements on the stack");
+            }
+            auto dataSize = isPush(instruction) ? pushOperandSize(instruction) : 0;
+            program.m_immediateOffsets.push_back(program.m_immediateOffsets[i] + dataSize);
+            program.m_stackSize.push_back(program.m_stackSize[i] + stackDifference(instruction));
+            program.m_lastProtectionGroup =
+                std::max(program.m_lastProtectionGroup, program.m_protectionGroups[i]);
+        }
+        if (program.m_immediateOffsets.back() != program.m_immediates.size())
+        {
+            throw std::runtime_error("inconsistent immediates size");
+        }
+        return program;
+    }
+    catch (const RLPException& e)
+    {
+        throw std::runtime_error(std::string("invalid encoded program: ") + e.what());
+    }
+    catch (const std::runtime_error& e)
+    {
+        throw std::runtime_error(std::string("invalid encoded program: ") + e.what());
+    }
+}
+
+const StackSizeIndex& Program::stackSizeReverseIndex() const
+{
+    if (m_stackSizeIndex == nullptr)
+    {
+        m_stackSizeIndex = std::make_shared<StackSizeIndex>(m_stackSize, m_protectionGroups);
     }
-    return reverseIndex;
+    return *m_stackSizeIndex;
 }
 
 }
@@ -22,6 +22,8 @@ struct ProgramData
     std::string toHex() const;
 };
 
+/// ProgramInstruction is a standalone copy of a single instruction of a program
+/// Programs do not store instructions individually, see `Program`
 class ProgramInstruction
 {
 public:
@@ -31,84 +33,108 @@ public:
         Protected
     };
 
-    ProgramInstruction(Instruction instruction, Protection protection = Protection::None)
-      : m_instruction(instruction), m_protection(protection), m_requiredBy(std::shared_ptr<ProgramInstruction>(nullptr))
+    explicit ProgramInstruction(Instruction instruction, Protection protection = Protection::None)
+      : m_instruction(instruction), m_data(0, 0), m_protection(protection)
     {}
 
-    ProgramInstruction(Instruction instruction,
-                       std::shared_ptr<ProgramInstruction> requiredBy)
-      : m_instruction(instruction), m_protection(Protection::Protected), m_requiredBy(requiredBy)
-    {}
-
-    virtual ~ProgramInstruction() {}
+    /// throws if `data` is not valid for `instruction`
+    ProgramInstruction(
+        Instruction instruction, ProgramData data, Protection protection = Protection::None);
 
-    virtual bool hasData() const { return false; }
+    bool hasData() const { return m_data.size > 0; }
     Instruction instruction() const { return m_instruction; }
-    virtual std::string toHex() const;
-    virtual std::string toOpcode() const;
+    ProgramData data() const { return m_data; }
+    std::string toHex() const;
+    std::string toOpcode() const;
     Protection protection() const { return m_protection; }
     bool isProtected() const { return m_protection == Protection::Protected; }
-    void enableProtection() { m_protection = Protection::Protected; }
-    void disableProtection() { m_protection = Protection::None; }
-    const std::shared_ptr<ProgramInstruction> requiredBy() const { return m_requiredBy.lock(); }
 
-    static std::shared_ptr<ProgramInstruction> create(
-        Instruction instruction, Protection protection = Protection::None)
+    bool operator==(const ProgramInstruction& other) const
     {
-        return std::make_shared<ProgramInstruction>(instruction, protection);
+        return m_instruction == other.m_instruction && m_data.size == other.m_data.size &&
+               m_data.value == other.m_data.value && m_protection == other.m_protection;
     }
-    static std::shared_ptr<ProgramInstruction> create(
-        Instruction instruction, ProgramData data, Protection protection = Protection::None);
+    bool operator!=(const ProgramInstruction& other) const { return !(*this == other); }
 
-protected:
+private:
     Instruction m_instruction;
+    ProgramData m_data;
     Protection m_protection;
-    std::weak_ptr<ProgramInstruction> m_requiredBy;
 };
 
-class ProgramInstructionWithData : public ProgramInstruction
+
+/// StackSizeIndex groups the positions where a program can be split by the size
+/// of the stack before the instruction at this position.
+/// The first instruction and protected instructions are never split points
+class StackSizeIndex
 {
 public:
-    ProgramInstructionWithData(
-        Instruction instruction, ProgramData data, Protection protection = Protection::None)
-      : ProgramInstruction(instruction, protection), m_data(data)
-    {}
-    ProgramInstructionWithData(
-        Instruction instruction, ProgramData data, std::shared_ptr<ProgramInstruction> requiredBy)
-      : ProgramInstruction(instruction, requiredBy), m_data(data)
-    {}
+    StackSizeIndex(
+        const std::vector<uint64_t>& stackSizes, const std::vector<uint32_t>& protectionGroups);
+
+    /// Returns the split points with `stackSize` elements on the stack, in increasing order
+    const std::vector<size_t>& positions(uint64_t stackSize) const;
+    size_t count(uint64_t stackSize) const { return positions(stackSize).size(); }
+
+    /// Largest stack size with at least one split point, 0 when there is none
+    uint64_t maxStackSize() const { return m_positions.empty() ? 0 : m_positions.size() - 1; }
+
+    /// Number of distinct stack sizes with at least one split point
+    size_t stackSizesCount() const { return m_stackSizesCount; }
 
-    bool hasData() const override { return true; }
-    ProgramData data() const { return m_data; }
-    std::string toHex() const override;
-    std::string toOpcode() const override;
 private:
-    ProgramData m_data;
+    std::vector<std::vector<size_t>> m_positions;
+    size_t m_stackSizesCount = 0;
 };
 
 
+/// Program stores its instructions as a structure of flat arrays
+/// (opcodes, pool of PUSH immediates, protection groups and stack sizes)
+/// so that copying, concatenating or truncating programs only copies
+/// contiguous ranges of bytes and integers
+///
+/// Instructions added to make another instruction memory safe (see `appendMemorySafeSequence`)
+/// share a protection group with it. The instruction requiring the sequence
+/// is always the last one of its group
 class Program
 {
 public:
     using Protection = ProgramInstruction::Protection;
 
     Program();
-    explicit Program(std::vector<std::shared_ptr<ProgramInstruction>> _instructions);
 
-    void addInstruction(std::shared_ptr<ProgramInstruction> instruction);
+    /// Creates an empty program meant to be executed with `initialStackSize`
+    /// elements already on the stack, e.g. a replacement for some instructions of another program
+    explicit Program(uint64_t initialStackSize);
+
+    void addInstruction(const ProgramInstruction& instruction);
     void addInstruction(Instruction instruction, Protection protection = Protection::None);
     void addInstruction(
         Instruction instruction, u256 data, Protection protection = Protection::None);
     void addInstruction(
         Instruction instruction, ProgramData data, Protection protection = Protection::None);
 
-    void replaceInstruction(size_t index, std::vector<std::shared_ptr<ProgramInstruction>> replacement);
+    /// Appends the instructions of `other` in the range [`begin`, `end`)
+    /// `other` can be this program
+    void append(const Program& other, size_t begin, size_t end);
+    void append(const Program& other) { append(other, 0, other.size()); }
+
+    /// Puts the last `count` instructions in a new protection group
+    void protectLast(size_t count);
+
+    /// Replaces the instruction at `index`, as well as the rest of its protection group,
+    /// by all the instructions of `replacement`
+    void replaceInstruction(size_t index, const Program& replacement);
 
-    const std::vector<std::shared_ptr<ProgramInstruction>>& instructions() const
-    {
-        return m_instructions;
-    };
     uint64_t stackSize() const { return m_stackSize.back(); }
+    uint64_t stackSize(size_t i) const { return m_stackSize[i]; }
+
+    Instruction instruction(size_t i) const { return static_cast<Instruction>(m_opcodes[i]); }
+    bool isProtected(size_t i) const { return m_protectionGroups[i] != 0; }
+
+    /// Returns the range [begin, end) of the protection group of the instruction at `i`
+    /// or [i, i + 1) if the instruction is not protected
+    std::pair<size_t, size_t> protectionGroup(size_t i) const;
 
     /// Adjusts the program size so that it is between `minimumSize` and `maximumSize`
     void adjustSize(size_t minimumSize, size_t maximumSize);
@@ -125,19 +151,40 @@ public:
     bytes toBytes() const;
     std::string toOpcodes() const;
 
+    /// Serializes the program as RLP, including the protection groups
+    /// so that it can be mutated in the same way once decoded
+    bytes encode() const;
+
+    /// Decodes a program serialized with `encode`, throws std::runtime_error if it is invalid
+    static Program decode(bytesConstRef data);
+
     Program withStop() const;
 
-    const std::shared_ptr<ProgramInstruction> operator[](size_t i) const { return m_instructions[i]; };
+    ProgramInstruction operator[](size_t i) const;
 
-    size_t size() const { return m_instructions.size(); }
+    size_t size() const { return m_opcodes.size(); }
     size_t uniqueSize() const { return size() / m_repeatedTime; }
 
-    std::map<uint64_t, std::vector<size_t>> stackSizeReverseIndex() const;
+    /// The index is computed on first use and kept until the program is modified
+    const StackSizeIndex& stackSizeReverseIndex() const;
 
 
 private:
-    /// m_instructions is the vector of instructions in the program
-    std::vector<std::shared_ptr<ProgramInstruction>> m_instructions;
+    /// m_opcodes contains the opcode of each instruction
+    bytes m_opcodes;
+
+    /// m_immediates contains the big-endian data of all the PUSH instructions
+    bytes m_immediates;
+
+    /// m_immediateOffsets[i] is the offset of the data of the i-th instruction in m_immediates
+    /// the data of the i-th instruction is in [m_immediateOffsets[i], m_immediateOffsets[i + 1])
+    std::vector<uint32_t> m_immediateOffsets = {0};
+
+    /// m_protectionGroups is the protection group of each instruction, 0 if not protected
+    std::vector<uint32_t> m_protectionGroups;
+
+    /// last protection group id assigned in this program
+    uint32_t m_lastProtectionGroup = 0;
 
     /// number of times the program is repeated
     size_t m_repeatedTime = 1;
@@ -145,9 +192,8 @@ private:
     /// m_stackSize is the size of the program stack at each point of the program
     std::vector<uint64_t> m_stackSize = {0};
 
-
-    /// recomputeStackSize recomputes the values for m_stackSize
-    void recomputeStackSize();
+    /// cached result of stackSizeReverseIndex, reset when the program changes
+    mutable std::shared_ptr<const StackSizeIndex> m_stackSizeIndex;
 };
 
 }
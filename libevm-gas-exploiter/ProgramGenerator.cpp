@@ -5,6 +5,8 @@
 
 #include <libdevcore/Common.h>
 
+#include <sstream>
+
 
 namespace
 {
@@ -199,27 +201,22 @@ ProgramGenerator::ProgramGenerator(
 }
 
 
-std::shared_ptr<ProgramInstruction> ProgramGenerator::makeInstruction(Instruction instruction)
+ProgramInstruction ProgramGenerator::makeInstruction(Instruction instruction)
 {
     if (isPush(instruction))
     {
         uint8_t operandSize = pushOperandSize(instruction);
-        return std::make_shared<ProgramInstructionWithData>(instruction, makePushData(operandSize));
+        return ProgramInstruction(instruction, makePushData(operandSize));
     }
     else
     {
-        return std::make_shared<ProgramInstruction>(instruction);
+        return ProgramInstruction(instruction);
     }
 }
 
 void ProgramGenerator::addInstruction(Program& program, Instruction instruction)
 {
-    auto pInstruction = makeInstruction(instruction);
-    auto instructionsToAdd = generateMemorySafeSequence(pInstruction, m_generator);
-    for (auto instruction : instructionsToAdd)
-    {
-        program.addInstruction(instruction);
-    }
+    appendMemorySafeSequence(program, makeInstruction(instruction), m_generator);
 }
 
 ProgramData ProgramGenerator::makePushData(uint8_t operandSize)
@@ -255,5 +252,24 @@ Program ProgramGenerator::generateInitialProgram(uint64_t programSize)
     return program;
 }
 
+std::string ProgramGenerator::state() const
+{
+    std::ostringstream stream;
+    // boost engines skip the whitespace following each value when reading them back,
+    // which fails at the end of the stream without a trailing separator
+    stream << m_generator << ' ' << m_u256Generator << ' ';
+    return stream.str();
+}
+
+void ProgramGenerator::setState(const std::string& state)
+{
+    std::istringstream stream(state);
+    stream >> m_generator >> m_u256Generator;
+    if (stream.fail())
+    {
+        throw std::runtime_error("invalid program generator state");
+    }
+}
+
 }
 }
@@ -34,7 +34,7 @@ public:
 
     Program generateInitialProgram(uint64_t programSize = 10000);
 
-    std::shared_ptr<ProgramInstruction> makeInstruction(Instruction instruction);
+    ProgramInstruction makeInstruction(Instruction instruction);
     ProgramData makePushData(uint8_t operandSize);
 
     const std::map<int, std::vector<Instruction>>& instructionsPerArgsCount() { return m_instructionsPerArgsCount; }
@@ -43,6 +43,11 @@ public:
         return m_instructionsPerArgsCount[i];
     }
 
+    /// Textual state of the random generators, restoring it with `setState`
+    /// makes the generator produce the same programs again
+    std::string state() const;
+    void setState(const std::string& state);
+
 private:
     void addInstruction(Program& program, Instruction instruction);
 
@@ -100,5 +100,27 @@ typename std::iterator_traits<It>::value_type constMedian(It first, It last)
     return median(v.begin(), v.end());
 }
 
+/// Distribution-free confidence interval of the median, given by the order statistics
+/// of ranks n/2 -/+ z * sqrt(n) / 2 (normal approximation of the binomial distribution)
+/// `z` is the standard normal quantile of the confidence level, 1.96 for 95%
+template <typename It>
+std::pair<typename std::iterator_traits<It>::value_type,
+    typename std::iterator_traits<It>::value_type>
+medianConfidenceInterval(It first, It last, double z = 1.96)
+{
+    std::vector<typename std::iterator_traits<It>::value_type> v(first, last);
+    if (v.empty())
+    {
+        return {};
+    }
+    std::sort(v.begin(), v.end());
+    double size = v.size();
+    double halfWidth = z * std::sqrt(size) / 2;
+    // 1-based ranks of the bounds, clamped to the samples
+    auto low = std::max(std::floor(size / 2 - halfWidth), 1.0);
+    auto high = std::min(std::ceil(1 + size / 2 + halfWidth), size);
+    return {v[static_cast<size_t>(low) - 1], v[static_cast<size_t>(high) - 1]};
+}
+
 }  // namespace math
 }
\ No newline at end of file
@@ -0,0 +1,407 @@
+#include "WorkerPool.h"
+#include "Message.h"
+#include "Utils.h"
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+
+using dev::eth::MessageReader;
+using dev::eth::MessageWriter;
+
+namespace
+{
+enum class Request : uint8_t
+{
+    Benchmark = 0,
+    Shutdown = 1,
+};
+
+enum class Response : uint8_t
+{
+    Ok = 0,
+    Error = 1,
+};
+
+void sendError(int fd, const std::string& message)
+{
+    MessageWriter writer;
+    writer.write(Response::Error);
+    writer.writeString(message);
+    writer.send(fd);
+}
+
+double calibrate(const dev::eth::ExecutionEnv& execEnv, dev::eth::BenchmarkConfig config,
+    const dev::bytes& calibrationCode)
+{
+    config.dropCaches = false;
+    config.alwaysDropCache = false;
+    return dev::eth::benchmarkCode(execEnv, calibrationCode, config).timeMedian;
+}
+
+/// Main loop of a worker process, this never returns
+[[noreturn]] void runWorker(const dev::eth::ExecutionEnv& execEnv,
+    const dev::eth::BenchmarkConfig& config, unsigned core, const dev::bytes& calibrationCode,
+    int requestFd, int responseFd)
+{
+    // the parent process is in charge of handling interruptions
+    signal(SIGINT, SIG_IGN);
+
+    int exitCode = 0;
+    try
+    {
+        dev::eth::pinToCore(core);
+
+        for (uint16_t i = 0; i < config.initialWarmupCount; i++)
+        {
+            calibrate(execEnv, config, calibrationCode);
+        }
+        MessageWriter ready;
+        ready.write(Response::Ok);
+        ready.write(calibrate(execEnv, config, calibrationCode));
+        ready.send(responseFd);
+
+        while (true)
+        {
+            auto request = MessageReader::receive(requestFd);
+            if (request.read<Request>() == Request::Shutdown)
+            {
+                break;
+            }
+
+            std::vector<dev::bytes> codes(request.read<uint64_t>());
+            for (auto& code : codes)
+            {
+                code = request.readBytes();
+            }
+
+            try
+            {
+                auto calibrationTime = calibrate(execEnv, config, calibrationCode);
+                auto stats = dev::eth::benchmarkCodes(execEnv, codes, config);
+
+                MessageWriter response;
+                response.write(Response::Ok);
+                response.write(calibrationTime);
+                response.writeDoubles(stats.blockExecutionTimes);
+                for (auto& programStats : stats.programStats)
+                {
+                    writeExecutionStats(response, programStats);
+                }
+                response.send(responseFd);
+            }
+            catch (std::exception const& e)
+            {
+                sendError(responseFd, e.what());
+            }
+        }
+    }
+    catch (std::exception const& e)
+    {
+        try
+        {
+            sendError(responseFd, e.what());
+        }
+        catch (std::exception const&)
+        {
+            // the parent is gone, nothing left to report to
+        }
+        exitCode = 1;
+    }
+
+    close(requestFd);
+    close(responseFd);
+    // do not run the destructors and exit handlers inherited from the parent
+    _exit(exitCode);
+}
+
+}  // namespace
+
+namespace dev
+{
+namespace eth
+{
+
+BenchmarkWorkerPool::BenchmarkWorkerPool(const ExecutionEnv& execEnv,
+    const BenchmarkConfig& config, const std::vector<unsigned>& cores,
+    const bytes& calibrationCode)
+{
+    if (cores.empty())
+    {
+        throw std::invalid_argument("benchmark worker pool needs at least one core");
+    }
+
+    try
+    {
+        for (auto core : cores)
+        {
+            startWorker(execEnv, config, core, calibrationCode);
+        }
+
+        std::vector<double> calibrationTimes;
+        for (auto& worker : m_workers)
+        {
+            auto response = receive(worker, "failed to start");
+            if (response.read<Response>() == Response::Error)
+            {
+                throw std::runtime_error("benchmark worker on core " +
+                                         std::to_string(worker.core) +
+                                         " failed to start: " + response.readString());
+            }
+            auto calibrationTime = response.read<double>();
+            calibrationTimes.push_back(calibrationTime);
+            m_calibrations.push_back(WorkerCalibration{
+                .core = worker.core,
+                .initialTime = calibrationTime,
+                .lastTime = calibrationTime,
+                .drift = 0.0,
+                .skew = 0.0,
+            });
+        }
+        updateCalibrations(calibrationTimes);
+    }
+    catch (...)
+    {
+        stopWorkers();
+        throw;
+    }
+}
+
+BenchmarkWorkerPool::~BenchmarkWorkerPool()
+{
+    stopWorkers();
+}
+
+void BenchmarkWorkerPool::startWorker(const ExecutionEnv& execEnv, const BenchmarkConfig& config,
+    unsigned core, const bytes& calibrationCode)
+{
+    int requestPipe[2];
+    int responsePipe[2];
+    if (pipe(requestPipe) != 0)
+    {
+        throw std::runtime_error(std::string("failed to create pipe: ") + std::strerror(errno));
+    }
+    if (pipe(responsePipe) != 0)
+    {
+        close(requestPipe[0]);
+        close(requestPipe[1]);
+        throw std::runtime_error(std::string("failed to create pipe: ") + std::strerror(errno));
+    }
+
+    // avoid duplicating pending output in the child
+    std::cout.flush();
+    std::cerr.flush();
+
+    auto pid = fork();
+    if (pid < 0)
+    {
+        throw std::runtime_error(std::string("failed to fork benchmark worker: ") + std::strerror(errno));
+    }
+
+    if (pid == 0)
+    {
+        // the worker must not keep the other workers' pipes open,
+        // otherwise they would never see the pool closing them
+        for (auto& worker : m_workers)
+        {
+            close(worker.requestFd);
+            close(worker.responseFd);
+        }
+        close(requestPipe[1]);
+        close(responsePipe[0]);
+        runWorker(execEnv, config, core, calibrationCode, requestPipe[0], responsePipe[1]);
+    }
+
+    close(requestPipe[0]);
+    close(responsePipe[1]);
+    m_workers.push_back(Worker{
+        .pid = pid,
+        .core = core,
+        .requestFd = requestPipe[1],
+        .responseFd = responsePipe[0],
+    });
+}
+
+std::string BenchmarkWorkerPool::reapWorker(Worker& worker)
+{
+    if (worker.pid <= 0)
+    {
+        return "exited";
+    }
+    int status = 0;
+    pid_t result;
+    do
+    {
+        result = waitpid(worker.pid, &status, 0);
+    } while (result < 0 && errno == EINTR);
+    worker.pid = 0;
+    if (result < 0)
+    {
+        return "exited";
+    }
+    if (WIFSIGNALED(status))
+    {
+        return "was killed by signal " + std::to_string(WTERMSIG(status));
+    }
+    return "exited with code " + std::to_string(WEXITSTATUS(status));
+}
+
+void BenchmarkWorkerPool::stopWorkers()
+{
+    for (auto& worker : m_workers)
+    {
+        try
+        {
+            MessageWriter request;
+            request.write(Request::Shutdown);
+            request.send(worker.requestFd);
+        }
+        catch (std::exception const&)
+        {
+            // the worker already exited
+            reapWorker(worker);
+        }
+        close(worker.requestFd);
+        close(worker.responseFd);
+    }
+    for (auto& worker : m_workers)
+    {
+        reapWorker(worker);
+    }
+    m_workers.clear();
+}
+
+MessageReader BenchmarkWorkerPool::receive(Worker& worker, const std::string& failure)
+{
+    try
+    {
+        return MessageReader::receive(worker.responseFd);
+    }
+    catch (std::exception const& e)
+    {
+        m_broken = true;
+        throw std::runtime_error("benchmark worker on core " + std::to_string(worker.core) +
+                                 " " + failure + ": " + e.what() + ", it " +
+                                 reapWorker(worker));
+    }
+}
+
+void BenchmarkWorkerPool::updateCalibrations(const std::vector<double>& calibrationTimes)
+{
+    auto medianTime = math::constMedian(calibrationTimes.begin(), calibrationTimes.end());
+    for (size_t i = 0; i < calibrationTimes.size(); i++)
+    {
+        auto& calibration = m_calibrations[i];
+        calibration.lastTime = calibrationTimes[i];
+        calibration.drift = calibration.lastTime / calibration.initialTime - 1;
+        calibration.skew = calibration.lastTime / medianTime - 1;
+    }
+}
+
+BenchmarkStats BenchmarkWorkerPool::benchmarkCodes(const std::vector<bytes>& codes)
+{
+    if (codes.empty())
+    {
+        throw std::invalid_argument("no code to benchmark");
+    }
+    if (m_broken)
+    {
+        throw std::runtime_error("benchmark worker pool lost a worker, it cannot be used anymore");
+    }
+
+    auto workersCount = std::min(m_workers.size(), codes.size());
+    std::vector<size_t> chunkStarts;
+    for (size_t i = 0; i <= workersCount; i++)
+    {
+        chunkStarts.push_back(i * codes.size() / workersCount);
+    }
+
+    // send all the requests first so that the workers run concurrently
+    std::string error;
+    size_t sentCount = 0;
+    for (; sentCount < workersCount; sentCount++)
+    {
+        auto& worker = m_workers[sentCount];
+        MessageWriter request;
+        request.write(Request::Benchmark);
+        request.write<uint64_t>(chunkStarts[sentCount + 1] - chunkStarts[sentCount]);
+        for (size_t j = chunkStarts[sentCount]; j < chunkStarts[sentCount + 1]; j++)
+        {
+            request.writeBytes(codes[j]);
+        }
+        try
+        {
+            request.send(worker.requestFd);
+        }
+        catch (std::exception const& e)
+        {
+            m_broken = true;
+            error = "benchmark worker on core " + std::to_string(worker.core) + " " +
+                    reapWorker(worker) + ": " + e.what();
+            break;
+        }
+    }
+
+    std::vector<double> blockExecutionTimes;
+    std::vector<ExecutionAggregatedStats> programStats;
+    std::vector<double> calibrationTimes;
+    for (auto& calibration : m_calibrations)
+    {
+        calibrationTimes.push_back(calibration.lastTime);
+    }
+
+    // read the responses in order so that results are merged back in the order of `codes`,
+    // the responses of all the requests sent are read even after a failure so that the
+    // workers still alive are ready for the next batch
+    for (size_t i = 0; i < sentCount; i++)
+    {
+        try
+        {
+            auto response = receive(m_workers[i], "failed");
+            if (response.read<Response>() == Response::Error)
+            {
+                throw std::runtime_error("benchmark worker on core " +
+                                         std::to_string(m_workers[i].core) +
+                                         " failed: " + response.readString());
+            }
+
+            calibrationTimes[i] = response.read<double>();
+            auto workerBlockTimes = response.readDoubles();
+            blockExecutionTimes.resize(workerBlockTimes.size(), 0.0);
+            for (size_t j = 0; j < workerBlockTimes.size(); j++)
+            {
+                blockExecutionTimes[j] += workerBlockTimes[j];
+            }
+            for (size_t j = chunkStarts[i]; j < chunkStarts[i + 1]; j++)
+            {
+                programStats.push_back(readExecutionStats(response));
+            }
+        }
+        catch (std::exception const& e)
+        {
+            if (error.empty())
+            {
+                error = e.what();
+            }
+        }
+    }
+
+    if (!error.empty())
+    {
+        throw std::runtime_error(error);
+    }
+
+    updateCalibrations(calibrationTimes);
+
+    auto stats = aggregateBenchmarkStats(blockExecutionTimes, programStats);
+    stats.workerCalibrations = m_calibrations;
+    return stats;
+}
+
+}  // namespace eth
+}  // namespace dev
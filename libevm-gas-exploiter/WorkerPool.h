@@ -0,0 +1,70 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <vector>
+
+#include "Benchmarker.h"
+#include "ExecutionEnv.h"
+#include "Message.h"
+
+namespace dev
+{
+namespace eth
+{
+
+/// BenchmarkWorkerPool spreads the evaluation of a set of programs over
+/// a pool of worker processes, each of them pinned to its own core.
+/// Workers are forked when the pool is created, so that each of them
+/// owns a private copy of the execution environment (block, state and chain).
+/// The programs are split in contiguous chunks, one per worker, and each
+/// worker benchmarks its chunk with `benchmarkCodes`, so that a chunk
+/// is measured exactly as a block would be on the single-core path.
+///
+/// Before each batch, every worker measures a fixed calibration program
+/// which allows to detect drifting cores (e.g. frequency scaling or noisy neighbours)
+class BenchmarkWorkerPool
+{
+public:
+    BenchmarkWorkerPool(const ExecutionEnv& execEnv, const BenchmarkConfig& config,
+        const std::vector<unsigned>& cores, const bytes& calibrationCode);
+    ~BenchmarkWorkerPool();
+
+    BenchmarkWorkerPool(const BenchmarkWorkerPool&) = delete;
+    BenchmarkWorkerPool& operator=(const BenchmarkWorkerPool&) = delete;
+
+    /// Benchmarks all the codes and merges back the results in the order of `codes`.
+    /// Throws if a worker fails, once the responses of the other workers are read. The pool
+    /// cannot be used anymore if a worker died, its next batches throw
+    BenchmarkStats benchmarkCodes(const std::vector<bytes>& codes);
+
+    size_t size() const { return m_workers.size(); }
+    /// Whether a worker died, the pool does not restart it
+    bool broken() const { return m_broken; }
+    const std::vector<WorkerCalibration>& calibrations() const { return m_calibrations; }
+
+private:
+    struct Worker
+    {
+        pid_t pid;
+        unsigned core;
+        int requestFd;
+        int responseFd;
+    };
+
+    std::vector<Worker> m_workers;
+    std::vector<WorkerCalibration> m_calibrations;
+    bool m_broken = false;
+
+    void startWorker(const ExecutionEnv& execEnv, const BenchmarkConfig& config, unsigned core,
+        const bytes& calibrationCode);
+    void stopWorkers();
+    /// Waits for the exit of a worker and describes how it exited
+    std::string reapWorker(Worker& worker);
+    /// Receives the next response of a worker, reaping it and marking the pool broken if it died
+    MessageReader receive(Worker& worker, const std::string& failure);
+    void updateCalibrations(const std::vector<double>& calibrationTimes);
+};
+
+}  // namespace eth
+}  // namespace dev
@@ -17,12 +17,29 @@
 
 #include "ExtVMFace.h"
 
+#include <libdevcore/ExecutionArena.h>
+
 #include <evmc/helpers.h>
 
 namespace dev
 {
 namespace eth
 {
+namespace
+{
+/// Destroys the vector of bytes placed in the optional storage of @a _result, giving its buffer,
+/// usually the memory of the callee, back to the arena of the thread.
+void releaseOutput(evmc_result const* _result)
+{
+    auto* data = evmc_get_optional_storage(const_cast<evmc_result*>(_result));
+    auto& output = reinterpret_cast<bytes&>(*data);
+    ExecutionArena::threadArena().releaseMemory(std::move(output));
+    // Explicitly call vector's destructor to release its data.
+    // This is normal pattern when placement new operator is used.
+    output.~bytes();
+}
+}  // namespace
+
 static_assert(sizeof(Address) == sizeof(evmc_address), "Address types size mismatch");
 static_assert(alignof(Address) == alignof(evmc_address), "Address types alignment mismatch");
 static_assert(sizeof(h256) == sizeof(evmc_uint256be), "Hash types size mismatch");
@@ -188,13 +205,7 @@ evmc::result EvmCHost::create(evmc_message const& _msg) noexcept
         static_assert(sizeof(bytes) <= sizeof(*data), "Vector is too big");
         new (data) bytes(result.output.takeBytes());
         // Set the destructor to delete the vector.
-        evmcResult.release = [](evmc_result const* _result) {
-            auto* data = evmc_get_const_optional_storage(_result);
-            auto& output = reinterpret_cast<bytes const&>(*data);
-            // Explicitly call vector's destructor to release its data.
-            // This is normal pattern when placement new operator is used.
-            output.~bytes();
-        };
+        evmcResult.release = releaseOutput;
     }
     return evmc::result{evmcResult};
 }
@@ -236,13 +247,7 @@ evmc::result EvmCHost::call(evmc_message const& _msg) noexcept
     static_assert(sizeof(bytes) <= sizeof(*data), "Vector is too big");
     new (data) bytes(result.output.takeBytes());
     // Set the destructor to delete the vector.
-    evmcResult.release = [](evmc_result const* _result) {
-        auto* data = evmc_get_const_optional_storage(_result);
-        auto& output = reinterpret_cast<bytes const&>(*data);
-        // Explicitly call vector's destructor to release its data.
-        // This is normal pattern when placement new operator is used.
-        output.~bytes();
-    };
+    evmcResult.release = releaseOutput;
     return evmc::result{evmcResult};
 }
 
@@ -21,6 +21,13 @@ using namespace std;
 using namespace dev;
 using namespace dev::eth;
 
+LegacyVM::~LegacyVM()
+{
+    assert(&m_arena == &ExecutionArena::threadArena() && "destroyed on another thread");
+    m_arena.releaseMemory(std::move(m_mem));
+    m_arena.releaseStack(m_stack);
+}
+
 uint64_t LegacyVM::memNeed(u256 const& _offset, u256 const& _size)
 {
     return toInt63(_size ? u512(_offset) + _size : u512(0));
@@ -201,7 +208,7 @@ void LegacyVM::updateMem(uint64_t _newMem)
     m_newMemSize = (_newMem + 31) / 32 * 32;
     updateGas();
     if (m_newMemSize > m_mem.size())
-        m_mem.resize(m_newMemSize);
+        m_arena.growMemory(m_mem, m_newMemSize);
 }
 
 void LegacyVM::logGasMem()
@@ -247,6 +254,11 @@ owning_bytes_ref LegacyVM::exec(u256& _io_gas, ExtVMFace& _ext, OnOpFunc const&
     m_onFail = &LegacyVM::onOperation; // this results in operations that fail being logged twice in the trace
     m_PC = 0;
 
+    // clear what a previous execution left, so that an instance can be reused
+    m_SP = m_stackEnd;
+    m_mem.clear();
+    m_returnData.clear();
+
     try
     {
         // trampoline to minimize depth of call stack when calling out
@@ -325,6 +337,7 @@ void LegacyVM::interpretCases()
 
             uint64_t b = (uint64_t)m_SP[0];
             uint64_t s = (uint64_t)m_SP[1];
+            // the memory goes back to the arena once the caller consumed the output
             m_output = owning_bytes_ref{std::move(m_mem), b, s};
             m_bounce = 0;
         }
@@ -343,7 +356,7 @@ void LegacyVM::interpretCases()
 
             uint64_t b = (uint64_t)m_SP[0];
             uint64_t s = (uint64_t)m_SP[1];
-            owning_bytes_ref output{move(m_mem), b, s};
+            owning_bytes_ref output{std::move(m_mem), b, s};
             throwRevertInstruction(move(output));
         }
         BREAK;
@@ -777,7 +790,7 @@ void LegacyVM::interpretCases()
             ON_OP();
             updateIOGas();
 
-            m_PC = decodeJumpDest(m_code.data(), m_PC);
+            m_PC = decodeJumpDest(m_code, m_PC);
         }
         CONTINUE
 
@@ -787,7 +800,7 @@ void LegacyVM::interpretCases()
             updateIOGas();
 
             if (m_SP[0])
-                m_PC = decodeJumpDest(m_code.data(), m_PC);
+                m_PC = decodeJumpDest(m_code, m_PC);
             else
                 ++m_PC;
         }
@@ -797,7 +810,7 @@ void LegacyVM::interpretCases()
         {
             ON_OP();
             updateIOGas();
-            m_PC = decodeJumpvDest(m_code.data(), m_PC, byte(m_SP[0]));
+            m_PC = decodeJumpvDest(m_code, m_PC, byte(m_SP[0]));
         }
         CONTINUE
 
@@ -806,7 +819,7 @@ void LegacyVM::interpretCases()
             ON_OP();
             updateIOGas();
             *m_RP++ = m_PC++;
-            m_PC = decodeJumpDest(m_code.data(), m_PC);
+            m_PC = decodeJumpDest(m_code, m_PC);
         }
         CONTINUE
 
@@ -815,7 +828,7 @@ void LegacyVM::interpretCases()
             ON_OP();
             updateIOGas();
             *m_RP++ = m_PC;
-            m_PC = decodeJumpvDest(m_code.data(), m_PC, byte(m_SP[0]));
+            m_PC = decodeJumpvDest(m_code, m_PC, byte(m_SP[0]));
         }
         CONTINUE
 
@@ -1484,7 +1497,7 @@ void LegacyVM::interpretCases()
             off = m_code[m_PC++] << 8;
             off |= m_code[m_PC++];
             m_PC += m_code[m_PC];
-            m_SPP[0] = m_pool[off];
+            m_SPP[0] = m_analysis->pool[off];
             TRACE_VAL(2, "Retrieved pooled const", m_SPP[0]);
 #else
             throwBadInstruction();
@@ -1703,7 +1716,7 @@ void LegacyVM::interpretCases()
 
         CASE(JUMPDEST)
         {
-            m_runGas = 1;
+            m_runGas = toInt63(m_schedule->jumpdestGas);
             ON_OP();
             updateIOGas();
         }
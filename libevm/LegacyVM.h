@@ -19,6 +19,9 @@
 
 #include <map>
 
+#include <libdevcore/CodeAnalysisCache.h>
+#include <libdevcore/ExecutionArena.h>
+
 #include "Instruction.h"
 #include "LegacyVMConfig.h"
 #include "VMFace.h"
@@ -31,12 +34,17 @@ namespace eth
 class LegacyVM: public VMFace
 {
 public:
+    ~LegacyVM();
+
     virtual owning_bytes_ref exec(u256& _io_gas, ExtVMFace& _ext, OnOpFunc const& _onOp) override final;
 #ifdef ETH_MEASURE_GAS
     virtual owning_bytes_ref exec(u256& _io_gas, ExtVMFace& _ext, OnOpFunc const& _onOp,
         OnOpFunc const& _afterOp) override final;
 #endif
 
+    /// Analyses of the codes executed by the legacy VMs of the process
+    static CodeAnalysisCache& analysisCache();
+
 #if EIP_615
     // invalid code will throw an exeption
     void validate(ExtVMFace& _ext);
@@ -60,7 +68,7 @@ private:
     static std::array<InstructionMetric, 256> c_metrics;
     static void initMetrics();
     static u256 exp256(u256 _base, u256 _exponent);
-    void copyCode(int);
+    void copyCode(bytes& _code, int _extraBytes);
     typedef void (LegacyVM::*MemFnPtr)();
     MemFnPtr m_bounce = 0;
     MemFnPtr m_onFail = 0;
@@ -70,18 +78,23 @@ private:
     // return bytes
     owning_bytes_ref m_output;
 
+    // arena of the constructing thread, giving the memory and the stack of the frame, which
+    // must be destroyed on that thread
+    ExecutionArena& m_arena = ExecutionArena::threadArena();
+
     // space for memory
-    bytes m_mem;
+    bytes m_mem = m_arena.acquireMemory();
 
-    // space for code
-    bytes m_code;
+    // analysis shared with the other executions of the code, and its code
+    std::shared_ptr<CodeAnalysis const> m_analysis;
+    byte const* m_code = nullptr;
 
     /// RETURNDATA buffer for memory returned from direct subcalls.
     bytes m_returnData;
 
     // space for data stack, grows towards smaller addresses from the end
-    u256 m_stack[1024];
-    u256 *m_stackEnd = &m_stack[1024];
+    u256* m_stack = m_arena.acquireStack();
+    u256* m_stackEnd = m_stack + ExecutionArena::c_stackSize;
     size_t stackSize() { return m_stackEnd - m_SP; }
     
 #if EIP_615
@@ -92,9 +105,6 @@ private:
     std::vector<size_t> m_frameSize;
 #endif
 
-    // constant pool
-    std::vector<u256> m_pool;
-
     // interpreter state
     Instruction m_OP;                   // current operation
     uint64_t    m_PC    = 0;            // program counter
@@ -132,8 +142,6 @@ private:
     void throwDisallowedStateChange();
     void throwBufferOverrun(bigint const& _enfOfAccess);
 
-    std::vector<uint64_t> m_beginSubs;
-    std::vector<uint64_t> m_jumpDests;
     int64_t verifyJumpDest(u256 const& _dest, bool _throw = true);
 
     void onOperation();
@@ -102,7 +102,7 @@ int64_t LegacyVM::verifyJumpDest(u256 const& _dest, bool _throw)
         // check for within bounds and to a jump destination
         // use binary search of array because hashtable collisions are exploitable
         uint64_t pc = uint64_t(_dest);
-        if (std::binary_search(m_jumpDests.begin(), m_jumpDests.end(), pc))
+        if (std::binary_search(m_analysis->jumpDests.begin(), m_analysis->jumpDests.end(), pc))
             return pc;
     }
     if (_throw)
@@ -156,6 +156,7 @@ void LegacyVM::caseCreate()
         CreateResult result = m_ext->create(endowment, gas, initCode, m_OP, salt, m_onOp);
         m_SPP[0] = (u160)result.address;  // Convert address to integer.
         m_returnData = result.output.toBytes();
+        m_arena.releaseMemory(result.output.takeBytes());
 
         *m_io_gas_p -= (createGas - gas);
         m_io_gas = uint64_t(*m_io_gas_p);
@@ -189,6 +190,8 @@ void LegacyVM::caseCall()
         //    minimal memory footprint, additional memory copy.
         // Option 2 used:
         m_returnData = result.output.toBytes();
+        // the buffer of the output, usually the memory of the callee, goes back to the arena
+        m_arena.releaseMemory(result.output.takeBytes());
 
         m_SPP[0] = result.status == EVMC_SUCCESS ? 1 : 0;
     }
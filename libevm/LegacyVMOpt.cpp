@@ -39,20 +39,45 @@ void LegacyVM::initMetrics()
 	(void)done;
 }
 
-void LegacyVM::copyCode(int _extraBytes)
+void LegacyVM::copyCode(bytes& _code, int _extraBytes)
 {
 	// Copy code so that it can be safely modified and extend code by
 	// _extraBytes zero bytes to allow reading virtual data at the end
 	// of the code without bounds checks.
 	auto extendedSize = m_ext->code.size() + _extraBytes;
-	m_code.reserve(extendedSize);
-	m_code = m_ext->code;
-	m_code.resize(extendedSize);
+	_code.reserve(extendedSize);
+	_code = m_ext->code;
+	_code.resize(extendedSize);
+}
+
+CodeAnalysisCache& LegacyVM::analysisCache()
+{
+	static CodeAnalysisCache s_cache;
+	return s_cache;
 }
 
 void LegacyVM::optimize()
 {
-	copyCode(33);
+	// the code hash is left empty by the callers not knowing it, the size guards against
+	// a hash which would not be the one of the code
+	h256 const& codeHash = m_ext->codeHash;
+	bool const cacheable = codeHash != h256();
+	if (cacheable)
+	{
+		m_analysis = analysisCache().find(codeHash);
+		if (m_analysis && m_analysis->codeSize == m_ext->code.size())
+		{
+			m_code = m_analysis->code.data();
+			return;
+		}
+	}
+
+	auto analysis = std::make_shared<CodeAnalysis>();
+	bytes& code = analysis->code;
+	copyCode(code, 33);
+	analysis->codeSize = m_ext->code.size();
+	// verifyJumpDest reads the table being built
+	m_analysis = analysis;
 
 	size_t const nBytes = m_ext->code.size();
 
@@ -61,7 +86,7 @@ void LegacyVM::optimize()
 	TRACE_STR(1, "Build JUMPDEST table")
 	for (size_t pc = 0; pc < nBytes; ++pc)
 	{
-		Instruction op = Instruction(m_code[pc]);
+		Instruction op = Instruction(code[pc]);
 		TRACE_OP(2, pc, op);
 				
 		// make synthetic ops in user code trigger invalid instruction if run
@@ -72,12 +97,12 @@ void LegacyVM::optimize()
 		)
 		{
 			TRACE_OP(1, pc, op);
-			m_code[pc] = (byte)Instruction::INVALID;
+			code[pc] = (byte)Instruction::INVALID;
 		}
 
 		if (op == Instruction::JUMPDEST)
 		{
-			m_jumpDests.push_back(pc);
+			analysis->jumpDests.push_back(pc);
 		}
 		else if (
 			(byte)Instruction::PUSH1 <= (byte)op &&
@@ -98,11 +123,11 @@ void LegacyVM::optimize()
 		else if (op == Instruction::JUMPV || op == Instruction::JUMPSUBV)
 		{
 			++pc;
-			pc += 4 * m_code[pc];  // number of 4-byte dests followed by table
+			pc += 4 * code[pc];  // number of 4-byte dests followed by table
 		}
 		else if (op == Instruction::BEGINSUB)
 		{
-			m_beginSubs.push_back(pc);
+			analysis->beginSubs.push_back(pc);
 		}
 		else if (op == Instruction::BEGINDATA)
 		{
@@ -117,16 +142,16 @@ void LegacyVM::optimize()
 	for (size_t pc = 0; pc < nBytes; ++pc)
 	{
 		u256 val = 0;
-		Instruction op = Instruction(m_code[pc]);
+		Instruction op = Instruction(code[pc]);
 
 		if ((byte)Instruction::PUSH1 <= (byte)op && (byte)op <= (byte)Instruction::PUSH32)
 		{
 			byte nPush = (byte)op - (byte)Instruction::PUSH1 + 1;
 
 			// decode pushed bytes to integral value
-			val = m_code[pc+1];
+			val = code[pc+1];
 			for (uint64_t i = pc+2, n = nPush; --n; ++i) {
-				val = (val << 8) | m_code[i];
+				val = (val << 8) | code[i];
 			}
 
 		#if EVM_USE_CONSTANT_POOL
@@ -136,16 +161,16 @@ void LegacyVM::optimize()
 			// followed by one byte count of remaining pushed bytes
 			if (5 < nPush)
 			{
-				uint16_t pool_off = m_pool.size();
+				uint16_t pool_off = analysis->pool.size();
 				TRACE_VAL(1, "stash", val);
 				TRACE_VAL(1, "... in pool at offset" , pool_off);
-				m_pool.push_back(val);
+				analysis->pool.push_back(val);
 
 				TRACE_PRE_OPT(1, pc, op);
-				m_code[pc] = byte(op = Instruction::PUSHC);
-				m_code[pc+3] = nPush - 2;
-				m_code[pc+2] = pool_off & 0xff;
-				m_code[pc+1] = pool_off >> 8;
+				code[pc] = byte(op = Instruction::PUSHC);
+				code[pc+3] = nPush - 2;
+				code[pc+2] = pool_off & 0xff;
+				code[pc+1] = pool_off >> 8;
 				TRACE_POST_OPT(1, pc, op);
 			}
 
@@ -157,14 +182,14 @@ void LegacyVM::optimize()
 			// outer loop is N = number of bytes in code array
 			// so complexity is N log M, worst case is N log N
 			size_t i = pc + nPush + 1;
-			op = Instruction(m_code[i]);
+			op = Instruction(code[i]);
 			if (op == Instruction::JUMP)
 			{
 				TRACE_VAL(1, "Replace const JUMP with JUMPC to", val)
 				TRACE_PRE_OPT(1, i, op);
 				
 				if (0 <= verifyJumpDest(val, false))
-					m_code[i] = byte(op = Instruction::JUMPC);
+					code[i] = byte(op = Instruction::JUMPC);
 				
 				TRACE_POST_OPT(1, i, op);
 			}
@@ -174,7 +199,7 @@ void LegacyVM::optimize()
 				TRACE_PRE_OPT(1, i, op);
 				
 				if (0 <= verifyJumpDest(val, false))
-					m_code[i] = byte(op = Instruction::JUMPCI);
+					code[i] = byte(op = Instruction::JUMPCI);
 				
 				TRACE_POST_OPT(1, i, op);
 			}
@@ -185,6 +210,10 @@ void LegacyVM::optimize()
 	}
 	TRACE_STR(1, "Finished optimizations")
 #endif	
+
+	m_code = code.data();
+	if (cacheable)
+		analysisCache().insert(codeHash, m_analysis);
 }
 
 
@@ -33,6 +33,9 @@ namespace
 {
 auto g_kind = VMKind::Legacy;
 
+/// The name the global kind was selected with.
+std::string g_name = "legacy";
+
 /// The pointer to EVMC create function in DLL EVMC VM.
 ///
 /// This variable is only written once when processing command line arguments,
@@ -58,26 +61,11 @@ VMKindTableEntry vmKindsTable[] = {
     {VMKind::Legacy, "legacy"},
 };
 
-void setVMKind(const std::string& _name)
+/// Loads the EVMC VM of the shared library at _path.
+std::unique_ptr<EVMC> loadEVMC(const std::string& _path)
 {
-    for (auto& entry : vmKindsTable)
-    {
-        // Try to find a match in the table of VMs.
-        if (_name == entry.name)
-        {
-            g_kind = entry.kind;
-            return;
-        }
-    }
-
-    // If no match for predefined VM names, try loading it as an EVMC VM DLL.
-    g_kind = VMKind::DLL;
-
-    // Release previous instance
-    g_evmcDll.reset();
-
     evmc_loader_error_code ec;
-    evmc_instance *instance = evmc_load_and_create(_name.c_str(), &ec);
+    evmc_instance *instance = evmc_load_and_create(_path.c_str(), &ec);
     assert(ec == EVMC_LOADER_SUCCESS || instance == nullptr);
 
     switch (ec)
@@ -86,20 +74,51 @@ void setVMKind(const std::string& _name)
         break;
     case EVMC_LOADER_CANNOT_OPEN:
         BOOST_THROW_EXCEPTION(
-            po::validation_error(po::validation_error::invalid_option_value, "vm", _name, 1));
+            po::validation_error(po::validation_error::invalid_option_value, "vm", _path, 1));
     case EVMC_LOADER_SYMBOL_NOT_FOUND:
         BOOST_THROW_EXCEPTION(std::system_error(std::make_error_code(std::errc::invalid_seek),
-            "loading " + _name + " failed: EVMC create function not found"));
+            "loading " + _path + " failed: EVMC create function not found"));
     case EVMC_LOADER_ABI_VERSION_MISMATCH:
         BOOST_THROW_EXCEPTION(std::system_error(std::make_error_code(std::errc::invalid_argument),
-            "loading " + _name + " failed: EVMC ABI version mismatch"));
+            "loading " + _path + " failed: EVMC ABI version mismatch"));
     default:
         BOOST_THROW_EXCEPTION(
             std::system_error(std::error_code(static_cast<int>(ec), std::generic_category()),
-                "loading " + _name + " failed"));
+                "loading " + _path + " failed"));
     }
 
-    g_evmcDll.reset(new EVMC{instance});
+    return std::unique_ptr<EVMC>(new EVMC{instance});
+}
+
+/// Sets the capacity of the code analysis caches of the legacy VM and of the interpreter.
+void setAnalysisCacheSize(size_t _size)
+{
+    LegacyVM::analysisCache().setCapacity(_size);
+    auto interpreter = evmc_create_interpreter();
+    interpreter->set_option(interpreter, "analysis-cache-size", std::to_string(_size).c_str());
+}
+
+void setVMKind(const std::string& _name)
+{
+    g_name = _name;
+
+    for (auto& entry : vmKindsTable)
+    {
+        // Try to find a match in the table of VMs.
+        if (_name == entry.name)
+        {
+            g_kind = entry.kind;
+            return;
+        }
+    }
+
+    // If no match for predefined VM names, try loading it as an EVMC VM DLL.
+    g_kind = VMKind::DLL;
+
+    // Release previous instance
+    g_evmcDll.reset();
+
+    g_evmcDll = loadEVMC(_name);
 
     cnote << "Loaded EVMC module: " << g_evmcDll->name() << " " << g_evmcDll->version() << " ("
           << _name << ")";
@@ -170,6 +189,11 @@ po::options_description vmProgramOptions(unsigned _lineLength)
             ->notifier(parseEvmcOptions),
         "EVMC option\n");
 
+    add("vm-analysis-cache-size",
+        po::value<size_t>()->value_name("<bytes>")->notifier(setAnalysisCacheSize),
+        "Maximum size of the analyses of the codes kept by the legacy VM and by the interpreter "
+        "between executions, 0 to disable (default: 64 MiB each)\n");
+
     return opts;
 }
 
@@ -179,6 +203,23 @@ VMPtr VMFactory::create()
     return create(g_kind);
 }
 
+std::string const& VMFactory::name()
+{
+    return g_name;
+}
+
+VMPtr VMFactory::create(std::string const& _name)
+{
+    static const auto default_delete = [](VMFace * _vm) noexcept { delete _vm; };
+
+    for (auto& entry : vmKindsTable)
+    {
+        if (_name == entry.name)
+            return create(entry.kind);
+    }
+    return {loadEVMC(_name).release(), default_delete};
+}
+
 VMPtr VMFactory::create(VMKind _kind)
 {
     static const auto default_delete = [](VMFace * _vm) noexcept { delete _vm; };
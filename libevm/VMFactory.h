@@ -54,6 +54,13 @@ public:
 
     /// Creates a VM instance of the kind provided.
     static VMPtr create(VMKind _kind);
+
+    /// Creates a VM instance by name, as accepted by the --vm option: "legacy", "interpreter"
+    /// or the path of an EVMC VM shared library, which is loaded in a new instance.
+    static VMPtr create(std::string const& _name);
+
+    /// The name of the global kind, as given to the --vm option ("legacy" by default).
+    static std::string const& name();
 };
 }  // namespace eth
 }  // namespace dev
@@ -1,13 +1,102 @@
 #include "AnalysisEnv.h"
 
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <memory>
+
+#include <libdevcore/Log.h>
+
+#include "StreamWrapper.h"
+
 namespace dev
 {
 namespace eth
 {
+AnalysisEnv::~AnalysisEnv()
+{
+    if (m_statWriter)
+    {
+        m_statWriter->drain();
+        auto counters = m_statWriter->counters();
+        cnote << "Measurements writer: " << counters.written << " written, " << counters.dropped
+              << " dropped, " << counters.blocked << " blocked pushes ("
+              << counters.blockedTime << "s)";
+    }
+}
+
+namespace
+{
+/// Copy of the measurements output with an instructions benchmark, taken on the importing
+/// thread and serialised by the writer thread
+struct InstructionsBenchmarkSnapshot
+{
+    int64_t blockNumber = 0;
+    bool full = false;
+    std::map<ExtendedInstruction, InstructionTimings> timings;
+    size_t threadsCount = 0;
+    InstructionSampling sampling;
+    bool storageAccessTracking = false;
+    StorageAccessStats storageAccesses;
+    bool hasWriterCounters = false;
+    AsyncStatWriter::Counters writerCounters;
+
+    Json::Value toJson() const
+    {
+        auto root = InstructionsBenchmark::toJson(timings, threadsCount, full);
+        root["block_number"] = blockNumber;
+        root["sampling"]["interval"] = static_cast<Json::UInt64>(sampling.interval);
+        root["sampling"]["randomized"] = sampling.randomized;
+        root["sampling"]["probe_overhead_cycles"] = sampling.probeOverheadCycles;
+        root["sampling"]["nanoseconds_per_cycle"] = CycleClock::nanosecondsPerCycle();
+        if (storageAccessTracking)
+            root["storage_accesses"] = storageAccesses.toJson();
+        if (hasWriterCounters)
+            root["stat_writer"] = writerCounters.toJson();
+        return root;
+    }
+};
+}  // namespace
+
 void AnalysisEnv::outputInstructionsBenchmark(int64_t blockNumber, bool full)
 {
-    auto root = m_instructionsBenchmark.toJson(full);
-    root["block_number"] = blockNumber;
+    // the benchmark keeps changing: its merged timings are copied, the serialisation is
+    // deferred to the writer thread
+    auto snapshot = std::make_shared<InstructionsBenchmarkSnapshot>();
+    snapshot->blockNumber = blockNumber;
+    snapshot->full = full;
+    snapshot->timings = m_instructionsBenchmark.timings();
+    snapshot->threadsCount = m_instructionsBenchmark.threadsCount();
+    snapshot->sampling = m_instructionSampling;
+    snapshot->storageAccessTracking = m_storageAccessTracking;
+    if (m_storageAccessTracking)
+    {
+        boost::mutex::scoped_lock scoped_lock(m_storageAccessesLock);
+        snapshot->storageAccesses = m_storageAccesses;
+    }
+    m_lastInstructionsBenchmarkCount = 0;
+    for (const auto& kv : snapshot->timings)
+        m_lastInstructionsBenchmarkCount += kv.second.count;
+    if (!m_statWriter)
+    {
+        writeInstructionsBenchmark(snapshot->toJson());
+        return;
+    }
+    snapshot->hasWriterCounters = true;
+    snapshot->writerCounters = m_statWriter->counters();
+    m_statWriter->push([this, snapshot]() { writeInstructionsBenchmark(snapshot->toJson()); });
+}
+
+void AnalysisEnv::addStorageAccesses(const StorageAccessStats& stats)
+{
+    if (stats.empty())
+        return;
+    boost::mutex::scoped_lock scoped_lock(m_storageAccessesLock);
+    m_storageAccesses.merge(stats);
+}
+
+void AnalysisEnv::writeInstructionsBenchmark(const Json::Value& root)
+{
     Json::StreamWriterBuilder builder;
     builder.settings_["indentation"] = "";
     std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
@@ -15,7 +104,168 @@ void AnalysisEnv::outputInstructionsBenchmark(int64_t blockNumber, bool full)
 
     writer->write(root, &m_benchmarkStream);
     m_benchmarkStream << std::endl;
-    m_lastInstructionsBenchmarkCount = m_instructionsBenchmark.totalCount();
+}
+
+void AnalysisEnv::outputBasicBlocks(const std::string& profilePath, const std::string& costModelPath)
+{
+    if (!m_basicBlockProfile)
+        return;
+    Json::StreamWriterBuilder builder;
+    builder.settings_["indentation"] = "";
+    std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+    if (!profilePath.empty())
+    {
+        OStreamWrapper profileStream(profilePath, std::ios_base::trunc);
+        writer->write(m_basicBlockProfile->toJson(), &profileStream.getStream());
+        profileStream.getStream() << std::endl;
+    }
+    if (!costModelPath.empty())
+    {
+        OStreamWrapper costModelStream(costModelPath, std::ios_base::trunc);
+        writer->write(m_basicBlockProfile->fitCostModel().toJson(), &costModelStream.getStream());
+        costModelStream.getStream() << std::endl;
+    }
+}
+
+void AnalysisEnv::outputHotSpots(int64_t blockNumber, bool force)
+{
+    if (!m_hotSpotProfiler)
+        return;
+    {
+        boost::mutex::scoped_lock scoped_lock(m_hotSpotsLock);
+        if (m_lastHotSpotsBlock < 0 && !force)
+            m_lastHotSpotsBlock = blockNumber;
+        if (!force && blockNumber < m_lastHotSpotsBlock + m_hotSpotsInterval)
+            return;
+        m_lastHotSpotsBlock = blockNumber;
+    }
+
+    Json::Value summary;
+    summary["block_number"] = blockNumber;
+    summary["total_time"] = static_cast<Json::UInt64>(m_hotSpotProfiler->totalTime());
+    summary["capacity"] = static_cast<Json::UInt64>(m_hotSpotProfiler->capacity());
+    summary["evictions"] = static_cast<Json::UInt64>(m_hotSpotProfiler->evictionsCount());
+    auto spots = m_hotSpotProfiler->spots();
+    if (!m_statWriter)
+    {
+        writeHotSpots(spots, summary);
+        return;
+    }
+    auto sharedSpots = std::make_shared<std::vector<HotSpot>>(std::move(spots));
+    m_statWriter->push([this, sharedSpots, summary]() { writeHotSpots(*sharedSpots, summary); });
+}
+
+void AnalysisEnv::writeHotSpots(const std::vector<HotSpot>& spots, const Json::Value& summary)
+{
+    // written next to the outputs and renamed so that readers never see a partial profile
+    boost::mutex::scoped_lock scoped_lock(m_hotSpotsLock);
+    auto temporaryPath = m_hotSpotsPath + ".tmp";
+    {
+        std::ofstream folded(temporaryPath, std::ios_base::trunc);
+        HotSpotProfiler::writeFoldedStacks(folded, spots);
+    }
+    if (std::rename(temporaryPath.c_str(), m_hotSpotsPath.c_str()) != 0)
+        cwarn << "Could not write the hot spots to " << m_hotSpotsPath;
+
+    auto root = summary;
+    root["spots"] = HotSpotProfiler::toJson(spots);
+    Json::StreamWriterBuilder builder;
+    builder.settings_["indentation"] = "";
+    std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+    {
+        std::ofstream report(temporaryPath, std::ios_base::trunc);
+        writer->write(root, &report);
+        report << std::endl;
+    }
+    if (std::rename(temporaryPath.c_str(), (m_hotSpotsPath + ".json").c_str()) != 0)
+        cwarn << "Could not write the hot spots to " << m_hotSpotsPath << ".json";
+}
+
+void AnalysisEnv::outputTransaction(TransactionMeasurement measurement)
+{
+    if (!m_statWriter)
+    {
+        writeTransaction(measurement);
+        return;
+    }
+    // std::function must be copyable
+    auto sharedMeasurement = std::make_shared<TransactionMeasurement>(std::move(measurement));
+    m_statWriter->push([this, sharedMeasurement]() { writeTransaction(*sharedMeasurement); });
+}
+
+void AnalysisEnv::writeTransaction(const TransactionMeasurement& measurement)
+{
+    boost::mutex::scoped_lock scoped_lock(m_statStreamLock);
+    if (m_columnarWriter)
+        measurement.write(*m_columnarWriter, m_transactionsTable, m_instructionCallsTable);
+    else
+        measurement.write(m_statStream);
+}
+
+void AnalysisEnv::setAsyncOutput(size_t capacity, StatQueueOverflow overflow)
+{
+    m_statWriter.reset(new AsyncStatWriter(capacity, overflow));
+}
+
+void AnalysisEnv::setColumnarOutput(std::shared_ptr<ColumnarWriter> writer)
+{
+    m_transactionsTable = writer->addTable(transactionsSchema());
+    m_instructionCallsTable = writer->addTable(instructionCallsSchema());
+    m_columnarWriter = writer;
+}
+
+TableSchema AnalysisEnv::transactionsSchema()
+{
+    return TableSchema{"transactions",
+        {
+            {"env.block", ColumnType::UInt64},
+            {"transaction.hash", ColumnType::Hash},
+            {"transaction.sender", ColumnType::Address},
+            {"transaction.receiver", ColumnType::Address},
+            {"transaction.to", ColumnType::Address},
+            {"transaction.gas", ColumnType::UInt256},
+            {"transaction.gas_price", ColumnType::UInt256},
+            {"transaction.value", ColumnType::UInt256},
+            {"transaction.gas_for_deposit", ColumnType::UInt256},
+            {"transaction.gas_refunded", ColumnType::UInt256},
+            {"transaction.gas_used", ColumnType::UInt256},
+            {"transaction.output_size", ColumnType::UInt64},
+            {"transaction.excepted", ColumnType::Int64},
+            {"usage.clock_time", ColumnType::Double},
+            {"usage.user_time", ColumnType::Double},
+            {"usage.system_time", ColumnType::Double},
+            {"usage.monotonic_time", ColumnType::Double},
+            {"usage.chrono_time", ColumnType::Double},
+            {"usage.memory_allocated", ColumnType::UInt64},
+            {"usage.extra_memory_allocated", ColumnType::Int64},
+            {"usage.arena_allocations", ColumnType::UInt64},
+            {"usage.arena_allocated_bytes", ColumnType::UInt64},
+            {"usage.arena_reuses", ColumnType::UInt64},
+            {"usage.gas/s", ColumnType::Double},
+            {"counters.cycles", ColumnType::UInt64},
+            {"counters.instructions", ColumnType::UInt64},
+            {"counters.cache_misses", ColumnType::UInt64},
+            {"counters.branch_misses", ColumnType::UInt64},
+            {"counters.tlb_misses", ColumnType::UInt64},
+            {"counters.cycles/gas", ColumnType::Double},
+            {"instructions.storage.changesCount", ColumnType::UInt64},
+            {"instructions.storage.writesCount", ColumnType::UInt64},
+            {"instructions.storage.readsCount", ColumnType::UInt64},
+            {"instructions.storage.allocated", ColumnType::UInt64},
+            {"instructions.contracts.creationCount", ColumnType::UInt64},
+            {"instructions.contracts.creationSize", ColumnType::UInt64},
+            {"instructions.suicideCount", ColumnType::UInt64},
+        }};
+}
+
+TableSchema AnalysisEnv::instructionCallsSchema()
+{
+    return TableSchema{"instruction_calls",
+        {
+            {"transaction", ColumnType::UInt64},
+            {"instruction", ColumnType::Symbol},
+            {"count", ColumnType::UInt64},
+        }};
 }
 
 
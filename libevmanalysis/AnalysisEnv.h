@@ -1,11 +1,20 @@
 #pragma once
 
 #include <iostream>
+#include <memory>
 #include <ostream>
 
 #include <boost/thread/mutex.hpp>
 
+#include "AsyncStatWriter.h"
+#include "BasicBlocks.h"
 #include "BenchmarkResults.h"
+#include "ColumnarFile.h"
+#include "HotSpots.h"
+#include "InstructionHistograms.h"
+#include "InstructionSampler.h"
+#include "StorageAccesses.h"
+#include "TransactionMeasurement.h"
 
 namespace dev
 {
@@ -23,13 +32,81 @@ public:
         m_instructionsBenchmark(instructionsBenchmark)
     {}
     AnalysisEnv(const AnalysisEnv&) = delete;
+    /// Waits for the measurements queued to the writer thread to be written
+    ~AnalysisEnv();
 
     std::ostream& statStream() { return m_statStream; }
     InstructionsBenchmark& instructionsBenchmark() { return m_instructionsBenchmark; }
     boost::mutex& statStreamLock() { return m_statStreamLock; }
     int64_t benchmarkInteval() const { return m_benchmarkInterval; }
+    bool hardwareCounters() const { return m_hardwareCounters; }
+    /// The counters are opened by the executing threads, check that they are available with
+    /// `HardwareCounterCollector::checkAvailable` before enabling them
+    void setHardwareCounters(bool hardwareCounters) { m_hardwareCounters = hardwareCounters; }
+    /// Instructions timed by the benchmark and correction of their measurements
+    const InstructionSampling& instructionSampling() const { return m_instructionSampling; }
+    void setInstructionSampling(const InstructionSampling& sampling)
+    {
+        m_instructionSampling = sampling;
+    }
     void outputInstructionsBenchmark(int64_t blockNumber, bool full = false);
 
+    /// Whether the state accesses of the instructions are classified and timed, their totals
+    /// are added to the benchmark outputs
+    bool storageAccessTracking() const { return m_storageAccessTracking; }
+    void setStorageAccessTracking(bool tracking) { m_storageAccessTracking = tracking; }
+    void addStorageAccesses(const StorageAccessStats& stats);
+
+    /// Times basic blocks instead of single instructions, see `BasicBlockProfile`
+    void setBasicBlockProfile(std::shared_ptr<BasicBlockProfile> profile)
+    {
+        m_basicBlockProfile = profile;
+    }
+    /// Null when the instructions are timed
+    BasicBlockProfile* basicBlockProfile() { return m_basicBlockProfile.get(); }
+    /// Writes the durations of the basic blocks to `profilePath` and the instruction costs
+    /// fitted from them to `costModelPath`, empty paths are skipped
+    void outputBasicBlocks(const std::string& profilePath, const std::string& costModelPath);
+
+    /// Profiles the code locations executed by the transactions, see `HotSpotProfiler`
+    void setHotSpotProfiler(
+        std::shared_ptr<HotSpotProfiler> profiler, const std::string& path, int64_t blocksInterval)
+    {
+        m_hotSpotProfiler = profiler;
+        m_hotSpotsPath = path;
+        m_hotSpotsInterval = blocksInterval;
+    }
+    /// Null when the code locations are not profiled
+    HotSpotProfiler* hotSpotProfiler() { return m_hotSpotProfiler.get(); }
+    /// Replaces the hot spots outputs, the folded stacks at the profile path and the most
+    /// expensive locations at `<path>.json`, if the profile was last written at least
+    /// `blocksInterval` blocks before `blockNumber` or if `force` is set
+    void outputHotSpots(int64_t blockNumber, bool force = false);
+
+    /// Writes the measurements of a transaction to the stat stream or to the columnar output
+    void outputTransaction(TransactionMeasurement measurement);
+
+    /// Moves the writes of the transactions measurements and of the instructions benchmarks
+    /// to a writer thread fed by a queue of `capacity` entries. The counters of the queue are
+    /// added to the benchmark outputs
+    void setAsyncOutput(size_t capacity, StatQueueOverflow overflow);
+    /// Writer thread of the outputs, null when they are written synchronously
+    AsyncStatWriter* statWriter() { return m_statWriter.get(); }
+
+    /// Writes the transactions measurements to `writer` instead of the stat stream,
+    /// the transactions and instruction calls tables are declared if needed
+    void setColumnarOutput(std::shared_ptr<ColumnarWriter> writer);
+    /// Columnar output of the transactions measurements, null when they are written as JSON
+    ColumnarWriter* columnarWriter() { return m_columnarWriter.get(); }
+    uint16_t transactionsTable() const { return m_transactionsTable; }
+    uint16_t instructionCallsTable() const { return m_instructionCallsTable; }
+
+    /// One row per transaction, with the fields of its JSON output flattened
+    static TableSchema transactionsSchema();
+    /// One row per instruction executed by a transaction (`transaction` is the index of its row
+    /// in the transactions table) with the number of calls
+    static TableSchema instructionCallsSchema();
+
 private:
     std::ostream& m_statStream = std::cout;
     std::ostream& m_benchmarkStream = std::cout;
@@ -38,10 +115,38 @@ private:
 
     uint64_t m_lastInstructionsBenchmarkCount = 0;
 
+    /// whether transactions executions also output hardware counters
+    bool m_hardwareCounters = false;
+
+    bool m_storageAccessTracking = false;
+    StorageAccessStats m_storageAccesses;
+
+    InstructionSampling m_instructionSampling;
+    std::shared_ptr<BasicBlockProfile> m_basicBlockProfile;
+
     InstructionsBenchmark& m_instructionsBenchmark;
 
+    std::shared_ptr<HotSpotProfiler> m_hotSpotProfiler;
+    std::string m_hotSpotsPath;
+    int64_t m_hotSpotsInterval = 1000;
+    /// block of the last hot spots output, -1 before the first transaction
+    int64_t m_lastHotSpotsBlock = -1;
+
+    std::shared_ptr<ColumnarWriter> m_columnarWriter;
+    uint16_t m_transactionsTable = 0;
+    uint16_t m_instructionCallsTable = 0;
+
     boost::mutex m_statStreamLock;
     boost::mutex m_benchmarkStreamLock;
+    boost::mutex m_hotSpotsLock;
+    boost::mutex m_storageAccessesLock;
+
+    /// last member so that the queued writes run before the others are destroyed
+    std::unique_ptr<AsyncStatWriter> m_statWriter;
+
+    void writeTransaction(const TransactionMeasurement& measurement);
+    void writeInstructionsBenchmark(const Json::Value& root);
+    void writeHotSpots(const std::vector<HotSpot>& spots, const Json::Value& summary);
 };
 
 
@@ -0,0 +1,142 @@
+#include "AsyncStatWriter.h"
+
+#include <chrono>
+#include <memory>
+#include <stdexcept>
+
+#include <libdevcore/Log.h>
+
+namespace dev
+{
+namespace eth
+{
+namespace
+{
+/// Sleep of the writer thread when the queue is empty, doubled up to the maximum
+/// while nothing is pushed
+constexpr std::chrono::microseconds c_minIdleSleep{50};
+constexpr std::chrono::microseconds c_maxIdleSleep{2000};
+}  // namespace
+
+StatQueueOverflow parseStatQueueOverflow(const std::string& name)
+{
+    if (name == "block")
+        return StatQueueOverflow::Block;
+    if (name == "drop")
+        return StatQueueOverflow::Drop;
+    throw std::invalid_argument("unknown stat queue overflow policy " + name);
+}
+
+Json::Value AsyncStatWriter::Counters::toJson() const
+{
+    Json::Value root;
+    root["capacity"] = static_cast<Json::UInt64>(capacity);
+    root["queued"] = static_cast<Json::UInt64>(queued);
+    root["written"] = static_cast<Json::UInt64>(written);
+    root["dropped"] = static_cast<Json::UInt64>(dropped);
+    root["blocked"] = static_cast<Json::UInt64>(blocked);
+    root["blocked_time"] = blockedTime;
+    return root;
+}
+
+AsyncStatWriter::AsyncStatWriter(size_t capacity, StatQueueOverflow overflow)
+  : m_capacity(capacity), m_overflow(overflow), m_queue(capacity)
+{
+    if (capacity == 0)
+        throw std::invalid_argument("the stat queue must have a capacity");
+    m_thread = std::thread([this]() { run(); });
+}
+
+AsyncStatWriter::~AsyncStatWriter()
+{
+    m_stopping = true;
+    m_thread.join();
+}
+
+bool AsyncStatWriter::push(Task task)
+{
+    std::unique_ptr<Task> queuedTask(new Task(std::move(task)));
+    // bounded_push only uses the nodes allocated by the constructor
+    if (m_queue.bounded_push(queuedTask.get()))
+    {
+        queuedTask.release();
+        m_queued++;
+        return true;
+    }
+    if (m_overflow == StatQueueOverflow::Drop)
+    {
+        m_dropped++;
+        return false;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    while (!m_queue.bounded_push(queuedTask.get()))
+        std::this_thread::yield();
+    queuedTask.release();
+    m_queued++;
+    m_blocked++;
+    m_blockedNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start)
+                                .count();
+    return true;
+}
+
+void AsyncStatWriter::drain()
+{
+    auto queued = m_queued.load();
+    auto sleep = c_minIdleSleep;
+    while (m_written.load() < queued)
+    {
+        std::this_thread::sleep_for(sleep);
+        sleep = std::min(sleep * 2, c_maxIdleSleep);
+    }
+}
+
+AsyncStatWriter::Counters AsyncStatWriter::counters() const
+{
+    Counters counters;
+    counters.capacity = m_capacity;
+    counters.queued = m_queued;
+    counters.written = m_written;
+    counters.dropped = m_dropped;
+    counters.blocked = m_blocked;
+    counters.blockedTime = m_blockedNanoseconds / 1e9;
+    return counters;
+}
+
+void AsyncStatWriter::run()
+{
+    auto sleep = c_minIdleSleep;
+    Task* task = nullptr;
+    while (true)
+    {
+        if (m_queue.pop(task))
+        {
+            std::unique_ptr<Task> ownedTask(task);
+            try
+            {
+                (*ownedTask)();
+            }
+            catch (std::exception const& e)
+            {
+                cwarn << "Failed to write measurements: " << e.what();
+            }
+            m_written++;
+            sleep = c_minIdleSleep;
+        }
+        else if (m_stopping)
+        {
+            // tasks pushed before stopping are all visible once the queue is seen empty
+            if (m_queue.empty())
+                return;
+        }
+        else
+        {
+            std::this_thread::sleep_for(sleep);
+            sleep = std::min(sleep * 2, c_maxIdleSleep);
+        }
+    }
+}
+
+}  // namespace eth
+}  // namespace dev
@@ -0,0 +1,89 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <thread>
+
+#include <boost/lockfree/queue.hpp>
+
+#include <json/json.h>
+
+namespace dev
+{
+namespace eth
+{
+/// What happens when a task is pushed to a full queue
+enum class StatQueueOverflow
+{
+    /// wait for the writer thread to make room, no measurement is lost
+    Block,
+    /// discard the task and count it as dropped
+    Drop,
+};
+
+StatQueueOverflow parseStatQueueOverflow(const std::string& name);
+
+/// Runs the serialisation and the writes of the measurements on a dedicated thread so that
+/// they stay out of the execution of the transactions. Tasks are pushed to a bounded
+/// lock-free queue and run in order by the writer thread; the output streams (and their
+/// gzip compression) must then only be used through the writer.
+class AsyncStatWriter
+{
+public:
+    using Task = std::function<void()>;
+
+    struct Counters
+    {
+        /// size of the queue
+        uint64_t capacity = 0;
+        /// tasks accepted in the queue
+        uint64_t queued = 0;
+        /// tasks run by the writer thread
+        uint64_t written = 0;
+        /// tasks discarded because the queue was full
+        uint64_t dropped = 0;
+        /// pushes which had to wait for the writer thread
+        uint64_t blocked = 0;
+        /// total time spent waiting for the writer thread, in seconds
+        double blockedTime = 0;
+
+        Json::Value toJson() const;
+    };
+
+    explicit AsyncStatWriter(
+        size_t capacity = 4096, StatQueueOverflow overflow = StatQueueOverflow::Block);
+    /// Runs the remaining tasks and stops the writer thread
+    ~AsyncStatWriter();
+
+    AsyncStatWriter(const AsyncStatWriter&) = delete;
+    AsyncStatWriter& operator=(const AsyncStatWriter&) = delete;
+
+    /// Queues `task`, returns false if it was dropped
+    bool push(Task task);
+
+    /// Waits until all the tasks queued so far have been run
+    void drain();
+
+    Counters counters() const;
+
+private:
+    size_t m_capacity;
+    StatQueueOverflow m_overflow;
+    boost::lockfree::queue<Task*> m_queue;
+
+    std::atomic<bool> m_stopping{false};
+    std::atomic<uint64_t> m_queued{0};
+    std::atomic<uint64_t> m_written{0};
+    std::atomic<uint64_t> m_dropped{0};
+    std::atomic<uint64_t> m_blocked{0};
+    std::atomic<uint64_t> m_blockedNanoseconds{0};
+
+    std::thread m_thread;
+
+    void run();
+};
+
+}  // namespace eth
+}  // namespace dev
@@ -0,0 +1,261 @@
+#include "BasicBlocks.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include <libevm/ExtVMFace.h>
+
+#include "InstructionSampler.h"
+#include "NonNegativeLeastSquares.h"
+
+namespace dev
+{
+namespace eth
+{
+namespace
+{
+bool endsBlock(Instruction instruction)
+{
+    switch (instruction)
+    {
+    case Instruction::JUMP:
+    case Instruction::JUMPI:
+    case Instruction::STOP:
+    case Instruction::RETURN:
+    case Instruction::REVERT:
+    case Instruction::INVALID:
+    case Instruction::SUICIDE:
+        return true;
+    default:
+        return false;
+    }
+}
+
+bool callsOut(Instruction instruction)
+{
+    switch (instruction)
+    {
+    case Instruction::CALL:
+    case Instruction::CALLCODE:
+    case Instruction::DELEGATECALL:
+    case Instruction::STATICCALL:
+    case Instruction::CREATE:
+    case Instruction::CREATE2:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void closeBlock(BasicBlock& block, std::map<Instruction, uint32_t>& counts, CodeBlocks& result)
+{
+    block.instructions.assign(counts.begin(), counts.end());
+    result.blockStarts[block.start] = static_cast<int32_t>(result.blocks.size());
+    result.blocks.push_back(std::move(block));
+    block = BasicBlock();
+    counts.clear();
+}
+}  // namespace
+
+std::ostream& operator<<(std::ostream& os, const BasicBlockKey& key)
+{
+    return os << key.codeHash.hex() << ":" << key.start;
+}
+
+CodeBlocks splitBasicBlocks(bytesConstRef code)
+{
+    CodeBlocks result;
+    result.blockStarts.assign(code.size(), -1);
+
+    BasicBlock block;
+    std::map<Instruction, uint32_t> counts;
+    for (size_t pc = 0; pc < code.size(); pc++)
+    {
+        auto instruction = static_cast<Instruction>(code[pc]);
+        if (instruction == Instruction::JUMPDEST && block.size > 0)
+            closeBlock(block, counts, result);
+        if (block.size == 0)
+            block.start = static_cast<uint32_t>(pc);
+        block.last = static_cast<uint32_t>(pc);
+        block.size++;
+        counts[instruction]++;
+
+        if (instruction >= Instruction::PUSH1 && instruction <= Instruction::PUSH32)
+            pc += static_cast<size_t>(instruction) - static_cast<size_t>(Instruction::PUSH1) + 1;
+
+        if (callsOut(instruction))
+            block.external = true;
+        if (endsBlock(instruction) || callsOut(instruction))
+            closeBlock(block, counts, result);
+    }
+    if (block.size > 0)
+        closeBlock(block, counts, result);
+    return result;
+}
+
+
+Json::Value CostModel::toJson() const
+{
+    Json::Value result;
+    result["stats"] = Json::Value(Json::objectValue);
+    for (const auto& kv : instructions)
+    {
+        Json::Value stats;
+        stats["count"] = static_cast<Json::UInt64>(kv.second.executedCount);
+        stats["mean"] = kv.second.time;
+        result["stats"][instructionInfo(kv.first).name] = stats;
+    }
+    result["blocks_count"] = static_cast<Json::UInt64>(blocksCount);
+    result["rmse"] = rootMeanSquaredError;
+    return result;
+}
+
+
+constexpr size_t BasicBlockProfile::c_maxCachedCodes;
+
+BasicBlockProfile::BasicBlockProfile(uint64_t granularity) : m_results(granularity) {}
+
+std::shared_ptr<const CodeBlocks> BasicBlockProfile::codeBlocks(
+    const h256& codeHash, const bytes& code)
+{
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_codeBlocks.find(codeHash);
+        if (it != m_codeBlocks.end())
+            return it->second;
+    }
+    auto blocks = std::make_shared<const CodeBlocks>(splitBasicBlocks(&code));
+    std::lock_guard<std::mutex> lock(m_mutex);
+    // the frames being timed keep their blocks alive
+    if (m_codeBlocks.size() >= c_maxCachedCodes)
+        m_codeBlocks.clear();
+    m_codeBlocks.emplace(codeHash, blocks);
+    return blocks;
+}
+
+void BasicBlockProfile::addMeasurement(
+    const h256& codeHash, const BasicBlock& block, uint64_t nanoseconds, uint64_t gas)
+{
+    BasicBlockKey key{codeHash, block.start};
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_results.addMeasurement(key, BenchmarkMeasurement(nanoseconds, gas));
+    if (!m_blockInstructions.count(key))
+        m_blockInstructions.emplace(key, block.instructions);
+}
+
+uint64_t BasicBlockProfile::totalCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_results.totalCount();
+}
+
+Json::Value BasicBlockProfile::toJson(bool full) const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_results.toJson(full);
+}
+
+CostModel BasicBlockProfile::fitCostModel() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    // one variable per executed instruction. There is no constant term: almost every block
+    // ends with exactly one terminating instruction, which would make it indistinguishable
+    // from their costs, the probe overhead is subtracted by the timer instead
+    std::map<Instruction, size_t> variables;
+    for (const auto& kv : m_results.results())
+    {
+        if (kv.second.count() == 0)
+            continue;
+        for (const auto& instruction : m_blockInstructions.at(kv.first))
+            variables.emplace(instruction.first, 0);
+    }
+    size_t index = 0;
+    for (auto& kv : variables)
+        kv.second = index++;
+
+    CostModel model;
+    NormalEquations equations(variables.size());
+    double weightsSum = 0;
+    for (const auto& kv : m_results.results())
+    {
+        if (kv.second.count() == 0)
+            continue;
+        std::vector<double> row(variables.size(), 0);
+        auto executions = kv.second.count() * kv.second.granularity();
+        for (const auto& instruction : m_blockInstructions.at(kv.first))
+        {
+            row[variables[instruction.first]] = instruction.second;
+            model.instructions[instruction.first].executedCount +=
+                executions * instruction.second;
+        }
+        equations.addRow(row, kv.second.mean(), kv.second.count());
+        weightsSum += kv.second.count();
+        model.blocksCount++;
+    }
+    if (model.blocksCount == 0)
+        return model;
+
+    auto solution = nonNegativeLeastSquares(equations);
+    for (const auto& kv : variables)
+        model.instructions[kv.first].time = solution[kv.second];
+
+    double squaredErrors = 0;
+    for (const auto& kv : m_results.results())
+    {
+        if (kv.second.count() == 0)
+            continue;
+        double predicted = 0;
+        for (const auto& instruction : m_blockInstructions.at(kv.first))
+            predicted += model.instructions[instruction.first].time * instruction.second;
+        auto error = kv.second.mean() - predicted;
+        squaredErrors += kv.second.count() * error * error;
+    }
+    model.rootMeanSquaredError = std::sqrt(squaredErrors / weightsSum);
+    return model;
+}
+
+
+void BasicBlockTimer::onOp(
+    uint64_t steps, uint64_t pc, const bigint& gasCost, ExtVMFace const* ext)
+{
+    auto now = CycleClock::now();
+    auto depth = ext->depth;
+    // the frames of the calls which returned are discarded
+    if (m_frames.size() != depth + 1)
+        m_frames.resize(depth + 1);
+    auto& frame = m_frames[depth];
+    if (steps == 1 || !frame.blocks)
+    {
+        frame = Frame();
+        frame.codeHash = ext->codeHash;
+        frame.blocks = m_profile.codeBlocks(ext->codeHash, ext->code);
+    }
+
+    auto next = frame.blocks->blockStartingAt(pc);
+    if (next != nullptr)
+    {
+        auto current = frame.current;
+        if (current != nullptr && frame.steps == current->size && !current->external &&
+            now >= frame.start)
+        {
+            auto cycles =
+                std::max(static_cast<double>(now - frame.start) - m_probeOverheadCycles, 0.0);
+            auto nanoseconds =
+                static_cast<uint64_t>(std::llround(cycles * CycleClock::nanosecondsPerCycle()));
+            m_profile.addMeasurement(frame.codeHash, *current, nanoseconds, frame.gas);
+        }
+        frame.current = next;
+        frame.steps = 0;
+        frame.gas = 0;
+    }
+    if (frame.current == nullptr)
+        return;
+    frame.steps++;
+    frame.gas += gasCost.convert_to<uint64_t>();
+    if (next != nullptr)
+        frame.start = CycleClock::now();
+}
+
+}  // namespace eth
+}  // namespace dev
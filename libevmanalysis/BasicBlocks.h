@@ -0,0 +1,167 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <json/json.h>
+
+#include <libdevcore/Common.h>
+#include <libdevcore/FixedHash.h>
+#include <libevm/Instruction.h>
+
+#include "BenchmarkResults.h"
+
+namespace dev
+{
+namespace eth
+{
+class ExtVMFace;
+
+/// Identifies a basic block by the code containing it and the position of its first instruction
+struct BasicBlockKey
+{
+    h256 codeHash;
+    uint32_t start = 0;
+
+    bool operator<(const BasicBlockKey& other) const
+    {
+        return std::tie(codeHash, start) < std::tie(other.codeHash, other.start);
+    }
+    bool operator==(const BasicBlockKey& other) const
+    {
+        return codeHash == other.codeHash && start == other.start;
+    }
+};
+
+/// `<code hash>:<start>`
+std::ostream& operator<<(std::ostream& os, const BasicBlockKey& key);
+
+/// Straight-line sequence of instructions: it starts at the beginning of the code, at a
+/// JUMPDEST or after a terminating instruction and ends before the next JUMPDEST or at a
+/// JUMP, JUMPI, STOP, RETURN, REVERT, INVALID, SUICIDE, call or create
+struct BasicBlock
+{
+    /// position of the first and last instructions
+    uint32_t start = 0;
+    uint32_t last = 0;
+    /// number of instructions
+    uint32_t size = 0;
+    /// ends with a call or a create, its duration includes the execution of the callee
+    bool external = false;
+    /// number of occurrences of each instruction
+    std::vector<std::pair<Instruction, uint32_t>> instructions;
+};
+
+/// Basic blocks of a code and the block starting at each position
+struct CodeBlocks
+{
+    std::vector<BasicBlock> blocks;
+    /// index of the block starting at each position, -1 if no block starts there
+    std::vector<int32_t> blockStarts;
+
+    const BasicBlock* blockStartingAt(uint64_t pc) const
+    {
+        if (pc >= blockStarts.size() || blockStarts[pc] < 0)
+            return nullptr;
+        return &blocks[blockStarts[pc]];
+    }
+};
+
+CodeBlocks splitBasicBlocks(bytesConstRef code);
+
+/// Execution time of an instruction estimated from the durations of the blocks
+struct InstructionCost
+{
+    /// nanoseconds
+    double time = 0;
+    uint64_t executedCount = 0;
+};
+
+/// Per-instruction costs attributed from the measured blocks
+struct CostModel
+{
+    std::map<Instruction, InstructionCost> instructions;
+    size_t blocksCount = 0;
+    /// root mean squared error of the fit over the blocks, weighted by their executions
+    double rootMeanSquaredError = 0;
+
+    /// Same layout as the instructions benchmark (`stats.<name>.count` and `.mean`) so that the
+    /// file can be used as the metadata of the gas exploiter (see parseInstructionsFromFile)
+    Json::Value toJson() const;
+};
+
+/// Execution times of the basic blocks of the executed contracts. Timing whole blocks only
+/// needs a clock read at the block boundaries instead of two around every instruction, the
+/// cost of each instruction is then attributed with a non-negative least squares regression
+/// of the block durations over their instruction counts. Thread-safe
+class BasicBlockProfile
+{
+public:
+    /// `granularity` measurements of a block are averaged before being recorded, blocks
+    /// executed fewer times are not used by the regression
+    explicit BasicBlockProfile(uint64_t granularity = 100);
+
+    /// Blocks of `code`, cached by code hash
+    std::shared_ptr<const CodeBlocks> codeBlocks(const h256& codeHash, const bytes& code);
+
+    void addMeasurement(const h256& codeHash, const BasicBlock& block, uint64_t nanoseconds,
+        uint64_t gas);
+
+    uint64_t totalCount() const;
+
+    Json::Value toJson(bool full = false) const;
+
+    CostModel fitCostModel() const;
+
+private:
+    /// analysed codes kept in the cache
+    static constexpr size_t c_maxCachedCodes = 10000;
+
+    mutable std::mutex m_mutex;
+    BenchmarkResultsMap<BasicBlockKey> m_results;
+    std::map<BasicBlockKey, std::vector<std::pair<Instruction, uint32_t>>> m_blockInstructions;
+    std::unordered_map<h256, std::shared_ptr<const CodeBlocks>> m_codeBlocks;
+};
+
+/// Times the basic blocks executed during a transaction, including the ones of nested calls.
+/// A block is measured from its first instruction to the first instruction of the next block
+/// of the same call frame, blocks interrupted by an exception, ending the execution of the
+/// frame or calling another contract are not recorded
+class BasicBlockTimer
+{
+public:
+    /// `probeOverheadCycles` is subtracted from every measurement
+    /// (see `InstructionSampling::probeOverheadCycles`)
+    BasicBlockTimer(BasicBlockProfile& profile, double probeOverheadCycles)
+      : m_profile(profile), m_probeOverheadCycles(probeOverheadCycles)
+    {}
+
+    /// To be called before each instruction
+    void onOp(uint64_t steps, uint64_t pc, const bigint& gasCost, ExtVMFace const* ext);
+
+private:
+    struct Frame
+    {
+        h256 codeHash;
+        std::shared_ptr<const CodeBlocks> blocks;
+        const BasicBlock* current = nullptr;
+        uint32_t steps = 0;
+        uint64_t gas = 0;
+        uint64_t start = 0;
+    };
+
+    BasicBlockProfile& m_profile;
+    double m_probeOverheadCycles;
+    /// indexed by depth
+    std::vector<Frame> m_frames;
+};
+
+}  // namespace eth
+}  // namespace dev
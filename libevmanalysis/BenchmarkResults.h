@@ -117,6 +117,8 @@ public:
 
     void addMeasurement(const T& key, BenchmarkMeasurement measurement);
 
+    const std::map<T, BenchmarkResults>& results() const { return m_results; }
+
     Json::Value toJson(bool full = false) const;
 
 private:
@@ -166,8 +168,5 @@ std::ostream& operator<<(std::ostream& os, const BenchmarkResultsMap<T>& v)
 }
 
 
-using InstructionsBenchmark = BenchmarkResultsMap<eth::ExtendedInstruction>;
-
-
 }  // namespace eth
 }  // namespace dev
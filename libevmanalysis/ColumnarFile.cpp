@@ -0,0 +1,718 @@
+#include "ColumnarFile.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+
+#include <snappy.h>
+
+#include <libdevcore/CommonData.h>
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+    "columnar files are written in the native byte order, which must be little-endian");
+
+namespace
+{
+const char fileMagic[8] = {'A', 'L', 'E', 'T', 'H', 'C', 'O', 'L'};
+const uint32_t fileVersion = 1;
+const size_t fileHeaderSize = 16;
+
+enum ChunkKind : uint8_t
+{
+    TableChunk = 0,
+    DictionaryChunk = 1,
+    RowsChunk = 2,
+};
+
+struct ChunkHeader
+{
+    uint8_t kind;
+    uint8_t codec;
+    uint16_t table;
+    uint32_t rowsCount;
+    uint64_t rawSize;
+    uint64_t storedSize;
+};
+static_assert(sizeof(ChunkHeader) == 24, "chunk headers must not be padded");
+
+size_t padded(size_t size)
+{
+    return (size + 7) & ~static_cast<size_t>(7);
+}
+
+template <typename T>
+void append(dev::bytes& buffer, T value)
+{
+    auto ptr = reinterpret_cast<const uint8_t*>(&value);
+    buffer.insert(buffer.end(), ptr, ptr + sizeof(T));
+}
+
+void appendString(dev::bytes& buffer, const std::string& value)
+{
+    append<uint32_t>(buffer, value.size());
+    buffer.insert(buffer.end(), value.begin(), value.end());
+}
+
+/// Bounds-checked reader of the payload of table and dictionary chunks
+class PayloadReader
+{
+public:
+    PayloadReader(const uint8_t* data, size_t size) : m_data(data), m_size(size) {}
+
+    template <typename T>
+    T read()
+    {
+        check(sizeof(T));
+        T value;
+        std::memcpy(&value, m_data + m_offset, sizeof(T));
+        m_offset += sizeof(T);
+        return value;
+    }
+
+    std::string readString()
+    {
+        auto size = read<uint32_t>();
+        check(size);
+        std::string value(reinterpret_cast<const char*>(m_data + m_offset), size);
+        m_offset += size;
+        return value;
+    }
+
+private:
+    const uint8_t* m_data;
+    size_t m_size;
+    size_t m_offset = 0;
+
+    void check(size_t size) const
+    {
+        if (m_offset + size > m_size)
+        {
+            throw std::runtime_error("corrupted columnar chunk");
+        }
+    }
+};
+
+}  // namespace
+
+namespace dev
+{
+namespace eth
+{
+size_t columnWidth(ColumnType type)
+{
+    switch (type)
+    {
+    case ColumnType::UInt64:
+    case ColumnType::Int64:
+    case ColumnType::Double:
+        return 8;
+    case ColumnType::Symbol:
+        return 4;
+    case ColumnType::Address:
+        return 20;
+    case ColumnType::Hash:
+    case ColumnType::UInt256:
+        return 32;
+    }
+    throw std::invalid_argument("unknown column type " + std::to_string(static_cast<int>(type)));
+}
+
+bool TableSchema::operator==(const TableSchema& other) const
+{
+    if (name != other.name || columns.size() != other.columns.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < columns.size(); i++)
+    {
+        if (columns[i].name != other.columns[i].name || columns[i].type != other.columns[i].type)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+ColumnarCodec parseColumnarCodec(const std::string& name)
+{
+    if (name == "none")
+    {
+        return ColumnarCodec::None;
+    }
+    else if (name == "snappy")
+    {
+        return ColumnarCodec::Snappy;
+    }
+    throw std::invalid_argument("codec should be 'none' or 'snappy', got '" + name + "'");
+}
+
+bool isColumnarPath(const std::string& path)
+{
+    return path.size() >= 4 && path.compare(path.size() - 4, 4, ".col") == 0;
+}
+
+
+ColumnarWriter::ColumnarWriter(const std::string& path, ColumnarCodec codec, uint32_t blockRows)
+  : m_codec(codec), m_blockRows(blockRows)
+{
+    if (blockRows == 0)
+    {
+        throw std::invalid_argument("columnar blocks need at least one row");
+    }
+
+    struct stat fileStat;
+    bool existing = stat(path.c_str(), &fileStat) == 0 && fileStat.st_size > 0;
+    if (existing)
+    {
+        size_t validSize;
+        {
+            ColumnarReader reader(path);
+            ColumnarReader::Block block;
+            std::vector<uint64_t> rowsCounts;
+            while (reader.next(block))
+            {
+                rowsCounts.resize(reader.tables().size());
+                rowsCounts[block.table()] += block.rowsCount();
+            }
+            rowsCounts.resize(reader.tables().size());
+            for (size_t i = 0; i < reader.tables().size(); i++)
+            {
+                Table table;
+                table.schema = reader.tables()[i];
+                table.columns.resize(table.schema.columns.size());
+                table.rowsCount = rowsCounts[i];
+                m_tables.push_back(table);
+            }
+            for (size_t i = 0; i < reader.dictionary().size(); i++)
+            {
+                m_symbols[reader.dictionary()[i]] = i;
+            }
+            validSize = reader.validSize();
+        }
+        // drop the chunk which was being written when the previous writer stopped
+        if (validSize < static_cast<size_t>(fileStat.st_size) &&
+            truncate(path.c_str(), validSize) != 0)
+        {
+            throw std::runtime_error(
+                "failed to truncate " + path + ": " + std::strerror(errno));
+        }
+    }
+
+    m_file.open(path, std::ios_base::out | std::ios_base::app | std::ios_base::binary);
+    if (!m_file)
+    {
+        throw std::runtime_error("failed to open " + path);
+    }
+    if (!existing)
+    {
+        bytes header(fileMagic, fileMagic + sizeof(fileMagic));
+        append(header, fileVersion);
+        append<uint32_t>(header, 0);
+        m_file.write(reinterpret_cast<const char*>(header.data()), header.size());
+    }
+}
+
+ColumnarWriter::~ColumnarWriter()
+{
+    try
+    {
+        flush();
+    }
+    catch (std::exception const&)
+    {
+        // nothing sensible to do in a destructor, the file stays valid up to the last chunk
+    }
+}
+
+uint16_t ColumnarWriter::addTable(const TableSchema& schema)
+{
+    for (size_t i = 0; i < m_tables.size(); i++)
+    {
+        if (m_tables[i].schema.name != schema.name)
+        {
+            continue;
+        }
+        if (m_tables[i].schema != schema)
+        {
+            throw std::invalid_argument(
+                "table '" + schema.name + "' already exists with other columns");
+        }
+        return i;
+    }
+    if (m_tables.size() > UINT16_MAX)
+    {
+        throw std::invalid_argument("too many tables in columnar file");
+    }
+
+    bytes payload;
+    appendString(payload, schema.name);
+    append<uint32_t>(payload, schema.columns.size());
+    for (const auto& column : schema.columns)
+    {
+        append(payload, column.type);
+        appendString(payload, column.name);
+    }
+    uint16_t id = m_tables.size();
+    writeChunk(TableChunk, ColumnarCodec::None, id, 0, payload);
+
+    Table table;
+    table.schema = schema;
+    table.columns.resize(schema.columns.size());
+    m_tables.push_back(table);
+    return id;
+}
+
+ColumnarWriter& ColumnarWriter::beginRow(uint16_t table)
+{
+    if (m_currentTable >= 0)
+    {
+        throw std::logic_error("previous columnar row was not completed");
+    }
+    if (table >= m_tables.size())
+    {
+        throw std::invalid_argument("unknown table " + std::to_string(table));
+    }
+    m_currentTable = table;
+    m_currentColumn = 0;
+    return *this;
+}
+
+bytes& ColumnarWriter::nextColumn(ColumnType type)
+{
+    if (m_currentTable < 0)
+    {
+        throw std::logic_error("no columnar row started");
+    }
+    auto& table = m_tables[m_currentTable];
+    if (m_currentColumn >= table.schema.columns.size())
+    {
+        throw std::logic_error("too many values for a row of " + table.schema.name);
+    }
+    const auto& column = table.schema.columns[m_currentColumn];
+    if (column.type != type)
+    {
+        throw std::logic_error(
+            "wrong value type for column " + column.name + " of " + table.schema.name);
+    }
+    return table.columns[m_currentColumn++];
+}
+
+ColumnarWriter& ColumnarWriter::add(uint64_t value)
+{
+    append(nextColumn(ColumnType::UInt64), value);
+    return *this;
+}
+
+ColumnarWriter& ColumnarWriter::add(int64_t value)
+{
+    append(nextColumn(ColumnType::Int64), value);
+    return *this;
+}
+
+ColumnarWriter& ColumnarWriter::add(double value)
+{
+    append(nextColumn(ColumnType::Double), value);
+    return *this;
+}
+
+ColumnarWriter& ColumnarWriter::add(const Address& value)
+{
+    auto& column = nextColumn(ColumnType::Address);
+    column.insert(column.end(), value.begin(), value.end());
+    return *this;
+}
+
+ColumnarWriter& ColumnarWriter::add(const h256& value)
+{
+    auto& column = nextColumn(ColumnType::Hash);
+    column.insert(column.end(), value.begin(), value.end());
+    return *this;
+}
+
+ColumnarWriter& ColumnarWriter::add(const u256& value)
+{
+    auto& column = nextColumn(ColumnType::UInt256);
+    auto encoded = toBigEndian(value);
+    column.insert(column.end(), encoded.begin(), encoded.end());
+    return *this;
+}
+
+ColumnarWriter& ColumnarWriter::addSymbol(const std::string& value)
+{
+    auto& column = nextColumn(ColumnType::Symbol);
+    auto it = m_symbols.find(value);
+    if (it == m_symbols.end())
+    {
+        it = m_symbols.emplace(value, m_symbols.size()).first;
+        m_pendingSymbols.push_back(value);
+    }
+    append(column, it->second);
+    return *this;
+}
+
+void ColumnarWriter::endRow()
+{
+    if (m_currentTable < 0)
+    {
+        throw std::logic_error("no columnar row started");
+    }
+    uint16_t tableId = m_currentTable;
+    auto& table = m_tables[tableId];
+    if (m_currentColumn != table.schema.columns.size())
+    {
+        throw std::logic_error("missing values for a row of " + table.schema.name);
+    }
+    m_currentTable = -1;
+    table.bufferedRows++;
+    table.rowsCount++;
+    if (table.bufferedRows >= m_blockRows)
+    {
+        flushTable(tableId);
+    }
+}
+
+uint64_t ColumnarWriter::rowsCount(uint16_t table) const
+{
+    return m_tables.at(table).rowsCount;
+}
+
+void ColumnarWriter::flush()
+{
+    for (size_t i = 0; i < m_tables.size(); i++)
+    {
+        flushTable(i);
+    }
+    m_file.flush();
+}
+
+void ColumnarWriter::flushTable(uint16_t tableId)
+{
+    auto& table = m_tables[tableId];
+    if (table.bufferedRows == 0)
+    {
+        return;
+    }
+
+    if (!m_pendingSymbols.empty())
+    {
+        bytes payload;
+        append<uint32_t>(payload, m_pendingSymbols.size());
+        for (const auto& symbol : m_pendingSymbols)
+        {
+            appendString(payload, symbol);
+        }
+        writeChunk(DictionaryChunk, ColumnarCodec::None, 0, 0, payload);
+        m_pendingSymbols.clear();
+    }
+
+    bytes raw;
+    for (auto& column : table.columns)
+    {
+        raw.insert(raw.end(), column.begin(), column.end());
+        raw.resize(padded(raw.size()));
+        column.clear();
+    }
+
+    auto rowsCount = table.bufferedRows;
+    table.bufferedRows = 0;
+    if (m_codec == ColumnarCodec::Snappy)
+    {
+        std::string compressed;
+        snappy::Compress(reinterpret_cast<const char*>(raw.data()), raw.size(), &compressed);
+        // keep the block uncompressed when it does not help so that it can be mapped directly
+        if (compressed.size() < raw.size())
+        {
+            writeChunk(RowsChunk, ColumnarCodec::Snappy, tableId, rowsCount, raw.size(),
+                compressed.data(), compressed.size());
+            return;
+        }
+    }
+    writeChunk(RowsChunk, ColumnarCodec::None, tableId, rowsCount, raw);
+}
+
+void ColumnarWriter::writeChunk(uint8_t kind, ColumnarCodec codec, uint16_t table,
+    uint32_t rowsCount, const bytes& payload)
+{
+    writeChunk(kind, codec, table, rowsCount, payload.size(),
+        reinterpret_cast<const char*>(payload.data()), payload.size());
+}
+
+void ColumnarWriter::writeChunk(uint8_t kind, ColumnarCodec codec, uint16_t table,
+    uint32_t rowsCount, uint64_t rawSize, const char* data, size_t size)
+{
+    ChunkHeader header{kind, static_cast<uint8_t>(codec), table, rowsCount, rawSize, size};
+    std::string padding(padded(size) - size, '\0');
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_file.write(data, size);
+    m_file.write(padding.data(), padding.size());
+}
+
+
+ColumnarReader::ColumnarReader(const std::string& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        throw std::runtime_error("failed to open " + path + ": " + std::strerror(errno));
+    }
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0)
+    {
+        close(fd);
+        throw std::runtime_error("failed to stat " + path + ": " + std::strerror(errno));
+    }
+    m_size = fileStat.st_size;
+    if (m_size < fileHeaderSize)
+    {
+        close(fd);
+        throw std::runtime_error(path + " is not a columnar file");
+    }
+    void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+    {
+        throw std::runtime_error("failed to map " + path + ": " + std::strerror(errno));
+    }
+    m_data = static_cast<const uint8_t*>(data);
+    madvise(data, m_size, MADV_SEQUENTIAL);
+
+    uint32_t version;
+    std::memcpy(&version, m_data + sizeof(fileMagic), sizeof(version));
+    if (std::memcmp(m_data, fileMagic, sizeof(fileMagic)) != 0 || version != fileVersion)
+    {
+        munmap(data, m_size);
+        throw std::runtime_error(path + " is not a columnar file of version " +
+                                 std::to_string(fileVersion));
+    }
+    m_offset = fileHeaderSize;
+}
+
+ColumnarReader::~ColumnarReader()
+{
+    munmap(const_cast<uint8_t*>(m_data), m_size);
+}
+
+bool ColumnarReader::next(Block& block)
+{
+    while (m_offset + sizeof(ChunkHeader) <= m_size)
+    {
+        ChunkHeader header;
+        std::memcpy(&header, m_data + m_offset, sizeof(header));
+        auto payload = m_data + m_offset + sizeof(header);
+        auto chunkEnd = m_offset + sizeof(header) + padded(header.storedSize);
+        if (header.storedSize > m_size || chunkEnd > m_size)
+        {
+            return false;
+        }
+
+        PayloadReader reader(payload, header.storedSize);
+        switch (header.kind)
+        {
+        case TableChunk:
+        {
+            TableSchema schema;
+            schema.name = reader.readString();
+            auto columnsCount = reader.read<uint32_t>();
+            for (uint32_t i = 0; i < columnsCount; i++)
+            {
+                auto type = reader.read<ColumnType>();
+                columnWidth(type);
+                schema.columns.push_back(ColumnSchema{reader.readString(), type});
+            }
+            m_tables.push_back(schema);
+            break;
+        }
+        case DictionaryChunk:
+        {
+            auto symbolsCount = reader.read<uint32_t>();
+            for (uint32_t i = 0; i < symbolsCount; i++)
+            {
+                m_dictionary.push_back(reader.readString());
+            }
+            break;
+        }
+        case RowsChunk:
+        {
+            if (header.table >= m_tables.size())
+            {
+                throw std::runtime_error("columnar rows of an undeclared table");
+            }
+            const auto& schema = m_tables[header.table];
+            block.m_reader = this;
+            block.m_table = header.table;
+            block.m_rowsCount = header.rowsCount;
+            block.m_columnOffsets.clear();
+            size_t rawSize = 0;
+            for (const auto& column : schema.columns)
+            {
+                block.m_columnOffsets.push_back(rawSize);
+                rawSize += padded(columnWidth(column.type) * header.rowsCount);
+            }
+            if (rawSize != header.rawSize)
+            {
+                throw std::runtime_error("corrupted columnar rows of " + schema.name);
+            }
+
+            if (header.codec == static_cast<uint8_t>(ColumnarCodec::None))
+            {
+                block.m_data = payload;
+            }
+            else if (header.codec == static_cast<uint8_t>(ColumnarCodec::Snappy))
+            {
+                auto compressed = reinterpret_cast<const char*>(payload);
+                size_t uncompressedSize;
+                if (!snappy::GetUncompressedLength(
+                        compressed, header.storedSize, &uncompressedSize) ||
+                    uncompressedSize != rawSize)
+                {
+                    throw std::runtime_error("corrupted columnar rows of " + schema.name);
+                }
+                block.m_decompressed.resize(rawSize);
+                if (!snappy::RawUncompress(compressed, header.storedSize,
+                        reinterpret_cast<char*>(block.m_decompressed.data())))
+                {
+                    throw std::runtime_error("corrupted columnar rows of " + schema.name);
+                }
+                block.m_data = block.m_decompressed.data();
+            }
+            else
+            {
+                throw std::runtime_error(
+                    "unknown columnar codec " + std::to_string(header.codec));
+            }
+            m_offset = chunkEnd;
+            return true;
+        }
+        default:
+            throw std::runtime_error("unknown columnar chunk kind " + std::to_string(header.kind));
+        }
+        m_offset = chunkEnd;
+    }
+    return false;
+}
+
+void ColumnarReader::writeJsonLines(std::ostream& os)
+{
+    Json::StreamWriterBuilder builder;
+    builder.settings_["indentation"] = "";
+    std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+
+    Block block;
+    while (next(block))
+    {
+        for (size_t row = 0; row < block.rowsCount(); row++)
+        {
+            writer->write(block.rowToJson(row), &os);
+            os << std::endl;
+        }
+    }
+}
+
+
+const TableSchema& ColumnarReader::Block::schema() const
+{
+    return m_reader->tables()[m_table];
+}
+
+const uint8_t* ColumnarReader::Block::value(size_t column, size_t row, ColumnType type) const
+{
+    const auto& columns = schema().columns;
+    if (column >= columns.size() || row >= m_rowsCount)
+    {
+        throw std::out_of_range("no value at column " + std::to_string(column) + ", row " +
+                                std::to_string(row) + " of " + schema().name);
+    }
+    if (columns[column].type != type)
+    {
+        throw std::invalid_argument("column " + columns[column].name + " has another type");
+    }
+    return m_data + m_columnOffsets[column] + row * columnWidth(type);
+}
+
+uint64_t ColumnarReader::Block::getUInt64(size_t column, size_t row) const
+{
+    uint64_t result;
+    std::memcpy(&result, value(column, row, ColumnType::UInt64), sizeof(result));
+    return result;
+}
+
+int64_t ColumnarReader::Block::getInt64(size_t column, size_t row) const
+{
+    int64_t result;
+    std::memcpy(&result, value(column, row, ColumnType::Int64), sizeof(result));
+    return result;
+}
+
+double ColumnarReader::Block::getDouble(size_t column, size_t row) const
+{
+    double result;
+    std::memcpy(&result, value(column, row, ColumnType::Double), sizeof(result));
+    return result;
+}
+
+const std::string& ColumnarReader::Block::getSymbol(size_t column, size_t row) const
+{
+    uint32_t id;
+    std::memcpy(&id, value(column, row, ColumnType::Symbol), sizeof(id));
+    return m_reader->dictionary().at(id);
+}
+
+Address ColumnarReader::Block::getAddress(size_t column, size_t row) const
+{
+    return Address(bytesConstRef(value(column, row, ColumnType::Address), Address::size));
+}
+
+h256 ColumnarReader::Block::getHash(size_t column, size_t row) const
+{
+    return h256(bytesConstRef(value(column, row, ColumnType::Hash), h256::size));
+}
+
+u256 ColumnarReader::Block::getUInt256(size_t column, size_t row) const
+{
+    return fromBigEndian<u256>(bytesConstRef(value(column, row, ColumnType::UInt256), 32));
+}
+
+Json::Value ColumnarReader::Block::rowToJson(size_t row) const
+{
+    Json::Value result;
+    result["table"] = schema().name;
+    const auto& columns = schema().columns;
+    for (size_t i = 0; i < columns.size(); i++)
+    {
+        auto& field = result[columns[i].name];
+        switch (columns[i].type)
+        {
+        case ColumnType::UInt64:
+            field = static_cast<Json::UInt64>(getUInt64(i, row));
+            break;
+        case ColumnType::Int64:
+            field = static_cast<Json::Int64>(getInt64(i, row));
+            break;
+        case ColumnType::Double:
+            field = getDouble(i, row);
+            break;
+        case ColumnType::Symbol:
+            field = getSymbol(i, row);
+            break;
+        case ColumnType::Address:
+            field = getAddress(i, row).hex();
+            break;
+        case ColumnType::Hash:
+            field = getHash(i, row).hex();
+            break;
+        case ColumnType::UInt256:
+            field = getUInt256(i, row).str();
+            break;
+        }
+    }
+    return result;
+}
+
+}  // namespace eth
+}  // namespace dev
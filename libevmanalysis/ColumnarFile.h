@@ -0,0 +1,207 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <json/json.h>
+
+#include <libdevcore/Address.h>
+#include <libdevcore/Common.h>
+#include <libdevcore/FixedHash.h>
+
+namespace dev
+{
+namespace eth
+{
+/// Type of the values of a column, all the types have a fixed width
+enum class ColumnType : uint8_t
+{
+    UInt64 = 0,
+    Int64 = 1,
+    Double = 2,
+    /// string stored as a 32 bits index in the dictionary of the file
+    Symbol = 3,
+    /// 20 bytes
+    Address = 4,
+    /// 32 bytes, converted to hexadecimal
+    Hash = 5,
+    /// 32 bytes big-endian, converted to a decimal string
+    UInt256 = 6,
+};
+
+/// Size in bytes of a value of type `type`
+size_t columnWidth(ColumnType type);
+
+struct ColumnSchema
+{
+    std::string name;
+    ColumnType type;
+};
+
+struct TableSchema
+{
+    std::string name;
+    std::vector<ColumnSchema> columns;
+
+    bool operator==(const TableSchema& other) const;
+    bool operator!=(const TableSchema& other) const { return !(*this == other); }
+};
+
+enum class ColumnarCodec : uint8_t
+{
+    None = 0,
+    Snappy = 1,
+};
+
+ColumnarCodec parseColumnarCodec(const std::string& name);
+
+/// Whether outputs to `path` should be written as a columnar file, i.e. it has a `.col` extension
+bool isColumnarPath(const std::string& path);
+
+/// Columnar files are an append-only alternative to the JSONL outputs for large amounts of rows
+/// with a fixed schema (transactions measurements, search generations).
+///
+/// A file starts with a 16 bytes header (the `ALETHCOL` magic and the format version) followed
+/// by chunks. Each chunk has a 24 bytes header (kind, codec, table id, rows count, raw size,
+/// stored size) and a payload padded to 8 bytes:
+///   * table chunks declare the name and the columns of a table, their id is their position
+///   * dictionary chunks append strings to the dictionary of `Symbol` columns
+///   * rows chunks contain a block of rows of a table, stored column by column,
+///     each column being padded to 8 bytes
+/// Symbols and tables are always declared before the first rows chunk using them, so a file
+/// can be read sequentially and a file truncated by a crash is valid up to its last complete
+/// chunk. Values are stored in little-endian order, the layout of uncompressed chunks can be
+/// used directly from a memory mapping (see scripts/columnar.py).
+class ColumnarWriter
+{
+public:
+    /// Opens `path` for appending. The tables and the dictionary of an existing file are
+    /// reloaded and an incomplete last chunk is discarded.
+    /// Rows are buffered until a table reaches `blockRows` rows
+    explicit ColumnarWriter(const std::string& path,
+        ColumnarCodec codec = ColumnarCodec::Snappy, uint32_t blockRows = 4096);
+    ~ColumnarWriter();
+
+    ColumnarWriter(const ColumnarWriter&) = delete;
+    ColumnarWriter& operator=(const ColumnarWriter&) = delete;
+
+    /// Returns the id of the table named after `schema`, declaring it if it does not exist yet.
+    /// Throws std::invalid_argument if the existing table has other columns
+    uint16_t addTable(const TableSchema& schema);
+
+    /// Starts a row of `table`, its values must then be added in the order of the columns
+    ColumnarWriter& beginRow(uint16_t table);
+    ColumnarWriter& add(uint64_t value);
+    ColumnarWriter& add(int64_t value);
+    ColumnarWriter& add(double value);
+    ColumnarWriter& add(const Address& value);
+    ColumnarWriter& add(const h256& value);
+    ColumnarWriter& add(const u256& value);
+    ColumnarWriter& addSymbol(const std::string& value);
+    /// Completes the current row, throws std::logic_error if some values are missing
+    void endRow();
+
+    /// Number of rows of `table`, including the ones already in the file when it was opened
+    uint64_t rowsCount(uint16_t table) const;
+
+    /// Writes the rows buffered for every table
+    void flush();
+
+private:
+    struct Table
+    {
+        TableSchema schema;
+        std::vector<bytes> columns;
+        uint32_t bufferedRows = 0;
+        uint64_t rowsCount = 0;
+    };
+
+    ColumnarCodec m_codec;
+    uint32_t m_blockRows;
+    std::ofstream m_file;
+    std::vector<Table> m_tables;
+    std::unordered_map<std::string, uint32_t> m_symbols;
+    std::vector<std::string> m_pendingSymbols;
+
+    int m_currentTable = -1;
+    size_t m_currentColumn = 0;
+
+    bytes& nextColumn(ColumnType type);
+    void flushTable(uint16_t table);
+    void writeChunk(uint8_t kind, ColumnarCodec codec, uint16_t table, uint32_t rowsCount,
+        const bytes& payload);
+    void writeChunk(uint8_t kind, ColumnarCodec codec, uint16_t table, uint32_t rowsCount,
+        uint64_t rawSize, const char* data, size_t size);
+};
+
+
+/// Sequential reader of columnar files. The file is memory mapped and the uncompressed
+/// rows chunks are read in place
+class ColumnarReader
+{
+public:
+    /// Rows of one chunk
+    class Block
+    {
+    public:
+        uint16_t table() const { return m_table; }
+        uint32_t rowsCount() const { return m_rowsCount; }
+        const TableSchema& schema() const;
+
+        uint64_t getUInt64(size_t column, size_t row) const;
+        int64_t getInt64(size_t column, size_t row) const;
+        double getDouble(size_t column, size_t row) const;
+        const std::string& getSymbol(size_t column, size_t row) const;
+        Address getAddress(size_t column, size_t row) const;
+        h256 getHash(size_t column, size_t row) const;
+        u256 getUInt256(size_t column, size_t row) const;
+
+        /// Row as a flat JSON object with a `table` field and one field per column
+        Json::Value rowToJson(size_t row) const;
+
+    private:
+        friend class ColumnarReader;
+
+        const ColumnarReader* m_reader = nullptr;
+        uint16_t m_table = 0;
+        uint32_t m_rowsCount = 0;
+        const uint8_t* m_data = nullptr;
+        bytes m_decompressed;
+        std::vector<size_t> m_columnOffsets;
+
+        const uint8_t* value(size_t column, size_t row, ColumnType type) const;
+    };
+
+    explicit ColumnarReader(const std::string& path);
+    ~ColumnarReader();
+
+    ColumnarReader(const ColumnarReader&) = delete;
+    ColumnarReader& operator=(const ColumnarReader&) = delete;
+
+    /// Reads the next rows chunk into `block`, tables and symbols declared before are loaded.
+    /// Returns false at the end of the file or at an incomplete chunk
+    bool next(Block& block);
+
+    const std::vector<TableSchema>& tables() const { return m_tables; }
+    const std::vector<std::string>& dictionary() const { return m_dictionary; }
+
+    /// Offset of the end of the last complete chunk read
+    size_t validSize() const { return m_offset; }
+
+    /// Writes every row of the file as a JSON line
+    void writeJsonLines(std::ostream& os);
+
+private:
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+    size_t m_offset = 0;
+    std::vector<TableSchema> m_tables;
+    std::vector<std::string> m_dictionary;
+};
+
+}  // namespace eth
+}  // namespace dev
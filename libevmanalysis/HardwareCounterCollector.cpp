@@ -0,0 +1,168 @@
+#include "HardwareCounterCollector.h"
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace
+{
+struct EventDefinition
+{
+    uint32_t type;
+    uint64_t config;
+    uint64_t dev::eth::HardwareCounters::*field;
+};
+
+// the first event is the group leader and must be supported
+const EventDefinition eventDefinitions[] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, &dev::eth::HardwareCounters::cycles},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, &dev::eth::HardwareCounters::instructions},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, &dev::eth::HardwareCounters::cacheMisses},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, &dev::eth::HardwareCounters::branchMisses},
+    {PERF_TYPE_HW_CACHE,
+        PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+            (PERF_COUNT_HW_CACHE_RESULT_MISS << 16),
+        &dev::eth::HardwareCounters::tlbMisses},
+};
+
+int openEvent(const EventDefinition& definition, int groupFd)
+{
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = definition.type;
+    attr.config = definition.config;
+    attr.disabled = groupFd == -1 ? 1 : 0;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format =
+        PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // count the calling thread on any CPU
+    return static_cast<int>(syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0));
+}
+}  // namespace
+
+namespace dev
+{
+namespace eth
+{
+HardwareCounters& HardwareCounters::operator+=(const HardwareCounters& other)
+{
+    cycles += other.cycles;
+    instructions += other.instructions;
+    cacheMisses += other.cacheMisses;
+    branchMisses += other.branchMisses;
+    tlbMisses += other.tlbMisses;
+    return *this;
+}
+
+Json::Value HardwareCounters::toJson() const
+{
+    Json::Value root;
+    root["cycles"] = static_cast<Json::UInt64>(cycles);
+    root["instructions"] = static_cast<Json::UInt64>(instructions);
+    root["cache_misses"] = static_cast<Json::UInt64>(cacheMisses);
+    root["branch_misses"] = static_cast<Json::UInt64>(branchMisses);
+    root["tlb_misses"] = static_cast<Json::UInt64>(tlbMisses);
+    return root;
+}
+
+HardwareCounters HardwareCounters::fromJson(const Json::Value& root)
+{
+    HardwareCounters counters;
+    counters.cycles = root["cycles"].asUInt64();
+    counters.instructions = root["instructions"].asUInt64();
+    counters.cacheMisses = root["cache_misses"].asUInt64();
+    counters.branchMisses = root["branch_misses"].asUInt64();
+    counters.tlbMisses = root["tlb_misses"].asUInt64();
+    return counters;
+}
+
+
+HardwareCounterCollector::HardwareCounterCollector()
+{
+    int leaderFd = -1;
+    for (const auto& definition : eventDefinitions)
+    {
+        int fd = openEvent(definition, leaderFd);
+        if (fd == -1)
+        {
+            if (leaderFd == -1)
+            {
+                throw std::runtime_error(
+                    std::string("failed to open hardware counters: ") + std::strerror(errno));
+            }
+            continue;
+        }
+        if (leaderFd == -1)
+        {
+            leaderFd = fd;
+        }
+        m_counters.push_back(Counter{fd, definition.field});
+    }
+}
+
+HardwareCounterCollector::~HardwareCounterCollector()
+{
+    for (const auto& counter : m_counters)
+    {
+        close(counter.fd);
+    }
+}
+
+void HardwareCounterCollector::start()
+{
+    auto leaderFd = m_counters.front().fd;
+    ioctl(leaderFd, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP);
+    ioctl(leaderFd, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+}
+
+HardwareCounters HardwareCounterCollector::stop()
+{
+    auto leaderFd = m_counters.front().fd;
+    ioctl(leaderFd, PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP);
+
+    // layout for PERF_FORMAT_GROUP: nr, time_enabled, time_running, values[nr]
+    std::vector<uint64_t> values(3 + m_counters.size());
+    auto size = values.size() * sizeof(uint64_t);
+    if (read(leaderFd, values.data(), size) != static_cast<ssize_t>(size))
+    {
+        throw std::runtime_error(
+            std::string("failed to read hardware counters: ") + std::strerror(errno));
+    }
+
+    auto timeEnabled = values[1];
+    auto timeRunning = values[2];
+    HardwareCounters counters;
+    for (size_t i = 0; i < m_counters.size(); i++)
+    {
+        auto value = values[3 + i];
+        if (timeRunning > 0 && timeRunning < timeEnabled)
+        {
+            value = static_cast<uint64_t>(
+                static_cast<double>(value) * timeEnabled / timeRunning);
+        }
+        counters.*(m_counters[i].field) = value;
+    }
+    return counters;
+}
+
+HardwareCounterCollector& HardwareCounterCollector::threadCollector()
+{
+    static thread_local HardwareCounterCollector collector;
+    return collector;
+}
+
+void HardwareCounterCollector::checkAvailable()
+{
+    HardwareCounterCollector collector;
+}
+
+}  // namespace eth
+}  // namespace dev
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <json/json.h>
+
+namespace dev
+{
+namespace eth
+{
+/// Hardware events counted by `HardwareCounterCollector`, in user space only
+struct HardwareCounters
+{
+    uint64_t cycles = 0;
+    uint64_t instructions = 0;
+    uint64_t cacheMisses = 0;
+    uint64_t branchMisses = 0;
+    uint64_t tlbMisses = 0;
+
+    HardwareCounters& operator+=(const HardwareCounters& other);
+
+    Json::Value toJson() const;
+    static HardwareCounters fromJson(const Json::Value& root);
+};
+
+
+/// Counts hardware events of the calling thread using perf_event_open.
+/// All the events are opened as a single group so that they are scheduled together,
+/// and the values are scaled if the kernel had to multiplex the counters.
+/// Events which are not supported by the CPU (e.g. TLB misses on some virtual machines)
+/// are skipped and stay at 0.
+class HardwareCounterCollector
+{
+public:
+    /// Opens the counters, throws std::runtime_error if the CPU cycles cannot be counted
+    /// (e.g. when kernel.perf_event_paranoid is too restrictive)
+    HardwareCounterCollector();
+    ~HardwareCounterCollector();
+
+    HardwareCounterCollector(const HardwareCounterCollector&) = delete;
+    HardwareCounterCollector& operator=(const HardwareCounterCollector&) = delete;
+
+    /// Resets and starts the counters
+    void start();
+
+    /// Stops the counters and returns the events counted since `start`
+    HardwareCounters stop();
+
+    /// Collector of the calling thread, opened on first use.
+    /// The counters are bound to the thread which opened them
+    static HardwareCounterCollector& threadCollector();
+
+    /// Opens and closes the counters, so that their availability is checked when the options
+    /// are parsed rather than by the first execution. Throws std::runtime_error if they cannot
+    /// be opened
+    static void checkAvailable();
+
+private:
+    struct Counter
+    {
+        int fd;
+        uint64_t HardwareCounters::*field;
+    };
+
+    std::vector<Counter> m_counters;
+};
+
+}  // namespace eth
+}  // namespace dev
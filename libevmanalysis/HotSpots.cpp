@@ -0,0 +1,218 @@
+#include "HotSpots.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+#include <libevm/ExtVMFace.h>
+
+#include "InstructionSampler.h"
+
+namespace dev
+{
+namespace eth
+{
+namespace
+{
+std::string addressToString(const Address& address)
+{
+    return "0x" + address.hex();
+}
+
+std::string locationToString(const HotSpot& spot)
+{
+    return spot.location.codeHash.hex().substr(0, 8) + ":" + std::to_string(spot.location.pc) +
+           ":" + instructionInfo(spot.instruction).name;
+}
+}  // namespace
+
+constexpr size_t HotSpotProfiler::c_maxStacksPerSpot;
+
+Json::Value HotSpot::toJson() const
+{
+    Json::Value result;
+    result["code_hash"] = toHex(location.codeHash.ref());
+    result["pc"] = location.pc;
+    result["instruction"] = instructionInfo(instruction).name;
+    result["count"] = static_cast<Json::UInt64>(count);
+    result["time"] = static_cast<Json::UInt64>(time);
+    result["time_error"] = static_cast<Json::UInt64>(timeError);
+    result["gas"] = static_cast<Json::UInt64>(gas);
+    result["time/gas"] = timePerGas();
+    Json::Value addresses(Json::arrayValue);
+    std::set<Address> seen;
+    for (const auto& kv : stacks)
+    {
+        if (!kv.first.empty() && seen.insert(kv.first.back()).second)
+            addresses.append(addressToString(kv.first.back()));
+    }
+    result["addresses"] = addresses;
+    return result;
+}
+
+
+HotSpotProfiler::HotSpotProfiler(size_t capacity) : m_capacity(capacity)
+{
+    if (capacity == 0)
+        throw std::invalid_argument("the hot spots capacity must be at least 1");
+    m_spots.reserve(capacity);
+}
+
+void HotSpotProfiler::record(
+    const std::vector<HotSpotSample>& samples, const std::vector<CallStack>& stacks)
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    for (const auto& sample : samples)
+    {
+        m_totalTime += sample.time;
+        auto it = m_spots.find(sample.location);
+        if (it != m_spots.end())
+        {
+            m_byTime.erase({it->second.time, sample.location});
+        }
+        else
+        {
+            HotSpot spot;
+            spot.location = sample.location;
+            spot.instruction = sample.instruction;
+            if (m_spots.size() >= m_capacity)
+            {
+                // space-saving: the new location takes the place of the cheapest one
+                auto evicted = m_byTime.begin();
+                spot.time = evicted->first;
+                spot.timeError = evicted->first;
+                m_spots.erase(evicted->second);
+                m_byTime.erase(evicted);
+                m_evictionsCount++;
+            }
+            it = m_spots.emplace(sample.location, std::move(spot)).first;
+        }
+
+        auto& spot = it->second;
+        spot.count += sample.count;
+        spot.time += sample.time;
+        spot.gas += sample.gas;
+        const auto& stack = stacks.at(sample.stack);
+        auto stackIt = spot.stacks.find(stack);
+        if (stackIt != spot.stacks.end())
+            stackIt->second += sample.time;
+        else if (spot.stacks.size() < c_maxStacksPerSpot)
+            spot.stacks.emplace(stack, sample.time);
+        else
+            spot.stacks[CallStack()] += sample.time;
+        m_byTime.emplace(spot.time, sample.location);
+    }
+}
+
+uint64_t HotSpotProfiler::totalTime() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_totalTime;
+}
+
+uint64_t HotSpotProfiler::evictionsCount() const
+{
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_evictionsCount;
+}
+
+std::vector<HotSpot> HotSpotProfiler::spots() const
+{
+    std::vector<HotSpot> result;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        result.reserve(m_spots.size());
+        for (auto it = m_byTime.rbegin(); it != m_byTime.rend(); ++it)
+            result.push_back(m_spots.at(it->second));
+    }
+    return result;
+}
+
+void HotSpotProfiler::writeFoldedStacks(std::ostream& os, const std::vector<HotSpot>& spots)
+{
+    for (const auto& spot : spots)
+    {
+        auto location = locationToString(spot);
+        for (const auto& kv : spot.stacks)
+        {
+            if (kv.second == 0)
+                continue;
+            if (kv.first.empty())
+                os << "[other callers];";
+            for (const auto& address : kv.first)
+                os << addressToString(address) << ";";
+            os << location << " " << kv.second << "\n";
+        }
+    }
+}
+
+Json::Value HotSpotProfiler::toJson(const std::vector<HotSpot>& spots, size_t limit)
+{
+    Json::Value result(Json::arrayValue);
+    for (size_t i = 0; i < std::min(limit, spots.size()); i++)
+        result.append(spots[i].toJson());
+    return result;
+}
+
+
+void HotSpotTracer::onOp(
+    uint64_t steps, uint64_t pc, Instruction inst, const bigint& gasCost, ExtVMFace const* ext)
+{
+    auto now = CycleClock::now();
+    if (m_hasPending && now >= m_pending.start)
+    {
+        m_pending.sample->time += static_cast<uint64_t>(
+            std::max(static_cast<double>(now - m_pending.start) - m_probeOverheadCycles, 0.0));
+    }
+
+    // the stack only changes when a frame starts or returns
+    auto depth = ext->depth;
+    if (steps == 1 || !m_hasCurrentStack || m_callStack.size() != depth + 1)
+    {
+        m_callStack.resize(depth + 1);
+        m_callStack[depth] = ext->myAddress;
+        auto inserted = m_stackIds.emplace(m_callStack, m_stacks.size());
+        if (inserted.second)
+            m_stacks.push_back(m_callStack);
+        m_currentStack = inserted.first->second;
+        m_hasCurrentStack = true;
+    }
+
+    auto& sample = m_samples[SampleKey{CodeLocation{ext->codeHash, static_cast<uint32_t>(pc)},
+        m_currentStack}];
+    if (sample.count == 0)
+    {
+        sample.location = CodeLocation{ext->codeHash, static_cast<uint32_t>(pc)};
+        sample.instruction = inst;
+        sample.stack = m_currentStack;
+    }
+    sample.count++;
+    sample.gas += gasCost.convert_to<uint64_t>();
+    m_hasPending = true;
+    m_pending = PendingSample{&sample, CycleClock::now()};
+}
+
+void HotSpotTracer::flush()
+{
+    m_hasPending = false;
+    m_hasCurrentStack = false;
+    m_callStack.clear();
+    if (m_samples.empty())
+        return;
+
+    std::vector<HotSpotSample> samples;
+    samples.reserve(m_samples.size());
+    auto nanosecondsPerCycle = CycleClock::nanosecondsPerCycle();
+    for (auto& kv : m_samples)
+    {
+        kv.second.time = static_cast<uint64_t>(std::llround(kv.second.time * nanosecondsPerCycle));
+        samples.push_back(kv.second);
+    }
+    m_profiler.record(samples, m_stacks);
+    m_samples.clear();
+    m_stacks.clear();
+    m_stackIds.clear();
+}
+
+}  // namespace eth
+}  // namespace dev
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <json/json.h>
+
+#include <libdevcore/Address.h>
+#include <libdevcore/Common.h>
+#include <libdevcore/FixedHash.h>
+#include <libevm/Instruction.h>
+
+namespace dev
+{
+namespace eth
+{
+class ExtVMFace;
+
+/// Position of an instruction in a code
+struct CodeLocation
+{
+    h256 codeHash;
+    uint32_t pc = 0;
+
+    bool operator<(const CodeLocation& other) const
+    {
+        return std::tie(codeHash, pc) < std::tie(other.codeHash, other.pc);
+    }
+    bool operator==(const CodeLocation& other) const
+    {
+        return codeHash == other.codeHash && pc == other.pc;
+    }
+};
+
+struct CodeLocationHash
+{
+    size_t operator()(const CodeLocation& location) const
+    {
+        return std::hash<h256>()(location.codeHash) ^ (location.pc * 0x9e3779b97f4a7c15ULL);
+    }
+};
+
+/// Contracts addresses of the call frames leading to an instruction, outermost first
+using CallStack = std::vector<Address>;
+
+/// Accumulated cost of the executions of an instruction at a code location
+struct HotSpot
+{
+    CodeLocation location;
+    Instruction instruction = Instruction::STOP;
+    uint64_t count = 0;
+    /// nanoseconds, includes `timeError`
+    uint64_t time = 0;
+    /// time of the evicted location this one replaced, upper bound of the over-estimation of
+    /// `time`
+    uint64_t timeError = 0;
+    uint64_t gas = 0;
+    /// time recorded per call stack since the location is tracked, the stacks beyond
+    /// `HotSpotProfiler::c_maxStacksPerSpot` are merged under an empty stack
+    std::map<CallStack, uint64_t> stacks;
+
+    double timePerGas() const { return gas == 0 ? 0 : static_cast<double>(time) / gas; }
+    Json::Value toJson() const;
+};
+
+/// Executions of an instruction at a code location during a transaction, called from the
+/// stack `stack` of `HotSpotTracer::stacks()`
+struct HotSpotSample
+{
+    CodeLocation location;
+    Instruction instruction = Instruction::STOP;
+    uint32_t stack = 0;
+    uint64_t count = 0;
+    uint64_t time = 0;
+    uint64_t gas = 0;
+};
+
+/// Code locations taking the most time across the executed transactions, kept in a bounded
+/// space-saving summary: when the summary is full, a new location replaces the one with the
+/// least time and inherits its time, so that every location with more than
+/// `totalTime / capacity` nanoseconds is guaranteed to be tracked. Thread-safe
+class HotSpotProfiler
+{
+public:
+    /// call stacks kept per location
+    static constexpr size_t c_maxStacksPerSpot = 8;
+
+    /// Tracks up to `capacity` locations, throws std::invalid_argument if it is 0
+    explicit HotSpotProfiler(size_t capacity = 10000);
+
+    /// Adds the samples of a transaction, `stacks` are the call stacks they refer to
+    void record(const std::vector<HotSpotSample>& samples, const std::vector<CallStack>& stacks);
+
+    size_t capacity() const { return m_capacity; }
+    /// nanoseconds recorded, including the ones of evicted locations
+    uint64_t totalTime() const;
+    uint64_t evictionsCount() const;
+
+    /// Copy of the tracked locations, the most expensive first
+    std::vector<HotSpot> spots() const;
+
+    /// Folded stacks as read by flamegraph.pl and speedscope: one line per location and call
+    /// stack, `0x<address>;...;<code hash prefix>:<pc>:<instruction> <nanoseconds>`
+    static void writeFoldedStacks(std::ostream& os, const std::vector<HotSpot>& spots);
+    /// The `limit` first locations of `spots` with their time per gas
+    static Json::Value toJson(const std::vector<HotSpot>& spots, size_t limit = 1000);
+
+private:
+    size_t m_capacity;
+    mutable std::mutex m_mutex;
+    std::unordered_map<CodeLocation, HotSpot, CodeLocationHash> m_spots;
+    /// tracked locations by time, the first one is evicted next
+    std::set<std::pair<uint64_t, CodeLocation>> m_byTime;
+    uint64_t m_totalTime = 0;
+    uint64_t m_evictionsCount = 0;
+};
+
+/// Attributes the time between two instructions of a transaction, nested calls included,
+/// to the first one and aggregates them per code location and call stack. The samples are
+/// added to the profiler when the tracer is flushed or destroyed, so that the profiler is only
+/// locked once per transaction
+class HotSpotTracer
+{
+public:
+    /// `probeOverheadCycles` is subtracted from every measurement
+    /// (see `InstructionSampling::probeOverheadCycles`)
+    HotSpotTracer(HotSpotProfiler& profiler, double probeOverheadCycles)
+      : m_profiler(profiler), m_probeOverheadCycles(probeOverheadCycles)
+    {}
+    ~HotSpotTracer() { flush(); }
+
+    HotSpotTracer(const HotSpotTracer&) = delete;
+    HotSpotTracer& operator=(const HotSpotTracer&) = delete;
+
+    /// To be called before each instruction
+    void onOp(uint64_t steps, uint64_t pc, Instruction inst, const bigint& gasCost,
+        ExtVMFace const* ext);
+
+    /// Adds the samples to the profiler. The last instruction executed is counted but not
+    /// timed, its duration would include the end of the transaction
+    void flush();
+
+private:
+    struct SampleKey
+    {
+        CodeLocation location;
+        uint32_t stack;
+
+        bool operator==(const SampleKey& other) const
+        {
+            return location == other.location && stack == other.stack;
+        }
+    };
+    struct SampleKeyHash
+    {
+        size_t operator()(const SampleKey& key) const
+        {
+            return CodeLocationHash()(key.location) ^ (key.stack * 0x85ebca6bULL);
+        }
+    };
+    struct PendingSample
+    {
+        HotSpotSample* sample;
+        uint64_t start;
+    };
+
+    HotSpotProfiler& m_profiler;
+    double m_probeOverheadCycles;
+
+    /// `time` is counted in cycles until the flush
+    std::unordered_map<SampleKey, HotSpotSample, SampleKeyHash> m_samples;
+    std::vector<CallStack> m_stacks;
+    std::map<CallStack, uint32_t> m_stackIds;
+
+    /// addresses of the frames of the current instruction, indexed by depth
+    CallStack m_callStack;
+    uint32_t m_currentStack = 0;
+    bool m_hasCurrentStack = false;
+
+    /// sample of the previous instruction, waiting for its duration
+    bool m_hasPending = false;
+    PendingSample m_pending{nullptr, 0};
+};
+
+}  // namespace eth
+}  // namespace dev
@@ -0,0 +1,308 @@
+#include "InstructionHistograms.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <unordered_map>
+
+namespace dev
+{
+namespace eth
+{
+namespace
+{
+/// Only the owning thread writes to the counters, no read-modify-write instruction is needed
+template <typename T>
+void addRelaxed(std::atomic<T>& counter, T value)
+{
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+unsigned mostSignificantBit(uint64_t value)
+{
+    return 63 - __builtin_clzll(value);
+}
+
+double variance(double sum, double squaresSum, uint64_t count)
+{
+    if (count == 0)
+        return 0;
+    auto mean = sum / count;
+    return std::max(squaresSum / count - mean * mean, 0.0);
+}
+
+std::atomic<uint64_t> nextHistogramsId{0};
+}  // namespace
+
+constexpr unsigned LatencyHistogram::precisionBits;
+constexpr unsigned LatencyHistogram::maxValueBits;
+constexpr size_t LatencyHistogram::bucketsCount;
+constexpr size_t InstructionHistograms::instructionsCount;
+
+size_t LatencyHistogram::bucketIndex(uint64_t value)
+{
+    if (value < (uint64_t(1) << precisionBits))
+        return value;
+    auto msb = mostSignificantBit(value);
+    if (msb >= maxValueBits)
+        return bucketsCount - 1;
+    auto shift = msb - precisionBits;
+    return (static_cast<size_t>(shift) << precisionBits) + (value >> shift);
+}
+
+uint64_t LatencyHistogram::bucketLowerBound(size_t index)
+{
+    if (index < (size_t(1) << precisionBits))
+        return index;
+    auto shift = (index >> precisionBits) - 1;
+    auto subBucket = index & ((size_t(1) << precisionBits) - 1);
+    return ((uint64_t(1) << precisionBits) + subBucket) << shift;
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t index)
+{
+    if (index + 1 == bucketsCount)
+        return std::numeric_limits<uint64_t>::max();
+    return bucketLowerBound(index + 1) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value, uint64_t count)
+{
+    m_buckets[bucketIndex(value)] += count;
+    m_count += count;
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other)
+{
+    for (size_t i = 0; i < bucketsCount; i++)
+        m_buckets[i] += other.m_buckets[i];
+    m_count += other.m_count;
+}
+
+uint64_t LatencyHistogram::valueAtPercentile(double percentile) const
+{
+    if (m_count == 0)
+        return 0;
+    auto rank = static_cast<uint64_t>(std::ceil(percentile / 100 * m_count));
+    rank = std::min(std::max(rank, uint64_t(1)), m_count);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < bucketsCount; i++)
+    {
+        seen += m_buckets[i];
+        if (seen >= rank)
+        {
+            auto lower = bucketLowerBound(i);
+            if (i + 1 == bucketsCount)
+                return lower;
+            return lower + (bucketUpperBound(i) - lower) / 2;
+        }
+    }
+    return bucketLowerBound(bucketsCount - 1);
+}
+
+Json::Value LatencyHistogram::toJson() const
+{
+    Json::Value result(Json::arrayValue);
+    for (size_t i = 0; i < bucketsCount; i++)
+    {
+        if (m_buckets[i] == 0)
+            continue;
+        Json::Value bucket(Json::arrayValue);
+        bucket.append(static_cast<Json::UInt64>(bucketLowerBound(i)));
+        bucket.append(static_cast<Json::UInt64>(bucketUpperBound(i)));
+        bucket.append(static_cast<Json::UInt64>(m_buckets[i]));
+        result.append(bucket);
+    }
+    return result;
+}
+
+
+double InstructionTimings::timeMean() const
+{
+    return count == 0 ? 0 : timeSum / count;
+}
+
+double InstructionTimings::timeVariance() const
+{
+    return variance(timeSum, timeSquaresSum, count);
+}
+
+double InstructionTimings::gasMean() const
+{
+    return count == 0 ? 0 : gasSum / count;
+}
+
+double InstructionTimings::gasVariance() const
+{
+    return variance(gasSum, gasSquaresSum, count);
+}
+
+void InstructionTimings::merge(const InstructionTimings& other)
+{
+    if (other.count == 0)
+        return;
+    minTime = count == 0 ? other.minTime : std::min(minTime, other.minTime);
+    maxTime = std::max(maxTime, other.maxTime);
+    histogram.merge(other.histogram);
+    count += other.count;
+    timeSum += other.timeSum;
+    timeSquaresSum += other.timeSquaresSum;
+    gasSum += other.gasSum;
+    gasSquaresSum += other.gasSquaresSum;
+}
+
+Json::Value InstructionTimings::toJson(bool full) const
+{
+    Json::Value result;
+    result["count"] = static_cast<Json::UInt64>(count);
+    result["timeMean"] = timeMean();
+    result["timeVariance"] = timeVariance();
+    result["timeStdev"] = std::sqrt(timeVariance());
+    result["timeMin"] = static_cast<Json::UInt64>(minTime);
+    result["timeMax"] = static_cast<Json::UInt64>(maxTime);
+    result["timeP50"] = static_cast<Json::UInt64>(histogram.valueAtPercentile(50));
+    result["timeP99"] = static_cast<Json::UInt64>(histogram.valueAtPercentile(99));
+    result["timeP999"] = static_cast<Json::UInt64>(histogram.valueAtPercentile(99.9));
+    result["gasMean"] = gasMean();
+    result["gasStdev"] = std::sqrt(gasVariance());
+    result["throughputMean"] = timeSum > 0 ? gasSum / timeSum : 0;
+    if (full)
+        result["histogram"] = histogram.toJson();
+    return result;
+}
+
+
+InstructionHistograms::ThreadHistograms::~ThreadHistograms()
+{
+    for (auto& entry : m_entries)
+        delete entry.load();
+}
+
+void InstructionHistograms::ThreadHistograms::record(
+    ExtendedInstruction instruction, uint64_t nanoseconds, double gas)
+{
+    auto index = static_cast<size_t>(instruction);
+    if (index >= instructionsCount)
+        return;
+    auto entry = m_entries[index].load(std::memory_order_relaxed);
+    if (entry == nullptr)
+    {
+        // value-initialized, all the counters start at 0
+        entry = new Entry();
+        entry->minTime.store(std::numeric_limits<uint64_t>::max(), std::memory_order_relaxed);
+        m_entries[index].store(entry, std::memory_order_release);
+    }
+
+    addRelaxed(entry->buckets[LatencyHistogram::bucketIndex(nanoseconds)], uint64_t(1));
+    addRelaxed(entry->count, uint64_t(1));
+    if (nanoseconds < entry->minTime.load(std::memory_order_relaxed))
+        entry->minTime.store(nanoseconds, std::memory_order_relaxed);
+    if (nanoseconds > entry->maxTime.load(std::memory_order_relaxed))
+        entry->maxTime.store(nanoseconds, std::memory_order_relaxed);
+    auto time = static_cast<double>(nanoseconds);
+    addRelaxed(entry->timeSum, time);
+    addRelaxed(entry->timeSquaresSum, time * time);
+    addRelaxed(entry->gasSum, gas);
+    addRelaxed(entry->gasSquaresSum, gas * gas);
+}
+
+void InstructionHistograms::ThreadHistograms::collect(
+    size_t index, InstructionTimings& timings) const
+{
+    auto entry = m_entries[index].load(std::memory_order_acquire);
+    if (entry == nullptr)
+        return;
+
+    InstructionTimings threadTimings;
+    for (size_t i = 0; i < LatencyHistogram::bucketsCount; i++)
+    {
+        auto count = entry->buckets[i].load(std::memory_order_relaxed);
+        if (count > 0)
+            threadTimings.histogram.record(LatencyHistogram::bucketLowerBound(i), count);
+    }
+    // the counters may be updated while they are read, the histogram is the reference
+    threadTimings.count = threadTimings.histogram.count();
+    threadTimings.minTime = entry->minTime.load(std::memory_order_relaxed);
+    threadTimings.maxTime = entry->maxTime.load(std::memory_order_relaxed);
+    threadTimings.timeSum = entry->timeSum.load(std::memory_order_relaxed);
+    threadTimings.timeSquaresSum = entry->timeSquaresSum.load(std::memory_order_relaxed);
+    threadTimings.gasSum = entry->gasSum.load(std::memory_order_relaxed);
+    threadTimings.gasSquaresSum = entry->gasSquaresSum.load(std::memory_order_relaxed);
+    timings.merge(threadTimings);
+}
+
+
+InstructionHistograms::InstructionHistograms() : m_id(nextHistogramsId++) {}
+
+InstructionHistograms::ThreadHistograms& InstructionHistograms::local()
+{
+    thread_local std::unordered_map<uint64_t, ThreadHistograms*> threadHistograms;
+    auto it = threadHistograms.find(m_id);
+    if (it != threadHistograms.end())
+        return *it->second;
+
+    std::lock_guard<std::mutex> lock(m_threadsMutex);
+    m_threads.emplace_back(new ThreadHistograms());
+    threadHistograms[m_id] = m_threads.back().get();
+    return *m_threads.back();
+}
+
+uint64_t InstructionHistograms::totalCount() const
+{
+    std::lock_guard<std::mutex> lock(m_threadsMutex);
+    uint64_t total = 0;
+    for (const auto& thread : m_threads)
+    {
+        for (const auto& entry : thread->m_entries)
+        {
+            if (auto e = entry.load(std::memory_order_acquire))
+                total += e->count.load(std::memory_order_relaxed);
+        }
+    }
+    return total;
+}
+
+size_t InstructionHistograms::threadsCount() const
+{
+    std::lock_guard<std::mutex> lock(m_threadsMutex);
+    return m_threads.size();
+}
+
+std::map<ExtendedInstruction, InstructionTimings> InstructionHistograms::timings() const
+{
+    std::lock_guard<std::mutex> lock(m_threadsMutex);
+    std::map<ExtendedInstruction, InstructionTimings> result;
+    for (size_t index = 0; index < instructionsCount; index++)
+    {
+        InstructionTimings timings;
+        for (const auto& thread : m_threads)
+            thread->collect(index, timings);
+        if (timings.count > 0)
+            result.emplace(static_cast<ExtendedInstruction>(index), std::move(timings));
+    }
+    return result;
+}
+
+Json::Value InstructionHistograms::toJson(bool full) const
+{
+    return toJson(timings(), threadsCount(), full);
+}
+
+Json::Value InstructionHistograms::toJson(
+    const std::map<ExtendedInstruction, InstructionTimings>& timings, size_t threadsCount, bool full)
+{
+    Json::Value result;
+    uint64_t totalCount = 0;
+    result["stats"] = Json::Value(Json::objectValue);
+    for (const auto& kv : timings)
+    {
+        totalCount += kv.second.count;
+        result["stats"][instructionName(kv.first)] = kv.second.toJson(full);
+    }
+    result["total_count"] = static_cast<Json::UInt64>(totalCount);
+    result["threads"] = static_cast<Json::UInt64>(threadsCount);
+    return result;
+}
+
+}  // namespace eth
+}  // namespace dev
@@ -0,0 +1,158 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <json/json.h>
+
+#include <libevmanalysis/ExtendedInstruction.h>
+
+namespace dev
+{
+namespace eth
+{
+/// Log-linear (HDR-style) histogram of latencies in nanoseconds. Values below
+/// 2^precisionBits have their own bucket, each larger power of two is split in
+/// 2^precisionBits buckets, so that a bucket is at most 1/2^precisionBits of its values wide.
+/// Values of 2^maxValueBits (about a minute) and more are counted in the last bucket
+class LatencyHistogram
+{
+public:
+    static constexpr unsigned precisionBits = 5;
+    static constexpr unsigned maxValueBits = 36;
+    static constexpr size_t bucketsCount = (maxValueBits - precisionBits + 1) << precisionBits;
+
+    static size_t bucketIndex(uint64_t value);
+    /// Smallest and largest values counted in the bucket `index`
+    static uint64_t bucketLowerBound(size_t index);
+    static uint64_t bucketUpperBound(size_t index);
+
+    void record(uint64_t value, uint64_t count = 1);
+    void merge(const LatencyHistogram& other);
+
+    uint64_t count() const { return m_count; }
+    uint64_t bucketCount(size_t index) const { return m_buckets[index]; }
+
+    /// Middle of the bucket containing the value at `percentile` (between 0 and 100),
+    /// 0 if the histogram is empty
+    uint64_t valueAtPercentile(double percentile) const;
+
+    /// Non-empty buckets as [lower bound, upper bound, count] arrays
+    Json::Value toJson() const;
+
+private:
+    std::array<uint64_t, bucketsCount> m_buckets{};
+    uint64_t m_count = 0;
+};
+
+/// Time and gas of the executions of one instruction, merged from all the threads
+struct InstructionTimings
+{
+    LatencyHistogram histogram;
+    uint64_t count = 0;
+    uint64_t minTime = 0;
+    uint64_t maxTime = 0;
+    double timeSum = 0;
+    double timeSquaresSum = 0;
+    double gasSum = 0;
+    double gasSquaresSum = 0;
+
+    double timeMean() const;
+    double timeVariance() const;
+    double gasMean() const;
+    double gasVariance() const;
+
+    void merge(const InstructionTimings& other);
+
+    /// `full` adds the non-empty buckets of the histogram
+    Json::Value toJson(bool full = false) const;
+};
+
+/// Per-instruction latency histograms and gas sums of every executed instruction.
+/// Each thread records in its own fixed-size table indexed by the instruction, so recording
+/// costs a few relaxed stores and no lookup or lock; the tables are only merged when the
+/// results are read. The memory used is bounded by the number of instructions and threads
+/// and does not grow with the number of measurements.
+class InstructionHistograms
+{
+public:
+    static constexpr size_t instructionsCount =
+        static_cast<size_t>(ExtendedInstruction::PRECOMPILED_RIPEMD160) + 1;
+
+    /// Table of the measurements of one thread. Only the owning thread writes to it,
+    /// the counters are atomics so that they can be read while they are updated
+    class ThreadHistograms
+    {
+    public:
+        ThreadHistograms() = default;
+        ~ThreadHistograms();
+
+        ThreadHistograms(const ThreadHistograms&) = delete;
+        ThreadHistograms& operator=(const ThreadHistograms&) = delete;
+
+        void record(ExtendedInstruction instruction, uint64_t nanoseconds, double gas);
+
+    private:
+        friend class InstructionHistograms;
+
+        struct Entry
+        {
+            std::array<std::atomic<uint64_t>, LatencyHistogram::bucketsCount> buckets;
+            std::atomic<uint64_t> count;
+            std::atomic<uint64_t> minTime;
+            std::atomic<uint64_t> maxTime;
+            std::atomic<double> timeSum;
+            std::atomic<double> timeSquaresSum;
+            std::atomic<double> gasSum;
+            std::atomic<double> gasSquaresSum;
+        };
+
+        /// allocated on the first execution of the instruction by the thread
+        std::array<std::atomic<Entry*>, instructionsCount> m_entries{};
+
+        void collect(size_t index, InstructionTimings& timings) const;
+    };
+
+    InstructionHistograms();
+
+    InstructionHistograms(const InstructionHistograms&) = delete;
+    InstructionHistograms& operator=(const InstructionHistograms&) = delete;
+
+    /// Table of the calling thread, created on the first call. The reference stays valid
+    /// as long as this object, callers recording many measurements should keep it
+    ThreadHistograms& local();
+
+    void record(ExtendedInstruction instruction, uint64_t nanoseconds, double gas)
+    {
+        local().record(instruction, nanoseconds, gas);
+    }
+
+    uint64_t totalCount() const;
+    size_t threadsCount() const;
+
+    /// Measurements of every executed instruction merged from all the threads
+    std::map<ExtendedInstruction, InstructionTimings> timings() const;
+
+    /// `full` adds the non-empty buckets of the histograms
+    Json::Value toJson(bool full = false) const;
+    /// Same as `toJson` from merged timings, so that they can be serialised on another thread
+    static Json::Value toJson(const std::map<ExtendedInstruction, InstructionTimings>& timings,
+        size_t threadsCount, bool full = false);
+
+private:
+    /// identifies this object in the thread-local tables of the threads, unlike its address
+    /// it is never reused
+    const uint64_t m_id;
+    mutable std::mutex m_threadsMutex;
+    std::vector<std::unique_ptr<ThreadHistograms>> m_threads;
+};
+
+using InstructionsBenchmark = InstructionHistograms;
+
+}  // namespace eth
+}  // namespace dev
@@ -0,0 +1,61 @@
+#include "InstructionSampler.h"
+
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+
+namespace dev
+{
+namespace eth
+{
+namespace
+{
+double calibrateCycleClock()
+{
+    using Clock = std::chrono::steady_clock;
+    auto startTime = Clock::now();
+    auto startCycles = CycleClock::now();
+    auto endTime = startTime;
+    while (endTime - startTime < std::chrono::milliseconds(20))
+        endTime = Clock::now();
+    auto endCycles = CycleClock::now();
+    auto nanoseconds =
+        std::chrono::duration_cast<std::chrono::nanoseconds>(endTime - startTime).count();
+    return static_cast<double>(nanoseconds) / (endCycles - startCycles);
+}
+}  // namespace
+
+double CycleClock::nanosecondsPerCycle()
+{
+    static double const nanosecondsPerCycle = calibrateCycleClock();
+    return nanosecondsPerCycle;
+}
+
+InstructionSampler::InstructionSampler(const InstructionSampling& sampling)
+  : m_sampling(sampling),
+    m_nanosecondsPerCycle(CycleClock::nanosecondsPerCycle()),
+    m_random(static_cast<std::minstd_rand::result_type>(CycleClock::now()))
+{
+    if (sampling.interval == 0)
+        throw std::invalid_argument("the sampling interval must be at least 1");
+    m_countdown = nextInterval();
+}
+
+uint64_t InstructionSampler::lastNanoseconds() const
+{
+    auto cycles = static_cast<double>(m_lastCycles) - m_sampling.probeOverheadCycles;
+    if (cycles <= 0)
+        return 0;
+    return static_cast<uint64_t>(std::llround(cycles * m_nanosecondsPerCycle));
+}
+
+uint64_t InstructionSampler::nextInterval()
+{
+    if (!m_sampling.randomized || m_sampling.interval == 1)
+        return m_sampling.interval;
+    std::uniform_int_distribution<uint64_t> distribution(1, 2 * m_sampling.interval - 1);
+    return distribution(m_random);
+}
+
+}  // namespace eth
+}  // namespace dev
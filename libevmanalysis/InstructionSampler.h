@@ -0,0 +1,108 @@
+#pragma once
+
+#include <cstdint>
+#include <random>
+#include <string>
+
+#include <time.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace dev
+{
+namespace eth
+{
+/// Time stamp counter of the CPU, read with rdtscp so that the instructions before the probe
+/// are completed. Falls back to CLOCK_MONOTONIC (one cycle per nanosecond) on other
+/// architectures
+class CycleClock
+{
+public:
+    static uint64_t now()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        unsigned int aux;
+        return __rdtscp(&aux);
+#else
+        timespec time;
+        clock_gettime(CLOCK_MONOTONIC, &time);
+        return static_cast<uint64_t>(time.tv_sec) * 1000000000 + time.tv_nsec;
+#endif
+    }
+
+    /// Measured against the steady clock the first time it is called (takes about 20ms)
+    static double nanosecondsPerCycle();
+};
+
+/// Which instructions are timed and how the measurements are corrected
+struct InstructionSampling
+{
+    /// one instruction out of `interval` is timed, 1 times all of them
+    uint64_t interval = 1;
+    /// draws the number of instructions between two samples uniformly in
+    /// [1, 2 * interval - 1] so that the samples do not follow loops in the contracts
+    bool randomized = false;
+    /// cycles measured by an empty sample, subtracted from every sample
+    double probeOverheadCycles = 0;
+};
+
+/// Times the instructions selected by an `InstructionSampling`, `start` and `stop` are called
+/// by the VM probes before and after each instruction. Not thread-safe, an executive owns one
+class InstructionSampler
+{
+public:
+    InstructionSampler() : InstructionSampler(InstructionSampling()) {}
+    explicit InstructionSampler(const InstructionSampling& sampling);
+
+    void start()
+    {
+        if (--m_countdown > 0)
+        {
+            // the previous instruction may have been interrupted before its stop
+            m_active = false;
+            return;
+        }
+        m_countdown = nextInterval();
+        m_active = true;
+        m_start = CycleClock::now();
+    }
+
+    /// Returns true if the instruction which just executed was sampled
+    bool stop()
+    {
+        auto end = CycleClock::now();
+        if (!m_active)
+            return false;
+        m_active = false;
+        // the thread moved to a core whose counter is behind
+        if (end < m_start)
+            return false;
+        m_lastCycles = end - m_start;
+        return true;
+    }
+
+    /// Cycles of the last sample, including the probe overhead
+    uint64_t lastCycles() const { return m_lastCycles; }
+
+    /// Duration of the last sample without the probe overhead
+    uint64_t lastNanoseconds() const;
+
+    const InstructionSampling& sampling() const { return m_sampling; }
+
+private:
+    InstructionSampling m_sampling;
+    double m_nanosecondsPerCycle;
+    std::minstd_rand m_random;
+
+    uint64_t m_countdown = 1;
+    bool m_active = false;
+    uint64_t m_start = 0;
+    uint64_t m_lastCycles = 0;
+
+    uint64_t nextInterval();
+};
+
+}  // namespace eth
+}  // namespace dev
@@ -1,5 +1,8 @@
 #include "InstructionStats.h"
 
+#include <algorithm>
+#include <stdexcept>
+
 
 namespace dev
 {
@@ -48,43 +51,69 @@ void InstructionStats::recordInstruction(ExtendedInstruction einstruction)
     m_instructionCounts[std::move(einstruction)]++;
 }
 
+void InstructionStats::recordBigram(Instruction instruction, uint64_t pc, unsigned depth)
+{
+    // the jumps pre-verified by the optimizations of the legacy VM count as the ones they replace
+    if (instruction == Instruction::JUMPC)
+        instruction = Instruction::JUMP;
+    else if (instruction == Instruction::JUMPCI)
+        instruction = Instruction::JUMPI;
 
-Json::Value InstructionStats::toJson() const
+    // jumps and calls break the sequences, as well as the returns to the caller
+    if (m_hasPrevious && pc == m_nextPC && depth == m_previousDepth)
+        m_bigramCounts[std::make_pair(m_previousInstruction, instruction)]++;
+
+    uint64_t size = 1;
+    if (instruction >= Instruction::PUSH1 && instruction <= Instruction::PUSH32)
+        size += static_cast<uint64_t>(instruction) - static_cast<uint64_t>(Instruction::PUSH1) + 1;
+    m_previousInstruction = instruction;
+    m_nextPC = pc + size;
+    m_previousDepth = depth;
+    m_hasPrevious = true;
+}
+
+
+InstructionStats::Summary InstructionStats::summary() const
 {
-    uint64_t changesCount = 0;
-    uint64_t writesCount = 0;
-    uint64_t readsCount = 0;
-    uint64_t storageAllocated = 0;
+    Summary summary;
     for (auto& changeKv : m_changes)
     {
         auto& change = changeKv.second;
-        changesCount += change.changesCount;
-        writesCount += change.writesCount;
-        readsCount += change.readsCount;
+        summary.storageChangesCount += change.changesCount;
+        summary.storageWritesCount += change.writesCount;
+        summary.storageReadsCount += change.readsCount;
         if (change.initialValue == 0 && change.newValue != 0)
         {
-            storageAllocated++;
+            summary.storageAllocated++;
         }
         else if (change.initialValue != 0 && change.newValue == 0)
         {
-            storageAllocated--;
+            summary.storageAllocated--;
         }
     }
 
-    uint64_t creationSize = 0;
+    summary.contractsCreationCount = m_createCalls.size();
     for (const u256& size : m_createCalls)
     {
-        creationSize += size.convert_to<uint64_t>();
+        summary.contractsCreationSize += size.convert_to<uint64_t>();
     }
+    summary.suicideCount = m_suicideCallsCount;
+    return summary;
+}
+
+
+Json::Value InstructionStats::toJson() const
+{
+    auto stats = summary();
 
     Json::Value result;
-    result["storage.changesCount"] = changesCount;
-    result["storage.writesCount"] = writesCount;
-    result["storage.readsCount"] = readsCount;
-    result["storage.allocated"] = storageAllocated;
-    result["contracts.creationCount"] = m_createCalls.size();
-    result["contracts.creationSize"] = creationSize;
-    result["suicideCount"] = m_suicideCallsCount;
+    result["storage.changesCount"] = stats.storageChangesCount;
+    result["storage.writesCount"] = stats.storageWritesCount;
+    result["storage.readsCount"] = stats.storageReadsCount;
+    result["storage.allocated"] = stats.storageAllocated;
+    result["contracts.creationCount"] = stats.contractsCreationCount;
+    result["contracts.creationSize"] = stats.contractsCreationSize;
+    result["suicideCount"] = stats.suicideCount;
 
     result["calls"] = Json::Value();
     for (auto& kv : m_instructionCounts)
@@ -93,6 +122,50 @@ Json::Value InstructionStats::toJson() const
         result["calls"][name] = kv.second;
     }
 
+    result["bigrams"] = Json::Value(Json::objectValue);
+    for (auto& kv : m_bigramCounts)
+    {
+        auto name = std::string(instructionInfo(kv.first.first).name) + " " +
+                    instructionInfo(kv.first.second).name;
+        result["bigrams"][name] = kv.second;
+    }
+
+    return result;
+}
+
+std::map<std::string, uint64_t> readBigramCounts(std::istream& measurements)
+{
+    std::map<std::string, uint64_t> counts;
+    Json::Reader reader;
+    std::string line;
+    while (std::getline(measurements, line))
+    {
+        if (line.empty())
+            continue;
+        Json::Value root;
+        if (!reader.parse(line, root))
+            throw std::invalid_argument("invalid JSON line: " + reader.getFormattedErrorMessages());
+        const auto& bigrams = root["instructions"]["bigrams"];
+        if (!bigrams.isObject())
+            continue;
+        for (auto it = bigrams.begin(); it != bigrams.end(); ++it)
+            counts[it.key().asString()] += it->asUInt64();
+    }
+    return counts;
+}
+
+std::vector<std::string> mostFrequentBigrams(
+    const std::map<std::string, uint64_t>& bigramCounts, size_t count)
+{
+    std::vector<std::pair<std::string, uint64_t>> bigrams(bigramCounts.begin(), bigramCounts.end());
+    // ties are kept in the order of the names so that the result is deterministic
+    std::stable_sort(bigrams.begin(), bigrams.end(),
+        [](const std::pair<std::string, uint64_t>& a, const std::pair<std::string, uint64_t>& b) {
+            return a.second > b.second;
+        });
+    std::vector<std::string> result;
+    for (size_t i = 0; i < std::min(count, bigrams.size()); i++)
+        result.push_back(bigrams[i].first);
     return result;
 }
 
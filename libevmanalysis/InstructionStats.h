@@ -1,6 +1,9 @@
 #pragma once
 
+#include <istream>
 #include <map>
+#include <string>
+#include <vector>
 
 #include <json/json.h>
 
@@ -27,12 +30,37 @@ struct StoreKeyStats
 class InstructionStats
 {
 public:
+    /// Totals of the storage and contracts operations
+    struct Summary
+    {
+        uint64_t storageChangesCount = 0;
+        uint64_t storageWritesCount = 0;
+        uint64_t storageReadsCount = 0;
+        uint64_t storageAllocated = 0;
+        uint64_t contractsCreationCount = 0;
+        uint64_t contractsCreationSize = 0;
+        uint64_t suicideCount = 0;
+    };
+
     void recordWrite(
         const u256& key, u256 originalValue, const u256& currentValue, const u256& newValue);
     void recordRead(const u256& key);
     void recordCreate(const u256& size);
     void recordSuicide();
     void recordInstruction(ExtendedInstruction instruction);
+    /// Counts the pair formed with the previous instruction if `instruction`, at `pc` in a call
+    /// of depth `depth`, directly follows it in the code
+    void recordBigram(Instruction instruction, uint64_t pc, unsigned depth);
+
+    Summary summary() const;
+    const std::map<ExtendedInstruction, uint64_t>& instructionCounts() const
+    {
+        return m_instructionCounts;
+    }
+    const std::map<std::pair<Instruction, Instruction>, uint64_t>& bigramCounts() const
+    {
+        return m_bigramCounts;
+    }
 
     Json::Value toJson() const;
 
@@ -41,7 +69,21 @@ private:
     std::vector<u256> m_createCalls;
     uint64_t m_suicideCallsCount = 0;
     std::map<ExtendedInstruction, uint64_t> m_instructionCounts;
+    std::map<std::pair<Instruction, Instruction>, uint64_t> m_bigramCounts;
+    /// previous instruction recorded by recordBigram and the position of the one following it
+    Instruction m_previousInstruction = Instruction::STOP;
+    uint64_t m_nextPC = 0;
+    unsigned m_previousDepth = 0;
+    bool m_hasPrevious = false;
 };
 
+/// Sums the `instructions.bigrams` of transaction measurements written as JSON lines
+std::map<std::string, uint64_t> readBigramCounts(std::istream& measurements);
+
+/// The `count` most frequent bigrams of `bigramCounts`, most frequent first, the candidates of
+/// the superinstructions of the interpreter (see its `superinstruction-bigrams` option)
+std::vector<std::string> mostFrequentBigrams(
+    const std::map<std::string, uint64_t>& bigramCounts, size_t count);
+
 }  // namespace eth
 }  // namespace dev
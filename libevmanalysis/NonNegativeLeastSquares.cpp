@@ -0,0 +1,172 @@
+#include "NonNegativeLeastSquares.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+namespace dev
+{
+namespace eth
+{
+namespace
+{
+/// Solves the square system `matrix` x = `vector` with Gaussian elimination and partial pivoting
+std::vector<double> solve(std::vector<std::vector<double>> matrix, std::vector<double> vector)
+{
+    auto n = vector.size();
+    for (size_t column = 0; column < n; column++)
+    {
+        auto pivot = column;
+        for (size_t row = column + 1; row < n; row++)
+        {
+            if (std::abs(matrix[row][column]) > std::abs(matrix[pivot][column]))
+                pivot = row;
+        }
+        std::swap(matrix[column], matrix[pivot]);
+        std::swap(vector[column], vector[pivot]);
+        if (matrix[column][column] == 0)
+            continue;
+        for (size_t row = column + 1; row < n; row++)
+        {
+            auto factor = matrix[row][column] / matrix[column][column];
+            for (size_t k = column; k < n; k++)
+                matrix[row][k] -= factor * matrix[column][k];
+            vector[row] -= factor * vector[column];
+        }
+    }
+    std::vector<double> result(n, 0);
+    for (size_t i = n; i-- > 0;)
+    {
+        auto value = vector[i];
+        for (size_t k = i + 1; k < n; k++)
+            value -= matrix[i][k] * result[k];
+        result[i] = matrix[i][i] == 0 ? 0 : value / matrix[i][i];
+    }
+    return result;
+}
+
+/// Unconstrained solution restricted to the variables of `passive`, the others are 0
+std::vector<double> solvePassive(const std::vector<std::vector<double>>& gram,
+    const std::vector<double>& moments, const std::vector<bool>& passive, double ridge)
+{
+    std::vector<size_t> indices;
+    for (size_t i = 0; i < passive.size(); i++)
+    {
+        if (passive[i])
+            indices.push_back(i);
+    }
+    std::vector<std::vector<double>> matrix(indices.size(), std::vector<double>(indices.size()));
+    std::vector<double> vector(indices.size());
+    for (size_t i = 0; i < indices.size(); i++)
+    {
+        for (size_t j = 0; j < indices.size(); j++)
+            matrix[i][j] = gram[indices[i]][indices[j]];
+        matrix[i][i] += ridge;
+        vector[i] = moments[indices[i]];
+    }
+    auto solution = solve(std::move(matrix), std::move(vector));
+    std::vector<double> result(passive.size(), 0);
+    for (size_t i = 0; i < indices.size(); i++)
+        result[indices[i]] = solution[i];
+    return result;
+}
+}  // namespace
+
+NormalEquations::NormalEquations(size_t variablesCount)
+  : m_gram(variablesCount, std::vector<double>(variablesCount, 0)),
+    m_moments(variablesCount, 0)
+{}
+
+void NormalEquations::addRow(const std::vector<double>& values, double target, double weight)
+{
+    if (values.size() != variablesCount())
+        throw std::invalid_argument("the row does not have a value for each variable");
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        if (values[i] == 0)
+            continue;
+        auto weighted = weight * values[i];
+        for (size_t j = 0; j < values.size(); j++)
+            m_gram[i][j] += weighted * values[j];
+        m_moments[i] += weighted * target;
+    }
+    m_rowsCount++;
+}
+
+std::vector<double> nonNegativeLeastSquares(const NormalEquations& equations)
+{
+    const auto& gram = equations.gram();
+    const auto& moments = equations.moments();
+    auto n = equations.variablesCount();
+
+    double trace = 0;
+    for (size_t i = 0; i < n; i++)
+        trace += gram[i][i];
+    auto ridge = n == 0 ? 0 : 1e-10 * trace / n;
+    auto tolerance = 1e-10 * std::max(trace, 1.0);
+
+    std::vector<double> x(n, 0);
+    std::vector<bool> passive(n, false);
+    for (size_t iteration = 0; iteration < 3 * n + 1; iteration++)
+    {
+        // negative gradient of ½xᵀGx - hᵀx
+        std::vector<double> gradient(moments);
+        for (size_t i = 0; i < n; i++)
+        {
+            for (size_t j = 0; j < n; j++)
+                gradient[i] -= gram[i][j] * x[j];
+        }
+        size_t best = n;
+        for (size_t i = 0; i < n; i++)
+        {
+            if (!passive[i] && gradient[i] > tolerance &&
+                (best == n || gradient[i] > gradient[best]))
+                best = i;
+        }
+        if (best == n)
+            break;
+        passive[best] = true;
+
+        while (true)
+        {
+            auto s = solvePassive(gram, moments, passive, ridge);
+            bool feasible = true;
+            double alpha = 1;
+            size_t blocking = n;
+            for (size_t i = 0; i < n; i++)
+            {
+                if (passive[i] && s[i] <= 0)
+                {
+                    feasible = false;
+                    auto step = x[i] - s[i] > 0 ? x[i] / (x[i] - s[i]) : 0;
+                    if (blocking == n || step < alpha)
+                    {
+                        alpha = step;
+                        blocking = i;
+                    }
+                }
+            }
+            if (feasible)
+            {
+                x = s;
+                break;
+            }
+            // moves towards s until the first variable reaches 0, which leaves the passive set
+            for (size_t i = 0; i < n; i++)
+            {
+                x[i] += alpha * (s[i] - x[i]);
+                if (passive[i] && (i == blocking || x[i] <= 0))
+                {
+                    passive[i] = false;
+                    x[i] = 0;
+                }
+            }
+            if (std::none_of(passive.begin(), passive.end(), [](bool p) { return p; }))
+                break;
+        }
+    }
+    return x;
+}
+
+}  // namespace eth
+}  // namespace dev
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+namespace dev
+{
+namespace eth
+{
+/// Normal equations of a weighted least squares problem: `gram` is AᵀWA and `moments` AᵀWb.
+/// Rows are accumulated one at a time so that the design matrix is never stored
+class NormalEquations
+{
+public:
+    explicit NormalEquations(size_t variablesCount);
+
+    size_t variablesCount() const { return m_moments.size(); }
+    size_t rowsCount() const { return m_rowsCount; }
+
+    /// Adds the row `values` (one value per variable) with the target `target`
+    void addRow(const std::vector<double>& values, double target, double weight = 1);
+
+    const std::vector<std::vector<double>>& gram() const { return m_gram; }
+    const std::vector<double>& moments() const { return m_moments; }
+
+private:
+    std::vector<std::vector<double>> m_gram;
+    std::vector<double> m_moments;
+    size_t m_rowsCount = 0;
+};
+
+/// Solves min ||W^½(Ax - b)||² subject to x >= 0 with the active set method of
+/// Lawson and Hanson. Variables which cannot be separated (e.g. opcodes which always appear
+/// together) are kept solvable by a small ridge term
+std::vector<double> nonNegativeLeastSquares(const NormalEquations& equations);
+
+}  // namespace eth
+}  // namespace dev
@@ -0,0 +1,140 @@
+#include "StorageAccesses.h"
+
+#include <cmath>
+
+#include <libdevcore/OverlayDB.h>
+
+#include "InstructionSampler.h"
+
+namespace dev
+{
+namespace eth
+{
+const char* storageAccessLevelName(StorageAccessLevel level)
+{
+    switch (level)
+    {
+    case StorageAccessLevel::StateCache:
+        return "cache";
+    case StorageAccessLevel::Overlay:
+        return "overlay";
+    case StorageAccessLevel::Database:
+        return "database";
+    }
+    return "unknown";
+}
+
+StorageAccessLevel classifyStorageAccess(uint64_t memoryHits, uint64_t databaseReads)
+{
+    if (databaseReads > 0)
+        return StorageAccessLevel::Database;
+    if (memoryHits > 0)
+        return StorageAccessLevel::Overlay;
+    return StorageAccessLevel::StateCache;
+}
+
+bool isStorageAccess(Instruction instruction)
+{
+    switch (instruction)
+    {
+    case Instruction::SLOAD:
+    case Instruction::SSTORE:
+    case Instruction::BALANCE:
+    case Instruction::EXTCODESIZE:
+    case Instruction::EXTCODECOPY:
+    case Instruction::EXTCODEHASH:
+        return true;
+    default:
+        return false;
+    }
+}
+
+
+void StorageAccessCost::merge(const StorageAccessCost& other)
+{
+    count += other.count;
+    time += other.time;
+    gas += other.gas;
+    memoryHits += other.memoryHits;
+    databaseReads += other.databaseReads;
+}
+
+Json::Value StorageAccessCost::toJson() const
+{
+    Json::Value result;
+    result["count"] = static_cast<Json::UInt64>(count);
+    result["time"] = static_cast<Json::UInt64>(time);
+    result["timeMean"] = count == 0 ? 0.0 : static_cast<double>(time) / count;
+    result["gas"] = static_cast<Json::UInt64>(gas);
+    result["memory_hits"] = static_cast<Json::UInt64>(memoryHits);
+    result["database_reads"] = static_cast<Json::UInt64>(databaseReads);
+    return result;
+}
+
+
+void StorageAccessStats::record(Instruction instruction, StorageAccessLevel level,
+    uint64_t nanoseconds, uint64_t gas, uint64_t memoryHits, uint64_t databaseReads)
+{
+    auto& cost = m_costs[{instruction, level}];
+    cost.count++;
+    cost.time += nanoseconds;
+    cost.gas += gas;
+    cost.memoryHits += memoryHits;
+    cost.databaseReads += databaseReads;
+}
+
+void StorageAccessStats::merge(const StorageAccessStats& other)
+{
+    for (const auto& kv : other.m_costs)
+        m_costs[kv.first].merge(kv.second);
+}
+
+Json::Value StorageAccessStats::toJson() const
+{
+    Json::Value result(Json::objectValue);
+    std::map<StorageAccessLevel, StorageAccessCost> totals;
+    for (const auto& kv : m_costs)
+    {
+        auto level = storageAccessLevelName(kv.first.second);
+        result[instructionInfo(kv.first.first).name][level] = kv.second.toJson();
+        totals[kv.first.second].merge(kv.second);
+    }
+    for (const auto& kv : totals)
+        result["total"][storageAccessLevelName(kv.first)] = kv.second.toJson();
+    return result;
+}
+
+
+StorageAccessTracker::Snapshot StorageAccessTracker::snapshot()
+{
+    auto const& counters = OverlayDB::threadLookupCounters();
+    return Snapshot{CycleClock::now(), counters.memoryHits, counters.databaseReads};
+}
+
+void StorageAccessTracker::onOp(Instruction inst, const bigint& gas, const void* frame)
+{
+    auto now = snapshot();
+    if (m_hasPending && frame == m_pendingFrame && gas <= m_pendingGas &&
+        now.time >= m_pendingStart.time)
+    {
+        auto memoryHits = now.memoryHits - m_pendingStart.memoryHits;
+        auto databaseReads = now.databaseReads - m_pendingStart.databaseReads;
+        auto nanoseconds = static_cast<uint64_t>(std::llround(
+            (now.time - m_pendingStart.time) * CycleClock::nanosecondsPerCycle()));
+        m_stats.record(m_pendingInstruction, classifyStorageAccess(memoryHits, databaseReads),
+            nanoseconds, static_cast<uint64_t>(m_pendingGas - gas), memoryHits, databaseReads);
+    }
+    m_hasPending = false;
+
+    if (isStorageAccess(inst))
+    {
+        m_hasPending = true;
+        m_pendingInstruction = inst;
+        m_pendingGas = gas;
+        m_pendingFrame = frame;
+        m_pendingStart = snapshot();
+    }
+}
+
+}  // namespace eth
+}  // namespace dev
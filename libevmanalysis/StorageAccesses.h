@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstdint>
+#include <map>
+#include <utility>
+
+#include <json/json.h>
+
+#include <libdevcore/Common.h>
+#include <libevm/Instruction.h>
+
+namespace dev
+{
+namespace eth
+{
+/// Deepest layer reached by the state lookups of an instruction
+enum class StorageAccessLevel : uint8_t
+{
+    /// answered by the accounts cache of the state (`State::m_cache`, the storage overlays and
+    /// original values of the accounts) or by the code size cache
+    StateCache = 0,
+    /// trie nodes found in the memory layer of the OverlayDB
+    Overlay = 1,
+    /// at least one read of the database behind the OverlayDB
+    Database = 2,
+};
+
+const char* storageAccessLevelName(StorageAccessLevel level);
+
+/// Classifies an access from the lookups of the OverlayDB made during it
+StorageAccessLevel classifyStorageAccess(uint64_t memoryHits, uint64_t databaseReads);
+
+/// Instructions reading the state: SLOAD, SSTORE, BALANCE and EXTCODE*
+bool isStorageAccess(Instruction instruction);
+
+/// Accesses of an instruction reaching a level
+struct StorageAccessCost
+{
+    uint64_t count = 0;
+    /// nanoseconds
+    uint64_t time = 0;
+    uint64_t gas = 0;
+    uint64_t memoryHits = 0;
+    uint64_t databaseReads = 0;
+
+    void merge(const StorageAccessCost& other);
+    Json::Value toJson() const;
+};
+
+/// Count and time of the state accesses per instruction and level, so that the part of the
+/// instructions costs spent in I/O can be told apart and a warm/cold pricing evaluated
+class StorageAccessStats
+{
+public:
+    void record(Instruction instruction, StorageAccessLevel level, uint64_t nanoseconds,
+        uint64_t gas, uint64_t memoryHits, uint64_t databaseReads);
+    void merge(const StorageAccessStats& other);
+
+    bool empty() const { return m_costs.empty(); }
+    const std::map<std::pair<Instruction, StorageAccessLevel>, StorageAccessCost>& costs() const
+    {
+        return m_costs;
+    }
+
+    /// `<instruction>.<level>` entries with their count, time, mean time and lookups,
+    /// and the totals per level under `total`
+    Json::Value toJson() const;
+
+private:
+    std::map<std::pair<Instruction, StorageAccessLevel>, StorageAccessCost> m_costs;
+};
+
+/// Times the state accesses of a transaction, nested calls included, and classifies them
+/// with the OverlayDB lookups of the executing thread. An access is timed from its
+/// instruction to the next one, and its gas is the gas left at its instruction minus the gas
+/// left at the next one: the gas of SSTORE is only computed after its probe. An access whose
+/// next instruction is in another frame failed before reaching the state and is not recorded
+class StorageAccessTracker
+{
+public:
+    /// To be called before each instruction with the gas left and the frame executing it,
+    /// e.g. its ExtVMFace
+    void onOp(Instruction inst, const bigint& gas, const void* frame);
+
+    /// Accesses recorded since the beginning of the transaction. The last instruction is not
+    /// recorded if it accesses the state
+    const StorageAccessStats& stats() const { return m_stats; }
+
+private:
+    struct Snapshot
+    {
+        uint64_t time = 0;
+        uint64_t memoryHits = 0;
+        uint64_t databaseReads = 0;
+    };
+
+    static Snapshot snapshot();
+
+    StorageAccessStats m_stats;
+    /// access waiting for the next instruction
+    bool m_hasPending = false;
+    Instruction m_pendingInstruction = Instruction::STOP;
+    /// gas left at the access
+    bigint m_pendingGas;
+    const void* m_pendingFrame = nullptr;
+    Snapshot m_pendingStart;
+};
+
+}  // namespace eth
+}  // namespace dev
@@ -76,6 +76,9 @@ Json::Value SystemUsageStat::toJson() const
     root["system_time"] = systemTime;
     root["memory_allocated"] = memoryAllocated;
     root["extra_memory_allocated"] = extraMemoryAllocated;
+    root["arena_allocations"] = arenaAllocations;
+    root["arena_allocated_bytes"] = arenaAllocatedBytes;
+    root["arena_reuses"] = arenaReuses;
     return root;
 }
 
@@ -90,6 +93,7 @@ void SystemUsageStatCollector::reset()
     m_startMemoryDeallocated = memoryDeallocated;
     m_startClock = clock();
     m_startChrono = high_resolution_clock::now();
+    m_startArenaStats = ExecutionArena::threadArena().stats();
     getrusage(RUSAGE_SELF, &m_startUsage);
 }
 
@@ -97,6 +101,7 @@ SystemUsageStat SystemUsageStatCollector::getSystemStat() const
 {
     auto totalMemoryAllocated = memoryAllocated - m_startMemoryAllocated;
     auto totalMemoryDeallocated = memoryDeallocated - m_startMemoryDeallocated;
+    auto const& arenaStats = ExecutionArena::threadArena().stats();
 
     timespec endTimespec;
     clock_gettime(CLOCK_MONOTONIC, &endTimespec);
@@ -112,7 +117,10 @@ SystemUsageStat SystemUsageStatCollector::getSystemStat() const
         .monotonicTime = getTimespecEllapsedSecs(m_startTimespec, endTimespec),
         .chronoTime = duration_cast<duration<float>>(chronoStop - m_startChrono).count(),
         .memoryAllocated = totalMemoryAllocated,
-        .extraMemoryAllocated = static_cast<int64_t>(totalMemoryAllocated - totalMemoryDeallocated)
+        .extraMemoryAllocated = static_cast<int64_t>(totalMemoryAllocated - totalMemoryDeallocated),
+        .arenaAllocations = arenaStats.allocations - m_startArenaStats.allocations,
+        .arenaAllocatedBytes = arenaStats.allocatedBytes - m_startArenaStats.allocatedBytes,
+        .arenaReuses = arenaStats.reuses - m_startArenaStats.reuses
     };
 }
 
@@ -8,6 +8,8 @@
 
 #include <json/json.h>
 
+#include <libdevcore/ExecutionArena.h>
+
 namespace dev
 {
 namespace eth
@@ -21,6 +23,11 @@ struct SystemUsageStat
     float chronoTime;
     size_t memoryAllocated;
     int64_t extraMemoryAllocated;
+    /// stacks and memory regions allocated by the execution arena of the thread, and the
+    /// stacks and memories it reused instead
+    uint64_t arenaAllocations;
+    uint64_t arenaAllocatedBytes;
+    uint64_t arenaReuses;
 
     Json::Value toJson() const;
 };
@@ -40,6 +47,7 @@ private:
     size_t m_startMemoryAllocated;
     size_t m_startMemoryDeallocated;
     std::chrono::high_resolution_clock::time_point m_startChrono;
+    ExecutionArena::Stats m_startArenaStats;
 };
 
 }  // namespace eth
@@ -0,0 +1,131 @@
+#include "TransactionMeasurement.h"
+
+#include <memory>
+#include <sstream>
+
+#include <libdevcore/CommonData.h>
+
+namespace dev
+{
+namespace eth
+{
+static std::string u256ToString(const u256& value)
+{
+    std::stringstream ss;
+    ss << value;
+    return ss.str();
+}
+
+Json::Value TransactionMeasurement::toJson(bool includeOutput) const
+{
+    Json::Value root;
+    root["env"] = Json::Value();
+    root["env"]["block"] = blockNumber;
+
+    root["usage"] = usage.toJson();
+    if (counters)
+        root["counters"] = counters->toJson();
+    root["instructions"] = instructions.toJson();
+
+    if (hasResult)
+    {
+        root["transaction"] = Json::Value();
+        if (hash)
+        {
+            root["transaction"]["hash"] = hash->hex();
+        }
+        root["transaction"]["sender"] = sender.hex();
+        root["transaction"]["receiver"] = receiver.hex();
+        root["transaction"]["to"] = to.hex();
+        root["transaction"]["gas"] = u256ToString(gas);
+        root["transaction"]["gas_price"] = u256ToString(gasPrice);
+        root["transaction"]["value"] = u256ToString(value);
+        root["transaction"]["gas_for_deposit"] = u256ToString(gasForDeposit);
+        root["transaction"]["gas_refunded"] = u256ToString(gasRefunded);
+        root["transaction"]["gas_used"] = u256ToString(gasUsed);
+        root["transaction"]["output_size"] = static_cast<Json::UInt64>(outputSize);
+        root["transaction"]["excepted"] = static_cast<int>(excepted);
+        if (includeOutput)
+        {
+            root["transaction"]["output"] = toHex(output);
+        }
+
+        root["usage"]["gas/s"] = gasUsed.convert_to<double>() / usage.chronoTime;
+        if (counters && gasUsed > 0)
+            root["counters"]["cycles/gas"] = counters->cycles / gasUsed.convert_to<double>();
+    }
+    return root;
+}
+
+void TransactionMeasurement::write(std::ostream& os, bool includeOutput) const
+{
+    Json::StreamWriterBuilder builder;
+    builder.settings_["indentation"] = "";
+    std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
+    writer->write(toJson(includeOutput), &os);
+    os << std::endl;
+}
+
+void TransactionMeasurement::write(
+    ColumnarWriter& writer, uint16_t transactionsTable, uint16_t instructionCallsTable) const
+{
+    auto transactionRow = writer.rowsCount(transactionsTable);
+    writer.beginRow(transactionsTable)
+        .add(static_cast<uint64_t>(blockNumber))
+        .add(hash ? *hash : h256())
+        .add(sender)
+        .add(receiver)
+        .add(to)
+        .add(gas)
+        .add(gasPrice)
+        .add(value)
+        .add(gasForDeposit)
+        .add(gasRefunded)
+        .add(gasUsed)
+        .add(outputSize)
+        .add(excepted);
+
+    writer.add(usage.clockTime)
+        .add(usage.userTime)
+        .add(usage.systemTime)
+        .add(usage.monotonicTime)
+        .add(usage.chronoTime)
+        .add(static_cast<uint64_t>(usage.memoryAllocated))
+        .add(usage.extraMemoryAllocated)
+        .add(usage.arenaAllocations)
+        .add(usage.arenaAllocatedBytes)
+        .add(usage.arenaReuses)
+        .add(hasResult ? gasUsed.convert_to<double>() / usage.chronoTime : 0.0);
+
+    auto hardwareCounters = counters ? *counters : HardwareCounters();
+    writer.add(hardwareCounters.cycles)
+        .add(hardwareCounters.instructions)
+        .add(hardwareCounters.cacheMisses)
+        .add(hardwareCounters.branchMisses)
+        .add(hardwareCounters.tlbMisses)
+        .add(counters && hasResult && gasUsed > 0 ?
+                 hardwareCounters.cycles / gasUsed.convert_to<double>() :
+                 0.0);
+
+    auto summary = instructions.summary();
+    writer.add(summary.storageChangesCount)
+        .add(summary.storageWritesCount)
+        .add(summary.storageReadsCount)
+        .add(summary.storageAllocated)
+        .add(summary.contractsCreationCount)
+        .add(summary.contractsCreationSize)
+        .add(summary.suicideCount);
+    writer.endRow();
+
+    for (const auto& kv : instructions.instructionCounts())
+    {
+        writer.beginRow(instructionCallsTable)
+            .add(transactionRow)
+            .addSymbol(instructionName(kv.first))
+            .add(kv.second);
+        writer.endRow();
+    }
+}
+
+}  // namespace eth
+}  // namespace dev
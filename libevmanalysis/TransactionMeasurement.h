@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstdint>
+#include <ostream>
+
+#include <boost/optional.hpp>
+
+#include <json/json.h>
+
+#include <libdevcore/Address.h>
+#include <libdevcore/Common.h>
+#include <libdevcore/FixedHash.h>
+
+#include "ColumnarFile.h"
+#include "HardwareCounterCollector.h"
+#include "InstructionStats.h"
+#include "SystemUsageStatCollector.h"
+
+namespace dev
+{
+namespace eth
+{
+/// Copy of the measurements of a transaction execution, taken once the execution is done
+/// so that they can be serialised after the executive is gone (e.g. on a writer thread)
+struct TransactionMeasurement
+{
+    int64_t blockNumber = 0;
+
+    /// whether the fields of the transaction and its results are set
+    bool hasResult = false;
+    /// unset for unsigned transactions
+    boost::optional<h256> hash;
+    Address sender;
+    Address receiver;
+    Address to;
+    u256 gas;
+    u256 gasPrice;
+    u256 value;
+    u256 gasForDeposit;
+    u256 gasRefunded;
+    u256 gasUsed;
+    uint64_t outputSize = 0;
+    int64_t excepted = 0;
+    /// only copied when the output is requested
+    bytes output;
+
+    SystemUsageStat usage;
+    /// only set when hardware counters are collected
+    boost::optional<HardwareCounters> counters;
+    InstructionStats instructions;
+
+    /// `includeOutput` adds the output of the transaction in hexadecimal
+    Json::Value toJson(bool includeOutput = false) const;
+
+    /// Writes the measurements as a JSON line
+    void write(std::ostream& os, bool includeOutput = false) const;
+
+    /// Writes one row of `transactionsTable` and one row of `instructionCallsTable` per
+    /// instruction, see `AnalysisEnv::transactionsSchema`
+    void write(
+        ColumnarWriter& writer, uint16_t transactionsTable, uint16_t instructionCallsTable) const;
+};
+
+}  // namespace eth
+}  // namespace dev
@@ -0,0 +1,196 @@
+"""Reader for the columnar files written by aleth (--gas-measurements-file with a .col
+extension) and aleth-vm-instr (--columnar-output), see libevmanalysis/ColumnarFile.h
+for a description of the format.
+
+The file is memory-mapped and the columns of uncompressed blocks are returned as numpy
+arrays pointing directly into the mapping. Snappy blocks need python-snappy.
+"""
+
+import argparse
+import json
+import mmap
+import struct
+import sys
+
+import numpy as np
+
+
+MAGIC = b"ALETHCOL"
+VERSION = 1
+FILE_HEADER = struct.Struct("<8sII")
+CHUNK_HEADER = struct.Struct("<BBHIQQ")
+
+TABLE_CHUNK = 0
+DICTIONARY_CHUNK = 1
+ROWS_CHUNK = 2
+
+CODEC_NONE = 0
+CODEC_SNAPPY = 1
+
+UINT64 = 0
+INT64 = 1
+DOUBLE = 2
+SYMBOL = 3
+ADDRESS = 4
+HASH = 5
+UINT256 = 6
+
+DTYPES = {
+    UINT64: np.dtype("<u8"),
+    INT64: np.dtype("<i8"),
+    DOUBLE: np.dtype("<f8"),
+    SYMBOL: np.dtype("<u4"),
+    ADDRESS: np.dtype("V20"),
+    HASH: np.dtype("V32"),
+    UINT256: np.dtype("V32"),
+}
+
+
+def padded(size):
+    return (size + 7) & ~7
+
+
+def read_string(buffer, offset):
+    (size,) = struct.unpack_from("<I", buffer, offset)
+    offset += 4
+    return bytes(buffer[offset:offset + size]).decode(), offset + size
+
+
+class ColumnarFile:
+    def __init__(self, path):
+        with open(path, "rb") as f:
+            self.data = mmap.mmap(f.fileno(), 0, access=mmap.ACCESS_READ)
+        magic, version, _ = FILE_HEADER.unpack_from(self.data, 0)
+        if magic != MAGIC or version != VERSION:
+            raise ValueError("{0} is not a columnar file of version {1}".format(path, VERSION))
+        self.tables = []
+        self.dictionary = []
+
+    def blocks(self):
+        """Yields (table name, {column name: array}) for each block of rows,
+        stops at the end of the file or at an incomplete chunk"""
+        offset = FILE_HEADER.size
+        while offset + CHUNK_HEADER.size <= len(self.data):
+            kind, codec, table, rows_count, raw_size, stored_size = \
+                CHUNK_HEADER.unpack_from(self.data, offset)
+            payload = offset + CHUNK_HEADER.size
+            chunk_end = payload + padded(stored_size)
+            if chunk_end > len(self.data):
+                return
+            if kind == TABLE_CHUNK:
+                self.tables.append(self._read_table(payload))
+            elif kind == DICTIONARY_CHUNK:
+                self._read_dictionary(payload)
+            elif kind == ROWS_CHUNK:
+                yield self._read_rows(payload, codec, table, rows_count, raw_size, stored_size)
+            else:
+                raise ValueError("unknown chunk kind {0}".format(kind))
+            offset = chunk_end
+
+    def read_table(self, name, decode=True):
+        """Returns all the rows of table `name` as a {column name: array} dict,
+        symbols, addresses, hashes and 256 bits integers are decoded when `decode` is set"""
+        blocks = [columns for table, columns in self.blocks() if table == name]
+        table = next((t for t in self.tables if t[0] == name), None)
+        if table is None:
+            raise KeyError("no table {0}".format(name))
+        result = {}
+        for column, column_type in table[1]:
+            values = np.concatenate([block[column] for block in blocks]) if blocks \
+                else np.empty(0, dtype=DTYPES[column_type])
+            result[column] = self.decode(values, column_type) if decode else values
+        return result
+
+    def decode(self, values, column_type):
+        if column_type == SYMBOL:
+            return np.asarray(self.dictionary, dtype=object)[values]
+        elif column_type in (ADDRESS, HASH):
+            return np.array([bytes(value).hex() for value in values], dtype=object)
+        elif column_type == UINT256:
+            return decode_uint256(values)
+        return values
+
+    def _read_table(self, offset):
+        name, offset = read_string(self.data, offset)
+        (columns_count,) = struct.unpack_from("<I", self.data, offset)
+        offset += 4
+        columns = []
+        for _ in range(columns_count):
+            column_type = self.data[offset]
+            column, offset = read_string(self.data, offset + 1)
+            columns.append((column, column_type))
+        return name, columns
+
+    def _read_dictionary(self, offset):
+        (symbols_count,) = struct.unpack_from("<I", self.data, offset)
+        offset += 4
+        for _ in range(symbols_count):
+            symbol, offset = read_string(self.data, offset)
+            self.dictionary.append(symbol)
+
+    def _read_rows(self, offset, codec, table, rows_count, raw_size, stored_size):
+        if codec == CODEC_NONE:
+            buffer = self.data
+        elif codec == CODEC_SNAPPY:
+            import snappy
+            buffer = snappy.decompress(self.data[offset:offset + stored_size])
+            offset = 0
+        else:
+            raise ValueError("unknown codec {0}".format(codec))
+        if len(buffer) < offset + raw_size:
+            raise ValueError("corrupted rows chunk")
+
+        name, columns = self.tables[table]
+        result = {}
+        for column, column_type in columns:
+            dtype = DTYPES[column_type]
+            result[column] = np.frombuffer(buffer, dtype=dtype, count=rows_count, offset=offset)
+            offset += padded(dtype.itemsize * rows_count)
+        return name, result
+
+
+def decode_uint256(values):
+    """Converts 32 bytes big-endian values to uint64 when they all fit, to python ints otherwise"""
+    words = np.frombuffer(values.tobytes(), dtype=">u8").reshape(-1, 4)
+    if not words[:, :3].any():
+        return words[:, 3].astype(np.uint64)
+    return np.array([int.from_bytes(bytes(value), "big") for value in values], dtype=object)
+
+
+def read_dataframe(path, table="transactions"):
+    import pandas as pd
+    return pd.DataFrame(ColumnarFile(path).read_table(table))
+
+
+def to_jsonl(path, output, table=None):
+    columnar = ColumnarFile(path)
+    for name, columns in columnar.blocks():
+        if table is not None and name != table:
+            continue
+        _, schema = next(t for t in columnar.tables if t[0] == name)
+        decoded = {column: columnar.decode(columns[column], column_type)
+                   for column, column_type in schema}
+        rows_count = len(next(iter(decoded.values()))) if decoded else 0
+        for i in range(rows_count):
+            row = {"table": name}
+            for column, column_type in schema:
+                value = decoded[column][i]
+                if column_type == UINT256:
+                    value = str(value)
+                elif isinstance(value, np.generic):
+                    value = value.item()
+                row[column] = value
+            output.write(json.dumps(row))
+            output.write("\n")
+
+
+def main():
+    parser = argparse.ArgumentParser(prog="columnar")
+    parser.add_argument("input", help="columnar file")
+    parser.add_argument("-t", "--table", help="only output the rows of this table")
+    args = parser.parse_args()
+    to_jsonl(args.input, sys.stdout, args.table)
+
+
+if __name__ == "__main__":
+    main()
@@ -12,6 +12,8 @@ import matplotlib.pyplot as plt
 import numpy as np
 from sklearn.decomposition import PCA
 
+import columnar
+
 
 
 COLUMNS_TO_CAST = [
@@ -43,6 +45,12 @@ def combine(X, Y):
 
 def load_data(filepath, start=1_000_000, stop=1_500_000):
     logging.info("loading data from %s", filepath)
+    if filepath.endswith(".col"):
+        df = columnar.read_dataframe(filepath).iloc[start:stop].reset_index(drop=True)
+        for column in COLUMNS_TO_CAST:
+            df[column] = df[column].astype(np.int64)
+        logging.info("finished loading data from %s", filepath)
+        return df
     rows = []
     with gzip.open(filepath) as f:
         for i, line in enumerate(f):
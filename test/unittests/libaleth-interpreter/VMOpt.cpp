@@ -0,0 +1,368 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#include <libaleth-interpreter/interpreter.h>
+#include <libdevcore/CommonData.h>
+#include <libdevcore/ExecutionArena.h>
+
+#include <evmc/helpers.h>
+#include <gtest/gtest.h>
+
+#include <random>
+
+using namespace std;
+using namespace dev;
+
+namespace
+{
+bool accountExists(evmc_context*, evmc_address const*)
+{
+    return false;
+}
+
+evmc_bytes32 getStorage(evmc_context*, evmc_address const*, evmc_bytes32 const*)
+{
+    return {};
+}
+
+evmc_storage_status setStorage(
+    evmc_context*, evmc_address const*, evmc_bytes32 const*, evmc_bytes32 const*)
+{
+    return EVMC_STORAGE_MODIFIED;
+}
+
+evmc_uint256be getBalance(evmc_context*, evmc_address const*)
+{
+    return {};
+}
+
+size_t getCodeSize(evmc_context*, evmc_address const*)
+{
+    return 0;
+}
+
+// the executed codes are not the codes of accounts: the interpreter hashes them
+evmc_bytes32 getCodeHash(evmc_context*, evmc_address const*)
+{
+    return {};
+}
+
+size_t copyCode(evmc_context*, evmc_address const*, size_t, uint8_t*, size_t)
+{
+    return 0;
+}
+
+void selfdestruct(evmc_context*, evmc_address const*, evmc_address const*) {}
+
+evmc_result call(evmc_context*, evmc_message const*)
+{
+    evmc_result result = {};
+    result.status_code = EVMC_FAILURE;
+    return result;
+}
+
+evmc_tx_context getTxContext(evmc_context*)
+{
+    return {};
+}
+
+evmc_bytes32 getBlockHash(evmc_context*, int64_t)
+{
+    return {};
+}
+
+void emitLog(
+    evmc_context*, evmc_address const*, uint8_t const*, size_t, evmc_bytes32 const[], size_t)
+{}
+
+evmc_host_interface const c_host = {accountExists, getStorage, setStorage, getBalance,
+    getCodeSize, getCodeHash, copyCode, selfdestruct, call, getTxContext, getBlockHash, emitLog};
+
+struct Outcome
+{
+    evmc_status_code status;
+    int64_t gasLeft;
+    bytes output;
+};
+
+/// Interpreter whose options are restored to their defaults after each test
+class VMOptTest : public testing::Test
+{
+protected:
+    void TearDown() override
+    {
+        evmc_set_option(m_vm, "block-checks", "off");
+        evmc_set_option(m_vm, "superinstructions", "none");
+    }
+
+    Outcome execute(bytes const& _code, int64_t _gas, evmc_revision _rev = EVMC_CONSTANTINOPLE)
+    {
+        evmc_context context = {&c_host};
+        evmc_message message = {};
+        message.gas = _gas;
+        auto result = evmc_execute(m_vm, &context, _rev, &message, _code.data(), _code.size());
+        Outcome outcome{result.status_code, result.gas_left,
+            bytes(result.output_data, result.output_data + result.output_size)};
+        evmc_release_result(&result);
+        return outcome;
+    }
+
+    /// Executes @a _code with @a _gas with and without the block checks, expecting the same
+    /// outcome, and returns it
+    Outcome expectSameWithBlockChecks(
+        bytes const& _code, int64_t _gas, evmc_revision _rev = EVMC_CONSTANTINOPLE)
+    {
+        EXPECT_EQ(evmc_set_option(m_vm, "block-checks", "off"), EVMC_SET_OPTION_SUCCESS);
+        auto unchecked = execute(_code, _gas, _rev);
+        EXPECT_EQ(evmc_set_option(m_vm, "block-checks", "on"), EVMC_SET_OPTION_SUCCESS);
+        auto checked = execute(_code, _gas, _rev);
+        EXPECT_EQ(checked.status, unchecked.status) << "gas " << _gas << " revision " << _rev;
+        EXPECT_EQ(checked.gasLeft, unchecked.gasLeft) << "gas " << _gas << " revision " << _rev;
+        EXPECT_EQ(checked.output, unchecked.output) << "gas " << _gas << " revision " << _rev;
+        return checked;
+    }
+
+    /// Same as expectSameWithBlockChecks for each gas up to @a _maxGas, so that the execution
+    /// runs out of gas at each of the instructions
+    void expectSameWithBlockChecksUpTo(
+        bytes const& _code, int64_t _maxGas, evmc_revision _rev = EVMC_CONSTANTINOPLE)
+    {
+        for (int64_t gas = 0; gas <= _maxGas; ++gas)
+            expectSameWithBlockChecks(_code, gas, _rev);
+    }
+
+    evmc_instance* m_vm = evmc_create_interpreter();
+};
+
+/// Random program of @a _length instructions, mostly arithmetic, stack and memory instructions
+/// with small immediates so that the jumps often land on a JUMPDEST and the memory stays small.
+/// All the pairs of the superinstructions can occur
+bytes randomProgram(mt19937& _rng, size_t _length)
+{
+    static uint8_t const c_opcodes[] = {0x01, 0x02, 0x03, 0x04, 0x10, 0x11, 0x14, 0x15, 0x16,
+        0x20, 0x50, 0x51, 0x52, 0x54, 0x55, 0x56, 0x57, 0x58, 0x5a, 0x5b, 0x5b, 0x80, 0x81,
+        0x90, 0x91, 0x00, 0xf3, 0xfd};
+    uniform_int_distribution<size_t> pick(0, sizeof(c_opcodes) + 8);
+    uniform_int_distribution<int> immediate(0, 63);
+    bytes code;
+    for (size_t i = 0; i < _length; ++i)
+    {
+        auto index = pick(_rng);
+        if (index < sizeof(c_opcodes))
+            code.push_back(c_opcodes[index]);
+        else if (index % 2)
+            code += bytes{0x60, uint8_t(immediate(_rng))};  // PUSH1
+        else
+            code += bytes{0x61, 0x00, uint8_t(immediate(_rng))};  // PUSH2
+    }
+    return code;
+}
+}  // namespace
+
+TEST_F(VMOptTest, blockChecksOutOfGas)
+{
+    // PUSH1 1 PUSH1 2 ADD PUSH1 3 MUL PUSH1 0 MSTORE PUSH1 32 PUSH1 0 RETURN
+    auto code = fromHex("600160020160030260005260206000f3");
+    expectSameWithBlockChecksUpTo(code, 100);
+
+    auto outcome = expectSameWithBlockChecks(code, 100);
+    EXPECT_EQ(outcome.status, EVMC_SUCCESS);
+    ASSERT_EQ(outcome.output.size(), 32);
+    EXPECT_EQ(outcome.output[31], 9);
+    EXPECT_EQ(expectSameWithBlockChecks(code, 5).status, EVMC_OUT_OF_GAS);
+}
+
+TEST_F(VMOptTest, blockChecksStackUnderflow)
+{
+    // PUSH1 1 PUSH1 2 ADD ADD STOP: the block underflows at its second ADD
+    auto code = fromHex("600160020101600000");
+    expectSameWithBlockChecksUpTo(code, 50);
+    EXPECT_EQ(expectSameWithBlockChecks(code, 50).status, EVMC_STACK_UNDERFLOW);
+
+    // PUSH1 4 JUMP INVALID JUMPDEST POP POP STOP: the block at the destination underflows at
+    // its entry
+    code = fromHex("600456fe5b505000");
+    expectSameWithBlockChecksUpTo(code, 50);
+    EXPECT_EQ(expectSameWithBlockChecks(code, 50).status, EVMC_STACK_UNDERFLOW);
+}
+
+TEST_F(VMOptTest, blockChecksStackOverflow)
+{
+    // JUMPDEST PUSH1 1 PUSH1 1 PUSH1 0 JUMP: two items more on each iteration, the block
+    // overflows at its entry once the stack holds 1022 items
+    auto code = fromHex("5b60016001600056");
+    for (int64_t gas : {0, 10, 1000, 10000, 20000, 1000000})
+        expectSameWithBlockChecks(code, gas);
+    EXPECT_EQ(expectSameWithBlockChecks(code, 1000000).status, EVMC_STACK_OVERFLOW);
+}
+
+TEST_F(VMOptTest, blockChecksJumpToBlockEntry)
+{
+    // counts down from 10 with a pre-verified JUMPI:
+    // 0  PUSH1 10
+    // 2  JUMPDEST          entry of the block of the loop
+    // 3  PUSH1 1 SWAP1 SUB DUP1 PUSH1 2 JUMPI
+    // 11 PUSH1 0 MSTORE PUSH1 32 PUSH1 0 RETURN
+    auto code = fromHex("600a5b6001900380600257" "60005260206000f3");
+    expectSameWithBlockChecksUpTo(code, 400);
+    EXPECT_EQ(expectSameWithBlockChecks(code, 1000).status, EVMC_SUCCESS);
+
+    // the same with the jump back through a computed destination:
+    // 0  PUSH1 10
+    // 2  JUMPDEST
+    // 3  PUSH1 1 SWAP1 SUB DUP1 ISZERO PUSH1 18 JUMPI
+    // 12 PUSH1 1 PUSH1 1 ADD JUMP
+    // 18 JUMPDEST STOP
+    code = fromHex("600a5b600190038015601257" "600160010156" "5b00");
+    expectSameWithBlockChecksUpTo(code, 500);
+    EXPECT_EQ(expectSameWithBlockChecks(code, 1000).status, EVMC_SUCCESS);
+
+    // PUSH1 5 JUMP PUSH1 1 PUSH1 2 ADD STOP: a jump inside a block, not to a JUMPDEST
+    code = fromHex("600556600160020100");
+    expectSameWithBlockChecksUpTo(code, 30);
+    EXPECT_EQ(expectSameWithBlockChecks(code, 30).status, EVMC_BAD_JUMP_DESTINATION);
+}
+
+TEST_F(VMOptTest, blockChecksRevisionGatedInstructions)
+{
+    struct GatedInstruction
+    {
+        char const* code;
+        evmc_revision revision;
+    };
+    // each one in a block of instructions of static costs, after 2 PUSH1 and before a PUSH1
+    // and a POP
+    GatedInstruction const gatedInstructions[] = {
+        {"600160021b600150600000", EVMC_CONSTANTINOPLE},  // SHL
+        {"600160021c600150600000", EVMC_CONSTANTINOPLE},  // SHR
+        {"600160021d600150600000", EVMC_CONSTANTINOPLE},  // SAR
+        {"600160023f600150600000", EVMC_CONSTANTINOPLE},  // EXTCODEHASH
+        {"600160023d600150600000", EVMC_BYZANTIUM},       // RETURNDATASIZE
+    };
+    for (auto const& gated : gatedInstructions)
+    {
+        auto code = fromHex(gated.code);
+        for (auto rev : {EVMC_HOMESTEAD, EVMC_BYZANTIUM, EVMC_CONSTANTINOPLE})
+        {
+            expectSameWithBlockChecksUpTo(code, 500, rev);
+            auto outcome = expectSameWithBlockChecks(code, 1000, rev);
+            auto expected = rev < gated.revision ? EVMC_UNDEFINED_INSTRUCTION : EVMC_SUCCESS;
+            EXPECT_EQ(outcome.status, expected) << gated.code << " revision " << rev;
+        }
+    }
+}
+
+TEST_F(VMOptTest, blockChecksRandomPrograms)
+{
+    mt19937 rng(24);
+    for (int program = 0; program < 500; ++program)
+    {
+        auto code = randomProgram(rng, 48);
+        for (int64_t gas : {0, 3, 20, 50, 100, 300, 1000, 30000})
+        {
+            auto outcome = expectSameWithBlockChecks(code, gas);
+            if (HasFailure())
+                FAIL() << "code " << toHex(code) << " gas " << gas << " status " << outcome.status;
+        }
+    }
+}
+
+TEST_F(VMOptTest, superinstructionsRandomPrograms)
+{
+    mt19937 rng(23);
+    for (int program = 0; program < 500; ++program)
+    {
+        auto code = randomProgram(rng, 48);
+        for (char const* blockChecks : {"off", "on"})
+        {
+            ASSERT_EQ(evmc_set_option(m_vm, "block-checks", blockChecks), EVMC_SET_OPTION_SUCCESS);
+            for (int64_t gas : {0, 3, 20, 50, 100, 300, 1000, 30000})
+            {
+                ASSERT_EQ(
+                    evmc_set_option(m_vm, "superinstructions", "none"), EVMC_SET_OPTION_SUCCESS);
+                auto unfused = execute(code, gas);
+                ASSERT_EQ(
+                    evmc_set_option(m_vm, "superinstructions", "all"), EVMC_SET_OPTION_SUCCESS);
+                auto fused = execute(code, gas);
+                EXPECT_EQ(fused.status, unfused.status);
+                EXPECT_EQ(fused.gasLeft, unfused.gasLeft);
+                EXPECT_EQ(fused.output, unfused.output);
+                if (HasFailure())
+                    FAIL() << "code " << toHex(code) << " gas " << gas << " block checks "
+                           << blockChecks;
+            }
+        }
+    }
+}
+
+TEST_F(VMOptTest, superinstructionsConstantJumps)
+{
+    // 0  PUSH2 5 JUMP
+    // 4  INVALID
+    // 5  JUMPDEST PUSH1 10
+    // 8  JUMPDEST
+    // 9  PUSH1 1 SWAP1 SUB DUP1 PUSH2 8 JUMPI
+    // 18 PUSH1 0 MSTORE PUSH1 32 PUSH1 0 RETURN
+    auto code = fromHex("61000556fe5b600a5b600190038061000857" "60005260206000f3");
+    for (int64_t gas = 0; gas <= 500; ++gas)
+    {
+        ASSERT_EQ(evmc_set_option(m_vm, "superinstructions", "none"), EVMC_SET_OPTION_SUCCESS);
+        auto unfused = execute(code, gas);
+        ASSERT_EQ(evmc_set_option(m_vm, "superinstructions", "PUSH2JUMP,PUSH2JUMPI"),
+            EVMC_SET_OPTION_SUCCESS);
+        auto fused = execute(code, gas);
+        EXPECT_EQ(fused.status, unfused.status) << "gas " << gas;
+        EXPECT_EQ(fused.gasLeft, unfused.gasLeft) << "gas " << gas;
+        EXPECT_EQ(fused.output, unfused.output) << "gas " << gas;
+    }
+    EXPECT_EQ(execute(code, 1000).status, EVMC_SUCCESS);
+}
+
+TEST_F(VMOptTest, superinstructionsFromBigrams)
+{
+    // PUSH1 1 PUSH1 2 ADD PUSH1 0 MSTORE PUSH1 32 PUSH1 0 RETURN
+    auto code = fromHex("600160020160005260206000f3");
+    ASSERT_EQ(evmc_set_option(m_vm, "superinstructions", "none"), EVMC_SET_OPTION_SUCCESS);
+    auto unfused = execute(code, 100);
+
+    // the pairs without a superinstruction are ignored
+    EXPECT_EQ(evmc_set_option(
+                  m_vm, "superinstruction-bigrams", "DUP1 PUSH1,PUSH1 ADD,PUSH1 MSTORE"),
+        EVMC_SET_OPTION_SUCCESS);
+    auto fused = execute(code, 100);
+    EXPECT_EQ(fused.status, EVMC_SUCCESS);
+    EXPECT_EQ(fused.gasLeft, unfused.gasLeft);
+    EXPECT_EQ(fused.output, unfused.output);
+}
+
+TEST_F(VMOptTest, fusedOpcodesInCodeAreInvalid)
+{
+    // the bytes of the superinstructions are not EVM instructions
+    for (auto op : {"a5", "a6", "a7", "a8", "a9", "aa", "ab", "af"})
+    {
+        ASSERT_EQ(evmc_set_option(m_vm, "superinstructions", "all"), EVMC_SET_OPTION_SUCCESS);
+        EXPECT_EQ(execute(fromHex(std::string("6001") + op), 100).status,
+            EVMC_UNDEFINED_INSTRUCTION) << op;
+    }
+}
+
+TEST_F(VMOptTest, returningFramesGiveTheirMemoryBack)
+{
+    // PUSH1 42 PUSH1 0 MSTORE PUSH1 32 PUSH1 0 RETURN, and the same with REVERT
+    for (auto code : {fromHex("602a60005260206000f3"), fromHex("602a60005260206000fd")})
+    {
+        auto first = execute(code, 100);
+        auto const& stats = ExecutionArena::threadArena().stats();
+        auto allocations = stats.allocations;
+        auto reuses = stats.reuses;
+
+        auto second = execute(code, 100);
+        EXPECT_EQ(second.status, first.status);
+        EXPECT_EQ(second.output, first.output);
+        EXPECT_EQ(second.output.size(), 32);
+        EXPECT_EQ(stats.allocations, allocations);
+        // the stack and the memory
+        EXPECT_EQ(stats.reuses, reuses + 2);
+    }
+}
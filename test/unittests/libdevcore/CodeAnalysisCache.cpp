@@ -0,0 +1,67 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#include <libdevcore/CodeAnalysisCache.h>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace dev;
+
+namespace
+{
+shared_ptr<CodeAnalysis const> makeAnalysis(size_t _codeSize)
+{
+    auto analysis = make_shared<CodeAnalysis>();
+    analysis->code = bytes(_codeSize + 33, 0);
+    analysis->codeSize = _codeSize;
+    analysis->jumpDests = {1, 5};
+    return analysis;
+}
+}  // namespace
+
+TEST(CodeAnalysisCache, findInserted)
+{
+    CodeAnalysisCache cache;
+    h256 hash(1);
+    EXPECT_EQ(cache.find(hash), nullptr);
+
+    auto analysis = makeAnalysis(100);
+    cache.insert(hash, analysis);
+    EXPECT_EQ(cache.find(hash), analysis);
+    // a concurrent analysis of the same code does not replace the cached one
+    cache.insert(hash, makeAnalysis(100));
+    EXPECT_EQ(cache.find(hash), analysis);
+
+    auto stats = cache.stats();
+    EXPECT_EQ(stats.hits, 2);
+    EXPECT_EQ(stats.misses, 1);
+    EXPECT_EQ(stats.entries, 1);
+    EXPECT_EQ(stats.size, analysis->memoryUsage());
+}
+
+TEST(CodeAnalysisCache, evictLeastRecentlyUsed)
+{
+    auto size = makeAnalysis(1000)->memoryUsage();
+    CodeAnalysisCache cache(2 * size);
+    cache.insert(h256(1), makeAnalysis(1000));
+    cache.insert(h256(2), makeAnalysis(1000));
+    auto first = cache.find(h256(1));
+    cache.insert(h256(3), makeAnalysis(1000));
+
+    EXPECT_NE(cache.find(h256(1)), nullptr);
+    EXPECT_EQ(cache.find(h256(2)), nullptr);
+    EXPECT_NE(cache.find(h256(3)), nullptr);
+    EXPECT_EQ(cache.stats().evictions, 1);
+
+    // borrowed analyses outlive their eviction
+    cache.setCapacity(0);
+    EXPECT_EQ(cache.stats().entries, 0);
+    EXPECT_EQ(cache.stats().size, 0);
+    EXPECT_EQ(first->jumpDests.size(), 2);
+
+    // nothing is cached once disabled
+    cache.insert(h256(1), first);
+    EXPECT_EQ(cache.find(h256(1)), nullptr);
+}
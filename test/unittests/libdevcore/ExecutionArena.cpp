@@ -0,0 +1,66 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#include <libdevcore/ExecutionArena.h>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace dev;
+
+TEST(ExecutionArena, reusesStacks)
+{
+    ExecutionArena arena;
+    u256* outer = arena.acquireStack();
+    u256* inner = arena.acquireStack();
+    EXPECT_NE(outer, inner);
+    arena.releaseStack(inner);
+    // the next nested frame gets the stack of the previous one
+    EXPECT_EQ(arena.acquireStack(), inner);
+    arena.releaseStack(inner);
+    arena.releaseStack(outer);
+
+    auto const& stats = arena.stats();
+    EXPECT_EQ(stats.allocations, 2);
+    EXPECT_EQ(stats.allocatedBytes, 2 * ExecutionArena::c_stackSize * sizeof(u256));
+    EXPECT_EQ(stats.reuses, 1);
+}
+
+TEST(ExecutionArena, growsAndReusesMemories)
+{
+    ExecutionArena arena;
+    bytes memory = arena.acquireMemory();
+    arena.growMemory(memory, 64);
+    EXPECT_EQ(memory, bytes(64, 0));
+    EXPECT_EQ(memory.capacity(), ExecutionArena::c_pageSize);
+    memory[10] = 1;
+    // no allocation within the capacity
+    arena.growMemory(memory, 1024);
+    EXPECT_EQ(arena.stats().allocations, 1);
+    EXPECT_EQ(memory[10], 1);
+    EXPECT_EQ(memory[1000], 0);
+    // the capacity at least doubles
+    arena.growMemory(memory, ExecutionArena::c_pageSize + 32);
+    EXPECT_EQ(memory.capacity(), 2 * ExecutionArena::c_pageSize);
+    EXPECT_EQ(arena.stats().allocations, 2);
+    EXPECT_EQ(arena.stats().allocatedBytes, 3 * ExecutionArena::c_pageSize);
+
+    auto data = memory.data();
+    arena.releaseMemory(std::move(memory));
+    bytes reused = arena.acquireMemory();
+    EXPECT_TRUE(reused.empty());
+    EXPECT_EQ(reused.data(), data);
+    arena.growMemory(reused, 32);
+    EXPECT_EQ(reused, bytes(32, 0));
+    EXPECT_EQ(arena.stats().allocations, 2);
+    EXPECT_EQ(arena.stats().reuses, 1);
+
+    // the memories too large are not kept
+    bytes large;
+    arena.growMemory(large, ExecutionArena::c_maxPooledMemory + 1);
+    arena.releaseMemory(std::move(large));
+    arena.releaseMemory(std::move(reused));
+    EXPECT_EQ(arena.acquireMemory().data(), data);
+    EXPECT_EQ(arena.acquireMemory().capacity(), 0);
+}
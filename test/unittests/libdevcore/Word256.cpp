@@ -0,0 +1,128 @@
+// Aleth: Ethereum C++ client, tools and libraries.
+// Copyright 2019 Aleth Authors.
+// Licensed under the GNU General Public License, Version 3.
+
+#include <libdevcore/Word256.h>
+
+#include <gtest/gtest.h>
+
+#include <random>
+
+using namespace std;
+using namespace dev;
+
+namespace
+{
+/// Random values of random widths, with runs of set and cleared limbs to reach the corner
+/// cases of the divisions
+vector<u256> randomValues(size_t _count)
+{
+    mt19937_64 engine(42);
+    vector<u256> values = {0, 1, 2, u256(1) << 64, u256(1) << 255, ~u256(0), ~u256(0) - 1,
+        (u256(1) << 128) - 1, u256(0xffffffffffffffffULL) << 64};
+    while (values.size() < _count)
+    {
+        u256 value;
+        unsigned limbs = engine() % 4 + 1;
+        for (unsigned i = 0; i < limbs; ++i)
+        {
+            uint64_t limb;
+            switch (engine() % 4)
+            {
+            case 0:
+                limb = 0;
+                break;
+            case 1:
+                limb = ~0ULL;
+                break;
+            default:
+                limb = engine() >> (engine() % 64);
+            }
+            value = (value << 64) | limb;
+        }
+        values.push_back(value);
+    }
+    return values;
+}
+}  // namespace
+
+TEST(Word256, conversions)
+{
+    for (auto const& value : randomValues(100))
+    {
+        Word256 word(value);
+        EXPECT_EQ(word.toU256(), value);
+        EXPECT_EQ(word.isZero(), value == 0);
+        EXPECT_EQ(word.shiftAmount(), value < 256 ? unsigned(value) : 256);
+    }
+
+    // values which shrank, whose backends keep the limbs they no longer use
+    u256 shifted = ~u256(0);
+    shifted >>= 192;
+    EXPECT_EQ(Word256(shifted).toU256(), shifted);
+    u256 subtracted = ~u256(0);
+    subtracted -= ~u256(0) - 1;
+    EXPECT_EQ(Word256(subtracted).toU256(), 1);
+}
+
+TEST(Word256, arithmetic)
+{
+    auto values = randomValues(60);
+    for (auto const& a : values)
+        for (auto const& b : values)
+        {
+            Word256 x(a);
+            Word256 y(b);
+            ASSERT_EQ((x + y).toU256(), a + b) << a << " + " << b;
+            ASSERT_EQ((x - y).toU256(), a - b) << a << " - " << b;
+            ASSERT_EQ((x * y).toU256(), a * b) << a << " * " << b;
+            ASSERT_EQ(x < y, a < b);
+            ASSERT_EQ(x == y, a == b);
+            ASSERT_EQ(slt(x, y), u2s(a) < u2s(b));
+            if (b == 0)
+                continue;
+            Word256 q;
+            Word256 r;
+            divRem(x, y, q, r);
+            ASSERT_EQ(q.toU256(), a / b) << a << " / " << b;
+            ASSERT_EQ(r.toU256(), a % b) << a << " % " << b;
+            u256 m = a ^ b;
+            if (m == 0)
+                continue;
+            ASSERT_EQ(addMod(x, y, Word256(m)).toU256(), u256((u512(a) + u512(b)) % m));
+            ASSERT_EQ(mulMod(x, y, Word256(m)).toU256(), u256((u512(a) * u512(b)) % m));
+        }
+}
+
+TEST(Word256, shifts)
+{
+    for (auto const& value : randomValues(30))
+        for (unsigned shift : {0, 1, 63, 64, 65, 127, 128, 200, 255, 256, 300})
+        {
+            Word256 word(value);
+            u256 left = shift < 256 ? u256(value << shift) : 0;
+            u256 right = shift < 256 ? u256(value >> shift) : 0;
+            EXPECT_EQ((word << shift).toU256(), left);
+            EXPECT_EQ((word >> shift).toU256(), right);
+            u256 arithmetic = shift < 256 ? s2u(u2s(value) >> shift) : (u2s(value) < 0 ? ~u256(0) : 0);
+            EXPECT_EQ(sar(word, shift).toU256(), arithmetic) << value << " >> " << shift;
+        }
+}
+
+TEST(Word256, exp)
+{
+    auto values = randomValues(20);
+    for (auto const& base : values)
+        for (auto const& exponent : values)
+        {
+            u256 expected = 1;
+            u256 b = base;
+            for (u256 e = exponent; e; e >>= 1)
+            {
+                if (e & 1)
+                    expected *= b;
+                b *= b;
+            }
+            EXPECT_EQ(exp(Word256(base), Word256(exponent)).toU256(), expected);
+        }
+}
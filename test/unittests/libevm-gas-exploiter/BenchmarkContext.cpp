@@ -0,0 +1,71 @@
+#include <libevm-gas-exploiter/BenchmarkContext.h>
+#include <libevm-gas-exploiter/Benchmarker.h>
+
+#include <set>
+#include <gtest/gtest.h>
+
+#include "TestEnv.h"
+
+using namespace dev;
+using namespace eth;
+
+
+TEST(BenchmarkContext, execute)
+{
+    auto execEnv = test::createExecutionEnv();
+    auto codes = test::generateCodes(5);
+
+    BenchmarkContext context(execEnv, codes);
+    ASSERT_EQ(context.size(), codes.size());
+    for (size_t i = 0; i < codes.size(); i++)
+    {
+        auto expected = executeCode(codes[i], execEnv);
+        // executing twice checks that the state and the VM are restored between runs
+        for (size_t j = 0; j < 2; j++)
+        {
+            auto result = context.execute(i);
+            EXPECT_EQ(result.excepted, expected.excepted);
+            EXPECT_EQ(result.gasUsed, expected.gasUsed);
+            EXPECT_EQ(result.output, expected.output);
+            EXPECT_GT(result.executionTime, 0);
+        }
+    }
+}
+
+TEST(BenchmarkContext, exceptions)
+{
+    auto execEnv = test::createExecutionEnv();
+    // REVERT is available from Byzantium
+    execEnv.blockHeader.setNumber(0x42ae50);
+    std::vector<bytes> codes = {
+        // PUSH1 1 PUSH1 0 SSTORE PUSH1 0 PUSH1 0 SSTORE INVALID: the refund of the cleared slot
+        // must not be credited after the exception
+        fromHex("60016000556000600055fe"),
+        // the same ending with PUSH1 0 PUSH1 0 REVERT
+        fromHex("6001600055600060005560006000fd"),
+    };
+
+    BenchmarkContext context(execEnv, codes);
+    std::vector<TransactionException> exceptions = {
+        TransactionException::BadInstruction, TransactionException::RevertInstruction};
+    for (size_t i = 0; i < codes.size(); i++)
+    {
+        auto expected = executeCode(codes[i], execEnv);
+        for (size_t j = 0; j < 2; j++)
+        {
+            auto result = context.execute(i);
+            EXPECT_EQ(result.excepted, exceptions[i]);
+            EXPECT_EQ(result.excepted, expected.excepted);
+            EXPECT_EQ(result.gasUsed, expected.gasUsed);
+        }
+    }
+    EXPECT_EQ(context.execute(0).gasUsed, execEnv.gas);
+    EXPECT_LT(context.execute(1).gasUsed, execEnv.gas);
+}
+
+TEST(BenchmarkContext, contractAddresses)
+{
+    auto addresses = contractAddresses(10);
+    ASSERT_EQ(addresses.size(), 10);
+    EXPECT_EQ(std::set<Address>(addresses.begin(), addresses.end()).size(), 10);
+}
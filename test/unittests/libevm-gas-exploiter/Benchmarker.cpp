@@ -0,0 +1,71 @@
+#include <libevm-gas-exploiter/Benchmarker.h>
+
+#include <algorithm>
+#include <gtest/gtest.h>
+
+#include "TestEnv.h"
+
+using namespace dev;
+using namespace eth;
+
+
+TEST(Benchmarker, adaptiveExecCount)
+{
+    auto execEnv = test::createExecutionEnv();
+    auto codes = test::generateCodes(3);
+
+    BenchmarkConfig benchmarkConfig(10, test::debugBenchmarks());
+    benchmarkConfig.maxExecCount = 30;
+
+    // an unreachable width runs every program up to the budget
+    benchmarkConfig.targetMedianWidth = 1e-12;
+    auto stats = benchmarkCode(execEnv, codes[0], benchmarkConfig);
+    EXPECT_EQ(stats.execCount, benchmarkConfig.maxExecCount);
+    EXPECT_EQ(stats.measurements.size(), benchmarkConfig.maxExecCount);
+    EXPECT_LE(stats.timeMedianLow, stats.timeMedian);
+    EXPECT_GE(stats.timeMedianHigh, stats.timeMedian);
+
+    auto results = benchmarkCodes(execEnv, codes, benchmarkConfig);
+    EXPECT_EQ(results.blockExecutionTimes.size(), benchmarkConfig.execCount);
+    for (const auto& programStats : results.programStats)
+    {
+        EXPECT_EQ(programStats.execCount, benchmarkConfig.maxExecCount);
+    }
+
+    // any width is reached after the minimum number of executions
+    benchmarkConfig.targetMedianWidth = 1e12;
+    stats = benchmarkCode(execEnv, codes[0], benchmarkConfig);
+    EXPECT_EQ(stats.execCount, benchmarkConfig.execCount);
+}
+
+TEST(Benchmarker, severalVMs)
+{
+    auto execEnv = test::createExecutionEnv();
+    auto code = test::generateCodes(1)[0];
+
+    BenchmarkConfig benchmarkConfig(10, test::debugBenchmarks());
+    benchmarkConfig.vms = {"legacy", "interpreter"};
+    auto stats = benchmarkCode(execEnv, code, benchmarkConfig);
+    ASSERT_EQ(stats.backends.size(), 2);
+    const auto& legacy = stats.backends.at("legacy");
+    const auto& interpreter = stats.backends.at("interpreter");
+    EXPECT_EQ(legacy.gas, interpreter.gas);
+    EXPECT_EQ(stats.gas, legacy.gas);
+    EXPECT_EQ(stats.timeMedian, std::min(legacy.timeMedian, interpreter.timeMedian));
+    EXPECT_TRUE(stats.toJson()["backends"].isMember("interpreter"));
+
+    benchmarkConfig.vmAggregation = VMAggregation::GeometricMean;
+    auto results = benchmarkCodes(execEnv, {code, code}, benchmarkConfig);
+    ASSERT_EQ(results.programStats.size(), 2);
+    for (const auto& programStats : results.programStats)
+    {
+        ASSERT_EQ(programStats.backends.size(), 2);
+        auto times = {programStats.backends.at("legacy").timeMedian,
+            programStats.backends.at("interpreter").timeMedian};
+        EXPECT_GE(programStats.timeMedian, std::min(times) * (1 - 1e-9));
+        EXPECT_LE(programStats.timeMedian, std::max(times) * (1 + 1e-9));
+        EXPECT_EQ(programStats.execCount, 2 * benchmarkConfig.execCount);
+    }
+
+    EXPECT_THROW(parseVMAggregation("max"), std::invalid_argument);
+}
@@ -0,0 +1,110 @@
+#include <libevm-gas-exploiter/BlockReplay.h>
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include <gtest/gtest.h>
+
+#include <libdevcore/DBFactory.h>
+#include <libdevcore/TransientDirectory.h>
+#include <libdevcrypto/Common.h>
+#include <libethashseal/GenesisInfo.h>
+#include <libethcore/SealEngine.h>
+#include <libethereum/Block.h>
+#include <libethereum/ChainParams.h>
+#include <libethereum/State.h>
+#include <libethereum/Transaction.h>
+
+using namespace dev;
+using namespace eth;
+
+
+namespace
+{
+class BlockReplayTest : public testing::Test
+{
+protected:
+    void SetUp() override
+    {
+        NoProof::init();
+        m_databaseKind = db::databaseKind();
+        db::setDatabaseKind(db::DatabaseKind::MemoryDB);
+    }
+
+    void TearDown() override { db::setDatabaseKind(m_databaseKind); }
+
+    // seals the transactions in a new block on top of the chain and imports it
+    void importBlock(BlockChain& chain, OverlayDB const& stateDB, Address const& author,
+        std::vector<Transaction> const& transactions)
+    {
+        Block block = chain.genesisBlock(stateDB);
+        block.setAuthor(author);
+        block.sync(chain);
+        for (auto const& transaction : transactions)
+            block.execute(chain.lastBlockHashes(), transaction);
+        block.commitToSeal(chain);
+
+        bytes sealed;
+        chain.sealEngine()->onSealGenerated([&](bytes const& header) { sealed = header; });
+        chain.sealEngine()->generateSeal(block.info());
+        chain.sealEngine()->onSealGenerated([](bytes const&) {});
+        ASSERT_TRUE(block.sealBlock(sealed));
+        chain.import(block.blockData(), stateDB);
+    }
+
+private:
+    db::DatabaseKind m_databaseKind;
+};
+}  // namespace
+
+
+TEST_F(BlockReplayTest, replayBlocks)
+{
+    KeyPair sender(sha3("sender"));
+    ChainParams params(genesisInfo(Network::FrontierNoProofTest));
+    params.genesisState[sender.address()] = Account(0, u256(1) << 80);
+    params.setBlockReward(u256(3) << 60);
+    params.stateRoot = params.calculateStateRoot(true);
+
+    TransientDirectory directory;
+    BlockChain chain(params, directory.path(), WithExisting::Kill);
+    auto stateDB = State::openDB(directory.path(), chain.genesisHash(), WithExisting::Kill);
+
+    // stores its call data at the key 0
+    auto storer = toAddress(sender.address(), 0);
+    bytes deployStorer = fromHex("600780600b6000396000f3" "60003560005500");
+    // the rewards are paid to an account which is not in the state before
+    Address author(0x1234);
+    importBlock(chain, stateDB, author,
+        {Transaction(0, 1, 100000, deployStorer, 0, sender.secret()),
+            Transaction(1000, 1, 21000, Address(0x42), {}, 1, sender.secret())});
+    importBlock(chain, stateDB, author,
+        {Transaction(0, 1, 100000, storer, h256(1).asBytes(), 2, sender.secret()),
+            Transaction(0, 1, 100000, storer, h256(2).asBytes(), 3, sender.secret())});
+    ASSERT_EQ(chain.number(), 2);
+
+    BlockReplayConfig config;
+    config.firstBlock = 1;
+    config.lastBlock = 2;
+    config.repeatCount = 2;
+    std::ostringstream output;
+    replayBlocks(chain, stateDB, nullptr, config, output);
+
+    std::istringstream lines(output.str());
+    std::string line;
+    unsigned blocksCount = 0;
+    while (std::getline(lines, line))
+    {
+        Json::Value root;
+        ASSERT_TRUE(Json::Reader().parse(line, root));
+        if (!root.isMember("block"))
+            continue;
+        auto const& stats = root["block"];
+        BlockHeader header = chain.info(chain.numberHash(stats["number"].asUInt()));
+        EXPECT_EQ(stats["transactions_count"].asUInt(), 2);
+        EXPECT_EQ(stats["gas_used"].asString(), header.gasUsed().str());
+        EXPECT_EQ(stats["state_root"].asString(), header.stateRoot().hex());
+        blocksCount++;
+    }
+    EXPECT_EQ(blocksCount, 4);
+}
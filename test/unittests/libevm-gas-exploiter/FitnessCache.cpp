@@ -0,0 +1,117 @@
+#include <libevm-gas-exploiter/Benchmarker.h>
+#include <libevm-gas-exploiter/FitnessCache.h>
+
+#include <fstream>
+#include <gtest/gtest.h>
+
+#include <libdevcore/TransientDirectory.h>
+
+#include "TestEnv.h"
+
+using namespace dev;
+using namespace eth;
+
+
+namespace
+{
+ExecutionAggregatedStats makeEvaluation(uint64_t gas, double timeMedian)
+{
+    ExecutionAggregatedStats evaluation{};
+    evaluation.gas = gas;
+    evaluation.execCount = 1;
+    evaluation.timeMedian = timeMedian;
+    evaluation.timeMedianLow = timeMedian;
+    evaluation.timeMedianHigh = timeMedian;
+    evaluation.measurements = {timeMedian};
+    return evaluation;
+}
+}  // namespace
+
+
+TEST(FitnessCache, findAndInsert)
+{
+    FitnessCache cache;
+    EXPECT_FALSE(cache.persistent());
+    auto code = fromHex("600160020100");
+    auto key = FitnessCache::key(code);
+    EXPECT_EQ(key, sha3(code));
+
+    EXPECT_FALSE(cache.find(key).is_initialized());
+    cache.insert(key, makeEvaluation(24, 1.5));
+    // the first evaluation of a program is kept
+    cache.insert(key, makeEvaluation(24, 3.0));
+    auto evaluation = cache.find(key);
+    ASSERT_TRUE(evaluation.is_initialized());
+    EXPECT_EQ(evaluation->timeMedian, 1.5);
+    EXPECT_EQ(cache.size(), 1);
+    EXPECT_EQ(cache.hits(), 1);
+    EXPECT_EQ(cache.misses(), 1);
+}
+
+TEST(FitnessCache, persistent)
+{
+    TransientDirectory tempDir;
+    auto path = tempDir.path() + "/fitness-cache.jsonl";
+    h256 fingerprint = sha3("settings");
+    auto key = FitnessCache::key(fromHex("600160020100"));
+    {
+        FitnessCache cache(path, fingerprint);
+        EXPECT_TRUE(cache.persistent());
+        EXPECT_EQ(cache.size(), 0);
+        cache.insert(key, makeEvaluation(24, 1.5));
+    }
+    // a run killed while writing leaves a truncated line
+    std::ofstream(path, std::ios_base::app) << "{\"key\": \"12";
+
+    {
+        FitnessCache cache(path, fingerprint);
+        EXPECT_EQ(cache.size(), 1);
+        auto evaluation = cache.find(key);
+        ASSERT_TRUE(evaluation.is_initialized());
+        EXPECT_EQ(evaluation->gas, 24);
+        EXPECT_EQ(evaluation->timeMedian, 1.5);
+    }
+
+    // measurements of other settings are not loaded
+    EXPECT_THROW(FitnessCache(path, sha3("other settings")), std::runtime_error);
+}
+
+TEST(FitnessCache, restore)
+{
+    TransientDirectory tempDir;
+    auto path = tempDir.path() + "/fitness-cache.jsonl";
+    auto key = FitnessCache::key(fromHex("600160020100"));
+    auto otherKey = FitnessCache::key(fromHex("00"));
+    {
+        FitnessCache cache(path, h256());
+        cache.insert(key, makeEvaluation(24, 1.5));
+    }
+
+    FitnessCache cache(path, h256());
+    cache.restore({{key, makeEvaluation(24, 3.0)}, {otherKey, makeEvaluation(0, 0.5)}}, 5, 7);
+    EXPECT_EQ(cache.size(), 2);
+    EXPECT_EQ(cache.hits(), 5);
+    EXPECT_EQ(cache.misses(), 7);
+    // the entries of the cache file take precedence over the checkpoint
+    EXPECT_EQ(cache.find(key)->timeMedian, 1.5);
+    EXPECT_EQ(cache.find(otherKey)->timeMedian, 0.5);
+}
+
+TEST(FitnessCache, benchmarkFingerprint)
+{
+    auto execEnv = test::createExecutionEnv();
+    BenchmarkConfig config(10);
+    auto fingerprint = benchmarkFingerprint(execEnv, config);
+    EXPECT_EQ(benchmarkFingerprint(execEnv, config), fingerprint);
+
+    auto otherConfig = config;
+    otherConfig.execCount++;
+    EXPECT_NE(benchmarkFingerprint(execEnv, otherConfig), fingerprint);
+    otherConfig = config;
+    otherConfig.vms = {"legacy", "interpreter"};
+    EXPECT_NE(benchmarkFingerprint(execEnv, otherConfig), fingerprint);
+
+    auto otherEnv = execEnv;
+    otherEnv.blockHeader.setNumber(0x42ae50);
+    EXPECT_NE(benchmarkFingerprint(otherEnv, config), fingerprint);
+}
@@ -0,0 +1,105 @@
+#include <libevm-gas-exploiter/GasCostModel.h>
+#include <libevm-gas-exploiter/GasEstimator.h>
+
+#include <gtest/gtest.h>
+
+#include <sstream>
+
+using namespace dev;
+using namespace eth;
+
+namespace
+{
+/// Transactions costing 500ns plus 6ns per ADD, 10ns per MUL and 1000ns per SLOAD
+std::vector<CostSample> makeSamples()
+{
+    std::vector<CostSample> samples;
+    for (uint64_t adds = 10; adds <= 50; adds += 10)
+        for (uint64_t muls = 5; muls <= 25; muls += 5)
+            for (uint64_t sloads = 0; sloads <= 3; sloads++)
+            {
+                CostSample sample;
+                sample.counts = {{"ADD", adds}, {"MUL", muls}};
+                if (sloads > 0)
+                    sample.counts["SLOAD"] = sloads;
+                sample.time = 500 + 6 * adds + 10 * muls + 1000 * sloads;
+                samples.push_back(sample);
+            }
+    return samples;
+}
+}  // namespace
+
+TEST(GasCostModel, estimateTierGas)
+{
+    GasEstimator gasEstimator(ByzantiumSchedule);
+    EXPECT_EQ(gasEstimator.estimateGas(Instruction::ADD), 3);
+    EXPECT_EQ(gasEstimator.estimateGas(Instruction::MUL), 5);
+    EXPECT_EQ(gasEstimator.estimateGas(Instruction::SLOAD), 200);
+}
+
+TEST(GasCostModel, fit)
+{
+    auto model = fitGasCostModel(makeSamples(), ByzantiumSchedule);
+    ASSERT_EQ(model.costs.size(), 3);
+    EXPECT_LT(model.relativeError, 1e-3);
+    EXPECT_NEAR(model.transactionOverhead, 500, 1);
+
+    std::map<std::string, FittedInstructionCost> costs;
+    for (const auto& cost : model.costs)
+        costs[cost.name] = cost;
+    EXPECT_NEAR(costs["ADD"].time, 6, 0.1);
+    EXPECT_NEAR(costs["MUL"].time, 10, 0.1);
+    EXPECT_NEAR(costs["SLOAD"].time, 1000, 1);
+    EXPECT_EQ(costs["SLOAD"].gas, 200);
+
+    // SLOAD costs 5ns per gas against 2ns for the arithmetic
+    EXPECT_NEAR(model.nanosecondsPerGas, 1830.0 / 465, 0.01);
+    EXPECT_GT(costs["SLOAD"].deviation, 0);
+    EXPECT_LT(costs["ADD"].deviation, 0);
+    EXPECT_DOUBLE_EQ(costs["ADD"].deviation, model.costs[0].deviation);
+    EXPECT_EQ(costs["SLOAD"].proposedGas, 254);
+
+    auto proposed = model.proposeSchedule(ByzantiumSchedule);
+    EXPECT_GT(proposed.sloadGas, ByzantiumSchedule.sloadGas);
+    auto veryLow = static_cast<unsigned>(Tier::VeryLow);
+    auto low = static_cast<unsigned>(Tier::Low);
+    EXPECT_LT(proposed.tierStepGas[veryLow], proposed.tierStepGas[low]);
+    EXPECT_EQ(proposed.sstoreSetGas, ByzantiumSchedule.sstoreSetGas);
+    EXPECT_EQ(proposed.callGas, ByzantiumSchedule.callGas);
+}
+
+TEST(GasCostModel, readJsonLines)
+{
+    std::stringstream ss;
+    ss << R"({"usage":{"chrono_time":0.000002},"instructions":{"calls":{"ADD":3,"STOP":1}}})"
+       << "\n"
+       << R"({"block":{"number":1}})"
+       << "\n";
+    auto samples = readCostSamples(ss);
+    ASSERT_EQ(samples.size(), 1);
+    EXPECT_NEAR(samples[0].time, 2000, 1e-6);
+    EXPECT_EQ(samples[0].counts.at("ADD"), 3);
+
+    EXPECT_THROW(fitGasCostModel({}, ByzantiumSchedule), std::invalid_argument);
+}
+
+TEST(GasCostModel, scheduleJson)
+{
+    EVMSchedule schedule = ByzantiumSchedule;
+    schedule.sloadGas = 800;
+    schedule.tierStepGas[static_cast<unsigned>(Tier::Mid)] = 11;
+
+    Json::Value root;
+    root["schedule"] = scheduleToJson(schedule);
+    auto loaded = scheduleFromJson(root, ByzantiumSchedule);
+    EXPECT_EQ(loaded.sloadGas, 800);
+    EXPECT_EQ(loaded.tierStepGas, schedule.tierStepGas);
+    EXPECT_EQ(loaded.haveStaticCall, ByzantiumSchedule.haveStaticCall);
+
+    Json::Value invalid;
+    invalid["sloadGass"] = 10;
+    EXPECT_THROW(scheduleFromJson(invalid, ByzantiumSchedule), std::invalid_argument);
+    invalid = Json::Value();
+    invalid["tierStepGas"].append(1);
+    EXPECT_THROW(scheduleFromJson(invalid, ByzantiumSchedule), std::invalid_argument);
+}
@@ -1,14 +1,15 @@
 #include <libevm-gas-exploiter/GeneticEngine.h>
 #include <libevm-gas-exploiter/Benchmarker.h>
 
+#include <cstdio>
+#include <fstream>
 #include <memory>
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
 
-#include <libethashseal/GenesisInfo.h>
-#include <libethashseal/Ethash.h>
-#include <libdevcore/DBFactory.h>
-#include <libethcore/SealEngine.h>
+#include <libdevcore/TransientDirectory.h>
+
+#include "TestEnv.h"
 
 using namespace dev;
 using namespace eth;
@@ -21,56 +22,10 @@ const uint32_t generationsCount = 50;
 const uint32_t minimumProgramSize = 100;
 const uint32_t maximumProgramSize = 1000;
 
-ExecutionEnv createExecutionEnv()
-{
-    Ethash::init();
-    NoProof::init();
-    auto networkName = Network::MainNetworkTest;
-    ChainParams chainParams(genesisInfo(networkName), genesisStateRoot(networkName));
-    WithExisting withExisting = WithExisting::Trust;
-    auto dbPath = db::databasePath();
-    int64_t gasLimit = chainParams.maxGasLimit.convert_to<int64_t>();
-
-#ifdef ETH_MEASURE_GAS
-    InstructionsBenchmark instructionsBenchmark;
-    auto analysisEnv = std::make_shared<AnalysisEnv>(std::cout, std::cout, instructionsBenchmark);
-    auto blockchain = std::make_shared<BlockChain>(
-        chainParams, dbPath, withExisting, [](unsigned, unsigned) {}, analysisEnv);
-#else
-    auto blockchain = std::make_shared<BlockChain>(
-        chainParams, dbPath, withExisting, [](unsigned, unsigned) {});
-#endif
-
-    // OverlayDB stateDB;
-    auto stateDB = State::openDB(dbPath, blockchain->genesisHash(), withExisting);
-
-    auto block = blockchain->genesisBlock(stateDB);
-    block.sync(*blockchain);
-    auto blockHeader = block.info();
-    blockHeader.setGasLimit(gasLimit);
-
-    return ExecutionEnv{
-        .block = block,
-        .blockHeader = blockHeader,
-        .value = 0,
-        .gasPrice = 0,
-        .gas = gasLimit,
-        .sender = Address(777),
-        .origin = Address(777),
-        .chain = blockchain,
-    };
-}
-
-
 GeneticEngine::Config createConfig()
 {
-    auto execEnv = createExecutionEnv();
-    bool debug = false;
-    auto debugEnv = getenv("ALETH_DEBUG");
-    if (debugEnv != nullptr && std::string(debugEnv) != "0")
-    {
-        debug = true;
-    }
+    auto execEnv = test::createExecutionEnv();
+    bool debug = test::debugBenchmarks();
     auto benchmarkConfig = BenchmarkConfig(10, debug);
     return GeneticEngine::Config{
         .populationSize = populationSize,
@@ -122,6 +77,76 @@ TEST(GeneticEngine, computeFitness)
     }
 }
 
+TEST(GeneticEngine, computeFitnessWithWorkers)
+{
+    auto config = createConfig();
+    config.workerCores = {0, 0};
+    auto engine = createEngine(config);
+    auto stats = engine.computeFitness();
+    ASSERT_GT(stats.bestValue(), 0);
+
+    for (const auto& individual : engine.population())
+    {
+        ASSERT_TRUE(individual->evaluation.is_initialized());
+        EXPECT_EQ(individual->evaluation->execCount, config.benchmarkConfig.execCount);
+    }
+}
+
+TEST(GeneticEngine, computeFitnessWithCachePath)
+{
+    TransientDirectory tempDir;
+    auto config = createConfig();
+    config.fitnessCachePath = tempDir.path() + "/fitness-cache.jsonl";
+
+    {
+        auto engine = createEngine(config);
+        engine.computeFitness();
+        EXPECT_EQ(engine.fitnessCache()->size(), populationSize);
+        EXPECT_EQ(engine.fitnessCache()->hits(), 0);
+    }
+
+    auto engine = createEngine(config);
+    EXPECT_EQ(engine.fitnessCache()->size(), populationSize);
+    auto stats = engine.computeFitness();
+    ASSERT_GT(stats.bestValue(), 0);
+    EXPECT_EQ(engine.fitnessCache()->hits(), populationSize);
+    for (const auto& individual : engine.population())
+    {
+        ASSERT_TRUE(individual->evaluation.is_initialized());
+    }
+
+    // measurements of other settings are not reused
+    config.benchmarkConfig.execCount++;
+    EXPECT_THROW(createEngine(config), std::runtime_error);
+}
+
+TEST(GeneticEngine, computeFitnessWithHardwareCounters)
+{
+    auto config = createConfig();
+    config.targetMetric = GeneticEngine::Metric::CyclesPerGas;
+    EXPECT_THROW(createEngine(config), std::invalid_argument);
+
+    try
+    {
+        HardwareCounterCollector::threadCollector();
+    }
+    catch (const std::runtime_error&)
+    {
+        // perf_event_open is not available on this machine
+        return;
+    }
+
+    config.benchmarkConfig.hardwareCounters = true;
+    auto engine = createEngine(config);
+    auto stats = engine.computeFitness();
+    ASSERT_GT(stats.bestValue(), 0);
+    for (const auto& individual : engine.population())
+    {
+        ASSERT_TRUE(individual->evaluation->counters.is_initialized());
+        EXPECT_GT(individual->evaluation->counters->instructions, 0);
+    }
+}
+
 TEST(GeneticEngine, crossOver)
 {
     auto engine = createEngine();
@@ -138,16 +163,11 @@ TEST(GeneticEngine, crossOver)
         EXPECT_GT(child1.size(), 0);
         EXPECT_GT(child2.size(), 0);
 
-        auto child1Instrs = child1.instructions();
-        auto child2Instrs = child2.instructions();
-        auto prog1Instrs = prog1.instructions();
-        auto prog2Instrs = prog2.instructions();
-
-        EXPECT_EQ(child1Instrs[0], prog1.instructions()[0]);
-        EXPECT_EQ(child1Instrs[child1Instrs.size() - 1], prog2Instrs[prog2Instrs.size() - 1]);
+        EXPECT_EQ(child1[0], prog1[0]);
+        EXPECT_EQ(child1[child1.size() - 1], prog2[prog2.size() - 1]);
 
-        EXPECT_EQ(child2Instrs[0], prog2.instructions()[0]);
-        EXPECT_EQ(child2Instrs[child2Instrs.size() - 1], prog1Instrs[prog1Instrs.size() - 1]);
+        EXPECT_EQ(child2[0], prog2[0]);
+        EXPECT_EQ(child2[child2.size() - 1], prog1[prog1.size() - 1]);
 
         auto result1 = executeCode(child1.toBytes(), config.execEnv);
         EXPECT_EQ(result1.excepted, TransactionException::None);
@@ -228,3 +248,210 @@ TEST(GeneticEngine, runWithTimeMetric)
         EXPECT_GE(stats[i].bestValue(), stats[i - 1].bestValue());
     }
 }
+
+TEST(GeneticEngine, runWithObjectives)
+{
+    auto config = createConfig();
+    config.generationsCount = 5;
+    config.objectives = {
+        Objective::parse("max:time_median"), Objective::parse("min:time_stdev")};
+    auto engine = createEngine(config);
+    engine.run();
+    auto& stats = engine.stats();
+    EXPECT_EQ(stats.size(), config.generationsCount);
+    for (const auto& generationStats : stats)
+    {
+        const auto& front = generationStats.paretoFront();
+        ASSERT_FALSE(front.empty());
+        for (const auto& eProgram : front)
+        {
+            EXPECT_EQ(eProgram.paretoRank, 0);
+            ASSERT_EQ(eProgram.objectiveValues.size(), 2);
+            for (const auto& other : front)
+            {
+                EXPECT_FALSE(dominates(
+                    {other.objectiveValues[0], -other.objectiveValues[1]},
+                    {eProgram.objectiveValues[0], -eProgram.objectiveValues[1]}));
+            }
+        }
+        EXPECT_TRUE(generationStats.toJson().isMember("paretoFront"));
+    }
+}
+
+TEST(GeneticEngine, checkpoint)
+{
+    TransientDirectory tempDir;
+    auto config = createConfig();
+    config.generationsCount = 2;
+    config.checkpointPath = tempDir.path() + "/search.checkpoint";
+    config.checkpointInterval = 1;
+    auto engine = createEngine(config);
+    engine.run();
+
+    config.generationsCount = 4;
+    auto resumed = createEngine(config);
+    resumed.resume(config.checkpointPath);
+    EXPECT_EQ(resumed.generation(), 2);
+    // only the last generation is saved
+    ASSERT_EQ(resumed.stats().size(), 1);
+    EXPECT_EQ(resumed.stats()[0].generationNumber(), 1);
+    EXPECT_EQ(resumed.stats()[0].bestValue(), engine.stats()[1].bestValue());
+    EXPECT_EQ(resumed.fitnessCache()->size(), engine.fitnessCache()->size());
+    EXPECT_EQ(resumed.fitnessCache()->hits(), engine.fitnessCache()->hits());
+    ASSERT_EQ(resumed.population().size(), engine.population().size());
+    for (size_t i = 0; i < engine.population().size(); i++)
+    {
+        EXPECT_EQ(
+            resumed.population()[i]->program.toBytes(), engine.population()[i]->program.toBytes());
+        EXPECT_EQ(resumed.population()[i]->evaluation.is_initialized(),
+            engine.population()[i]->evaluation.is_initialized());
+    }
+
+    // both engines continue with the same random state
+    auto program = engine.population()[0]->program;
+    auto resumedProgram = resumed.population()[0]->program;
+    engine.mutate(program, 5);
+    resumed.mutate(resumedProgram, 5);
+    EXPECT_EQ(program.toBytes(), resumedProgram.toBytes());
+
+    config.seed = 1;
+    auto otherEngine = createEngine(config);
+    EXPECT_THROW(otherEngine.resume(config.checkpointPath), std::invalid_argument);
+}
+
+TEST(GeneticEngine, checkpointWithCachePath)
+{
+    TransientDirectory tempDir;
+    auto config = createConfig();
+    config.generationsCount = 2;
+    config.checkpointPath = tempDir.path() + "/search.checkpoint";
+    config.checkpointInterval = 1;
+    config.fitnessCachePath = tempDir.path() + "/fitness-cache.jsonl";
+    {
+        auto engine = createEngine(config);
+        engine.run();
+    }
+
+    config.generationsCount = 4;
+    {
+        auto resumed = createEngine(config);
+        auto cacheSize = resumed.fitnessCache()->size();
+        ASSERT_GT(cacheSize, 0);
+        resumed.resume(config.checkpointPath);
+        EXPECT_EQ(resumed.fitnessCache()->size(), cacheSize);
+    }
+
+    // the evaluations are only in the cache file, not in the checkpoint
+    std::remove(config.fitnessCachePath.c_str());
+    auto resumed = createEngine(config);
+    resumed.resume(config.checkpointPath);
+    EXPECT_EQ(resumed.fitnessCache()->size(), 0);
+    EXPECT_EQ(resumed.generation(), 2);
+
+    config.fitnessCachePath = tempDir.path() + "/other-cache.jsonl";
+    auto otherEngine = createEngine(config);
+    EXPECT_THROW(otherEngine.resume(config.checkpointPath), std::invalid_argument);
+}
+
+TEST(GeneticEngine, resumeIsDeterministic)
+{
+    TransientDirectory tempDir;
+    auto config = createConfig();
+    config.generationsCount = 4;
+    config.fitnessCachePath = tempDir.path() + "/fitness-cache.jsonl";
+
+    // measures every program of the search once, so that the runs below only read their
+    // fitness from the cache and the timings cannot change their selections
+    size_t cacheSize = 0;
+    {
+        auto engine = createEngine(config);
+        engine.run();
+        cacheSize = engine.fitnessCache()->size();
+    }
+
+    auto uninterrupted = createEngine(config);
+    uninterrupted.run();
+    EXPECT_EQ(uninterrupted.fitnessCache()->size(), cacheSize);
+
+    config.checkpointPath = tempDir.path() + "/search.checkpoint";
+    config.checkpointInterval = 0;
+    config.generationsCount = 2;
+    {
+        auto interrupted = createEngine(config);
+        interrupted.run();
+    }
+    config.generationsCount = 4;
+    auto resumed = createEngine(config);
+    resumed.resume(config.checkpointPath);
+    resumed.run();
+    EXPECT_EQ(resumed.fitnessCache()->size(), cacheSize);
+
+    EXPECT_EQ(resumed.generation(), uninterrupted.generation());
+    ASSERT_EQ(resumed.population().size(), uninterrupted.population().size());
+    for (size_t i = 0; i < uninterrupted.population().size(); i++)
+    {
+        EXPECT_EQ(resumed.population()[i]->program.toBytes(),
+            uninterrupted.population()[i]->program.toBytes());
+    }
+
+    // the resumed engine has the stats of the last generation of the checkpoint, followed
+    // by the ones it ran
+    const auto& stats = uninterrupted.stats();
+    const auto& resumedStats = resumed.stats();
+    ASSERT_EQ(stats.size(), 4);
+    ASSERT_EQ(resumedStats.size(), 3);
+    for (size_t i = 0; i < resumedStats.size(); i++)
+    {
+        const auto& expected = stats[i + 1];
+        EXPECT_EQ(resumedStats[i].generationNumber(), expected.generationNumber());
+        EXPECT_EQ(resumedStats[i].bestValue(), expected.bestValue());
+        EXPECT_EQ(resumedStats[i].bestProgram().program.toBytes(),
+            expected.bestProgram().program.toBytes());
+    }
+}
+
+TEST(GeneticEngine, columnarOutput)
+{
+    TransientDirectory tempDir;
+    auto config = createConfig();
+    config.generationsCount = 2;
+    config.columnarOutputPath = tempDir.path() + "/search.col";
+    {
+        auto engine = createEngine(config);
+        engine.run();
+    }
+
+    ColumnarReader reader(config.columnarOutputPath);
+    ColumnarReader::Block block;
+    std::map<std::string, uint64_t> rowsCounts;
+    while (reader.next(block))
+    {
+        rowsCounts[block.schema().name] += block.rowsCount();
+    }
+    EXPECT_EQ(rowsCounts["generations"], 2);
+    EXPECT_EQ(rowsCounts["programs"], 2 * config.populationSize);
+}
+
+TEST(GeneticEngine, migration)
+{
+    auto engine = createEngine();
+    EXPECT_TRUE(engine.emigrants(3).empty());
+
+    engine.computeFitness();
+    auto emigrants = engine.emigrants(3);
+    ASSERT_EQ(emigrants.size(), 3);
+
+    auto other = createEngine();
+    other.computeFitness();
+    other.immigrate(emigrants);
+    EXPECT_EQ(other.population().size(), populationSize);
+    size_t immigrantsCount = 0;
+    for (const auto& individual : other.population())
+    {
+        if (!individual->evaluation.is_initialized())
+        {
+            immigrantsCount++;
+        }
+    }
+    EXPECT_EQ(immigrantsCount, 3);
+}
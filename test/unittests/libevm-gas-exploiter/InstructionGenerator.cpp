@@ -6,19 +6,19 @@ using namespace dev;
 using namespace eth;
 
 
-TEST(InstructionGenerator, generateMemorySafeSequence)
+TEST(InstructionGenerator, appendMemorySafeSequence)
 {
-    auto addInstr = std::make_shared<ProgramInstruction>(Instruction::BALANCE);
-    auto instrs = generateMemorySafeSequence(addInstr);
-    EXPECT_FALSE(addInstr->isProtected());
-    EXPECT_EQ(instrs.size(), 1);
+    Program program(3);
+    appendMemorySafeSequence(program, ProgramInstruction(Instruction::BALANCE));
+    EXPECT_FALSE(program.isProtected(0));
+    EXPECT_EQ(program.size(), 1);
 
-    auto callDataInstr = std::make_shared<ProgramInstruction>(Instruction::CALLDATACOPY);
-    instrs = generateMemorySafeSequence(callDataInstr);
-    EXPECT_TRUE(callDataInstr->isProtected());
-    EXPECT_EQ(instrs.size(), 7);
-    for (const auto& instr : instrs)
+    appendMemorySafeSequence(program, ProgramInstruction(Instruction::CALLDATACOPY));
+    EXPECT_EQ(program.size(), 8);
+    EXPECT_EQ(program.instruction(7), Instruction::CALLDATACOPY);
+    for (size_t i = 1; i < program.size(); i++)
     {
-        ASSERT_TRUE(instr->isProtected());
+        ASSERT_TRUE(program.isProtected(i));
     }
-}
\ No newline at end of file
+    EXPECT_EQ(program.protectionGroup(1), (std::pair<size_t, size_t>(1, 8)));
+}
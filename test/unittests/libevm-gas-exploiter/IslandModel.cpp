@@ -0,0 +1,74 @@
+#include <libevm-gas-exploiter/IslandModel.h>
+
+#include <map>
+#include <sstream>
+#include <gtest/gtest.h>
+
+#include "TestEnv.h"
+
+using namespace dev;
+using namespace eth;
+
+
+TEST(IslandModel, destinations)
+{
+    using Topology = IslandModel::Topology;
+    EXPECT_EQ(IslandModel::destinations(Topology::Ring, 3, 4), (std::vector<size_t>{0}));
+    EXPECT_EQ(IslandModel::destinations(Topology::Star, 0, 3), (std::vector<size_t>{1, 2}));
+    EXPECT_EQ(IslandModel::destinations(Topology::Star, 2, 3), (std::vector<size_t>{0}));
+    EXPECT_EQ(
+        IslandModel::destinations(Topology::FullyConnected, 1, 3), (std::vector<size_t>{0, 2}));
+    EXPECT_TRUE(IslandModel::destinations(Topology::Ring, 0, 1).empty());
+
+    EXPECT_EQ(IslandModel::parseTopology("fully-connected"), Topology::FullyConnected);
+    EXPECT_THROW(IslandModel::parseTopology("mesh"), std::invalid_argument);
+}
+
+TEST(IslandModel, run)
+{
+    auto debug = test::debugBenchmarks();
+    GeneticEngine::Config config{
+        .populationSize = 10,
+        .initialProgramSize = 1000,
+        .minimumProgramSize = 100,
+        .maximumProgramSize = 1000,
+        .generationsCount = 4,
+        .mutationsCount = 5,
+        .eliteRatio = 0.2,
+        .debug = debug,
+        .cacheResults = true,
+        .tournamentSelectionConfig = GeneticEngine::TournamentSelectionConfig(),
+        .execEnv = test::createExecutionEnv(),
+        .seed = 0,
+        .targetMetric = GeneticEngine::Metric::ThroughputMean,
+        .benchmarkConfig = BenchmarkConfig(10, debug),
+    };
+    IslandModel::Config islandConfig{
+        .islandsCount = 2,
+        .topology = IslandModel::Topology::Ring,
+        .migrationInterval = 2,
+        .migrantsCount = 2,
+        .cores = {},
+    };
+
+    std::stringstream output;
+    {
+        IslandModel islandModel(islandConfig, config, {}, output);
+        islandModel.run();
+    }
+
+    // the stats lines of the islands are written by the coordinator
+    std::map<uint64_t, size_t> linesPerIsland;
+    std::string line;
+    while (std::getline(output, line))
+    {
+        std::istringstream lineStream(line);
+        Json::Value stats;
+        lineStream >> stats;
+        ASSERT_TRUE(stats.isMember("island"));
+        linesPerIsland[stats["island"].asUInt64()]++;
+    }
+    ASSERT_EQ(linesPerIsland.size(), 2);
+    EXPECT_EQ(linesPerIsland[0], config.generationsCount);
+    EXPECT_EQ(linesPerIsland[1], config.generationsCount);
+}
@@ -0,0 +1,81 @@
+#include <libevm-gas-exploiter/Message.h>
+
+#include <unistd.h>
+
+#include <gtest/gtest.h>
+
+using namespace dev;
+using namespace eth;
+
+
+TEST(Message, sendAndReceive)
+{
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+
+    MessageWriter writer;
+    writer.write<uint8_t>(7);
+    writer.write(2.5);
+    writer.writeBytes(fromHex("600160020100"));
+    writer.writeString("worker");
+    writer.writeDoubles({1.0, 2.0, 3.0});
+    writer.send(fds[1]);
+
+    auto reader = MessageReader::receive(fds[0]);
+    EXPECT_EQ(reader.read<uint8_t>(), 7);
+    EXPECT_EQ(reader.read<double>(), 2.5);
+    EXPECT_EQ(reader.readBytes(), fromHex("600160020100"));
+    EXPECT_EQ(reader.readString(), "worker");
+    EXPECT_EQ(reader.readDoubles(), (std::vector<double>{1.0, 2.0, 3.0}));
+    EXPECT_TRUE(reader.atEnd());
+    EXPECT_THROW(reader.read<uint8_t>(), std::runtime_error);
+
+    close(fds[0]);
+    close(fds[1]);
+}
+
+TEST(Message, closedPipe)
+{
+    // writing to a dead process must throw rather than kill the search with SIGPIPE
+    int fds[2];
+    ASSERT_EQ(pipe(fds), 0);
+    close(fds[0]);
+    MessageWriter message;
+    message.write<uint8_t>(1);
+    EXPECT_THROW(message.send(fds[1]), std::runtime_error);
+    close(fds[1]);
+
+    // reading from a process which exited without answering throws too
+    ASSERT_EQ(pipe(fds), 0);
+    close(fds[1]);
+    EXPECT_THROW(MessageReader::receive(fds[0]), std::runtime_error);
+    close(fds[0]);
+}
+
+TEST(Message, executionStats)
+{
+    ExecutionAggregatedStats stats{};
+    stats.gas = 21000;
+    stats.execCount = 3;
+    stats.timeMedian = 1.5;
+    stats.timeMedianLow = 1.0;
+    stats.timeMedianHigh = 2.0;
+    stats.measurements = {1.0, 1.5, 2.0};
+    auto backend = stats;
+    stats.backends["legacy"] = backend;
+
+    MessageWriter writer;
+    writeExecutionStats(writer, stats);
+    MessageReader reader(writer.buffer());
+    auto read = readExecutionStats(reader);
+    EXPECT_TRUE(reader.atEnd());
+    EXPECT_EQ(read.gas, stats.gas);
+    EXPECT_EQ(read.execCount, stats.execCount);
+    EXPECT_EQ(read.timeMedian, stats.timeMedian);
+    EXPECT_EQ(read.timeMedianLow, stats.timeMedianLow);
+    EXPECT_EQ(read.timeMedianHigh, stats.timeMedianHigh);
+    EXPECT_EQ(read.measurements, stats.measurements);
+    EXPECT_FALSE(read.counters.is_initialized());
+    ASSERT_EQ(read.backends.size(), 1);
+    EXPECT_EQ(read.backends.at("legacy").measurements, backend.measurements);
+}
@@ -0,0 +1,65 @@
+#include <libevm-gas-exploiter/ParetoSelection.h>
+
+#include <cmath>
+#include <gtest/gtest.h>
+
+using namespace dev;
+using namespace eth;
+
+
+TEST(ParetoSelection, objectiveParse)
+{
+    auto objective = Objective::parse("max:time_median");
+    EXPECT_EQ(objective.field(), "time_median");
+    EXPECT_EQ(objective.direction(), Objective::Direction::Maximize);
+    EXPECT_EQ(objective.toString(), "max:time_median");
+
+    ExecutionAggregatedStats stats{};
+    stats.timeMedian = 2.5;
+    stats.timeStdev = 0.5;
+    EXPECT_EQ(objective.score(stats), 2.5);
+    EXPECT_EQ(Objective::parse("min:time_stdev").score(stats), -0.5);
+
+    EXPECT_THROW(Objective::parse("time_median"), std::invalid_argument);
+    EXPECT_THROW(Objective::parse("max:unknown"), std::invalid_argument);
+    EXPECT_THROW(Objective::parse("best:time_median"), std::invalid_argument);
+}
+
+TEST(ParetoSelection, dominates)
+{
+    EXPECT_TRUE(dominates({2, 2}, {1, 2}));
+    EXPECT_FALSE(dominates({2, 2}, {2, 2}));
+    EXPECT_FALSE(dominates({3, 1}, {1, 3}));
+    EXPECT_FALSE(dominates({1, 2}, {2, 2}));
+}
+
+TEST(ParetoSelection, nonDominatedSort)
+{
+    std::vector<std::vector<double>> scores = {
+        {1, 1},  // dominated by 1, 2 and 3
+        {3, 1},
+        {2, 2},
+        {1, 3},
+        {1, 2},  // dominated by 2 and 3
+        {0, 0},
+    };
+    auto fronts = nonDominatedSort(scores);
+    ASSERT_EQ(fronts.size(), 4);
+    EXPECT_EQ(fronts[0], (std::vector<size_t>{1, 2, 3}));
+    EXPECT_EQ(fronts[1], (std::vector<size_t>{4}));
+    EXPECT_EQ(fronts[2], (std::vector<size_t>{0}));
+    EXPECT_EQ(fronts[3], (std::vector<size_t>{5}));
+
+    EXPECT_TRUE(nonDominatedSort({}).empty());
+}
+
+TEST(ParetoSelection, crowdingDistances)
+{
+    std::vector<std::vector<double>> scores = {{0, 4}, {1, 3}, {3, 1}, {4, 0}};
+    auto distances = crowdingDistances(scores, {0, 1, 2, 3});
+    ASSERT_EQ(distances.size(), 4);
+    EXPECT_TRUE(std::isinf(distances[0]));
+    EXPECT_TRUE(std::isinf(distances[3]));
+    EXPECT_DOUBLE_EQ(distances[1], 1.5);
+    EXPECT_DOUBLE_EQ(distances[2], 1.5);
+}
@@ -22,14 +22,14 @@ TEST(Program, ProgramDatatoHex)
 
 TEST(Program, InstructiontoHex)
 {
-    auto inst = std::make_shared<ProgramInstruction>(Instruction::ADD);
-    EXPECT_EQ(inst->toHex(), "01");
+    auto inst = ProgramInstruction(Instruction::ADD);
+    EXPECT_EQ(inst.toHex(), "01");
 
-    inst = std::make_shared<ProgramInstructionWithData>(Instruction::PUSH2, ProgramData(0x001f, 2));
-    EXPECT_EQ(inst->toHex(), "61001f");
+    inst = ProgramInstruction(Instruction::PUSH2, ProgramData(0x001f, 2));
+    EXPECT_EQ(inst.toHex(), "61001f");
 
-    inst = std::make_shared<ProgramInstructionWithData>(Instruction::PUSH1, ProgramData(0x0f, 1));
-    EXPECT_EQ(inst->toHex(), "600f");
+    inst = ProgramInstruction(Instruction::PUSH1, ProgramData(0x0f, 1));
+    EXPECT_EQ(inst.toHex(), "600f");
 }
 
 TEST(Program, addInstruction)
@@ -45,6 +45,106 @@ TEST(Program, addInstruction)
     ASSERT_EQ(program.stackSize(), 2);
 }
 
+TEST(Program, instructionAccess)
+{
+    Program program;
+    program.addInstruction(Instruction::PUSH2, 0x1234);
+    program.addInstruction(Instruction::PUSH1, 0xe0, Program::Protection::Protected);
+    program.addInstruction(Instruction::ADD);
+
+    EXPECT_EQ(program[0], ProgramInstruction(Instruction::PUSH2, ProgramData(0x1234, 2)));
+    EXPECT_TRUE(program[1].isProtected());
+    EXPECT_EQ(program[1].data().value, 0xe0);
+    EXPECT_FALSE(program[2].hasData());
+    EXPECT_EQ(program.instruction(2), Instruction::ADD);
+    EXPECT_EQ(program.toBytes(), fromHex("61123460e001"));
+}
+
+TEST(Program, append)
+{
+    Program first;
+    first.addInstruction(Instruction::PUSH1, 0x01);
+    first.addInstruction(Instruction::PUSH2, 0x0203);
+    first.addInstruction(Instruction::ADD);
+
+    Program second;
+    second.addInstruction(Instruction::PUSH1, 0x04);
+    second.addInstruction(Instruction::PUSH1, 0x05);
+    second.addInstruction(Instruction::MUL);
+    second.addInstruction(Instruction::POP);
+
+    Program child;
+    child.append(first, 0, 2);
+    child.append(second, 2, second.size());
+    EXPECT_EQ(child.toHex(), "6001610203" "0250");
+    EXPECT_EQ(child.stackSize(), 0);
+    EXPECT_EQ(child.stackSize(3), 1);
+
+    Program invalid;
+    EXPECT_THROW(invalid.append(second, 2, second.size()), std::runtime_error);
+}
+
+TEST(Program, replaceInstruction)
+{
+    Program program;
+    program.addInstruction(Instruction::PUSH1, 0x01);
+    program.addInstruction(Instruction::PUSH1, 0x02);
+    program.addInstruction(Instruction::POP);
+    program.addInstruction(Instruction::PUSH1, 0x20);
+    program.addInstruction(Instruction::MLOAD);
+    program.protectLast(3);
+    program.addInstruction(Instruction::ADD);
+    EXPECT_EQ(program.protectionGroup(2), (std::pair<size_t, size_t>(2, 5)));
+    EXPECT_EQ(program.protectionGroup(5), (std::pair<size_t, size_t>(5, 6)));
+
+    Program replacement(program.stackSize(2));
+    replacement.addInstruction(Instruction::POP);
+    replacement.addInstruction(Instruction::PUSH2, 0x0304);
+    replacement.addInstruction(Instruction::NOT);
+    program.replaceInstruction(4, replacement);
+    EXPECT_EQ(program.size(), 6);
+    EXPECT_EQ(program.toHex(), "600160025061030419" "01");
+    EXPECT_FALSE(program.isProtected(2));
+    EXPECT_EQ(program.stackSize(3), 1);
+    EXPECT_EQ(program.stackSize(5), 2);
+    EXPECT_EQ(program.stackSize(), 1);
+
+    // a replacement returning more values shifts the stack sizes after it
+    Program pushReplacement(program.stackSize(5));
+    pushReplacement.addInstruction(Instruction::PUSH1, 0x01);
+    program.replaceInstruction(5, pushReplacement);
+    EXPECT_EQ(program.toHex(), "60016002506103041960" "01");
+    EXPECT_EQ(program.stackSize(), 3);
+    program.addInstruction(Instruction::ADD);
+    EXPECT_EQ(program.stackSize(), 2);
+}
+
+TEST(Program, encode)
+{
+    Program program(1);
+    program.addInstruction(Instruction::PUSH2, 0x1234);
+    program.addInstruction(Instruction::PUSH1, 0x20);
+    program.addInstruction(Instruction::MLOAD);
+    program.protectLast(2);
+    program.addInstruction(Instruction::ADD);
+    program.extendSize(8);
+
+    auto encoded = program.encode();
+    auto decoded = Program::decode(&encoded);
+    EXPECT_EQ(decoded.toHex(), program.toHex());
+    EXPECT_EQ(decoded.size(), program.size());
+    EXPECT_EQ(decoded.uniqueSize(), program.uniqueSize());
+    EXPECT_EQ(decoded.stackSize(), program.stackSize());
+    for (size_t i = 0; i < program.size(); i++)
+    {
+        EXPECT_EQ(decoded[i], program[i]);
+        EXPECT_EQ(decoded.protectionGroup(i), program.protectionGroup(i));
+    }
+
+    encoded.resize(encoded.size() - 1);
+    EXPECT_THROW(Program::decode(&encoded), std::runtime_error);
+}
+
 TEST(Program, stackSizeReverseIndex)
 {
     Program program;
@@ -66,16 +166,21 @@ TEST(Program, stackSizeReverseIndex)
     // expected: {1: [1], 2: [2, 4, 6], 3: [3]}
     // because we ignore the first and last stack size
     // and protected instructions should be skipped
-    auto reverseIndex = program.stackSizeReverseIndex();
-    ASSERT_EQ(reverseIndex.size(), 3);
-    ASSERT_EQ(reverseIndex[1].size(), 1);
-    ASSERT_EQ(reverseIndex[1][0], 1);
-    ASSERT_EQ(reverseIndex[2].size(), 3);
-    ASSERT_EQ(reverseIndex[2][0], 2);
-    ASSERT_EQ(reverseIndex[2][1], 4);
-    ASSERT_EQ(reverseIndex[2][2], 6);
-    ASSERT_EQ(reverseIndex[3].size(), 1);
-    ASSERT_EQ(reverseIndex[3][0], 3);
+    const auto& reverseIndex = program.stackSizeReverseIndex();
+    ASSERT_EQ(reverseIndex.stackSizesCount(), 3);
+    ASSERT_EQ(reverseIndex.positions(1).size(), 1);
+    ASSERT_EQ(reverseIndex.positions(1)[0], 1);
+    ASSERT_EQ(reverseIndex.positions(2).size(), 3);
+    ASSERT_EQ(reverseIndex.positions(2)[0], 2);
+    ASSERT_EQ(reverseIndex.positions(2)[1], 4);
+    ASSERT_EQ(reverseIndex.positions(2)[2], 6);
+    ASSERT_EQ(reverseIndex.positions(3).size(), 1);
+    ASSERT_EQ(reverseIndex.positions(3)[0], 3);
+
+    // the index is recomputed once the program changes
+    program.addInstruction(Instruction::PUSH1, 0xe0);
+    ASSERT_EQ(program.stackSizeReverseIndex().positions(1).size(), 2);
+    ASSERT_EQ(program.stackSizeReverseIndex().positions(1)[1], 7);
 }
 
 
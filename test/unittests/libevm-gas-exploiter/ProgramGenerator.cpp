@@ -45,21 +45,33 @@ TEST(ProgramGenerator, makeInstruction)
 {
     ProgramGenerator programGenerator;
     auto instr = programGenerator.makeInstruction(Instruction::ADD);
-    EXPECT_FALSE(instr->hasData());
+    EXPECT_FALSE(instr.hasData());
 
     instr = programGenerator.makeInstruction(Instruction::PUSH1);
-    EXPECT_EQ(instr->instruction(), Instruction::PUSH1);
-    ASSERT_TRUE(instr->hasData());
-    auto instrWData = std::dynamic_pointer_cast<ProgramInstructionWithData>(instr);
-    auto data = instrWData->data();
+    EXPECT_EQ(instr.instruction(), Instruction::PUSH1);
+    ASSERT_TRUE(instr.hasData());
+    auto data = instr.data();
     EXPECT_EQ(data.size, uint8_t(1));
-    EXPECT_EQ(instrWData->toHex().size(), 4);
+    EXPECT_EQ(instr.toHex().size(), 4);
 
     instr = programGenerator.makeInstruction(Instruction::PUSH2);
-    EXPECT_EQ(instr->instruction(), Instruction::PUSH2);
-    ASSERT_TRUE(instr->hasData());
-    instrWData = std::dynamic_pointer_cast<ProgramInstructionWithData>(instr);
-    data = instrWData->data();
+    EXPECT_EQ(instr.instruction(), Instruction::PUSH2);
+    ASSERT_TRUE(instr.hasData());
+    data = instr.data();
     EXPECT_EQ(data.size, uint8_t(2));
-    EXPECT_EQ(instrWData->toHex().size(), 6);
+    EXPECT_EQ(instr.toHex().size(), 6);
+}
+
+TEST(ProgramGenerator, state)
+{
+    ProgramGenerator programGenerator(3);
+    programGenerator.generateInitialProgram(50);
+    auto state = programGenerator.state();
+
+    ProgramGenerator restored(5);
+    restored.setState(state);
+    EXPECT_EQ(restored.generateInitialProgram(100).toBytes(),
+        programGenerator.generateInitialProgram(100).toBytes());
+
+    EXPECT_THROW(restored.setState("invalid"), std::runtime_error);
 }
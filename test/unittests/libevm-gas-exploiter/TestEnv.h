@@ -0,0 +1,84 @@
+#pragma once
+
+#include <libevm-gas-exploiter/ExecutionEnv.h>
+#include <libevm-gas-exploiter/ProgramGenerator.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <libdevcore/DBFactory.h>
+#include <libethashseal/Ethash.h>
+#include <libethashseal/GenesisInfo.h>
+#include <libethcore/SealEngine.h>
+
+namespace dev
+{
+namespace test
+{
+/// Executes the programs on top of the genesis block of the main network test chain, with the
+/// whole gas limit of a block
+inline eth::ExecutionEnv createExecutionEnv()
+{
+    using namespace eth;
+    Ethash::init();
+    NoProof::init();
+    auto networkName = Network::MainNetworkTest;
+    ChainParams chainParams(genesisInfo(networkName), genesisStateRoot(networkName));
+    WithExisting withExisting = WithExisting::Trust;
+    auto dbPath = db::databasePath();
+    int64_t gasLimit = chainParams.maxGasLimit.convert_to<int64_t>();
+
+#ifdef ETH_MEASURE_GAS
+    // the analysis environment keeps a reference to the benchmark
+    static InstructionsBenchmark instructionsBenchmark;
+    auto analysisEnv = std::make_shared<AnalysisEnv>(std::cout, std::cout, instructionsBenchmark);
+    auto blockchain = std::make_shared<BlockChain>(
+        chainParams, dbPath, withExisting, [](unsigned, unsigned) {}, analysisEnv);
+#else
+    auto blockchain = std::make_shared<BlockChain>(
+        chainParams, dbPath, withExisting, [](unsigned, unsigned) {});
+#endif
+
+    auto stateDB = State::openDB(dbPath, blockchain->genesisHash(), withExisting);
+
+    auto block = blockchain->genesisBlock(stateDB);
+    block.sync(*blockchain);
+    auto blockHeader = block.info();
+    blockHeader.setGasLimit(gasLimit);
+
+    return ExecutionEnv{
+        .block = block,
+        .blockHeader = blockHeader,
+        .value = 0,
+        .gasPrice = 0,
+        .gas = gasLimit,
+        .sender = Address(777),
+        .origin = Address(777),
+        .chain = blockchain,
+    };
+}
+
+/// Whether the benchmarks of the tests print their measurements, set with ALETH_DEBUG
+inline bool debugBenchmarks()
+{
+    auto debugEnv = getenv("ALETH_DEBUG");
+    return debugEnv != nullptr && std::string(debugEnv) != "0";
+}
+
+/// Codes of `count` random programs of `programSize` instructions
+inline std::vector<bytes> generateCodes(size_t count, uint64_t programSize = 1000)
+{
+    eth::ProgramGenerator programGenerator;
+    std::vector<bytes> codes;
+    for (size_t i = 0; i < count; i++)
+    {
+        codes.push_back(programGenerator.generateInitialProgram(programSize).toBytes());
+    }
+    return codes;
+}
+
+}  // namespace test
+}  // namespace dev
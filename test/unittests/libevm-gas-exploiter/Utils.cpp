@@ -48,3 +48,20 @@ TEST(Utils, median)
     std::vector<double> evenSized = {0.2, 0.1, 0.3, 0.5, 0.05, 0.6};
     ASSERT_FLOAT_EQ(math::constMedian(evenSized.begin(), evenSized.end()), 0.25);
 }
+
+TEST(Utils, medianConfidenceInterval)
+{
+    std::vector<double> sorted(100);
+    for (size_t i = 0; i < sorted.size(); i++)
+    {
+        sorted[i] = i + 1;
+    }
+    // ranks 40 and 61 for 100 samples at 95%
+    auto interval = math::medianConfidenceInterval(sorted.rbegin(), sorted.rend());
+    EXPECT_EQ(interval.first, 40);
+    EXPECT_EQ(interval.second, 61);
+
+    interval = math::medianConfidenceInterval(values.begin(), values.end());
+    EXPECT_FLOAT_EQ(interval.first, 0.05);
+    EXPECT_FLOAT_EQ(interval.second, 0.5);
+}
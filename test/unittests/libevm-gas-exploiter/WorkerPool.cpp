@@ -0,0 +1,101 @@
+#include <libevm-gas-exploiter/WorkerPool.h>
+
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include <csignal>
+#include <fstream>
+#include <gtest/gtest.h>
+
+#include "TestEnv.h"
+
+using namespace dev;
+using namespace eth;
+
+
+namespace
+{
+/// Processes forked by the calling thread, empty if the kernel does not list them
+std::vector<pid_t> childProcesses()
+{
+    auto tid = syscall(SYS_gettid);
+    std::ifstream children("/proc/self/task/" + std::to_string(tid) + "/children");
+    std::vector<pid_t> pids;
+    pid_t pid;
+    while (children >> pid)
+    {
+        pids.push_back(pid);
+    }
+    return pids;
+}
+}  // namespace
+
+
+TEST(WorkerPool, benchmarkCodes)
+{
+    auto execEnv = test::createExecutionEnv();
+    BenchmarkConfig config(10, test::debugBenchmarks());
+    auto codes = test::generateCodes(4);
+    BenchmarkWorkerPool pool(execEnv, config, {0, 0}, codes[0]);
+    ASSERT_EQ(pool.size(), 2);
+    ASSERT_EQ(pool.calibrations().size(), 2);
+    for (const auto& calibration : pool.calibrations())
+    {
+        EXPECT_GT(calibration.initialTime, 0);
+        EXPECT_EQ(calibration.drift, 0);
+    }
+
+    // the codes are split between the workers and merged back in order
+    auto stats = pool.benchmarkCodes(codes);
+    ASSERT_EQ(stats.programStats.size(), codes.size());
+    EXPECT_EQ(stats.blockExecutionTimes.size(), config.execCount);
+    EXPECT_EQ(stats.workerCalibrations.size(), 2);
+    for (size_t i = 0; i < codes.size(); i++)
+    {
+        auto expected = executeCode(codes[i], execEnv);
+        EXPECT_EQ(stats.programStats[i].execCount, config.execCount);
+        EXPECT_EQ(stats.programStats[i].gas, expected.gasUsed.convert_to<uint64_t>());
+    }
+
+    // fewer codes than workers
+    stats = pool.benchmarkCodes({codes[1]});
+    ASSERT_EQ(stats.programStats.size(), 1);
+    auto expected = executeCode(codes[1], execEnv);
+    EXPECT_EQ(stats.programStats[0].gas, expected.gasUsed.convert_to<uint64_t>());
+
+    EXPECT_THROW(pool.benchmarkCodes({}), std::invalid_argument);
+}
+
+TEST(WorkerPool, workerDiesAtStartup)
+{
+    auto execEnv = test::createExecutionEnv();
+    BenchmarkConfig config(10, test::debugBenchmarks());
+    auto codes = test::generateCodes(1);
+    EXPECT_THROW(BenchmarkWorkerPool(execEnv, config, {}, codes[0]), std::invalid_argument);
+
+    // the first worker cannot be pinned and exits, the pool shuts down the other ones
+    EXPECT_THROW(BenchmarkWorkerPool(execEnv, config, {1023, 0}, codes[0]), std::runtime_error);
+
+    BenchmarkWorkerPool pool(execEnv, config, {0, 0}, codes[0]);
+    EXPECT_EQ(pool.benchmarkCodes(codes).programStats.size(), 1);
+}
+
+TEST(WorkerPool, workerDiesDuringBatch)
+{
+    auto execEnv = test::createExecutionEnv();
+    BenchmarkConfig config(10, test::debugBenchmarks());
+    auto codes = test::generateCodes(4);
+    BenchmarkWorkerPool pool(execEnv, config, {0, 0}, codes[0]);
+    auto workers = childProcesses();
+    if (workers.size() != 2)
+    {
+        // the children of the process are not listed by this kernel
+        return;
+    }
+
+    // the response of the other worker is still read, the pool is then unusable
+    ASSERT_EQ(kill(workers[1], SIGKILL), 0);
+    EXPECT_THROW(pool.benchmarkCodes(codes), std::runtime_error);
+    EXPECT_TRUE(pool.broken());
+    EXPECT_THROW(pool.benchmarkCodes(codes), std::runtime_error);
+}
@@ -0,0 +1,110 @@
+#include <libevmanalysis/AsyncStatWriter.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace dev;
+using namespace eth;
+
+TEST(AsyncStatWriter, runsTasksInOrder)
+{
+    vector<int> values;
+    {
+        AsyncStatWriter writer(4);
+        for (int i = 0; i < 100; i++)
+        {
+            EXPECT_TRUE(writer.push([&values, i]() { values.push_back(i); }));
+        }
+        writer.drain();
+        EXPECT_EQ(values.size(), 100);
+
+        auto counters = writer.counters();
+        EXPECT_EQ(counters.capacity, 4);
+        EXPECT_EQ(counters.queued, 100);
+        EXPECT_EQ(counters.written, 100);
+        EXPECT_EQ(counters.dropped, 0);
+    }
+    for (int i = 0; i < 100; i++)
+    {
+        EXPECT_EQ(values[i], i);
+    }
+}
+
+TEST(AsyncStatWriter, destructorRunsRemainingTasks)
+{
+    atomic<int> count{0};
+    {
+        AsyncStatWriter writer(16);
+        for (int i = 0; i < 10; i++)
+        {
+            writer.push([&count]() { count++; });
+        }
+    }
+    EXPECT_EQ(count, 10);
+}
+
+TEST(AsyncStatWriter, dropsWhenFull)
+{
+    atomic<bool> started{false};
+    atomic<bool> release{false};
+    AsyncStatWriter writer(2, StatQueueOverflow::Drop);
+    writer.push([&]() {
+        started = true;
+        while (!release)
+            this_thread::yield();
+    });
+    while (!started)
+        this_thread::yield();
+
+    EXPECT_TRUE(writer.push([]() {}));
+    EXPECT_TRUE(writer.push([]() {}));
+    EXPECT_FALSE(writer.push([]() {}));
+    release = true;
+    writer.drain();
+
+    auto counters = writer.counters();
+    EXPECT_EQ(counters.queued, 3);
+    EXPECT_EQ(counters.written, 3);
+    EXPECT_EQ(counters.dropped, 1);
+    EXPECT_EQ(counters.blocked, 0);
+}
+
+TEST(AsyncStatWriter, blocksWhenFull)
+{
+    atomic<bool> started{false};
+    atomic<bool> release{false};
+    AsyncStatWriter writer(1, StatQueueOverflow::Block);
+    writer.push([&]() {
+        started = true;
+        while (!release)
+            this_thread::yield();
+    });
+    while (!started)
+        this_thread::yield();
+    EXPECT_TRUE(writer.push([]() {}));
+
+    thread releaser([&]() {
+        this_thread::sleep_for(chrono::milliseconds(10));
+        release = true;
+    });
+    EXPECT_TRUE(writer.push([]() {}));
+    releaser.join();
+    writer.drain();
+
+    auto counters = writer.counters();
+    EXPECT_EQ(counters.written, 3);
+    EXPECT_EQ(counters.dropped, 0);
+    EXPECT_EQ(counters.blocked, 1);
+    EXPECT_GT(counters.blockedTime, 0);
+}
+
+TEST(AsyncStatWriter, parseOverflow)
+{
+    EXPECT_EQ(parseStatQueueOverflow("block"), StatQueueOverflow::Block);
+    EXPECT_EQ(parseStatQueueOverflow("drop"), StatQueueOverflow::Drop);
+    EXPECT_THROW(parseStatQueueOverflow("wait"), std::invalid_argument);
+}
@@ -0,0 +1,108 @@
+#include <libevmanalysis/BasicBlocks.h>
+#include <libevmanalysis/NonNegativeLeastSquares.h>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace dev;
+using namespace eth;
+
+namespace
+{
+bytes assemble(const vector<Instruction>& instructions)
+{
+    bytes code;
+    for (auto instruction : instructions)
+        code.push_back(static_cast<byte>(instruction));
+    return code;
+}
+}  // namespace
+
+TEST(BasicBlocks, split)
+{
+    // PUSH1 4 JUMP INVALID JUMPDEST PUSH2 0 0 POP JUMPDEST CALL ADD STOP
+    bytes code{0x60, 0x04, 0x56, 0xfe, 0x5b, 0x61, 0x5b, 0x5b, 0x50, 0x5b, 0xf1, 0x01, 0x00};
+    auto codeBlocks = splitBasicBlocks(&code);
+    ASSERT_EQ(codeBlocks.blocks.size(), 5);
+
+    auto& first = codeBlocks.blocks[0];
+    EXPECT_EQ(first.start, 0);
+    EXPECT_EQ(first.last, 2);
+    EXPECT_EQ(first.size, 2);
+    EXPECT_FALSE(first.external);
+
+    EXPECT_EQ(codeBlocks.blocks[1].start, 3);
+    // the JUMPDEST bytes pushed by PUSH2 do not start blocks
+    EXPECT_EQ(codeBlocks.blocks[2].start, 4);
+    EXPECT_EQ(codeBlocks.blocks[2].size, 3);
+    EXPECT_EQ(codeBlocks.blocks[3].start, 9);
+    EXPECT_TRUE(codeBlocks.blocks[3].external);
+    EXPECT_EQ(codeBlocks.blocks[4].start, 11);
+
+    EXPECT_EQ(codeBlocks.blockStartingAt(4), &codeBlocks.blocks[2]);
+    EXPECT_EQ(codeBlocks.blockStartingAt(6), nullptr);
+    EXPECT_EQ(codeBlocks.blockStartingAt(100), nullptr);
+
+    vector<pair<Instruction, uint32_t>> expected{
+        {Instruction::POP, 1}, {Instruction::JUMPDEST, 1}, {Instruction::PUSH2, 1}};
+    EXPECT_EQ(codeBlocks.blocks[2].instructions, expected);
+}
+
+TEST(BasicBlocks, keyToString)
+{
+    BasicBlockKey key{h256(1), 42};
+    EXPECT_EQ(keyToString(key), h256(1).hex() + ":42");
+}
+
+TEST(BasicBlocks, nonNegativeLeastSquares)
+{
+    // y = 2 * a + 3 * b, c would need a negative coefficient
+    NormalEquations equations(3);
+    equations.addRow({1, 0, 0}, 2);
+    equations.addRow({0, 1, 0}, 3);
+    equations.addRow({1, 1, 1}, 4);
+    equations.addRow({2, 1, 0}, 7, 2);
+    auto solution = nonNegativeLeastSquares(equations);
+    ASSERT_EQ(solution.size(), 3);
+    EXPECT_GE(solution[0], 0);
+    EXPECT_GE(solution[1], 0);
+    EXPECT_DOUBLE_EQ(solution[2], 0);
+
+    NormalEquations exact(2);
+    exact.addRow({1, 2}, 8);
+    exact.addRow({3, 1}, 9);
+    exact.addRow({1, 1}, 5);
+    solution = nonNegativeLeastSquares(exact);
+    EXPECT_NEAR(solution[0], 2, 1e-6);
+    EXPECT_NEAR(solution[1], 3, 1e-6);
+}
+
+TEST(BasicBlocks, fitCostModel)
+{
+    BasicBlockProfile profile(1);
+    auto addBlock = [&](const vector<Instruction>& instructions, uint32_t start, double time) {
+        auto code = assemble(instructions);
+        auto codeBlocks = splitBasicBlocks(&code);
+        for (int i = 0; i < 10; i++)
+            profile.addMeasurement(h256(start), codeBlocks.blocks[0], time, 3);
+    };
+    // ADD costs 10ns, MUL 20ns and JUMP 5ns
+    addBlock({Instruction::ADD, Instruction::JUMP}, 1, 15);
+    addBlock({Instruction::ADD, Instruction::ADD, Instruction::JUMP}, 2, 25);
+    addBlock({Instruction::MUL, Instruction::JUMP}, 3, 25);
+    addBlock({Instruction::MUL, Instruction::ADD, Instruction::MUL, Instruction::JUMP}, 4, 55);
+    addBlock({Instruction::JUMP}, 5, 5);
+    EXPECT_EQ(profile.totalCount(), 50);
+
+    auto model = profile.fitCostModel();
+    EXPECT_EQ(model.blocksCount, 5);
+    EXPECT_NEAR(model.instructions[Instruction::ADD].time, 10, 1e-3);
+    EXPECT_NEAR(model.instructions[Instruction::MUL].time, 20, 1e-3);
+    EXPECT_NEAR(model.instructions[Instruction::JUMP].time, 5, 1e-3);
+    EXPECT_EQ(model.instructions[Instruction::ADD].executedCount, 40);
+    EXPECT_NEAR(model.rootMeanSquaredError, 0, 1e-3);
+
+    auto json = model.toJson();
+    EXPECT_EQ(json["stats"]["MUL"]["count"].asUInt64(), 30);
+    EXPECT_NEAR(json["stats"]["MUL"]["mean"].asDouble(), 20, 1e-3);
+}
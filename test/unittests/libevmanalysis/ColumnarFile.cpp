@@ -0,0 +1,193 @@
+#include <libevmanalysis/ColumnarFile.h>
+#include <stdio.h>
+#include <unistd.h>
+
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace dev;
+using namespace eth;
+
+namespace
+{
+TableSchema testSchema()
+{
+    return TableSchema{"test",
+        {
+            {"number", ColumnType::UInt64},
+            {"delta", ColumnType::Int64},
+            {"time", ColumnType::Double},
+            {"instruction", ColumnType::Symbol},
+            {"sender", ColumnType::Address},
+            {"hash", ColumnType::Hash},
+            {"value", ColumnType::UInt256},
+        }};
+}
+
+void writeRow(ColumnarWriter& writer, uint16_t table, uint64_t i)
+{
+    writer.beginRow(table)
+        .add(i)
+        .add(-static_cast<int64_t>(i))
+        .add(i * 0.5)
+        .addSymbol(i % 2 == 0 ? "ADD" : "SSTORE")
+        .add(Address(i))
+        .add(h256(i + 1))
+        .add(u256(1) << (100 + i));
+    writer.endRow();
+}
+
+void checkRows(const string& path, uint64_t expectedRows)
+{
+    ColumnarReader reader(path);
+    ColumnarReader::Block block;
+    uint64_t i = 0;
+    while (reader.next(block))
+    {
+        ASSERT_EQ(block.schema(), testSchema());
+        for (size_t row = 0; row < block.rowsCount(); row++, i++)
+        {
+            EXPECT_EQ(block.getUInt64(0, row), i);
+            EXPECT_EQ(block.getInt64(1, row), -static_cast<int64_t>(i));
+            EXPECT_DOUBLE_EQ(block.getDouble(2, row), i * 0.5);
+            EXPECT_EQ(block.getSymbol(3, row), i % 2 == 0 ? "ADD" : "SSTORE");
+            EXPECT_EQ(block.getAddress(4, row), Address(i));
+            EXPECT_EQ(block.getHash(5, row), h256(i + 1));
+            EXPECT_EQ(block.getUInt256(6, row), u256(1) << (100 + i));
+        }
+    }
+    EXPECT_EQ(i, expectedRows);
+    EXPECT_EQ(reader.dictionary().size(), 2);
+}
+
+void testRoundTrip(ColumnarCodec codec)
+{
+    char filename[] = "/tmp/aleth-XXXXXX.col";
+    close(mkstemps(filename, 4));
+    {
+        ColumnarWriter writer(filename, codec, 4);
+        auto table = writer.addTable(testSchema());
+        for (uint64_t i = 0; i < 10; i++)
+        {
+            writeRow(writer, table, i);
+        }
+        EXPECT_EQ(writer.rowsCount(table), 10);
+    }
+    checkRows(filename, 10);
+    ASSERT_EQ(remove(filename), 0);
+}
+}  // namespace
+
+TEST(ColumnarFile, roundTrip)
+{
+    testRoundTrip(ColumnarCodec::None);
+}
+
+TEST(ColumnarFile, roundTripSnappy)
+{
+    testRoundTrip(ColumnarCodec::Snappy);
+}
+
+TEST(ColumnarFile, append)
+{
+    char filename[] = "/tmp/aleth-XXXXXX.col";
+    close(mkstemps(filename, 4));
+    {
+        ColumnarWriter writer(filename);
+        auto table = writer.addTable(testSchema());
+        for (uint64_t i = 0; i < 5; i++)
+        {
+            writeRow(writer, table, i);
+        }
+    }
+    {
+        ColumnarWriter writer(filename);
+        auto table = writer.addTable(testSchema());
+        EXPECT_EQ(table, 0);
+        EXPECT_EQ(writer.rowsCount(table), 5);
+        for (uint64_t i = 5; i < 8; i++)
+        {
+            writeRow(writer, table, i);
+        }
+
+        auto otherSchema = testSchema();
+        otherSchema.columns.pop_back();
+        EXPECT_THROW(writer.addTable(otherSchema), std::invalid_argument);
+    }
+    checkRows(filename, 8);
+    ASSERT_EQ(remove(filename), 0);
+}
+
+TEST(ColumnarFile, truncatedChunk)
+{
+    char filename[] = "/tmp/aleth-XXXXXX.col";
+    close(mkstemps(filename, 4));
+    {
+        ColumnarWriter writer(filename, ColumnarCodec::None, 4);
+        auto table = writer.addTable(testSchema());
+        for (uint64_t i = 0; i < 8; i++)
+        {
+            writeRow(writer, table, i);
+        }
+    }
+    // simulates a crash while the second block was written
+    FILE* file = fopen(filename, "rb");
+    fseek(file, 0, SEEK_END);
+    auto size = ftell(file);
+    fclose(file);
+    ASSERT_EQ(truncate(filename, size - 10), 0);
+    checkRows(filename, 4);
+
+    {
+        ColumnarWriter writer(filename, ColumnarCodec::None, 4);
+        auto table = writer.addTable(testSchema());
+        EXPECT_EQ(writer.rowsCount(table), 4);
+        for (uint64_t i = 4; i < 6; i++)
+        {
+            writeRow(writer, table, i);
+        }
+    }
+    checkRows(filename, 6);
+    ASSERT_EQ(remove(filename), 0);
+}
+
+TEST(ColumnarFile, invalidRows)
+{
+    char filename[] = "/tmp/aleth-XXXXXX.col";
+    close(mkstemps(filename, 4));
+    {
+        ColumnarWriter writer(filename);
+        auto table = writer.addTable(testSchema());
+        writer.beginRow(table);
+        EXPECT_THROW(writer.add(1.0), std::logic_error);
+        writer.add(uint64_t(1));
+        EXPECT_THROW(writer.endRow(), std::logic_error);
+    }
+    ASSERT_EQ(remove(filename), 0);
+}
+
+TEST(ColumnarFile, writeJsonLines)
+{
+    char filename[] = "/tmp/aleth-XXXXXX.col";
+    close(mkstemps(filename, 4));
+    {
+        ColumnarWriter writer(filename);
+        auto table = writer.addTable(testSchema());
+        writeRow(writer, table, 3);
+    }
+
+    ColumnarReader reader(filename);
+    std::stringstream output;
+    reader.writeJsonLines(output);
+    Json::Value row;
+    output >> row;
+    EXPECT_EQ(row["table"].asString(), "test");
+    EXPECT_EQ(row["number"].asUInt64(), 3);
+    EXPECT_EQ(row["delta"].asInt64(), -3);
+    EXPECT_EQ(row["instruction"].asString(), "SSTORE");
+    EXPECT_EQ(row["sender"].asString(), Address(3).hex());
+    EXPECT_EQ(row["value"].asString(), (u256(1) << 103).str());
+    ASSERT_EQ(remove(filename), 0);
+}
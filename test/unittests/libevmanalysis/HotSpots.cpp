@@ -0,0 +1,102 @@
+#include <libevmanalysis/HotSpots.h>
+
+#include <sstream>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace dev;
+using namespace eth;
+
+namespace
+{
+HotSpotSample sample(uint64_t code, uint32_t pc, uint64_t time, uint64_t gas = 3,
+    uint32_t stack = 0, Instruction instruction = Instruction::ADD)
+{
+    HotSpotSample result;
+    result.location = CodeLocation{h256(code), pc};
+    result.instruction = instruction;
+    result.stack = stack;
+    result.count = 1;
+    result.time = time;
+    result.gas = gas;
+    return result;
+}
+}  // namespace
+
+TEST(HotSpots, record)
+{
+    HotSpotProfiler profiler(10);
+    vector<CallStack> stacks{{Address(1)}, {Address(1), Address(2)}};
+    profiler.record({sample(1, 0, 100), sample(1, 1, 300, 20000, 1, Instruction::SSTORE)}, stacks);
+    profiler.record({sample(1, 0, 50, 3, 1)}, stacks);
+
+    auto spots = profiler.spots();
+    ASSERT_EQ(spots.size(), 2);
+    EXPECT_EQ(spots[0].location.pc, 1);
+    EXPECT_EQ(spots[0].instruction, Instruction::SSTORE);
+    EXPECT_EQ(spots[1].count, 2);
+    EXPECT_EQ(spots[1].time, 150);
+    EXPECT_EQ(spots[1].gas, 6);
+    EXPECT_DOUBLE_EQ(spots[1].timePerGas(), 25);
+    EXPECT_EQ(spots[1].stacks.at(stacks[0]), 100);
+    EXPECT_EQ(spots[1].stacks.at(stacks[1]), 50);
+    EXPECT_EQ(profiler.totalTime(), 450);
+    EXPECT_EQ(profiler.evictionsCount(), 0);
+}
+
+TEST(HotSpots, spaceSaving)
+{
+    HotSpotProfiler profiler(2);
+    vector<CallStack> stacks{{Address(1)}};
+    profiler.record({sample(1, 0, 100), sample(1, 1, 10)}, stacks);
+    // replaces the cheapest location and inherits its time
+    profiler.record({sample(1, 2, 20)}, stacks);
+
+    auto spots = profiler.spots();
+    ASSERT_EQ(spots.size(), 2);
+    EXPECT_EQ(spots[0].location.pc, 0);
+    EXPECT_EQ(spots[1].location.pc, 2);
+    EXPECT_EQ(spots[1].time, 30);
+    EXPECT_EQ(spots[1].timeError, 10);
+    EXPECT_EQ(spots[1].stacks.at(stacks[0]), 20);
+    EXPECT_EQ(profiler.evictionsCount(), 1);
+
+    EXPECT_THROW(HotSpotProfiler(0), std::invalid_argument);
+}
+
+TEST(HotSpots, stacksLimit)
+{
+    HotSpotProfiler profiler;
+    vector<CallStack> stacks;
+    vector<HotSpotSample> samples;
+    for (uint32_t i = 0; i < HotSpotProfiler::c_maxStacksPerSpot + 2; i++)
+    {
+        stacks.push_back({Address(i + 1)});
+        samples.push_back(sample(1, 0, 10, 3, i));
+    }
+    profiler.record(samples, stacks);
+
+    auto spots = profiler.spots();
+    ASSERT_EQ(spots.size(), 1);
+    EXPECT_EQ(spots[0].stacks.size(), HotSpotProfiler::c_maxStacksPerSpot + 1);
+    EXPECT_EQ(spots[0].stacks.at(CallStack()), 20);
+}
+
+TEST(HotSpots, foldedStacks)
+{
+    HotSpotProfiler profiler;
+    vector<CallStack> stacks{{Address(1), Address(2)}};
+    profiler.record({sample(1, 7, 42, 3, 0, Instruction::SLOAD)}, stacks);
+
+    stringstream folded;
+    HotSpotProfiler::writeFoldedStacks(folded, profiler.spots());
+    EXPECT_EQ(folded.str(), "0x" + Address(1).hex() + ";0x" + Address(2).hex() + ";" +
+                                h256(1).hex().substr(0, 8) + ":7:SLOAD 42\n");
+
+    auto json = HotSpotProfiler::toJson(profiler.spots());
+    ASSERT_EQ(json.size(), 1);
+    EXPECT_EQ(json[0]["instruction"].asString(), "SLOAD");
+    EXPECT_EQ(json[0]["time"].asUInt64(), 42);
+    EXPECT_EQ(json[0]["addresses"][0].asString(), "0x" + Address(2).hex());
+}
@@ -0,0 +1,109 @@
+#include <libevmanalysis/InstructionHistograms.h>
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace dev;
+using namespace eth;
+
+TEST(LatencyHistogram, buckets)
+{
+    for (uint64_t value = 0; value < 32; value++)
+    {
+        EXPECT_EQ(LatencyHistogram::bucketIndex(value), value);
+    }
+    size_t previousIndex = 0;
+    for (uint64_t value = 1; value < (uint64_t(1) << 36); value = value * 3 / 2 + 1)
+    {
+        auto index = LatencyHistogram::bucketIndex(value);
+        ASSERT_LT(index, LatencyHistogram::bucketsCount);
+        EXPECT_GE(index, previousIndex);
+        EXPECT_LE(LatencyHistogram::bucketLowerBound(index), value);
+        EXPECT_GE(LatencyHistogram::bucketUpperBound(index), value);
+        auto width =
+            LatencyHistogram::bucketUpperBound(index) - LatencyHistogram::bucketLowerBound(index);
+        EXPECT_LE(width, value / 32);
+        previousIndex = index;
+    }
+    for (size_t index = 0; index + 1 < LatencyHistogram::bucketsCount; index++)
+    {
+        EXPECT_EQ(LatencyHistogram::bucketIndex(LatencyHistogram::bucketLowerBound(index)), index);
+        EXPECT_EQ(LatencyHistogram::bucketIndex(LatencyHistogram::bucketUpperBound(index)), index);
+    }
+    EXPECT_EQ(LatencyHistogram::bucketIndex(uint64_t(1) << 50), LatencyHistogram::bucketsCount - 1);
+}
+
+TEST(LatencyHistogram, percentiles)
+{
+    LatencyHistogram histogram;
+    EXPECT_EQ(histogram.valueAtPercentile(50), 0);
+    for (uint64_t value = 1; value <= 1000; value++)
+    {
+        histogram.record(value * 100);
+    }
+    EXPECT_EQ(histogram.count(), 1000);
+    EXPECT_NEAR(histogram.valueAtPercentile(50), 50000, 50000 / 32);
+    EXPECT_NEAR(histogram.valueAtPercentile(99), 99000, 99000 / 32);
+    EXPECT_NEAR(histogram.valueAtPercentile(99.9), 99900, 99900 / 32);
+    EXPECT_NEAR(histogram.valueAtPercentile(100), 100000, 100000 / 32);
+}
+
+TEST(InstructionHistograms, record)
+{
+    InstructionHistograms histograms;
+    histograms.record(ExtendedInstruction::ADD, 10, 3);
+    histograms.record(ExtendedInstruction::ADD, 30, 3);
+    histograms.record(ExtendedInstruction::PRECOMPILED_SHA256, 1000, 72);
+    EXPECT_EQ(histograms.totalCount(), 3);
+
+    auto timings = histograms.timings();
+    ASSERT_EQ(timings.size(), 2);
+    auto& add = timings[ExtendedInstruction::ADD];
+    EXPECT_EQ(add.count, 2);
+    EXPECT_EQ(add.minTime, 10);
+    EXPECT_EQ(add.maxTime, 30);
+    EXPECT_DOUBLE_EQ(add.timeMean(), 20);
+    EXPECT_DOUBLE_EQ(add.timeVariance(), 100);
+    EXPECT_DOUBLE_EQ(add.gasMean(), 3);
+    EXPECT_EQ(add.histogram.valueAtPercentile(50), 10);
+    EXPECT_EQ(timings[ExtendedInstruction::PRECOMPILED_SHA256].count, 1);
+
+    auto json = histograms.toJson(true);
+    EXPECT_EQ(json["total_count"].asUInt64(), 3);
+    EXPECT_EQ(json["stats"]["ADD"]["count"].asUInt64(), 2);
+    EXPECT_EQ(json["stats"]["ADD"]["timeP99"].asUInt64(), 30);
+    EXPECT_EQ(json["stats"]["ADD"]["histogram"].size(), 2);
+    EXPECT_TRUE(json["stats"].isMember("PRECOMPILED_SHA256"));
+}
+
+TEST(InstructionHistograms, mergesThreads)
+{
+    InstructionHistograms histograms;
+    vector<thread> threads;
+    for (uint64_t i = 0; i < 4; i++)
+    {
+        threads.emplace_back([&histograms, i]() {
+            auto& local = histograms.local();
+            for (uint64_t j = 0; j < 1000; j++)
+            {
+                local.record(ExtendedInstruction::MUL, 100 * (i + 1), 5);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    EXPECT_EQ(histograms.threadsCount(), 4);
+    EXPECT_EQ(histograms.totalCount(), 4000);
+
+    auto mul = histograms.timings()[ExtendedInstruction::MUL];
+    EXPECT_EQ(mul.count, 4000);
+    EXPECT_EQ(mul.minTime, 100);
+    EXPECT_EQ(mul.maxTime, 400);
+    EXPECT_DOUBLE_EQ(mul.timeMean(), 250);
+    EXPECT_DOUBLE_EQ(mul.gasMean(), 5);
+}
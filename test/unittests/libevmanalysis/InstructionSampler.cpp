@@ -0,0 +1,83 @@
+#include <libevmanalysis/InstructionSampler.h>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace dev;
+using namespace eth;
+
+TEST(CycleClock, nanosecondsPerCycle)
+{
+    EXPECT_GT(CycleClock::nanosecondsPerCycle(), 0);
+    auto start = CycleClock::now();
+    EXPECT_GE(CycleClock::now(), start);
+}
+
+TEST(InstructionSampler, everyInstruction)
+{
+    InstructionSampler sampler;
+    for (int i = 0; i < 10; i++)
+    {
+        sampler.start();
+        EXPECT_TRUE(sampler.stop());
+        EXPECT_FALSE(sampler.stop());
+    }
+}
+
+TEST(InstructionSampler, interval)
+{
+    InstructionSampling sampling;
+    sampling.interval = 3;
+    InstructionSampler sampler(sampling);
+    int sampled = 0;
+    for (int i = 0; i < 30; i++)
+    {
+        sampler.start();
+        if (sampler.stop())
+        {
+            EXPECT_EQ(i % 3, 2);
+            sampled++;
+        }
+    }
+    EXPECT_EQ(sampled, 10);
+}
+
+TEST(InstructionSampler, randomizedInterval)
+{
+    InstructionSampling sampling;
+    sampling.interval = 10;
+    sampling.randomized = true;
+    InstructionSampler sampler(sampling);
+    int sampled = 0;
+    for (int i = 0; i < 100000; i++)
+    {
+        sampler.start();
+        if (sampler.stop())
+            sampled++;
+    }
+    EXPECT_NEAR(sampled, 10000, 1000);
+}
+
+TEST(InstructionSampler, missingStop)
+{
+    InstructionSampling sampling;
+    sampling.interval = 2;
+    InstructionSampler sampler(sampling);
+    sampler.start();
+    sampler.start();
+    // the VM did not call the probe after the second instruction
+    sampler.start();
+    EXPECT_FALSE(sampler.stop());
+}
+
+TEST(InstructionSampler, probeOverhead)
+{
+    InstructionSampling sampling;
+    sampling.probeOverheadCycles = 1e12;
+    InstructionSampler sampler(sampling);
+    sampler.start();
+    ASSERT_TRUE(sampler.stop());
+    EXPECT_EQ(sampler.lastNanoseconds(), 0);
+
+    EXPECT_THROW(InstructionSampler(InstructionSampling{0, false, 0}), std::invalid_argument);
+}
@@ -2,6 +2,8 @@
 
 #include <gtest/gtest.h>
 
+#include <sstream>
+
 using namespace std;
 using namespace dev;
 using namespace eth;
@@ -18,6 +20,46 @@ TEST(InstructionStats, recordInstruction)
     EXPECT_EQ(json["calls"]["SUB"].asUInt64(), 1);
 }
 
+TEST(InstructionStats, recordBigram)
+{
+    auto stats = InstructionStats();
+    stats.recordBigram(Instruction::PUSH2, 0, 0);
+    stats.recordBigram(Instruction::JUMPI, 3, 0);
+    // jumped
+    stats.recordBigram(Instruction::PUSH2, 10, 0);
+    stats.recordBigram(Instruction::JUMPI, 13, 0);
+    // called
+    stats.recordBigram(Instruction::POP, 14, 1);
+    stats.recordBigram(Instruction::POP, 15, 1);
+    auto json = stats.toJson();
+    EXPECT_EQ(json["bigrams"].size(), 2);
+    EXPECT_EQ(json["bigrams"]["PUSH2 JUMPI"].asUInt64(), 2);
+    EXPECT_EQ(json["bigrams"]["POP POP"].asUInt64(), 1);
+}
+
+TEST(InstructionStats, recordBigramOfPreverifiedJump)
+{
+    auto stats = InstructionStats();
+    stats.recordBigram(Instruction::PUSH2, 0, 0);
+    stats.recordBigram(Instruction::JUMPCI, 3, 0);
+    auto json = stats.toJson();
+    EXPECT_EQ(json["bigrams"]["PUSH2 JUMPI"].asUInt64(), 1);
+}
+
+TEST(InstructionStats, mostFrequentBigrams)
+{
+    std::istringstream measurements(
+        "{\"instructions\": {\"bigrams\": {\"PUSH1 ADD\": 3, \"SWAP1 POP\": 5}}}\n"
+        "\n"
+        "{\"instructions\": {\"bigrams\": {\"PUSH1 ADD\": 4, \"POP POP\": 1}}}\n");
+    auto counts = readBigramCounts(measurements);
+    EXPECT_EQ(counts.size(), 3);
+    EXPECT_EQ(counts["PUSH1 ADD"], 7);
+
+    EXPECT_EQ(mostFrequentBigrams(counts, 2), (vector<string>{"PUSH1 ADD", "SWAP1 POP"}));
+    EXPECT_EQ(mostFrequentBigrams(counts, 10).size(), 3);
+}
+
 TEST(InstructionStats, recordRead)
 {
     auto stats = InstructionStats();
@@ -0,0 +1,76 @@
+#include <libdevcore/MemoryDB.h>
+#include <libdevcore/OverlayDB.h>
+#include <libdevcore/SHA3.h>
+#include <libevmanalysis/StorageAccesses.h>
+
+#include <gtest/gtest.h>
+
+using namespace std;
+using namespace dev;
+using namespace eth;
+
+TEST(StorageAccesses, classify)
+{
+    EXPECT_EQ(classifyStorageAccess(0, 0), StorageAccessLevel::StateCache);
+    EXPECT_EQ(classifyStorageAccess(3, 0), StorageAccessLevel::Overlay);
+    EXPECT_EQ(classifyStorageAccess(3, 1), StorageAccessLevel::Database);
+
+    EXPECT_TRUE(isStorageAccess(Instruction::SLOAD));
+    EXPECT_TRUE(isStorageAccess(Instruction::EXTCODEHASH));
+    EXPECT_FALSE(isStorageAccess(Instruction::MLOAD));
+}
+
+TEST(StorageAccesses, stats)
+{
+    StorageAccessStats stats;
+    stats.record(Instruction::SLOAD, StorageAccessLevel::StateCache, 100, 200, 0, 0);
+    StorageAccessStats other;
+    other.record(Instruction::SLOAD, StorageAccessLevel::StateCache, 300, 200, 0, 0);
+    other.record(Instruction::BALANCE, StorageAccessLevel::Database, 5000, 400, 4, 2);
+    stats.merge(other);
+
+    auto json = stats.toJson();
+    EXPECT_EQ(json["SLOAD"]["cache"]["count"].asUInt64(), 2);
+    EXPECT_DOUBLE_EQ(json["SLOAD"]["cache"]["timeMean"].asDouble(), 200);
+    EXPECT_EQ(json["BALANCE"]["database"]["database_reads"].asUInt64(), 2);
+    EXPECT_EQ(json["total"]["cache"]["gas"].asUInt64(), 400);
+    EXPECT_EQ(json["total"]["database"]["memory_hits"].asUInt64(), 4);
+}
+
+TEST(StorageAccesses, tracker)
+{
+    OverlayDB db(unique_ptr<db::DatabaseFace>(new db::MemoryDB()));
+    auto value = sha3("value").asBytes();
+    auto key = sha3(value);
+    db.insert(key, &value);
+    db.commit();
+
+    // the VM calls the probes with the gas left before the instruction is charged, SSTORE
+    // being charged after its probe
+    int frame = 0;
+    int callee = 0;
+    StorageAccessTracker tracker;
+    tracker.onOp(Instruction::SLOAD, 10000, &frame);
+    EXPECT_FALSE(db.lookup(key).empty());
+    tracker.onOp(Instruction::BALANCE, 9800, &frame);
+    db.insert(key, &value);
+    EXPECT_FALSE(db.lookup(key).empty());
+    tracker.onOp(Instruction::PUSH1, 9400, &frame);
+    tracker.onOp(Instruction::SSTORE, 9397, &frame);
+    EXPECT_FALSE(db.lookup(key).empty());
+    tracker.onOp(Instruction::STOP, 4397, &frame);
+    // an access failing ends its frame, the next instruction being in the caller
+    tracker.onOp(Instruction::SLOAD, 100, &callee);
+    tracker.onOp(Instruction::POP, 9000, &frame);
+
+    const auto& costs = tracker.stats().costs();
+    ASSERT_EQ(costs.size(), 3);
+    auto sload = costs.at({Instruction::SLOAD, StorageAccessLevel::Database});
+    EXPECT_EQ(sload.count, 1);
+    EXPECT_EQ(sload.gas, 200);
+    EXPECT_EQ(sload.databaseReads, 1);
+    EXPECT_EQ(costs.at({Instruction::BALANCE, StorageAccessLevel::Overlay}).memoryHits, 1);
+    auto sstore = costs.at({Instruction::SSTORE, StorageAccessLevel::Overlay});
+    EXPECT_EQ(sstore.count, 1);
+    EXPECT_EQ(sstore.gas, 5000);
+}